@@ -1,3 +1,5 @@
+#include <cstring>
+#include <fstream>
 #include "BaseApplication.hpp"
 
 namespace Panda
@@ -5,7 +7,7 @@ namespace Panda
 	bool BaseApplication::m_Quit = false;
 
 	BaseApplication::BaseApplication(GfxConfiguration& cfg)
-		: m_Config(cfg)
+		: m_Config(cfg), m_ArgC(0), m_ppArgV(nullptr), m_RecordStartupManifest(false)
 	{
 		
 	}
@@ -25,6 +27,18 @@ namespace Panda
 			std::cerr << "Failed. err = " << ret;
 			return ret;
 		}
+		if (!m_StartupManifestPath.empty())
+		{
+			// warm the page cache with what the last launch read, while the directories are indexed
+			g_pAssetLoader->ReplayManifest(m_StartupManifestPath.c_str());
+			if (m_RecordStartupManifest)
+				g_pAssetLoader->StartRecording();
+		}
+		#ifdef DEBUG
+		g_pAssetLoader->GetProfiler().Start();
+		#endif
+		// resolve asset names once up front instead of probing the directories on every open
+		g_pAssetLoader->BuildDirectoryIndex();
 
 		if ((ret = g_pSceneManager->Initialize()) != 0)
 		{
@@ -55,6 +69,18 @@ namespace Panda
 			std::cerr << "Failed. err = " << ret;
 			return ret;
 		}
+		if (!m_StartupManifestPath.empty() && m_RecordStartupManifest)
+		{
+			// the splash scene is loaded, what was read up to here is the next launch's manifest
+			g_pAssetLoader->StopRecording(m_StartupManifestPath.c_str());
+		}
+		#ifdef DEBUG
+		// where the scene load time went, open the trace in chrome://tracing
+		g_pAssetLoader->GetProfiler().Stop();
+		g_pAssetLoader->GetProfiler().WriteSummary(std::cout);
+		std::ofstream trace("AssetLoad.trace.json");
+		g_pAssetLoader->GetProfiler().WriteChromeTrace(trace);
+		#endif
 
 		#ifdef DEBUG
 		if ((ret = g_pDebugManager->Initialize()) != 0)
@@ -98,6 +124,15 @@ namespace Panda
 	{
 		m_ArgC = argc;
 		m_ppArgV = argv;
+
+		// the startup manifest is opt-in, recording rewrites the file on every launch
+		for (int i = 1; i < argc; ++i)
+		{
+			if (strcmp(argv[i], "--startup-manifest") == 0 && i + 1 < argc)
+				m_StartupManifestPath = argv[++i];
+			else if (strcmp(argv[i], "--record-startup-manifest") == 0)
+				m_RecordStartupManifest = true;
+		}
 	}
 
 	bool BaseApplication::IsQuit() {
@@ -1,4 +1,5 @@
 #pragma once
+#include <string>
 #include "Interface/IApplication.hpp"
 #include "GraphicsManager.hpp"
 #include "MemoryManager.hpp"
@@ -33,6 +34,11 @@ namespace Panda {
 		GfxConfiguration m_Config;
 		int m_ArgC;
 		char** m_ppArgV;
+
+		// 启动时读取的资源清单，为空时不预读也不记录。
+		// --startup-manifest <path> 指定路径，加上 --record-startup-manifest 才会在启动后重写它
+		std::string m_StartupManifestPath;
+		bool m_RecordStartupManifest;
 		
 	private:
 		// 不允许没有配置的构造函数
@@ -2,6 +2,8 @@
 #include <string.h>
 #include <stdlib.h>
 #include "Allocator.hpp"
+#include "PageAllocator.hpp"
+#include "PageMap.hpp"
 
 
 #ifndef ALIGN
@@ -9,14 +11,15 @@
 #endif
 
 Panda::Allocator::Allocator()
-	:m_BlockSize(0), m_PageSize(0), m_BlockCountPerPage(0), m_AlignmentSize(0), 
+	:m_BlockSize(0), m_PageSize(0), m_BlockCountPerPage(0), m_AlignmentSize(0),
+	m_BlockAlignment(0), m_BlockOffset(0),
 	m_pFreeBlockList(nullptr),m_FreeBlockCount(0),m_BlockCount(0),
-	 m_pPageList(nullptr), m_PageCount(0)
+	 m_pPageList(nullptr), m_PageCount(0), m_EmptyPageCount(0), m_PageTag(0)
 {
 }
 
 Panda::Allocator::Allocator(uint32_t inPageSize, uint32_t inBlockSize, uint32_t inAlignment) 
-	:m_pFreeBlockList(nullptr), m_pPageList(nullptr)
+	:m_pFreeBlockList(nullptr), m_pPageList(nullptr), m_PageTag(0)
 {
 	Reset(inPageSize, inBlockSize, inAlignment);
 }
@@ -29,16 +32,21 @@ Panda::Allocator::~Allocator()
 void* Panda::Allocator::Allocate() {
 	if (m_pFreeBlockList == nullptr) {
 		// 分配一页内存
-		PageHeader* pNewPage = reinterpret_cast<PageHeader*>(new uint8_t[m_PageSize]);
+		PageHeader* pNewPage = reinterpret_cast<PageHeader*>(PageAllocator::Allocate(m_PageSize));
 		m_FreeBlockCount += m_BlockCountPerPage;
 		m_BlockCount += m_BlockCountPerPage;
 		m_PageCount++;
+		m_EmptyPageCount++;
 		
+		pNewPage->LiveBlockCount = 0;
 		pNewPage->pNext = m_pPageList;
 		m_pPageList = pNewPage;
+
+		if (m_PageTag)
+			PageMap::Insert(pNewPage, m_PageSize, m_PageTag);
 	 	
 		// 将所有内存块串联起来
-		BlockHeader* pBlockStart = m_pPageList->BlockStart();
+		BlockHeader* pBlockStart = m_pPageList->BlockStart(m_BlockOffset);
 		m_pFreeBlockList = pBlockStart;
 		for (size_t i = 0; i < m_BlockCountPerPage - 1; ++i) {
 			pBlockStart->pNext = NextBlock(pBlockStart);
@@ -51,6 +59,9 @@ void* Panda::Allocator::Allocate() {
 	BlockHeader* pBlock = m_pFreeBlockList;
 	m_pFreeBlockList = m_pFreeBlockList->pNext;
 	m_FreeBlockCount--;
+
+	if (PageOf(pBlock)->LiveBlockCount++ == 0)
+		m_EmptyPageCount--;
 	
 	return reinterpret_cast<void*>(pBlock);
 }
@@ -59,6 +70,10 @@ Panda::BlockHeader* Panda::Allocator::NextBlock(BlockHeader* pCurrentBlock) {
 	return reinterpret_cast<BlockHeader*>( reinterpret_cast<uint8_t*> (pCurrentBlock) + m_BlockSize);
 }
 
+Panda::PageHeader* Panda::Allocator::PageOf(void* p) const {
+	return reinterpret_cast<PageHeader*>(reinterpret_cast<uintptr_t>(p) & ~(m_PageSize - 1));
+}
+
 // 重置分配器
 void Panda::Allocator::Reset(uint32_t inPageSize, uint32_t inBlockSize, uint32_t inAlignment) {
 	FreeAll();
@@ -68,11 +83,21 @@ void Panda::Allocator::Reset(uint32_t inPageSize, uint32_t inBlockSize, uint32_t
 	m_BlockSize = ALIGN(minBlockSize, inAlignment);
 	
 	m_AlignmentSize = m_BlockSize - minBlockSize;
+
+	// 块尺寸能被整除的最大的2的幂就是块天然的对齐值，最多到缓存行。
+	// 只要第一个块按此对齐，页内所有块都是对齐的。
+	m_BlockAlignment = m_BlockSize & (~m_BlockSize + 1);
+	if (m_BlockAlignment > MAX_BLOCK_ALIGNMENT)
+		m_BlockAlignment = MAX_BLOCK_ALIGNMENT;
+	m_BlockOffset = ALIGN(sizeof(PageHeader), m_BlockAlignment);
 	
-	// 一页至少一个块
-	m_PageSize = inPageSize > (m_BlockSize + sizeof (PageHeader))? inPageSize : (m_BlockSize + sizeof(PageHeader));
+	// 一页至少一个块，并且页尺寸是2的幂，这样页可以按页尺寸对齐
+	size_t minPageSize = inPageSize > (m_BlockSize + m_BlockOffset)? inPageSize : (m_BlockSize + m_BlockOffset);
+	m_PageSize = 1;
+	while (m_PageSize < minPageSize)
+		m_PageSize <<= 1;
 	
-	m_BlockCountPerPage = (m_PageSize - sizeof(PageHeader)) / m_BlockSize;
+	m_BlockCountPerPage = (m_PageSize - m_BlockOffset) / m_BlockSize;
 	
 }
 
@@ -82,6 +107,9 @@ void Panda::Allocator::Free(void* p)
 	pHeader->pNext = m_pFreeBlockList;
 	m_pFreeBlockList = pHeader;
 	m_FreeBlockCount++;
+
+	if (--PageOf(p)->LiveBlockCount == 0)
+		m_EmptyPageCount++;
 }
 
 void Panda::Allocator::FreeAll() 
@@ -91,12 +119,72 @@ void Panda::Allocator::FreeAll()
 		PageHeader* pTemp = pFree;
 		pFree = pFree->pNext;
 		
-		delete[] reinterpret_cast<uint8_t*>(pTemp);
+		// 页中可能还有块没有归还，之后释放它们时会被忽略
+		if (m_PageTag)
+			PageMap::Retire(pTemp, m_PageSize);
+		PageAllocator::Free(pTemp, m_PageSize);
 	}
 	
-	// 只重置这两个属性因为这两个属性是要用于判断的，其他的都是保存作用
 	m_pPageList = nullptr;
 	m_pFreeBlockList = nullptr;
+	m_FreeBlockCount = 0;
+	m_BlockCount = 0;
+	m_PageCount = 0;
+	m_EmptyPageCount = 0;
+}
+
+size_t Panda::Allocator::Trim(size_t inKeepPageCount)
+{
+	if (m_EmptyPageCount <= inKeepPageCount)
+		return 0;
+
+	// 标记要释放的空页：已分配块数为0，释放前把计数设为一个不可能的值作为标记
+	const uint32_t kReleaseMark = UINT32_MAX;
+	size_t releaseCount = m_EmptyPageCount - inKeepPageCount;
+	size_t marked = 0;
+	for (PageHeader* pPage = m_pPageList; pPage && marked < releaseCount; pPage = pPage->pNext)
+	{
+		if (pPage->LiveBlockCount == 0)
+		{
+			pPage->LiveBlockCount = kReleaseMark;
+			++marked;
+		}
+	}
+
+	// 从空余块列表中摘掉属于这些页的块
+	BlockHeader** ppBlock = &m_pFreeBlockList;
+	while (*ppBlock)
+	{
+		if (PageOf(*ppBlock)->LiveBlockCount == kReleaseMark)
+			*ppBlock = (*ppBlock)->pNext;
+		else
+			ppBlock = &(*ppBlock)->pNext;
+	}
+
+	// 释放这些页
+	PageHeader** ppPage = &m_pPageList;
+	while (*ppPage)
+	{
+		PageHeader* pPage = *ppPage;
+		if (pPage->LiveBlockCount == kReleaseMark)
+		{
+			*ppPage = pPage->pNext;
+			if (m_PageTag)
+				PageMap::Erase(pPage, m_PageSize);
+			PageAllocator::Free(pPage, m_PageSize);
+		}
+		else
+		{
+			ppPage = &pPage->pNext;
+		}
+	}
+
+	m_FreeBlockCount -= marked * m_BlockCountPerPage;
+	m_BlockCount -= marked * m_BlockCountPerPage;
+	m_PageCount -= marked;
+	m_EmptyPageCount -= marked;
+
+	return marked;
 }
 
 #if defined(_DEBUG)
@@ -104,7 +192,7 @@ void Panda::Allocator::FillFreePage(PageHeader* pPage)
 {
 	pPage->pNext = nullptr;
 
-	BlockHeader* pBlock = pPage->BlockStart();
+	BlockHeader* pBlock = pPage->BlockStart(m_BlockOffset);
 	for (uint32_t i = 0; i < m_BlockCountPerPage; ++i)
 	{
 		FillFreeBlock(pBlock);
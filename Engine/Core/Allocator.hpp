@@ -14,8 +14,9 @@ namespace Panda{
 	
 	struct PageHeader {
 		PageHeader* pNext;
-		BlockHeader* BlockStart() {
-			return reinterpret_cast<BlockHeader*>(this + 1);	// PageHeader之后就是块的起始位置
+		uint32_t	LiveBlockCount;		// 这一页中已分配出去的块数
+		BlockHeader* BlockStart(size_t inOffset) {
+			return reinterpret_cast<BlockHeader*>(reinterpret_cast<uint8_t*>(this) + inOffset);	// PageHeader之后对齐的位置是块的起始位置
 		}
 	};
 	
@@ -26,6 +27,9 @@ namespace Panda{
 		static const uint8_t PATTERN_ALLOC = 0xFD;
 		static const uint8_t PATTERN_FREE = 0xFE;
 
+		// 块的对齐最多到缓存行，更大的对齐需求由MemoryManager直接分配
+		static const uint32_t MAX_BLOCK_ALIGNMENT = 64;
+
 		Allocator();
 		Allocator(uint32_t inPageSize, uint32_t inBlockSize, uint32_t inAlignment);
 		~Allocator();
@@ -34,6 +38,22 @@ namespace Panda{
 		void* Allocate();
 		void Free(void* p);
 		void FreeAll();
+
+		// 释放没有任何已分配块的页，最多保留inKeepPageCount个空页，返回释放的页数
+		size_t Trim(size_t inKeepPageCount);
+		size_t GetEmptyPageCount() const { return m_EmptyPageCount; }
+
+		// 每个块的起始地址都保证按此值对齐
+		size_t GetBlockAlignment() const { return m_BlockAlignment; }
+
+		size_t GetBlockSize() const { return m_BlockSize; }
+		size_t GetPageCount() const { return m_PageCount; }
+		size_t GetBlockCount() const { return m_BlockCount; }
+		size_t GetFreeBlockCount() const { return m_FreeBlockCount; }
+
+		// 非0时，每一页都以此tag登记到PageMap中，可以从块的地址找到分配器。
+		// 必须在分配第一页之前设置。
+		void SetPageTag(uint8_t inTag) { m_PageTag = inTag; }
 		
 	private:
 #if defined(_DEBUG)
@@ -48,6 +68,8 @@ namespace Panda{
 #endif
 
 		BlockHeader* NextBlock(BlockHeader* pCurrentBlock);
+		// 页按页尺寸对齐，块所在的页可以直接由地址算出
+		PageHeader* PageOf(void* p) const;
 		// 禁用拷贝构造函数和赋值操作符
 		Allocator(const Allocator& clone);
 		Allocator& operator=(const Allocator& rhs);
@@ -57,6 +79,8 @@ namespace Panda{
 		size_t		m_PageSize;				// 页的尺寸
 		size_t		m_BlockCountPerPage;	// 每页的块数
 		size_t		m_AlignmentSize;		// 对齐尺寸
+		size_t		m_BlockAlignment;		// 块起始地址的对齐值
+		size_t		m_BlockOffset;			// 第一个块相对页起始的偏移
 		
 		
 		BlockHeader*	m_pFreeBlockList;		// 空余块列表
@@ -65,5 +89,7 @@ namespace Panda{
 		
 		PageHeader*		m_pPageList;			// 页列表
 		size_t		m_PageCount;			// 页数
+		size_t		m_EmptyPageCount;		// 没有已分配块的页数
+		uint8_t		m_PageTag;				// 页在PageMap中的tag，0表示不登记
 	};
 }
\ No newline at end of file
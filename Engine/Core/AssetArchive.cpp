@@ -0,0 +1,144 @@
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include "AssetArchive.hpp"
+#include "MappedFile.hpp"
+#include "PandaAllocator.hpp"
+#include "zlib/zlib.h"
+
+namespace Panda
+{
+    // compares a '\0' terminated name with a name from the table, like std::string::compare
+    static int CompareName(const char* name, size_t nameLength, const char* entryName, size_t entryLength)
+    {
+        int result = memcmp(name, entryName, nameLength < entryLength ? nameLength : entryLength);
+        if (result != 0)
+            return result;
+        if (nameLength == entryLength)
+            return 0;
+        return nameLength < entryLength ? -1 : 1;
+    }
+
+    bool AssetArchive::Open(const char* path)
+    {
+        Close();
+
+        FILE* fp = fopen(path, "rb");
+        if (!fp)
+            return false;
+
+        // lookups jump around the table, the entries themselves are read one by one
+        std::shared_ptr<MappedFile> pMapping = MakeShared<MappedFile>();
+        bool mapped = pMapping->Map(fp, MappedFile::PANDA_ACCESS_RANDOM);
+        fclose(fp);
+        if (!mapped)
+            return false;
+
+        const uint8_t* pData = pMapping->GetData();
+        size_t size = pMapping->GetDataSize();
+        if (size < sizeof(AssetArchiveHeader))
+            return false;
+
+        const AssetArchiveHeader* pHeader = reinterpret_cast<const AssetArchiveHeader*>(pData);
+        if (pHeader->Magic != k_AssetArchiveMagic || pHeader->Version != k_AssetArchiveVersion)
+        {
+            fprintf(stderr, "'%s' is not an asset archive\n", path);
+            return false;
+        }
+
+        uint64_t tableEnd = sizeof(AssetArchiveHeader) + uint64_t(pHeader->EntryCount) * sizeof(AssetArchiveEntry)
+            + pHeader->NamesSize;
+        if (tableEnd > size)
+        {
+            fprintf(stderr, "Asset archive '%s' is truncated\n", path);
+            return false;
+        }
+
+        const AssetArchiveEntry* pEntries = reinterpret_cast<const AssetArchiveEntry*>(pHeader + 1);
+        for (uint32_t i = 0; i < pHeader->EntryCount; ++i)
+        {
+            const AssetArchiveEntry& entry = pEntries[i];
+            if (entry.Offset > size || entry.StoredSize > size - entry.Offset
+                || uint64_t(entry.NameOffset) + entry.NameLength > pHeader->NamesSize
+                || (!(entry.Flags & PANDA_ARCHIVE_ENTRY_COMPRESSED) && entry.StoredSize != entry.Size))
+            {
+                fprintf(stderr, "Asset archive '%s' has a broken entry\n", path);
+                return false;
+            }
+        }
+
+        m_File = BufferView(std::move(pMapping), pData, size);
+        m_pHeader = pHeader;
+        m_pEntries = pEntries;
+        m_pNames = reinterpret_cast<const char*>(pEntries + pHeader->EntryCount);
+        return true;
+    }
+
+    void AssetArchive::Close()
+    {
+        m_File = BufferView();
+        m_pHeader = nullptr;
+        m_pEntries = nullptr;
+        m_pNames = nullptr;
+    }
+
+    const AssetArchiveEntry* AssetArchive::Find(const char* name) const
+    {
+        if (!m_pHeader)
+            return nullptr;
+
+        size_t nameLength = strlen(name);
+        size_t low = 0, high = m_pHeader->EntryCount;
+        while (low < high)
+        {
+            size_t mid = low + (high - low) / 2;
+            const AssetArchiveEntry& entry = m_pEntries[mid];
+            int result = CompareName(name, nameLength, m_pNames + entry.NameOffset, entry.NameLength);
+            if (result == 0)
+                return &entry;
+            if (result < 0)
+                high = mid;
+            else
+                low = mid + 1;
+        }
+
+        return nullptr;
+    }
+
+    std::string AssetArchive::GetEntryName(const AssetArchiveEntry& entry) const
+    {
+        return std::string(m_pNames + entry.NameOffset, entry.NameLength);
+    }
+
+    BufferView AssetArchive::Read(const AssetArchiveEntry& entry) const
+    {
+        if (!(entry.Flags & PANDA_ARCHIVE_ENTRY_COMPRESSED))
+            return m_File.Slice(entry.Offset, entry.StoredSize);
+
+        Buffer buffer(entry.Size);
+        if (!ReadInto(entry, buffer.GetData()))
+            return BufferView();
+
+        return BufferView(std::move(buffer));
+    }
+
+    bool AssetArchive::ReadInto(const AssetArchiveEntry& entry, uint8_t* pDest) const
+    {
+        const uint8_t* pStored = m_File.GetData() + entry.Offset;
+        if (!(entry.Flags & PANDA_ARCHIVE_ENTRY_COMPRESSED))
+        {
+            memcpy(pDest, pStored, entry.StoredSize);
+            return true;
+        }
+
+        uLongf size = static_cast<uLongf>(entry.Size);
+        int ret = uncompress(pDest, &size, pStored, static_cast<uLong>(entry.StoredSize));
+        if (ret != Z_OK || size != entry.Size)
+        {
+            fprintf(stderr, "Corrupt asset archive entry '%s'\n", GetEntryName(entry).c_str());
+            return false;
+        }
+
+        return true;
+    }
+}
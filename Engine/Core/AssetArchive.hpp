@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "BufferView.hpp"
+
+/**
+ * Packed asset archive (.pak).
+ *
+ * [header][entries, sorted by name][names][data]
+ *
+ * Entries are found by a binary search over the sorted table. Every entry's
+ * data starts on a k_AssetArchiveAlignment boundary, so a stored entry can be
+ * handed out straight from the mapped archive. Entries may be zlib compressed
+ * one by one. All fields are little endian.
+ */
+
+namespace Panda
+{
+    static const uint32_t k_AssetArchiveMagic = 0x4B415050;    // "PPAK"
+    static const uint16_t k_AssetArchiveVersion = 1;
+    static const uint64_t k_AssetArchiveAlignment = 64;
+
+    enum AssetArchiveEntryFlags
+    {
+        PANDA_ARCHIVE_ENTRY_STORED      = 0,
+        PANDA_ARCHIVE_ENTRY_COMPRESSED  = 1    // zlib stream
+    };
+
+#pragma pack(push, 1)
+    struct AssetArchiveHeader
+    {
+        uint32_t Magic;
+        uint16_t Version;
+        uint16_t Reserved;
+        uint32_t EntryCount;
+        uint32_t NamesSize;     // bytes of the name table right after the entries
+    };
+
+    struct AssetArchiveEntry
+    {
+        uint64_t Offset;        // from the start of the archive
+        uint64_t StoredSize;    // bytes in the archive
+        uint64_t Size;          // bytes once decompressed
+        uint32_t NameOffset;    // into the name table, names are not '\0' terminated
+        uint16_t NameLength;
+        uint16_t Flags;
+    };
+#pragma pack(pop)
+
+    class AssetArchive
+    {
+        public:
+            AssetArchive() : m_pHeader(nullptr), m_pEntries(nullptr), m_pNames(nullptr) {}
+
+            // maps the archive, false when it is missing or malformed
+            bool Open(const char* path);
+            void Close();
+
+            bool IsOpen() const {return m_pHeader != nullptr;}
+
+            // nullptr when there is no such entry
+            const AssetArchiveEntry* Find(const char* name) const;
+
+            size_t GetEntryCount() const {return m_pHeader ? m_pHeader->EntryCount : 0;}
+            const AssetArchiveEntry& GetEntry(size_t index) const {return m_pEntries[index];}
+            std::string GetEntryName(const AssetArchiveEntry& entry) const;
+
+            /**
+             * A stored entry is a slice of the mapped archive, no copy. A compressed
+             * one is inflated into a new Buffer. Either way the view keeps its memory
+             * alive after the archive is closed. Empty when the data is corrupt.
+             */
+            BufferView Read(const AssetArchiveEntry& entry) const;
+
+            // copies or inflates the entry into pDest, which holds entry.Size bytes
+            bool ReadInto(const AssetArchiveEntry& entry, uint8_t* pDest) const;
+
+        private:
+            BufferView m_File;
+            const AssetArchiveHeader* m_pHeader;
+            const AssetArchiveEntry* m_pEntries;
+            const char* m_pNames;
+    };
+}
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cstdio>
+#include "AssetArchiveWriter.hpp"
+#include "zlib/zlib.h"
+
+namespace Panda
+{
+    void AssetArchiveWriter::AddFile(const std::string& name, const BufferView& data, bool compress)
+    {
+        PendingFile file;
+        file.Name = name;
+        file.Data = data;
+        file.Compress = compress;
+        m_Files.push_back(std::move(file));
+    }
+
+    static uint64_t AlignOffset(uint64_t offset)
+    {
+        return (offset + k_AssetArchiveAlignment - 1) & ~(k_AssetArchiveAlignment - 1);
+    }
+
+    bool AssetArchiveWriter::Write(const char* path)
+    {
+        // the reader binary searches the entries
+        std::sort(m_Files.begin(), m_Files.end(), [](const PendingFile& a, const PendingFile& b) {
+            return a.Name < b.Name;
+        });
+
+        std::vector<AssetArchiveEntry> entries(m_Files.size());
+        std::vector<std::vector<uint8_t>> compressed(m_Files.size());
+        std::string names;
+        for (size_t i = 0; i < m_Files.size(); ++i)
+        {
+            const PendingFile& file = m_Files[i];
+            if (i > 0 && file.Name == m_Files[i - 1].Name)
+            {
+                fprintf(stderr, "'%s' is added to the archive twice\n", file.Name.c_str());
+                return false;
+            }
+            if (file.Name.size() > UINT16_MAX)
+                return false;
+
+            AssetArchiveEntry& entry = entries[i];
+            entry.NameOffset = static_cast<uint32_t>(names.size());
+            entry.NameLength = static_cast<uint16_t>(file.Name.size());
+            entry.Size = file.Data.GetDataSize();
+            entry.StoredSize = entry.Size;
+            entry.Flags = PANDA_ARCHIVE_ENTRY_STORED;
+            names += file.Name;
+
+            if (file.Compress && entry.Size > 0)
+            {
+                uLongf size = compressBound(static_cast<uLong>(entry.Size));
+                compressed[i].resize(size);
+                int ret = compress2(compressed[i].data(), &size, file.Data.GetData(), static_cast<uLong>(entry.Size),
+                    Z_BEST_COMPRESSION);
+
+                // not worth inflating on every load when it barely shrinks
+                if (ret == Z_OK && size < entry.Size - entry.Size / 8)
+                {
+                    compressed[i].resize(size);
+                    entry.StoredSize = size;
+                    entry.Flags = PANDA_ARCHIVE_ENTRY_COMPRESSED;
+                }
+                else
+                {
+                    compressed[i].clear();
+                }
+            }
+        }
+
+        AssetArchiveHeader header;
+        header.Magic = k_AssetArchiveMagic;
+        header.Version = k_AssetArchiveVersion;
+        header.Reserved = 0;
+        header.EntryCount = static_cast<uint32_t>(entries.size());
+        header.NamesSize = static_cast<uint32_t>(names.size());
+
+        // the data follows the tables in name order, so loading a directory reads the file front to back
+        uint64_t offset = sizeof(header) + entries.size() * sizeof(AssetArchiveEntry) + names.size();
+        for (auto& entry : entries)
+        {
+            offset = AlignOffset(offset);
+            entry.Offset = offset;
+            offset += entry.StoredSize;
+        }
+
+        FILE* fp = fopen(path, "wb");
+        if (!fp)
+        {
+            fprintf(stderr, "Error creating archive '%s'\n", path);
+            return false;
+        }
+
+        bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+        if (!entries.empty())
+            ok = ok && fwrite(entries.data(), sizeof(AssetArchiveEntry), entries.size(), fp) == entries.size();
+        ok = ok && fwrite(names.data(), 1, names.size(), fp) == names.size();
+
+        static const uint8_t padding[k_AssetArchiveAlignment] = {};
+        uint64_t written = sizeof(header) + entries.size() * sizeof(AssetArchiveEntry) + names.size();
+        for (size_t i = 0; ok && i < entries.size(); ++i)
+        {
+            size_t pad = static_cast<size_t>(entries[i].Offset - written);
+            ok = fwrite(padding, 1, pad, fp) == pad;
+
+            const uint8_t* pData = compressed[i].empty() ? m_Files[i].Data.GetData() : compressed[i].data();
+            size_t size = static_cast<size_t>(entries[i].StoredSize);
+            ok = ok && fwrite(pData, 1, size, fp) == size;
+            written = entries[i].Offset + size;
+        }
+
+        ok = (fclose(fp) == 0) && ok;
+        if (!ok)
+            fprintf(stderr, "Error writing archive '%s'\n", path);
+
+        return ok;
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "AssetArchive.hpp"
+
+namespace Panda
+{
+    /**
+     * Builds a .pak archive, see AssetArchive.hpp for the layout.
+     * The data of the added files is only referenced until Write().
+     */
+    class AssetArchiveWriter
+    {
+        public:
+            // name is how the asset is opened, e.g. "Textures/floor.png"
+            void AddFile(const std::string& name, const BufferView& data, bool compress);
+
+            size_t GetFileCount() const {return m_Files.size();}
+
+            // false on a duplicate name or an i/o error
+            bool Write(const char* path);
+
+        private:
+            struct PendingFile
+            {
+                std::string Name;
+                BufferView Data;
+                bool Compress;
+            };
+
+            std::vector<PendingFile> m_Files;
+    };
+}
@@ -0,0 +1,379 @@
+#include <algorithm>
+#include <cstring>
+#include "AssetCache.hpp"
+#include "AssetLoader.hpp"
+#include "PandaAllocator.hpp"
+#include "zlib/zlib.h"
+
+namespace Panda
+{
+    AssetCache::AssetCache(AssetLoader& loader, size_t budget)
+        : m_Loader(loader), m_Budget(budget), m_CachedBytes(0), m_Hits(0), m_Misses(0), m_ContentKeying(false)
+    {
+    }
+
+    std::shared_ptr<const Buffer> AssetCache::LoadBuffer(const char* name)
+    {
+        std::string path = m_Loader.ResolvePath(name);
+        if (path.empty())
+        {
+            DropPendingRead(name);
+            return nullptr;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            if (Entry* pEntry = Find(PANDA_ASSET_BUFFER, path))
+            {
+                m_PendingReads.erase(name);
+                ++m_Hits;
+                return pEntry->pBuffer;
+            }
+        }
+
+        Buffer buffer;
+        if (!TakePendingRead(name, buffer))
+            buffer = m_Loader.SyncOpenAndReadBinary(name);
+        if (!buffer.GetData())
+            return nullptr;
+
+        bool keyed = m_ContentKeying;
+        uint64_t contentKey = keyed ? HashContent(buffer) : 0;
+        Match match;
+        if (keyed && FindContent(PANDA_ASSET_BUFFER, path, contentKey, buffer, match))
+        {
+            ++m_Hits;
+            return match.pBuffer;
+        }
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        // another thread may have loaded the same path meanwhile
+        if (Entry* pEntry = Find(PANDA_ASSET_BUFFER, path))
+        {
+            ++m_Hits;
+            return pEntry->pBuffer;
+        }
+
+        ++m_Misses;
+        Entry entry;
+        entry.Kind = PANDA_ASSET_BUFFER;
+        entry.Paths.push_back(path);
+        entry.Name = name;
+        entry.HasContentKey = keyed;
+        entry.ContentKey = contentKey;
+        entry.Size = buffer.GetDataSize();
+        std::shared_ptr<const Buffer> pBuffer = MakeShared<Buffer>(std::move(buffer));
+        entry.pBuffer = pBuffer;
+        Insert(std::move(entry));
+        TrimLocked();
+
+        return pBuffer;
+    }
+
+    /**
+     * Decoding happens without the lock held. When two threads decode the same
+     * image at once, the one that finishes second throws its copy away.
+     */
+    std::shared_ptr<const CachedImage> AssetCache::LoadImage(const char* name, const ImageDecoder& decoder)
+    {
+        std::string path = m_Loader.ResolvePath(name);
+        if (path.empty())
+        {
+            DropPendingRead(name);
+            return nullptr;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            if (Entry* pEntry = Find(PANDA_ASSET_IMAGE, path))
+            {
+                m_PendingReads.erase(name);
+                ++m_Hits;
+                return pEntry->pImage;
+            }
+        }
+
+        // the encoded file is only needed until it is decoded, so map it rather than read it
+        Buffer prefetched;
+        BufferView data = TakePendingRead(name, prefetched) ? BufferView(std::move(prefetched))
+                                                           : m_Loader.SyncOpenAndMapBinary(name);
+        if (data.IsEmpty())
+            return nullptr;
+
+        bool keyed = m_ContentKeying;
+        uint64_t contentKey = keyed ? HashContent(data) : 0;
+        Match match;
+        if (keyed && FindContent(PANDA_ASSET_IMAGE, path, contentKey, data, match))
+        {
+            ++m_Hits;
+            return match.pImage;
+        }
+
+        ++m_Misses;
+        AssetLoadProfiler& profiler = m_Loader.GetProfiler();
+        int64_t parseStart = profiler.Now();
+        Image image = decoder(name, data);
+        profiler.RecordParse(name, parseStart, profiler.Now());
+        if (!image.Data)
+            return nullptr;
+
+        // the pixels live in the relocatable heap, so unloading scenes does not fragment the pools
+        std::shared_ptr<CachedImage> pImage = MakeShared<CachedImage>();
+        pImage->Pixels = RelocatableBuffer(image.Data, image.DataSize);
+        g_pMemoryManager->Free(image.Data, image.DataSize);
+        image.Data = nullptr;
+        pImage->Header = image;
+
+        if (keyed && FindContent(PANDA_ASSET_IMAGE, path, contentKey, data, match))
+            return match.pImage;
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        if (Entry* pEntry = Find(PANDA_ASSET_IMAGE, path))
+            return pEntry->pImage;
+
+        Entry entry;
+        entry.Kind = PANDA_ASSET_IMAGE;
+        entry.Paths.push_back(path);
+        entry.Name = name;
+        entry.HasContentKey = keyed;
+        entry.ContentKey = contentKey;
+        entry.Size = pImage->Pixels.GetDataSize();
+        entry.pImage = pImage;
+        Insert(std::move(entry));
+        TrimLocked();
+
+        return pImage;
+    }
+
+    void AssetCache::Prefetch(const char* name)
+    {
+        if (IsCached(name))
+            return;
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        if (m_PendingReads.count(name))
+            return;
+
+        m_PendingReads.emplace(name, m_Loader.AsyncOpenAndRead(name));
+    }
+
+    void AssetCache::Prefetch(const std::vector<std::string>& names)
+    {
+        std::vector<std::string> batch;
+        for (const auto& name : names)
+        {
+            if (IsCached(name.c_str()))
+                continue;
+
+            std::lock_guard<std::mutex> lock(m_Lock);
+            if (!m_PendingReads.count(name) && std::find(batch.begin(), batch.end(), name) == batch.end())
+                batch.push_back(name);
+        }
+        if (batch.empty())
+            return;
+
+        std::vector<std::future<Buffer>> reads = m_Loader.AsyncOpenAndReadBatch(batch);
+        std::lock_guard<std::mutex> lock(m_Lock);
+        for (size_t i = 0; i < batch.size(); ++i)
+            m_PendingReads.emplace(batch[i], std::move(reads[i]));
+    }
+
+    bool AssetCache::IsCached(const char* name)
+    {
+        std::string path = m_Loader.ResolvePath(name);
+        if (path.empty())
+            return false;
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        for (uint32_t kind = 0; kind < PANDA_ASSET_KIND_COUNT; ++kind)
+        {
+            if (m_ByPath[kind].count(path))
+                return true;
+        }
+
+        return false;
+    }
+
+    void AssetCache::SetBudget(size_t budget)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Budget = budget;
+        TrimLocked();
+    }
+
+    size_t AssetCache::GetCachedBytes()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        return m_CachedBytes;
+    }
+
+    size_t AssetCache::GetEntryCount()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        return m_Entries.size();
+    }
+
+    void AssetCache::Trim()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        TrimLocked();
+    }
+
+    void AssetCache::Clear()
+    {
+        std::unordered_map<std::string, std::future<Buffer>> pendingReads;
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            m_Entries.clear();
+            for (uint32_t kind = 0; kind < PANDA_ASSET_KIND_COUNT; ++kind)
+            {
+                m_ByPath[kind].clear();
+                m_ByContent[kind].clear();
+            }
+            m_CachedBytes = 0;
+            pendingReads.swap(m_PendingReads);
+        }
+    }
+
+    AssetCache::Entry* AssetCache::Find(AssetKind kind, const std::string& path)
+    {
+        auto iter = m_ByPath[kind].find(path);
+        if (iter == m_ByPath[kind].end())
+            return nullptr;
+
+        m_Entries.splice(m_Entries.begin(), m_Entries, iter->second);
+        return &*iter->second;
+    }
+
+    /**
+     * A new path with known content is remembered, the next lookup by that path
+     * needs no hashing. The candidate is taken under m_Lock, compared without it
+     * (for an image that maps its file again), and only added to when it is still
+     * cached afterwards.
+     */
+    bool AssetCache::FindContent(AssetKind kind, const std::string& path, uint64_t contentKey, const BufferView& data, Match& match)
+    {
+        auto take = [&match](const Entry& entry) {
+            match.Name = entry.Name;
+            match.pBuffer = entry.pBuffer;
+            match.pImage = entry.pImage;
+            return true;
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            if (Entry* pEntry = Find(kind, path))
+                return take(*pEntry);
+
+            auto iter = m_ByContent[kind].find(contentKey);
+            if (iter == m_ByContent[kind].end())
+                return false;
+            take(*iter->second);
+        }
+
+        if (!IsSameContent(match, data))
+            return false;
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        if (Entry* pEntry = Find(kind, path))
+            return take(*pEntry);
+
+        // the candidate may have been dropped or its key taken over while it was compared
+        auto iter = m_ByContent[kind].find(contentKey);
+        if (iter == m_ByContent[kind].end() || iter->second->pBuffer != match.pBuffer || iter->second->pImage != match.pImage)
+            return false;
+
+        iter->second->Paths.push_back(path);
+        m_ByPath[kind].emplace(path, iter->second);
+        m_Entries.splice(m_Entries.begin(), m_Entries, iter->second);
+        return true;
+    }
+
+    AssetCache::Entry* AssetCache::Insert(Entry&& entry)
+    {
+        m_Entries.push_front(std::move(entry));
+        EntryIterator iter = m_Entries.begin();
+        for (const auto& path : iter->Paths)
+            m_ByPath[iter->Kind][path] = iter;
+        if (iter->HasContentKey)
+            m_ByContent[iter->Kind][iter->ContentKey] = iter;
+        m_CachedBytes += iter->Size;
+        return &*iter;
+    }
+
+    void AssetCache::Evict(EntryIterator iter)
+    {
+        for (const auto& path : iter->Paths)
+            m_ByPath[iter->Kind].erase(path);
+        // other content with the same key may have taken the key over, or it was never keyed
+        auto content = m_ByContent[iter->Kind].find(iter->ContentKey);
+        if (content != m_ByContent[iter->Kind].end() && content->second == iter)
+            m_ByContent[iter->Kind].erase(content);
+        m_CachedBytes -= iter->Size;
+        m_Entries.erase(iter);
+    }
+
+    void AssetCache::TrimLocked()
+    {
+        auto iter = m_Entries.end();
+        while (m_CachedBytes > m_Budget && iter != m_Entries.begin())
+        {
+            --iter;
+            if (!iter->IsInUse())
+                Evict(iter++);
+        }
+    }
+
+    bool AssetCache::TakePendingRead(const char* name, Buffer& buffer)
+    {
+        std::future<Buffer> read;
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            auto iter = m_PendingReads.find(name);
+            if (iter == m_PendingReads.end())
+                return false;
+            read = std::move(iter->second);
+            m_PendingReads.erase(iter);
+        }
+
+        buffer = read.get();
+        return buffer.GetData() != nullptr;
+    }
+
+    void AssetCache::DropPendingRead(const char* name)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_PendingReads.erase(name);
+    }
+
+    uint64_t AssetCache::HashContent(const BufferView& data)
+    {
+        // two independent 32 bit checksums, zlib has fast versions of both
+        uLong crc = crc32(0L, Z_NULL, 0);
+        uLong adler = adler32(0L, Z_NULL, 0);
+        const uint8_t* p = data.GetData();
+        size_t size = data.GetDataSize();
+        while (size > 0)
+        {
+            uInt chunk = static_cast<uInt>(std::min<size_t>(size, 1u << 30));
+            crc = crc32(crc, p, chunk);
+            adler = adler32(adler, p, chunk);
+            p += chunk;
+            size -= chunk;
+        }
+
+        return (static_cast<uint64_t>(crc) << 32) | static_cast<uint32_t>(adler);
+    }
+
+    /**
+     * An image entry only holds the pixels, its file is read again to compare.
+     * That happens once for each copy of a file under a new name, from then on
+     * the copy is found by its path.
+     */
+    bool AssetCache::IsSameContent(const Match& match, const BufferView& data)
+    {
+        BufferView cached = match.pBuffer ? BufferView(match.pBuffer) : m_Loader.SyncOpenAndMapBinary(match.Name.c_str());
+        return cached.GetDataSize() == data.GetDataSize()
+            && memcmp(cached.GetData(), data.GetData(), data.GetDataSize()) == 0;
+    }
+}
@@ -0,0 +1,136 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "BufferView.hpp"
+#include "Image.hpp"
+#include "RelocatableBuffer.hpp"
+
+namespace Panda
+{
+    class AssetLoader;
+
+    // a decoded image shared through the cache, Header.Data is nullptr and the pixels are in Pixels
+    struct CachedImage
+    {
+        Image Header;
+        RelocatableBuffer Pixels;
+    };
+
+    // decodes a whole image file, Image::Data is allocated from g_pMemoryManager, nullptr when it fails
+    typedef std::function<Image(const std::string& name, const BufferView& data)> ImageDecoder;
+
+    /**
+     * Loads every asset once, however many times it is asked for.
+     * Assets are keyed by the path the name resolves to. With content keying
+     * on, a miss also hashes the whole file, so copies of a file under different
+     * names are decoded once too, after their bytes are compared. That costs a
+     * pass over every file loaded, so it is off unless SetContentKeying() turns
+     * it on. The cache hands out shared_ptrs. An asset only the cache
+     * still holds is evicted, least recently used first, once the cached bytes
+     * go over the budget. Assets in use are never evicted.
+     */
+    class AssetCache
+    {
+        public:
+            static const size_t k_DefaultBudget = 256 * 1024 * 1024;
+
+            explicit AssetCache(AssetLoader& loader, size_t budget = k_DefaultBudget);
+
+            // nullptr when the file can not be read
+            std::shared_ptr<const Buffer> LoadBuffer(const char* name);
+            // decoder only runs on a miss, nullptr when the file can not be read or decoded
+            std::shared_ptr<const CachedImage> LoadImage(const char* name, const ImageDecoder& decoder);
+
+            // start reading the file on the I/O workers unless it is cached already, the next Load*() picks it up
+            void Prefetch(const char* name);
+            // the same for many files, read together as one batch
+            void Prefetch(const std::vector<std::string>& names);
+
+            bool IsCached(const char* name);
+
+            // also key assets by their content, for asset sets that ship the same file under several names
+            void SetContentKeying(bool enable) {m_ContentKeying = enable;}
+            bool IsContentKeying() const {return m_ContentKeying;}
+
+            void SetBudget(size_t budget);
+            size_t GetBudget() const {return m_Budget;}
+            size_t GetCachedBytes();
+            size_t GetEntryCount();
+            uint64_t GetHitCount() const {return m_Hits;}
+            uint64_t GetMissCount() const {return m_Misses;}
+
+            // evict unused assets until the cache fits into the budget
+            void Trim();
+            // drop everything the cache holds, the assets still in use live on with their users
+            void Clear();
+
+        private:
+            enum AssetKind
+            {
+                PANDA_ASSET_BUFFER  = 0,
+                PANDA_ASSET_IMAGE   = 1,
+                PANDA_ASSET_KIND_COUNT
+            };
+
+            struct Entry
+            {
+                AssetKind Kind;
+                std::vector<std::string> Paths;     // every resolved path that led here
+                std::string Name;                   // the name it was loaded by first, to read the content again
+                bool HasContentKey;                 // loaded with content keying on
+                uint64_t ContentKey;
+                size_t Size;
+                std::shared_ptr<const Buffer> pBuffer;
+                std::shared_ptr<const CachedImage> pImage;
+
+                bool IsInUse() const {return pBuffer.use_count() > 1 || pImage.use_count() > 1;}
+            };
+            typedef std::list<Entry>::iterator EntryIterator;
+
+            // what a lookup hands back, held by reference so it can be used after m_Lock is released
+            struct Match
+            {
+                std::string Name;
+                std::shared_ptr<const Buffer> pBuffer;
+                std::shared_ptr<const CachedImage> pImage;
+            };
+
+            // the entry moves to the front of the LRU list, m_Lock has to be held
+            Entry* Find(AssetKind kind, const std::string& path);
+            // m_Lock must not be held, the content is compared without it
+            bool FindContent(AssetKind kind, const std::string& path, uint64_t contentKey, const BufferView& data, Match& match);
+            Entry* Insert(Entry&& entry);
+            void Evict(EntryIterator iter);
+            void TrimLocked();
+
+            // takes the read Prefetch() started for the name, if any
+            bool TakePendingRead(const char* name, Buffer& buffer);
+            void DropPendingRead(const char* name);
+
+            static uint64_t HashContent(const BufferView& data);
+            // the key only makes equal content likely, a hit is compared byte by byte
+            bool IsSameContent(const Match& match, const BufferView& data);
+
+        private:
+            AssetLoader& m_Loader;
+            size_t m_Budget;
+            size_t m_CachedBytes;
+            std::atomic<uint64_t> m_Hits;
+            std::atomic<uint64_t> m_Misses;
+            std::atomic<bool> m_ContentKeying;
+
+            std::mutex m_Lock;
+            std::list<Entry> m_Entries;     // most recently used first
+            std::unordered_map<std::string, EntryIterator> m_ByPath[PANDA_ASSET_KIND_COUNT];
+            std::unordered_map<uint64_t, EntryIterator> m_ByContent[PANDA_ASSET_KIND_COUNT];
+            std::unordered_map<std::string, std::future<Buffer>> m_PendingReads;
+    };
+}
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "AssetDependencyGraph.hpp"
+
+namespace Panda
+{
+    static thread_local uint32_t t_ResolveConcurrency = 0;
+
+    uint32_t AssetDependencyGraph::GetResolveConcurrency()
+    {
+        return t_ResolveConcurrency;
+    }
+
+    static std::string NodeKey(AssetNodeKind kind, const std::string& name)
+    {
+        return std::to_string(kind) + ":" + name;
+    }
+
+    uint32_t AssetDependencyGraph::AddNode(AssetNodeKind kind, const std::string& name)
+    {
+        auto result = m_NodeIndex.emplace(NodeKey(kind, name), static_cast<uint32_t>(m_Nodes.size()));
+        if (result.second)
+        {
+            Node node;
+            node.Kind = kind;
+            node.Name = name;
+            m_Nodes.push_back(std::move(node));
+        }
+
+        return result.first->second;
+    }
+
+    uint32_t AssetDependencyGraph::FindNode(AssetNodeKind kind, const std::string& name) const
+    {
+        auto iter = m_NodeIndex.find(NodeKey(kind, name));
+        return iter == m_NodeIndex.end() ? k_InvalidNode : iter->second;
+    }
+
+    void AssetDependencyGraph::AddDependency(uint32_t node, uint32_t dependency)
+    {
+        std::vector<uint32_t>& dependencies = m_Nodes[node].Dependencies;
+        if (std::find(dependencies.begin(), dependencies.end(), dependency) != dependencies.end())
+            return;
+
+        dependencies.push_back(dependency);
+        m_Nodes[dependency].Dependents.push_back(node);
+    }
+
+    void AssetDependencyGraph::AddDependency(AssetNodeKind kind, const std::string& name,
+        AssetNodeKind dependencyKind, const std::string& dependencyName)
+    {
+        uint32_t node = AddNode(kind, name);
+        AddDependency(node, AddNode(dependencyKind, dependencyName));
+    }
+
+    void AssetDependencyGraph::SetResolveFunction(uint32_t node, ResolveFunction resolve)
+    {
+        m_Nodes[node].Resolve = std::move(resolve);
+    }
+
+    void AssetDependencyGraph::Clear()
+    {
+        m_Nodes.clear();
+        m_NodeIndex.clear();
+    }
+
+    /**
+     * Every thread takes a ready node, resolves it without the lock held, and
+     * makes ready what was only waiting for it. A thread stops when nothing is
+     * ready and nothing is running, so nothing can become ready any more.
+     */
+    bool AssetDependencyGraph::Resolve(uint32_t maxConcurrency)
+    {
+        if (maxConcurrency == k_DefaultConcurrency)
+            maxConcurrency = std::max(std::thread::hardware_concurrency(), 1u);
+
+        std::vector<uint32_t> waitingOn(m_Nodes.size());    // dependencies not resolved yet
+        std::vector<uint32_t> ready;                        // taken from the back, so the first nodes go first
+        for (size_t i = m_Nodes.size(); i > 0; --i)
+        {
+            waitingOn[i - 1] = static_cast<uint32_t>(m_Nodes[i - 1].Dependencies.size());
+            if (waitingOn[i - 1] == 0)
+                ready.push_back(static_cast<uint32_t>(i - 1));
+        }
+
+        size_t resolved = 0;
+        uint32_t running = 0;
+        std::mutex lock;
+        std::condition_variable condition;
+
+        // the calling thread resolves nodes too
+        size_t threadCount = std::min<size_t>(maxConcurrency, m_Nodes.size());
+
+        auto resolveNodes = [&]() {
+            // a graph may be resolved from a node of another one, the calling thread goes back to that
+            uint32_t outerConcurrency = t_ResolveConcurrency;
+            t_ResolveConcurrency = static_cast<uint32_t>(std::max<size_t>(threadCount, 1));
+
+            std::unique_lock<std::mutex> guard(lock);
+            for (;;)
+            {
+                condition.wait(guard, [&] { return !ready.empty() || running == 0; });
+                if (ready.empty())
+                {
+                    t_ResolveConcurrency = outerConcurrency;
+                    return;
+                }
+
+                uint32_t node = ready.back();
+                ready.pop_back();
+                ++running;
+
+                guard.unlock();
+                if (m_Nodes[node].Resolve)
+                    m_Nodes[node].Resolve();
+                guard.lock();
+
+                --running;
+                ++resolved;
+                for (uint32_t dependent : m_Nodes[node].Dependents)
+                {
+                    if (--waitingOn[dependent] == 0)
+                        ready.push_back(dependent);
+                }
+                condition.notify_all();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < threadCount; ++i)
+            threads.emplace_back(resolveNodes);
+        resolveNodes();
+        for (auto& thread : threads)
+            thread.join();
+
+        return resolved == m_Nodes.size();
+    }
+}
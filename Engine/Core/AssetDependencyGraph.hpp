@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace Panda
+{
+    enum AssetNodeKind
+    {
+        PANDA_ASSET_NODE_SCENE      = 0,
+        PANDA_ASSET_NODE_GEOMETRY   = 1,
+        PANDA_ASSET_NODE_MATERIAL   = 2,
+        PANDA_ASSET_NODE_TEXTURE    = 3
+    };
+
+    /**
+     * What an asset needs loaded before it can be loaded itself, e.g. a scene
+     * needs its geometries, a geometry its materials, a material its textures.
+     * The parsers add the edges while they read the scene file, the loader
+     * attaches the work of each node and Resolve() runs it: every node after
+     * the ones it depends on, nodes that do not depend on each other in
+     * parallel.
+     *
+     * Building the graph is not thread safe, resolving it is done by one call at a time.
+     */
+    class AssetDependencyGraph
+    {
+        public:
+            typedef std::function<void()> ResolveFunction;
+
+            static const uint32_t k_InvalidNode = UINT32_MAX;
+            // as many threads as the machine has cores
+            static const uint32_t k_DefaultConcurrency = 0;
+
+            // a node is its kind and name, adding it again returns the one already there
+            uint32_t AddNode(AssetNodeKind kind, const std::string& name);
+            uint32_t FindNode(AssetNodeKind kind, const std::string& name) const;
+            // node can only be resolved once dependency is
+            void AddDependency(uint32_t node, uint32_t dependency);
+            // adds the nodes too when they are new
+            void AddDependency(AssetNodeKind kind, const std::string& name,
+                AssetNodeKind dependencyKind, const std::string& dependencyName);
+
+            // nodes without a function resolve as soon as their dependencies have
+            void SetResolveFunction(uint32_t node, ResolveFunction resolve);
+
+            size_t GetNodeCount() const {return m_Nodes.size();}
+            AssetNodeKind GetKind(uint32_t node) const {return m_Nodes[node].Kind;}
+            const std::string& GetName(uint32_t node) const {return m_Nodes[node].Name;}
+            const std::vector<uint32_t>& GetDependencies(uint32_t node) const {return m_Nodes[node].Dependencies;}
+
+            /**
+             * Run the resolve functions on up to maxConcurrency threads, the calling
+             * one included. Returns false when the dependencies form a cycle, the
+             * nodes on it and everything that depends on them are not resolved.
+             */
+            bool Resolve(uint32_t maxConcurrency = k_DefaultConcurrency);
+
+            /**
+             * The threads of the Resolve() the calling thread resolves nodes for, 0
+             * outside of one. Work a resolve function starts shares the cores with
+             * the other nodes, so it should not start one thread per core itself.
+             */
+            static uint32_t GetResolveConcurrency();
+
+            void Clear();
+
+        private:
+            struct Node
+            {
+                AssetNodeKind Kind;
+                std::string Name;
+                std::vector<uint32_t> Dependencies;
+                std::vector<uint32_t> Dependents;
+                ResolveFunction Resolve;
+            };
+
+            std::vector<Node> m_Nodes;
+            std::unordered_map<std::string, uint32_t> m_NodeIndex;     // kind and name to the node
+    };
+}
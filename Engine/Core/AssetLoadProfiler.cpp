@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include "AssetLoadProfiler.hpp"
+
+namespace Panda
+{
+    static int64_t SteadyMicroseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static int64_t PhaseEnd(const AssetLoadPhase& phase)
+    {
+        return phase.Start + phase.Duration;
+    }
+
+    // a step done twice for one record, e.g. a short read, covers both
+    static void MergePhase(AssetLoadPhase& phase, const AssetLoadPhase& more)
+    {
+        if (phase.Start < 0)
+        {
+            phase = more;
+            return;
+        }
+
+        int64_t end = std::max(PhaseEnd(phase), PhaseEnd(more));
+        phase.Start = std::min(phase.Start, more.Start);
+        phase.Duration = end - phase.Start;
+    }
+
+    void AssetLoadProfiler::Start()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Records.clear();
+        m_LatestRecords.clear();
+        m_Threads.clear();
+        m_Origin = SteadyMicroseconds();
+        m_IsEnabled = true;
+    }
+
+    void AssetLoadProfiler::Stop()
+    {
+        m_IsEnabled = false;
+    }
+
+    int64_t AssetLoadProfiler::Now() const
+    {
+        return SteadyMicroseconds() - m_Origin.load(std::memory_order_relaxed);
+    }
+
+    AssetLoadPhase AssetLoadProfiler::MakePhase(int64_t start, int64_t end)
+    {
+        auto result = m_Threads.emplace(std::this_thread::get_id(), static_cast<uint32_t>(m_Threads.size()));
+
+        AssetLoadPhase phase;
+        phase.Start = start;
+        phase.Duration = std::max<int64_t>(end - start, 0);
+        phase.Thread = result.first->second;
+        return phase;
+    }
+
+    AssetLoadRecord& AssetLoadProfiler::LatestRecord(const std::string& name)
+    {
+        auto iter = m_LatestRecords.find(name);
+        if (iter != m_LatestRecords.end())
+            return m_Records[iter->second];
+
+        // read or parsed without going through AssetLoader's open, e.g. a buffer decoded twice
+        m_LatestRecords.emplace(name, m_Records.size());
+        m_Records.emplace_back();
+        m_Records.back().Name = name;
+        return m_Records.back();
+    }
+
+    void AssetLoadProfiler::RecordOpen(const std::string& name, int64_t start, int64_t end)
+    {
+        if (!IsEnabled())
+            return;
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_LatestRecords[name] = m_Records.size();
+        m_Records.emplace_back();
+        m_Records.back().Name = name;
+        m_Records.back().Open = MakePhase(start, end);
+    }
+
+    void AssetLoadProfiler::RecordRead(const std::string& name, uint64_t bytes, int64_t start, int64_t end)
+    {
+        if (!IsEnabled())
+            return;
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        AssetLoadPhase phase = MakePhase(start, end);
+        AssetLoadRecord& record = LatestRecord(name);
+        MergePhase(record.Read, phase);
+        record.BytesRead += bytes;
+    }
+
+    void AssetLoadProfiler::RecordParse(const std::string& name, int64_t start, int64_t end)
+    {
+        if (!IsEnabled())
+            return;
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        AssetLoadPhase phase = MakePhase(start, end);
+        MergePhase(LatestRecord(name).Parse, phase);
+    }
+
+    std::vector<AssetLoadRecord> AssetLoadProfiler::GetRecords() const
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        return m_Records;
+    }
+
+    // from the first step started to the last one finished
+    static void RecordSpan(const AssetLoadRecord& record, int64_t& start, int64_t& end)
+    {
+        start = INT64_MAX;
+        end = 0;
+        for (const AssetLoadPhase* pPhase : {&record.Open, &record.Read, &record.Parse})
+        {
+            if (pPhase->Start < 0)
+                continue;
+            start = std::min(start, pPhase->Start);
+            end = std::max(end, PhaseEnd(*pPhase));
+        }
+        if (start > end)
+            start = end;
+    }
+
+    static double Milliseconds(int64_t microseconds)
+    {
+        return microseconds / 1000.0;
+    }
+
+    static double MegabytesPerSecond(uint64_t bytes, int64_t microseconds)
+    {
+        return microseconds > 0 ? bytes / static_cast<double>(microseconds) : 0.0;
+    }
+
+    void AssetLoadProfiler::WriteSummary(std::ostream& out) const
+    {
+        std::vector<AssetLoadRecord> records = GetRecords();
+        std::vector<std::pair<int64_t, size_t>> order;     // total time, record
+        int64_t wallStart = INT64_MAX;
+        int64_t wallEnd = 0;
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            int64_t start, end;
+            RecordSpan(records[i], start, end);
+            order.emplace_back(end - start, i);
+            wallStart = std::min(wallStart, start);
+            wallEnd = std::max(wallEnd, end);
+        }
+        std::sort(order.begin(), order.end(), [](const std::pair<int64_t, size_t>& a, const std::pair<int64_t, size_t>& b) {
+            return a.first > b.first;
+        });
+
+        char line[512];
+        snprintf(line, sizeof(line), "%-48s %10s %10s %12s %10s %10s %10s\n",
+            "Asset", "Open ms", "Read ms", "Bytes", "MB/s", "Parse ms", "Total ms");
+        out << line;
+
+        int64_t openTime = 0, readTime = 0, parseTime = 0;
+        uint64_t bytes = 0;
+        for (const auto& entry : order)
+        {
+            const AssetLoadRecord& record = records[entry.second];
+            snprintf(line, sizeof(line), "%-48s %10.3f %10.3f %12" PRIu64 " %10.1f %10.3f %10.3f\n",
+                record.Name.c_str(), Milliseconds(record.Open.Duration), Milliseconds(record.Read.Duration),
+                record.BytesRead, MegabytesPerSecond(record.BytesRead, record.Read.Duration),
+                Milliseconds(record.Parse.Duration), Milliseconds(entry.first));
+            out << line;
+
+            openTime += record.Open.Duration;
+            readTime += record.Read.Duration;
+            parseTime += record.Parse.Duration;
+            bytes += record.BytesRead;
+        }
+
+        // the steps of different assets overlap on the workers, so the sums may exceed the wall time
+        int64_t wallTime = records.empty() ? 0 : wallEnd - wallStart;
+        snprintf(line, sizeof(line), "%-48s %10.3f %10.3f %12" PRIu64 " %10.1f %10.3f %10.3f\n",
+            "Total", Milliseconds(openTime), Milliseconds(readTime), bytes, MegabytesPerSecond(bytes, readTime),
+            Milliseconds(parseTime), Milliseconds(wallTime));
+        out << line;
+
+        int64_t ioTime = openTime + readTime;
+        snprintf(line, sizeof(line), "%zu assets in %.3f ms wall time, %.3f ms in I/O and %.3f ms parsing: %s\n",
+            records.size(), Milliseconds(wallTime), Milliseconds(ioTime), Milliseconds(parseTime),
+            ioTime > parseTime ? "disk-bound" : "parse-bound");
+        out << line;
+    }
+
+    static void WriteJsonString(std::ostream& out, const std::string& text)
+    {
+        out << '"';
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out << '\\' << c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out << escaped;
+            }
+            else
+            {
+                out << c;
+            }
+        }
+        out << '"';
+    }
+
+    void AssetLoadProfiler::WriteChromeTrace(std::ostream& out) const
+    {
+        std::vector<AssetLoadRecord> records = GetRecords();
+        uint32_t threadCount;
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            threadCount = static_cast<uint32_t>(m_Threads.size());
+        }
+
+        out << "{\"traceEvents\": [" << std::endl;
+        bool isFirst = true;
+        for (uint32_t i = 0; i < threadCount; ++i)
+        {
+            out << (isFirst ? "" : ",\n") << "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << i
+                << ", \"args\": {\"name\": \"asset thread " << i << "\"}}";
+            isFirst = false;
+        }
+
+        for (const AssetLoadRecord& record : records)
+        {
+            const std::pair<const char*, const AssetLoadPhase*> phases[] = {
+                {"open", &record.Open}, {"read", &record.Read}, {"parse", &record.Parse}};
+            for (const auto& phase : phases)
+            {
+                if (phase.second->Start < 0)
+                    continue;
+
+                out << (isFirst ? "" : ",\n") << "  {\"name\": ";
+                WriteJsonString(out, std::string(phase.first) + " " + record.Name);
+                out << ", \"cat\": \"" << phase.first << "\", \"ph\": \"X\", \"pid\": 1"
+                    << ", \"tid\": " << phase.second->Thread
+                    << ", \"ts\": " << phase.second->Start
+                    << ", \"dur\": " << phase.second->Duration
+                    << ", \"args\": {\"asset\": ";
+                WriteJsonString(out, record.Name);
+                out << ", \"bytes\": " << record.BytesRead << "}}";
+                isFirst = false;
+            }
+        }
+        out << std::endl << "], \"displayTimeUnit\": \"ms\"}" << std::endl;
+    }
+}
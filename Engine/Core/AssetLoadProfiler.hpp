@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+namespace Panda
+{
+    // one step of loading an asset, in microseconds since the profiler started
+    struct AssetLoadPhase
+    {
+        int64_t Start = -1;     // -1 when the asset never went through the step
+        int64_t Duration = 0;
+        uint32_t Thread = 0;    // small ids, in the order the threads first showed up
+    };
+
+    struct AssetLoadRecord
+    {
+        std::string Name;
+        AssetLoadPhase Open;    // finding and opening the file, or the archive entry
+        AssetLoadPhase Read;    // getting the bytes into memory, inflating archive entries included
+        AssetLoadPhase Parse;   // decoding, until the parser finished
+        uint64_t BytesRead = 0;
+    };
+
+    /**
+     * Where the time of loading assets goes, for telling a disk-bound load from
+     * a parse-bound one. AssetLoader records the open and read of every asset,
+     * the callers of the parsers record the parse. Nothing is recorded until
+     * Start(), a disabled profiler costs one atomic load per call.
+     */
+    class AssetLoadProfiler
+    {
+        public:
+            // forgets what was recorded before
+            void Start();
+            void Stop();
+            bool IsEnabled() const {return m_IsEnabled.load(std::memory_order_relaxed);}
+
+            // microseconds on the profiler's clock, pass them to the Record calls
+            int64_t Now() const;
+
+            // a second open of a name starts a new record, the other steps go to the latest one
+            void RecordOpen(const std::string& name, int64_t start, int64_t end);
+            void RecordRead(const std::string& name, uint64_t bytes, int64_t start, int64_t end);
+            void RecordParse(const std::string& name, int64_t start, int64_t end);
+
+            std::vector<AssetLoadRecord> GetRecords() const;
+
+            // one row per asset, slowest first, and the totals
+            void WriteSummary(std::ostream& out) const;
+            // complete events for chrome://tracing or Perfetto, one track per thread
+            void WriteChromeTrace(std::ostream& out) const;
+
+        private:
+            AssetLoadRecord& LatestRecord(const std::string& name);
+            AssetLoadPhase MakePhase(int64_t start, int64_t end);
+
+        private:
+            std::atomic<bool> m_IsEnabled{false};
+            std::atomic<int64_t> m_Origin{0};
+
+            std::vector<AssetLoadRecord> m_Records;
+            std::unordered_map<std::string, size_t> m_LatestRecords;   // name to its latest record
+            std::unordered_map<std::thread::id, uint32_t> m_Threads;
+            mutable std::mutex m_Lock;
+    };
+}
@@ -1,24 +1,225 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <set>
 #include "AssetLoader.hpp"
 
 namespace Panda
 {
+    static const uint32_t k_IoWorkerCount = 2;     // reads are I/O bound, a couple of threads keep the disk busy
+    static const int32_t k_MaxParentLevels = 10;    // how far up the hierarchy OpenFile() looks for Asset/
+
     int AssetLoader::Initialize()
     {
+        StartWorkers();
         return 0;
     }
 
     void AssetLoader::Finalize()
     {
+        StopWorkers();
+
+        {
+            std::lock_guard<std::mutex> lock(m_CompletionLock);
+            m_Completions.clear();
+        }
+        m_PendingAsyncCount = 0;
+        m_Cache.Clear();
+
+        m_Replay.StopReadahead();
+        m_IsRecording = false;
+        m_Recording.Clear();
+
+        std::lock_guard<std::mutex> lock(m_SearchPathLock);
         m_SearchPath.clear();
+        m_Archives.clear();
+        m_ResolvedPaths.clear();
+        ++m_SearchPathVersion;
     }
 
+    /**
+     * Deliver the finished async reads. The list is swapped out first, so the
+     * callbacks can queue further reads.
+     */
     void AssetLoader::Tick()
     {
+        std::vector<AsyncCompletion> completions;
+        {
+            std::lock_guard<std::mutex> lock(m_CompletionLock);
+            completions.swap(m_Completions);
+        }
+
+        for (auto& completion : completions)
+        {
+            completion.Callback(completion.Name, completion.Data);
+            m_PendingAsyncCount.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+
+    // std heap functions keep the largest element at the front
+    static bool LowerPriority(AssetLoader::AssetLoadPriority a, uint64_t aSequence,
+        AssetLoader::AssetLoadPriority b, uint64_t bSequence)
+    {
+        if (a != b)
+            return a < b;
+        return aSequence > bSequence;
+    }
+
+    void AssetLoader::AsyncOpenAndRead(const char* name, AssetLoadPriority priority, AssetLoadCallback callback,
+        AssetOpenMode mode)
+    {
+        AsyncRequest request;
+        request.Name = name;
+        request.Mode = mode;
+        request.Priority = priority;
+        request.Callback = std::move(callback);
+        QueueRequest(std::move(request));
+    }
+
+    std::future<Buffer> AssetLoader::AsyncOpenAndRead(const char* name, AssetLoadPriority priority, AssetOpenMode mode)
+    {
+        AsyncRequest request;
+        request.Name = name;
+        request.Mode = mode;
+        request.Priority = priority;
+        request.pPromise = std::make_shared<std::promise<Buffer>>();
+        std::future<Buffer> future = request.pPromise->get_future();
+        QueueRequest(std::move(request));
+        return future;
+    }
+
+    std::vector<std::future<Buffer>> AssetLoader::AsyncOpenAndReadBatch(const std::vector<std::string>& names,
+        AssetLoadPriority priority, AssetOpenMode mode)
+    {
+        AsyncRequest request;
+        request.Mode = mode;
+        request.Priority = priority;
+        request.BatchNames = names;
+        request.BatchPromises.resize(names.size());
+
+        std::vector<std::future<Buffer>> futures;
+        for (auto& promise : request.BatchPromises)
+            futures.push_back(promise.get_future());
+        if (!names.empty())
+            QueueRequest(std::move(request));
+        return futures;
+    }
+
+    void AssetLoader::QueueRequest(AsyncRequest&& request)
+    {
+        m_PendingAsyncCount.fetch_add(1, std::memory_order_acq_rel);
+        {
+            std::lock_guard<std::mutex> lock(m_RequestLock);
+            request.Sequence = m_NextSequence++;
+            m_Requests.push_back(std::move(request));
+            std::push_heap(m_Requests.begin(), m_Requests.end(), [](const AsyncRequest& a, const AsyncRequest& b) {
+                return LowerPriority(a.Priority, a.Sequence, b.Priority, b.Sequence);
+            });
+        }
+        m_RequestCondition.notify_one();
+    }
+
+    void AssetLoader::WorkerThread()
+    {
+        for (;;)
+        {
+            AsyncRequest request;
+            {
+                std::unique_lock<std::mutex> lock(m_RequestLock);
+                m_RequestCondition.wait(lock, [this]() { return m_IsStopping || !m_Requests.empty(); });
+                if (m_IsStopping)
+                    return;
+
+                std::pop_heap(m_Requests.begin(), m_Requests.end(), [](const AsyncRequest& a, const AsyncRequest& b) {
+                    return LowerPriority(a.Priority, a.Sequence, b.Priority, b.Sequence);
+                });
+                request = std::move(m_Requests.back());
+                m_Requests.pop_back();
+            }
+
+            if (!request.BatchNames.empty())
+            {
+                // each future is ready as soon as its own file is, not when the whole batch is.
+                // The request stops being pending before the last one is ready, so whoever waits
+                // on the futures never sees it pending afterwards
+                std::atomic<size_t> delivered{0};
+                ReadBatch(request.BatchNames, request.Mode, [this, &request, &delivered](size_t index, Buffer&& buffer) {
+                    if (++delivered == request.BatchPromises.size())
+                        m_PendingAsyncCount.fetch_sub(1, std::memory_order_acq_rel);
+                    request.BatchPromises[index].set_value(std::move(buffer));
+                });
+                continue;
+            }
+
+            Buffer buffer = request.Mode == PANDA_OPEN_TEXT ? SyncOpenAndReadText(request.Name.c_str())
+                                                            : SyncOpenAndReadBinary(request.Name.c_str());
+
+            if (request.pPromise)
+            {
+                m_PendingAsyncCount.fetch_sub(1, std::memory_order_acq_rel);
+                request.pPromise->set_value(std::move(buffer));
+            }
+            else
+            {
+                AsyncCompletion completion;
+                completion.Name = std::move(request.Name);
+                completion.Data = std::move(buffer);
+                completion.Callback = std::move(request.Callback);
+
+                std::lock_guard<std::mutex> lock(m_CompletionLock);
+                m_Completions.push_back(std::move(completion));
+            }
+        }
+    }
+
+    void AssetLoader::StartWorkers()
+    {
+        if (!m_Workers.empty())
+            return;
+
+        m_IsStopping = false;
+        for (uint32_t i = 0; i < k_IoWorkerCount; ++i)
+            m_Workers.emplace_back(&AssetLoader::WorkerThread, this);
+    }
+
+    /**
+     * Reads in flight are finished, queued ones are dropped. Their futures
+     * get an empty Buffer, their callbacks are never called.
+     */
+    void AssetLoader::StopWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_RequestLock);
+            m_IsStopping = true;
+        }
+        m_RequestCondition.notify_all();
 
+        for (auto& worker : m_Workers)
+            worker.join();
+        m_Workers.clear();
+
+        for (auto& request : m_Requests)
+        {
+            if (request.pPromise)
+                request.pPromise->set_value(Buffer());
+            for (auto& promise : request.BatchPromises)
+                promise.set_value(Buffer());
+        }
+        m_Requests.clear();
+    }
+
+    static bool IsArchivePath(const char* path)
+    {
+        size_t length = strlen(path);
+        return length > 4 && strcmp(path + length - 4, ".pak") == 0;
     }
 
     bool AssetLoader::AddSearchPath(const char* path)
     {
+        if (IsArchivePath(path))
+            return MountArchive(path);
+
+        std::lock_guard<std::mutex> lock(m_SearchPathLock);
         std::vector<std::string>::iterator iter = m_SearchPath.begin();
 
         while (iter != m_SearchPath.end())
@@ -30,11 +231,22 @@ namespace Panda
         }
 
         m_SearchPath.push_back(path);
+        m_ResolvedPaths.clear();
+        ++m_SearchPathVersion;
         return true;
     }
 
     bool AssetLoader::RemoveSearchPath(const char* path)
     {
+        std::lock_guard<std::mutex> lock(m_SearchPathLock);
+        if (IsArchivePath(path))
+        {
+            // reads in flight keep their archive alive through the shared_ptr
+            m_Archives.erase(std::remove_if(m_Archives.begin(), m_Archives.end(),
+                [path](const MountedArchive& archive) { return archive.Path == path; }), m_Archives.end());
+            return true;
+        }
+
         std::vector<std::string>::iterator iter = m_SearchPath.begin();
 
         while (iter != m_SearchPath.end())
@@ -42,6 +254,8 @@ namespace Panda
             if (!(*iter).compare(path))
             {
                 m_SearchPath.erase(iter);
+                m_ResolvedPaths.clear();
+                ++m_SearchPathVersion;
                 return true;
             }
 
@@ -51,11 +265,66 @@ namespace Panda
         return true;
     }
 
+    /**
+     * The archive is looked for up the hierarchy like the Asset directories.
+     */
+    bool AssetLoader::MountArchive(const char* path)
+    {
+        std::string upPath;
+        for (int32_t i = 0; i < k_MaxParentLevels; ++i)
+        {
+            std::string fullPath = upPath + path;
+            std::shared_ptr<AssetArchive> pArchive = MakeShared<AssetArchive>();
+            if (pArchive->Open(fullPath.c_str()))
+            {
+                std::lock_guard<std::mutex> lock(m_SearchPathLock);
+                for (const auto& archive : m_Archives)
+                {
+                    if (archive.Path == path)
+                        return true;
+                }
+
+                MountedArchive archive;
+                archive.Path = path;
+                archive.FullPath = std::filesystem::absolute(fullPath).lexically_normal().string();
+                archive.pArchive = std::move(pArchive);
+                m_Archives.push_back(std::move(archive));
+                return true;
+            }
+
+            upPath.append("../");
+        }
+
+        fprintf(stderr, "Error mounting archive '%s'\n", path);
+        return false;
+    }
+
+    const AssetArchiveEntry* AssetLoader::FindInArchives(const char* name, std::shared_ptr<AssetArchive>& pArchive)
+    {
+        std::lock_guard<std::mutex> lock(m_SearchPathLock);
+        for (const auto& archive : m_Archives)
+        {
+            if (const AssetArchiveEntry* pEntry = archive.pArchive->Find(name))
+            {
+                if (m_IsRecording.load(std::memory_order_relaxed))
+                    m_Recording.Record(archive.FullPath, pEntry->Offset, pEntry->StoredSize);
+                pArchive = archive.pArchive;
+                return pEntry;
+            }
+        }
+
+        return nullptr;
+    }
+
     /**
      * Try to open the file to check if it exsits.
      */ 
     bool AssetLoader::FileExists(const char* filePath)
     {
+        std::shared_ptr<AssetArchive> pArchive;
+        if (FindInArchives(filePath, pArchive))
+            return true;
+
         AssetFilePtr fp = OpenFile(filePath, PANDA_OPEN_BINARY);
         if (fp != nullptr)
         {
@@ -66,98 +335,294 @@ namespace Panda
         return false;
     }
 
+    void AssetLoader::InvalidatePathCache()
+    {
+        std::lock_guard<std::mutex> lock(m_SearchPathLock);
+        m_ResolvedPaths.clear();
+        ++m_SearchPathVersion;
+    }
+
     /**
-     * Search the directories to open the file.
-     * It will try some parent directories.
-     */ 
-    AssetLoader::AssetFilePtr AssetLoader::OpenFile(const char* name, AssetOpenMode mode)
+     * Answered from the path cache, so a cache hit costs no file system call.
+     * Only a name that has not been looked up before is probed, once.
+     */
+    std::string AssetLoader::ResolvePath(const char* name)
     {
-        FILE* fp = nullptr;
-        // loop N times up the hierarchy, testing at each level
-        std::string upPath;
         std::string fullPath;
-        for (int32_t i = 0; i < 10; ++i)
+        uint64_t version;
         {
-            std::vector<std::string>::iterator iter = m_SearchPath.begin();
-            bool looping = true;
-
-            while (looping)
+            std::lock_guard<std::mutex> lock(m_SearchPathLock);
+            for (const auto& archive : m_Archives)
             {
-                fullPath.assign(upPath);    // reset to current upPath
-                if (iter != m_SearchPath.end())
-                {
-                    fullPath.append(*iter);
-                    fullPath.append("/Asset/");
-                    ++iter;
-                }
-                else
-                {
-                    fullPath.append("Asset/");
-                    looping = false;
-                }
-                fullPath.append(name);
-    //#ifdef DEBUG
-                fprintf(stderr, "Trying to open %s\n", fullPath.c_str());
-    //#endif
-                switch(mode)
-                {
-                    case PANDA_OPEN_TEXT:
-                        fp = fopen(fullPath.c_str(), "r");
-                        break;
-                    case PANDA_OPEN_BINARY:
-                        fp = fopen(fullPath.c_str(), "rb");
-                        break;
-                }
+                if (archive.pArchive->Find(name))
+                    return archive.Path + ":" + name;
+            }
 
-                if (fp)
-                    return (AssetFilePtr)fp;
+            version = m_SearchPathVersion;
+            auto iter = m_ResolvedPaths.find(name);
+            if (iter != m_ResolvedPaths.end())
+            {
+                if (iter->second.empty())
+                    return std::string();
+                fullPath = iter->second;
             }
+        }
+
+        if (fullPath.empty())
+        {
+            FILE* fp = ProbeFile(name, "rb", fullPath);
+            if (fp)
+                fclose(fp);
+
+            std::lock_guard<std::mutex> lock(m_SearchPathLock);
+            if (version == m_SearchPathVersion)
+                m_ResolvedPaths[name] = fullPath;
+            if (fullPath.empty())
+                return std::string();
+        }
+
+        // "Asset/a.png" and "Asset/Textures/../a.png" are the same file
+        return std::filesystem::path(fullPath).lexically_normal().generic_string();
+    }
+
+    std::vector<std::string> AssetLoader::GetAssetDirectories()
+    {
+        std::vector<std::string> searchPath;
+        {
+            std::lock_guard<std::mutex> lock(m_SearchPathLock);
+            searchPath = m_SearchPath;
+        }
+
+        std::vector<std::string> directories;
+        std::string upPath;
+        for (int32_t i = 0; i < k_MaxParentLevels; ++i)
+        {
+            for (const auto& path : searchPath)
+                directories.push_back(upPath + path + "/Asset/");
+            directories.push_back(upPath + "Asset/");
 
             upPath.append("../");
         }
 
+        return directories;
+    }
+
+    /**
+     * Index every directory in probing order, the first file found under a name
+     * wins like it does in ProbeFile(). The walk runs without the lock held.
+     */
+    size_t AssetLoader::BuildDirectoryIndex()
+    {
+        uint64_t version;
+        {
+            std::lock_guard<std::mutex> lock(m_SearchPathLock);
+            version = m_SearchPathVersion;
+        }
+
+        std::unordered_map<std::string, std::string> index;
+        std::set<std::filesystem::path> visited;   // the parent levels often reach the same directory twice
+        for (const auto& directory : GetAssetDirectories())
+        {
+            std::error_code error;
+            std::filesystem::path canonical = std::filesystem::canonical(directory, error);
+            if (error || !std::filesystem::is_directory(canonical, error) || !visited.insert(canonical).second)
+                continue;
+
+            auto options = std::filesystem::directory_options::skip_permission_denied;
+            for (std::filesystem::recursive_directory_iterator iter(directory, options, error), end;
+                 !error && iter != end; iter.increment(error))
+            {
+                if (!iter->is_regular_file(error))
+                    continue;
+
+                std::string name = iter->path().lexically_relative(directory).generic_string();
+                index.emplace(name, directory + name);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_SearchPathLock);
+        if (version != m_SearchPathVersion)
+            return 0;   // the search paths changed under us, the index would be wrong
+
+        for (auto& entry : index)
+            m_ResolvedPaths[entry.first] = std::move(entry.second);
+
+        return index.size();
+    }
+
+    FILE* AssetLoader::ProbeFile(const char* name, const char* mode, std::string& fullPath)
+    {
+        for (const auto& directory : GetAssetDirectories())
+        {
+            fullPath.assign(directory);
+            fullPath.append(name);
+    #ifdef DEBUG
+            fprintf(stderr, "Trying to open %s\n", fullPath.c_str());
+    #endif
+            FILE* fp = fopen(fullPath.c_str(), mode);
+            if (fp)
+                return fp;
+        }
+
+        fullPath.clear();
         return nullptr;
     }
 
+    /**
+     * Search the directories to open the file.
+     * It will try some parent directories. Where a name was found, or that it
+     * was not found, is cached, so each name is probed only once.
+     */ 
+    AssetLoader::AssetFilePtr AssetLoader::OpenFile(const char* name, AssetOpenMode mode)
+    {
+        const char* fileMode = (mode == PANDA_OPEN_TEXT) ? "r" : "rb";
+
+        std::string fullPath;
+        uint64_t version;
+        {
+            std::lock_guard<std::mutex> lock(m_SearchPathLock);
+            version = m_SearchPathVersion;
+            auto iter = m_ResolvedPaths.find(name);
+            if (iter != m_ResolvedPaths.end())
+            {
+                if (iter->second.empty())
+                    return nullptr;
+                fullPath = iter->second;
+            }
+        }
+
+        if (!fullPath.empty())
+        {
+            FILE* fp = fopen(fullPath.c_str(), fileMode);
+            if (fp)
+            {
+                RecordOpen(fullPath);
+                return (AssetFilePtr)fp;
+            }
+            // removed since it was cached, look for it again
+        }
+
+        FILE* fp = ProbeFile(name, fileMode, fullPath);
+        if (fp)
+            RecordOpen(fullPath);
+
+        std::lock_guard<std::mutex> lock(m_SearchPathLock);
+        if (version == m_SearchPathVersion)
+            m_ResolvedPaths[name] = fullPath;
+
+        return (AssetFilePtr)fp;
+    }
+
+    // the whole file, absolute so the manifest does not depend on the working directory
+    void AssetLoader::RecordOpen(const std::string& fullPath)
+    {
+        if (m_IsRecording.load(std::memory_order_relaxed))
+            m_Recording.Record(std::filesystem::absolute(fullPath).lexically_normal().string(), 0, 0);
+    }
+
+    void AssetLoader::StartRecording()
+    {
+        m_Recording.Clear();
+        m_IsRecording = true;
+    }
+
+    bool AssetLoader::StopRecording(const char* manifestPath)
+    {
+        m_IsRecording = false;
+        bool saved = m_Recording.Save(manifestPath);
+        #ifdef DEBUG
+        fprintf(stderr, "Recorded %zu asset ranges to '%s'\n", m_Recording.GetRangeCount(), manifestPath);
+        #endif
+        m_Recording.Clear();
+        return saved;
+    }
+
+    bool AssetLoader::ReplayManifest(const char* manifestPath)
+    {
+        m_Replay.StopReadahead();
+        m_Replay.Clear();
+        if (!m_Replay.Load(manifestPath))
+            return false;
+
+        m_Replay.StartReadahead();
+        return true;
+    }
+
     Buffer AssetLoader::SyncOpenAndReadText(const char* filePath)
     {
+        int64_t openStart = m_Profiler.Now();
+        std::shared_ptr<AssetArchive> pArchive;
+        if (const AssetArchiveEntry* pEntry = FindInArchives(filePath, pArchive))
+        {
+            int64_t readStart = m_Profiler.Now();
+            m_Profiler.RecordOpen(filePath, openStart, readStart);
+
+            // inflated or copied straight into the result, with room for the '\0'
+            size_t length = static_cast<size_t>(pEntry->Size);
+            Buffer buff(length + 1);
+            if (!pArchive->ReadInto(*pEntry, buff.GetData()))
+                return Buffer();
+            buff.GetData()[length] = '\0';
+            m_Profiler.RecordRead(filePath, pEntry->StoredSize, readStart, m_Profiler.Now());
+            return buff;
+        }
+
         AssetFilePtr fp = OpenFile(filePath, PANDA_OPEN_TEXT);
-        Buffer* pBuff = nullptr;
+        Buffer buff;
 
-		size_t length = GetSize(fp);
         if (fp)
         {
-            pBuff = new Buffer(length + 1);
-            size_t result = fread(pBuff->GetData(), 1, length, static_cast<FILE*>(fp));
+            int64_t readStart = m_Profiler.Now();
+            m_Profiler.RecordOpen(filePath, openStart, readStart);
+
+            size_t length = GetSize(fp);
+            buff = Buffer(length + 1);
+            size_t result = fread(buff.GetData(), 1, length, static_cast<FILE*>(fp));
+            m_Profiler.RecordRead(filePath, result, readStart, m_Profiler.Now());
             #ifdef DEBUG
             fprintf(stderr, "Read file '%s', %zu bytes\n", filePath, length);
             #endif
-            pBuff->GetData()[result] = '\0';
+            buff.GetData()[result] = '\0';
 
             CloseFile(fp);
         }
         else
         {
             fprintf(stderr, "Error opening file '%s' \n", filePath);
-            pBuff = new Buffer();
         }
-        
-    #ifdef DEBUG
-        fprintf(stderr, "Read file '%s', %d bytes\n", filePath, length);
-    #endif
-        return *pBuff;
+
+        // returned by move, the file content is never copied
+        return buff;
     }
 
     Buffer AssetLoader::SyncOpenAndReadBinary(const char* filePath)
     {
+        int64_t openStart = m_Profiler.Now();
+        std::shared_ptr<AssetArchive> pArchive;
+        if (const AssetArchiveEntry* pEntry = FindInArchives(filePath, pArchive))
+        {
+            int64_t readStart = m_Profiler.Now();
+            m_Profiler.RecordOpen(filePath, openStart, readStart);
+
+            Buffer buff(static_cast<size_t>(pEntry->Size));
+            if (!pArchive->ReadInto(*pEntry, buff.GetData()))
+                return Buffer();
+            m_Profiler.RecordRead(filePath, pEntry->StoredSize, readStart, m_Profiler.Now());
+            return buff;
+        }
+
         AssetFilePtr fp = OpenFile(filePath, PANDA_OPEN_BINARY);
-        Buffer* pBuff = nullptr;
+        Buffer buff;
 
-		size_t length = GetSize(fp);
         if (fp)
         {
-            pBuff = new Buffer(length);
-            fread (pBuff->GetData(), length, 1, static_cast<FILE*>(fp));
+            int64_t readStart = m_Profiler.Now();
+            m_Profiler.RecordOpen(filePath, openStart, readStart);
+
+            size_t length = GetSize(fp);
+            buff = Buffer(length);
+            fread (buff.GetData(), length, 1, static_cast<FILE*>(fp));
+            m_Profiler.RecordRead(filePath, length, readStart, m_Profiler.Now());
             #ifdef DEBUG
             fprintf(stderr, "Read file '%s', %zu bytes\n", filePath, length);
             #endif
@@ -167,13 +632,165 @@ namespace Panda
         else
         {
             fprintf(stderr, "Error opening file '%s' \n", filePath);
-            pBuff = new Buffer();
         }
-        
-    #ifdef DEBUG
-        fprintf(stderr, "Read file '%s', %d bytes\n", filePath, length);
-    #endif
-        return *pBuff;
+
+        return buff;
+    }
+
+    BufferView AssetLoader::SyncOpenAndMapBinary(const char* filePath, MappedFile::AccessPattern pattern)
+    {
+        // stored entries come straight from the mapped archive
+        int64_t openStart = m_Profiler.Now();
+        std::shared_ptr<AssetArchive> pArchive;
+        if (const AssetArchiveEntry* pEntry = FindInArchives(filePath, pArchive))
+        {
+            int64_t readStart = m_Profiler.Now();
+            m_Profiler.RecordOpen(filePath, openStart, readStart);
+            BufferView data = pArchive->Read(*pEntry);
+            m_Profiler.RecordRead(filePath, pEntry->StoredSize, readStart, m_Profiler.Now());
+            return data;
+        }
+
+        AssetFilePtr fp = OpenFile(filePath, PANDA_OPEN_BINARY);
+        if (!fp)
+        {
+            fprintf(stderr, "Error opening file '%s' \n", filePath);
+            return BufferView();
+        }
+
+        int64_t readStart = m_Profiler.Now();
+        m_Profiler.RecordOpen(filePath, openStart, readStart);
+
+        // the pages of a mapping are read when the parser touches them, so its read time is only the mapping
+        std::shared_ptr<MappedFile> pMapping = MakeShared<MappedFile>();
+        if (pMapping->Map(static_cast<FILE*>(fp), pattern))
+        {
+            CloseFile(fp);
+            #ifdef DEBUG
+            fprintf(stderr, "Mapped file '%s', %zu bytes\n", filePath, pMapping->GetDataSize());
+            #endif
+            const uint8_t* pData = pMapping->GetData();
+            size_t size = pMapping->GetDataSize();
+            m_Profiler.RecordRead(filePath, size, readStart, m_Profiler.Now());
+            return BufferView(std::move(pMapping), pData, size);
+        }
+
+        size_t length = GetSize(fp);
+        Buffer buff(length);
+        fread(buff.GetData(), length, 1, static_cast<FILE*>(fp));
+        CloseFile(fp);
+        m_Profiler.RecordRead(filePath, length, readStart, m_Profiler.Now());
+
+        return BufferView(std::move(buff));
+    }
+
+    std::vector<Buffer> AssetLoader::SyncOpenAndReadBatch(const std::vector<std::string>& names, AssetOpenMode mode)
+    {
+        std::vector<Buffer> buffers(names.size());
+        ReadBatch(names, mode, [&buffers](size_t index, Buffer&& buffer) {
+            buffers[index] = std::move(buffer);
+        });
+        return buffers;
+    }
+
+    /**
+     * All the files are opened and sized first, so every buffer exists before
+     * the first read is submitted. Archived assets are copied out of the
+     * mapped archive right away, there is nothing to queue for them.
+     */
+    void AssetLoader::ReadBatch(const std::vector<std::string>& names, AssetOpenMode mode, const BatchReadCallback& onRead)
+    {
+        std::vector<Buffer> buffers(names.size());
+        std::vector<BatchFileRead> reads;
+        std::vector<size_t> readNames;  // the name each read belongs to
+        size_t terminatorSize = mode == PANDA_OPEN_TEXT ? 1 : 0;
+
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            const char* name = names[i].c_str();
+            std::shared_ptr<AssetArchive> pArchive;
+            if (FindInArchives(name, pArchive))
+            {
+                onRead(i, mode == PANDA_OPEN_TEXT ? SyncOpenAndReadText(name) : SyncOpenAndReadBinary(name));
+                continue;
+            }
+
+            int64_t openStart = m_Profiler.Now();
+            AssetFilePtr fp = OpenFile(name, mode);
+            if (!fp)
+            {
+                fprintf(stderr, "Error opening file '%s' \n", name);
+                onRead(i, Buffer());
+                continue;
+            }
+            m_Profiler.RecordOpen(name, openStart, m_Profiler.Now());
+
+            size_t length = GetSize(fp);
+            buffers[i] = Buffer(length + terminatorSize);
+            reads.push_back({static_cast<FILE*>(fp), buffers[i].GetData(), length, 0, false});
+            readNames.push_back(i);
+        }
+
+        if (reads.empty())
+            return;
+
+        BatchFileReader reader;
+        int64_t readStart = m_Profiler.Now();
+
+        // runs on whichever thread finished the read, each index exactly once
+        auto finishRead = [&](size_t i) {
+            BatchFileRead& read = reads[i];
+            Buffer& buffer = buffers[readNames[i]];
+            if (read.Failed || (mode == PANDA_OPEN_BINARY && read.BytesRead != read.Size))
+            {
+                fprintf(stderr, "Error reading file '%s' \n", names[readNames[i]].c_str());
+                buffer = Buffer();
+            }
+            else if (mode == PANDA_OPEN_TEXT)
+            {
+                buffer.GetData()[read.BytesRead] = '\0';
+            }
+
+            AssetFilePtr fp = read.pFile;
+            CloseFile(fp);
+            // the whole batch is in flight at once, so each read counts from the submission
+            m_Profiler.RecordRead(names[readNames[i]], read.BytesRead, readStart, m_Profiler.Now());
+            onRead(readNames[i], std::move(buffer));
+        };
+
+        reader.ReadAll(reads, finishRead);
+        #ifdef DEBUG
+        fprintf(stderr, "Read %zu files in one batch (%s)\n", reads.size(),
+            reader.GetBackend() == BatchFileReader::PANDA_BATCH_IO_URING ? "io_uring" : "threads");
+        #endif
+    }
+
+    std::shared_ptr<AssetStream> AssetLoader::OpenStream(const char* name, size_t ringSize)
+    {
+        // compressed entries are inflated as a whole, stored ones are not copied
+        int64_t openStart = m_Profiler.Now();
+        std::shared_ptr<AssetArchive> pArchive;
+        if (const AssetArchiveEntry* pEntry = FindInArchives(name, pArchive))
+        {
+            int64_t readStart = m_Profiler.Now();
+            m_Profiler.RecordOpen(name, openStart, readStart);
+            BufferView data = pArchive->Read(*pEntry);
+            if (data.IsEmpty() && pEntry->Size)
+                return nullptr;
+            m_Profiler.RecordRead(name, pEntry->StoredSize, readStart, m_Profiler.Now());
+            return MakeShared<AssetStream>(data);
+        }
+
+        AssetFilePtr fp = OpenFile(name, PANDA_OPEN_BINARY);
+        if (!fp)
+        {
+            fprintf(stderr, "Error opening file '%s' \n", name);
+            return nullptr;
+        }
+        m_Profiler.RecordOpen(name, openStart, m_Profiler.Now());
+
+        // a loose file is read while it is parsed, the read shows up in the parse time
+        return MakeShared<AssetStream>(static_cast<FILE*>(fp), ringSize);
     }
 
     void AssetLoader::CloseFile(AssetFilePtr& fp)
@@ -8,15 +8,30 @@
 #include <string>
 #include <utility>
 #include <vector>
+#include <unordered_map>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include "Interface/IRuntimeModule.hpp"
 #include "Buffer.hpp"
+#include "BufferView.hpp"
+#include "MappedFile.hpp"
+#include "AssetArchive.hpp"
+#include "AssetCache.hpp"
+#include "AssetStream.hpp"
+#include "BatchFileReader.hpp"
+#include "AssetPrefetchManifest.hpp"
+#include "AssetLoadProfiler.hpp"
 
 namespace Panda
 {
     class AssetLoader : public IRuntimeModule
     {
         public:
-            virtual ~AssetLoader() {}
+            virtual ~AssetLoader() {StopWorkers();}
 
             virtual int Initialize();
             virtual void Finalize();
@@ -38,9 +53,53 @@ namespace Panda
                 PANDA_SEEK_END = 2  // seek end
             };
 
+            enum AssetLoadPriority
+            {
+                PANDA_LOAD_PRIORITY_LOW     = 0,
+                PANDA_LOAD_PRIORITY_NORMAL  = 1,
+                PANDA_LOAD_PRIORITY_HIGH    = 2    // e.g. what the player is looking at
+            };
+
+            // the buffer is empty when the file could not be read, the callback may move it away
+            typedef std::function<void(const std::string& name, Buffer& buffer)> AssetLoadCallback;
+
+            /**
+             * A path ending in ".pak" mounts an asset archive instead of a directory.
+             * Mounted archives are searched before loose files, in the order they were
+             * mounted. OpenFile() only sees loose files, the SyncOpenAndRead*() and
+             * SyncOpenAndMapBinary() calls see both.
+             */
             bool AddSearchPath(const char* path);
             bool RemoveSearchPath(const char* path);
 
+            /**
+             * Walk the Asset directories OpenFile() would probe and remember where every
+             * file is, so opening it later needs no probing. Returns the number of files.
+             * Call it again, or InvalidatePathCache(), after files are added on disk.
+             */
+            size_t BuildDirectoryIndex();
+            // forget all resolved paths, found and not found
+            void InvalidatePathCache();
+
+            // where the name is loaded from, "archive.pak:name" for archived assets, empty when it is nowhere
+            std::string ResolvePath(const char* name);
+
+            // loads each asset once however often it is asked for, see AssetCache
+            AssetCache& GetCache() {return m_Cache;}
+            // open, read and parse times of every asset while it is started
+            AssetLoadProfiler& GetProfiler() {return m_Profiler;}
+
+            /**
+             * From StartRecording() on, every file opened and every archive entry
+             * read is recorded in order, StopRecording() saves the list as a
+             * manifest. ReplayManifest() starts reading a saved manifest into the
+             * page cache in the background, see AssetPrefetchManifest. Returns
+             * false when there is no manifest, e.g. on the first launch.
+             */
+            void StartRecording();
+            bool StopRecording(const char* manifestPath);
+            bool ReplayManifest(const char* manifestPath);
+
             virtual bool FileExists(const char* filePath);
 
             virtual AssetFilePtr OpenFile(const char* name, AssetOpenMode mode);
@@ -51,6 +110,46 @@ namespace Panda
 
             virtual size_t SyncRead(const AssetFilePtr& fp, Buffer& buf);
 
+            /**
+             * Map the file read-only instead of reading it into a Buffer. The view
+             * points straight at the mapped pages and keeps the mapping alive, slices
+             * of it included. Files that can not be mapped are read into a Buffer.
+             */
+            virtual BufferView SyncOpenAndMapBinary(const char* filePath,
+                MappedFile::AccessPattern pattern = MappedFile::PANDA_ACCESS_SEQUENTIAL);
+
+            /**
+             * Read many assets at once, with all the file reads in flight together,
+             * see BatchFileReader. The buffers are in the order of the names, empty
+             * for the ones that could not be read. Use it for loading a scene's textures.
+             */
+            std::vector<Buffer> SyncOpenAndReadBatch(const std::vector<std::string>& names, AssetOpenMode mode = PANDA_OPEN_BINARY);
+
+            /**
+             * Open the asset for reading a chunk at a time, see AssetStream. Loose
+             * files are read ahead into a ring of ringSize bytes, archive entries
+             * are streamed out of the mapped archive. nullptr when there is no such asset.
+             */
+            std::shared_ptr<AssetStream> OpenStream(const char* name, size_t ringSize = AssetStream::k_DefaultRingSize);
+
+            /**
+             * Queue a read on the I/O worker threads, higher priorities are read first.
+             * The callback runs on the thread that calls Tick(), never on a worker.
+             */
+            void AsyncOpenAndRead(const char* name, AssetLoadPriority priority, AssetLoadCallback callback,
+                AssetOpenMode mode = PANDA_OPEN_BINARY);
+
+            // the future is ready as soon as a worker has read the file, it does not wait for Tick()
+            std::future<Buffer> AsyncOpenAndRead(const char* name, AssetLoadPriority priority = PANDA_LOAD_PRIORITY_NORMAL,
+                AssetOpenMode mode = PANDA_OPEN_BINARY);
+
+            // the whole batch is one request on the workers, each future is ready as soon as its file is read
+            std::vector<std::future<Buffer>> AsyncOpenAndReadBatch(const std::vector<std::string>& names,
+                AssetLoadPriority priority = PANDA_LOAD_PRIORITY_NORMAL, AssetOpenMode mode = PANDA_OPEN_BINARY);
+
+            // requests queued, being read, or read with the callback not run yet
+            size_t GetPendingAsyncCount() const {return m_PendingAsyncCount.load(std::memory_order_acquire);}
+
             virtual void CloseFile(AssetFilePtr& fp);
 
             virtual size_t GetSize(const AssetFilePtr& fp);
@@ -59,22 +158,102 @@ namespace Panda
 
             inline std::string SyncOpenAndReadFileToString (const char* fileName)
             {
+                // copied once, from the mapped pages straight into the string
                 std::string result;
-                Buffer buffer = SyncOpenAndReadText(fileName);
-                if (buffer.GetDataSize())
+                BufferView content = SyncOpenAndMapBinary(fileName);
+                if (!content.IsEmpty())
                 {
-                    char* content = reinterpret_cast<char*>(buffer.GetData());
-                    if (content)
+                    const char* pBegin = reinterpret_cast<const char*>(content.GetData());
+                    const char* pEnd = pBegin + content.GetDataSize();
+                    #if defined(_WIN32)
+                    // the mapping is binary, line ends become \n as the text mode of fopen() made them
+                    result.reserve(content.GetDataSize());
+                    for (const char* p = pBegin; p != pEnd; ++p)
                     {
-                        result = std::string(std::move(content)); // move content and clear content values, since C++11
+                        if (*p != '\r' || p + 1 == pEnd || p[1] != '\n')
+                            result.push_back(*p);
                     }
+                    #else
+                    result.assign(pBegin, pEnd);
+                    #endif
                 }
 
                 return result;
             }
 
+        private:
+            struct AsyncRequest
+            {
+                std::string Name;
+                AssetOpenMode Mode;
+                AssetLoadPriority Priority;
+                uint64_t Sequence;      // keeps requests of the same priority in order
+                AssetLoadCallback Callback;
+                std::shared_ptr<std::promise<Buffer>> pPromise;
+                // a batch read instead of Name, one promise per name
+                std::vector<std::string> BatchNames;
+                std::vector<std::promise<Buffer>> BatchPromises;
+            };
+
+            struct AsyncCompletion
+            {
+                std::string Name;
+                Buffer Data;
+                AssetLoadCallback Callback;
+            };
+
+            // the directories OpenFile() probes, in probing order
+            std::vector<std::string> GetAssetDirectories();
+            FILE* ProbeFile(const char* name, const char* mode, std::string& fullPath);
+
+            bool MountArchive(const char* path);
+            // the archive is returned too, so it stays open while the entry is read
+            const AssetArchiveEntry* FindInArchives(const char* name, std::shared_ptr<AssetArchive>& pArchive);
+            void RecordOpen(const std::string& fullPath);
+
+            // called once per name as soon as that name is read, possibly on another thread
+            typedef std::function<void(size_t index, Buffer&& buffer)> BatchReadCallback;
+            void ReadBatch(const std::vector<std::string>& names, AssetOpenMode mode, const BatchReadCallback& onRead);
+
+            void QueueRequest(AsyncRequest&& request);
+            void WorkerThread();
+            void StartWorkers();
+            void StopWorkers();
+
         private:
             std::vector<std::string> m_SearchPath;
+            std::mutex m_SearchPathLock;    // the workers open files while the main thread may add paths
+            // asset name to the path it was found at, an empty path caches a miss
+            std::unordered_map<std::string, std::string> m_ResolvedPaths;
+            uint64_t m_SearchPathVersion = 0;   // bumped when the search paths change, so stale probes are not cached
+
+            struct MountedArchive
+            {
+                std::string Path;
+                std::string FullPath;   // where it was found, for the prefetch manifest
+                std::shared_ptr<AssetArchive> pArchive;
+            };
+            std::vector<MountedArchive> m_Archives;     // guarded by m_SearchPathLock too
+
+            std::vector<std::thread> m_Workers;
+            std::vector<AsyncRequest> m_Requests;   // a heap ordered by priority, then sequence
+            std::mutex m_RequestLock;
+            std::condition_variable m_RequestCondition;
+            bool m_IsStopping = false;
+            uint64_t m_NextSequence = 0;
+
+            std::vector<AsyncCompletion> m_Completions;
+            std::mutex m_CompletionLock;
+
+            std::atomic<size_t> m_PendingAsyncCount{0};
+
+            AssetCache m_Cache{*this};
+
+            std::atomic<bool> m_IsRecording{false};
+            AssetPrefetchManifest m_Recording;
+            AssetPrefetchManifest m_Replay;
+
+            AssetLoadProfiler m_Profiler;
     };
 
     extern AssetLoader* g_pAssetLoader;
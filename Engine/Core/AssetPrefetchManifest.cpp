@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cinttypes>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include "AssetPrefetchManifest.hpp"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Panda
+{
+    static std::string RangeKey(const std::string& path, uint64_t offset, uint64_t size)
+    {
+        char prefix[48];
+        snprintf(prefix, sizeof(prefix), "%" PRIu64 " %" PRIu64 " ", offset, size);
+        return prefix + path;
+    }
+
+    void AssetPrefetchManifest::Record(const std::string& path, uint64_t offset, uint64_t size)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        if (m_Recorded.insert(RangeKey(path, offset, size)).second)
+            m_Ranges.push_back({path, offset, size});
+    }
+
+    void AssetPrefetchManifest::Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Ranges.clear();
+        m_Recorded.clear();
+    }
+
+    bool AssetPrefetchManifest::Load(const char* path)
+    {
+        FILE* fp = fopen(path, "r");
+        if (!fp)
+            return false;
+
+        std::vector<AssetPrefetchRange> ranges;
+        char line[4096];
+        while (fgets(line, sizeof(line), fp))
+        {
+            line[strcspn(line, "\r\n")] = '\0';
+            uint64_t offset;
+            uint64_t size;
+            int pathStart = 0;
+            if (sscanf(line, "%" SCNu64 " %" SCNu64 " %n", &offset, &size, &pathStart) != 2 || !line[pathStart])
+                continue;   // a damaged line costs one range, not the manifest
+            ranges.push_back({line + pathStart, offset, size});
+        }
+        fclose(fp);
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        for (auto& range : ranges)
+        {
+            if (m_Recorded.insert(RangeKey(range.Path, range.Offset, range.Size)).second)
+                m_Ranges.push_back(std::move(range));
+        }
+
+        return true;
+    }
+
+    bool AssetPrefetchManifest::Save(const char* path) const
+    {
+        FILE* fp = fopen(path, "w");
+        if (!fp)
+            return false;
+
+        bool succeeded = true;
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            for (const auto& range : m_Ranges)
+            {
+                if (fprintf(fp, "%" PRIu64 " %" PRIu64 " %s\n", range.Offset, range.Size, range.Path.c_str()) < 0)
+                    succeeded = false;
+            }
+        }
+
+        return fclose(fp) == 0 && succeeded;
+    }
+
+    size_t AssetPrefetchManifest::GetRangeCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        return m_Ranges.size();
+    }
+
+    std::vector<AssetPrefetchRange> AssetPrefetchManifest::GetRanges() const
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        return m_Ranges;
+    }
+
+    void AssetPrefetchManifest::StartReadahead()
+    {
+        StopReadahead();
+        m_IsStopping = false;
+        m_ReadaheadCount = 0;
+        m_Readahead = std::thread(&AssetPrefetchManifest::ReadaheadThread, this);
+    }
+
+    void AssetPrefetchManifest::StopReadahead()
+    {
+        m_IsStopping = true;
+        if (m_Readahead.joinable())
+            m_Readahead.join();
+    }
+
+    void AssetPrefetchManifest::ReadaheadThread()
+    {
+        for (const auto& range : GetRanges())
+        {
+            if (m_IsStopping)
+                return;
+
+            Readahead(range);
+            m_ReadaheadCount.fetch_add(1, std::memory_order_acq_rel);
+        }
+    }
+
+#if defined(_WIN32)
+    // no advice call for plain files here, reading the range through pulls it into the cache
+    bool AssetPrefetchManifest::Readahead(const AssetPrefetchRange& range)
+    {
+        FILE* fp = fopen(range.Path.c_str(), "rb");
+        if (!fp)
+            return false;
+
+        std::vector<char> scratch(64 * 1024);
+        uint64_t left = range.Size ? range.Size : UINT64_MAX;
+        bool succeeded = _fseeki64(fp, static_cast<int64_t>(range.Offset), SEEK_SET) == 0;
+        while (succeeded && left)
+        {
+            size_t read = fread(scratch.data(), 1, static_cast<size_t>(std::min<uint64_t>(left, scratch.size())), fp);
+            if (read == 0)
+                break;
+            left -= read;
+        }
+        fclose(fp);
+
+        return succeeded;
+    }
+#else
+    bool AssetPrefetchManifest::Readahead(const AssetPrefetchRange& range)
+    {
+        int fd = open(range.Path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+    #if defined(__APPLE__)
+        struct stat status;
+        bool succeeded = fstat(fd, &status) == 0 && static_cast<uint64_t>(status.st_size) > range.Offset;
+        if (succeeded)
+        {
+            uint64_t size = std::min<uint64_t>(range.Size ? range.Size : UINT64_MAX, status.st_size - range.Offset);
+            radvisory advice;
+            advice.ra_offset = static_cast<off_t>(range.Offset);
+            advice.ra_count = static_cast<int>(std::min<uint64_t>(size, INT_MAX));
+            succeeded = fcntl(fd, F_RDADVISE, &advice) == 0;
+        }
+    #else
+        // starts the reads and returns, it does not wait for the data
+        bool succeeded = posix_fadvise(fd, static_cast<off_t>(range.Offset), static_cast<off_t>(range.Size),
+            POSIX_FADV_WILLNEED) == 0;
+    #endif
+        close(fd);
+
+        return succeeded;
+    }
+#endif
+}
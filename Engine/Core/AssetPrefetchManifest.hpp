@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+namespace Panda
+{
+    // bytes of one file on disk, a Size of 0 runs to the end of the file
+    struct AssetPrefetchRange
+    {
+        std::string Path;
+        uint64_t Offset;
+        uint64_t Size;
+    };
+
+    /**
+     * The files, and the ranges of archives, a run read in the order it first
+     * read them. Saved at the end of startup, the next launch replays it as
+     * readahead, so the page cache is warm before the parsers ask for the data.
+     *
+     * The file is plain text, one "offset size path" line per range.
+     */
+    class AssetPrefetchManifest
+    {
+        public:
+            AssetPrefetchManifest() : m_IsStopping(false), m_ReadaheadCount(0) {}
+            ~AssetPrefetchManifest() {StopReadahead();}
+
+            AssetPrefetchManifest(const AssetPrefetchManifest&) = delete;
+            AssetPrefetchManifest& operator=(const AssetPrefetchManifest&) = delete;
+
+            // thread safe, a range recorded before is ignored
+            void Record(const std::string& path, uint64_t offset, uint64_t size);
+            void Clear();
+
+            // adds the ranges of the file to the ones already there
+            bool Load(const char* path);
+            bool Save(const char* path) const;
+
+            size_t GetRangeCount() const;
+            std::vector<AssetPrefetchRange> GetRanges() const;
+
+            /**
+             * Ask the OS to read every range into the page cache, on a thread of
+             * its own so the caller goes on starting up. The reads themselves are
+             * queued without waiting for each other, the disk sees them all at once.
+             */
+            void StartReadahead();
+            // abandons the ranges not issued yet
+            void StopReadahead();
+            // ranges issued so far, whether the file was there or not
+            size_t GetReadaheadCount() const {return m_ReadaheadCount.load(std::memory_order_acquire);}
+
+            static bool Readahead(const AssetPrefetchRange& range);
+
+        private:
+            void ReadaheadThread();
+
+        private:
+            std::vector<AssetPrefetchRange> m_Ranges;
+            std::unordered_set<std::string> m_Recorded;   // "offset size path" of each range
+            mutable std::mutex m_Lock;
+
+            std::thread m_Readahead;
+            std::atomic<bool> m_IsStopping;
+            std::atomic<size_t> m_ReadaheadCount;
+    };
+}
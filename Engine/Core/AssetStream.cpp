@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include "AssetStream.hpp"
+
+namespace Panda
+{
+    AssetStream::AssetStream(FILE* fp, size_t ringSize)
+        : m_pFile(fp), m_Size(0), m_Consumed(0), m_Handed(0), m_Written(0), m_IsStopping(false), m_HasError(false)
+    {
+        if (ringSize < k_MinRingSize)
+            ringSize = k_MinRingSize;
+
+        fseek(m_pFile, 0, SEEK_END);
+        long length = ftell(m_pFile);
+        fseek(m_pFile, 0, SEEK_SET);
+        if (length > 0)
+            m_Size = static_cast<size_t>(length);
+
+        // a quarter of the ring per read, so reading and decoding overlap without tiny reads
+        m_Ring = Buffer(std::min(ringSize, std::max<size_t>(m_Size, 1)));
+        m_ReadAheadSize = std::max<size_t>(m_Ring.GetDataSize() / 4, 1);
+        m_ReadAhead = std::thread(&AssetStream::ReadAheadThread, this);
+    }
+
+    AssetStream::AssetStream(const BufferView& data)
+        : m_Data(data), m_pFile(nullptr), m_Size(data.GetDataSize()), m_ReadAheadSize(0),
+          m_Consumed(0), m_Handed(0), m_Written(data.GetDataSize()), m_IsStopping(false), m_HasError(false)
+    {
+    }
+
+    AssetStream::~AssetStream()
+    {
+        if (m_ReadAhead.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Lock);
+                m_IsStopping = true;
+            }
+            m_SpaceCondition.notify_one();
+            m_ReadAhead.join();
+        }
+
+        if (m_pFile)
+            fclose(m_pFile);
+    }
+
+    size_t AssetStream::ReadChunk(const uint8_t*& pData, size_t maxSize)
+    {
+        Release();
+
+        if (!m_pFile)
+        {
+            size_t size = std::min(m_Size - m_Consumed, maxSize);
+            pData = m_Data.GetData() + m_Consumed;
+            m_Handed = size;
+            return size;
+        }
+
+        const size_t ringSize = m_Ring.GetDataSize();
+        std::unique_lock<std::mutex> lock(m_Lock);
+        m_DataCondition.wait(lock, [this] {
+            return m_Written > m_Consumed || m_Written == m_Size || m_HasError;
+        });
+
+        // the chunk ends where the ring wraps around, the rest comes with the next call
+        size_t offset = m_Consumed % ringSize;
+        size_t size = std::min({m_Written - m_Consumed, ringSize - offset, maxSize});
+        pData = m_Ring.GetData() + offset;
+        m_Handed = size;
+        return size;
+    }
+
+    void AssetStream::Unread(size_t size)
+    {
+        assert(size <= m_Handed);
+        m_Handed -= std::min(size, m_Handed);
+    }
+
+    size_t AssetStream::Read(void* pDest, size_t size)
+    {
+        uint8_t* pOut = reinterpret_cast<uint8_t*>(pDest);
+        size_t copied = 0;
+        while (copied < size)
+        {
+            const uint8_t* pChunk;
+            size_t chunkSize = ReadChunk(pChunk, size - copied);
+            if (chunkSize == 0)
+                break;
+            memcpy(pOut + copied, pChunk, chunkSize);
+            copied += chunkSize;
+        }
+
+        return copied;
+    }
+
+    size_t AssetStream::Skip(size_t size)
+    {
+        size_t skipped = 0;
+        while (skipped < size)
+        {
+            const uint8_t* pChunk;
+            size_t chunkSize = ReadChunk(pChunk, size - skipped);
+            if (chunkSize == 0)
+                break;
+            skipped += chunkSize;
+        }
+
+        return skipped;
+    }
+
+    bool AssetStream::HasError() const
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        return m_HasError;
+    }
+
+    void AssetStream::Release()
+    {
+        if (!m_Handed)
+            return;
+
+        if (!m_pFile)
+        {
+            m_Consumed += m_Handed;
+            m_Handed = 0;
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            m_Consumed += m_Handed;
+        }
+        m_Handed = 0;
+        m_SpaceCondition.notify_one();
+    }
+
+    void AssetStream::ReadAheadThread()
+    {
+        const size_t ringSize = m_Ring.GetDataSize();
+        uint8_t* pRing = m_Ring.GetData();
+
+        for (;;)
+        {
+            size_t offset;
+            size_t size;
+            {
+                std::unique_lock<std::mutex> lock(m_Lock);
+                if (m_Written == m_Size)
+                    return;
+
+                // wait for a whole read's worth of room, or for what is left of the file
+                size_t wanted = std::min(m_ReadAheadSize, m_Size - m_Written);
+                m_SpaceCondition.wait(lock, [&] {
+                    return m_IsStopping || ringSize - (m_Written - m_Consumed) >= wanted;
+                });
+                if (m_IsStopping)
+                    return;
+
+                offset = m_Written % ringSize;
+                size = std::min(wanted, ringSize - offset);
+            }
+
+            // the reader never touches bytes past m_Written, so this runs without the lock
+            size_t read = fread(pRing + offset, 1, size, m_pFile);
+            {
+                std::lock_guard<std::mutex> lock(m_Lock);
+                m_Written += read;
+                if (read < size)
+                    m_HasError = true;  // the file got shorter, or the disk failed
+            }
+            m_DataCondition.notify_one();
+
+            if (read < size)
+                return;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Buffer.hpp"
+#include "BufferView.hpp"
+
+namespace Panda
+{
+    /**
+     * Pull-based reader for assets too large to hold in memory at once.
+     * A file is read by a read-ahead thread into a fixed-size ring buffer while
+     * the caller decodes what is already there, so no more than the ring is
+     * ever held, however large the file. A stream over a BufferView hands out
+     * slices of the view instead and never copies.
+     *
+     * The stream is used by one thread at a time, the read-ahead thread aside.
+     */
+    class AssetStream
+    {
+        public:
+            static const size_t k_DefaultRingSize = 1024 * 1024;
+            static const size_t k_MinRingSize = 64;
+
+            // takes over the file and closes it, the ring is at least k_MinRingSize bytes
+            explicit AssetStream(FILE* fp, size_t ringSize = k_DefaultRingSize);
+            explicit AssetStream(const BufferView& data);
+            ~AssetStream();
+
+            AssetStream(const AssetStream&) = delete;
+            AssetStream& operator=(const AssetStream&) = delete;
+
+            /**
+             * Wait until data is there and point pData at up to maxSize bytes of it.
+             * The bytes stay valid until the next call on the stream. Returns 0 at
+             * the end of the stream, or when the file can not be read any further.
+             */
+            size_t ReadChunk(const uint8_t*& pData, size_t maxSize = SIZE_MAX);
+            // give back the last size bytes ReadChunk() returned, they are returned again next time
+            void Unread(size_t size);
+
+            // copies size bytes unless the stream ends first, returns how many were copied
+            size_t Read(void* pDest, size_t size);
+            size_t Skip(size_t size);
+
+            size_t GetSize() const {return m_Size;}
+            // bytes handed out so far
+            size_t GetPosition() const {return m_Consumed + m_Handed;}
+            bool IsEnd() const {return GetPosition() >= m_Size;}
+            // the file could not be read to the end
+            bool HasError() const;
+            // a stream over a BufferView, its first chunk is all of what is left
+            bool IsInMemory() const {return m_pFile == nullptr;}
+
+        private:
+            void ReadAheadThread();
+            // the bytes of the previous chunk are read, the ring may reuse them
+            void Release();
+
+        private:
+            BufferView m_Data;      // the whole content, for streams over memory
+            FILE* m_pFile;
+            size_t m_Size;
+
+            Buffer m_Ring;
+            size_t m_ReadAheadSize;     // the read-ahead thread reads at most this much at once
+            size_t m_Consumed;          // bytes released by the reader
+            size_t m_Handed;            // bytes of the last chunk, not released yet
+            size_t m_Written;           // bytes the read-ahead thread put into the ring
+            bool m_IsStopping;
+            bool m_HasError;
+
+            std::thread m_ReadAhead;
+            mutable std::mutex m_Lock;
+            std::condition_variable m_DataCondition;    // the ring has data, or the file ended
+            std::condition_variable m_SpaceCondition;   // the ring has room, or the stream is closing
+    };
+}
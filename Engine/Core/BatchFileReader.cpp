@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include "BatchFileReader.hpp"
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace Panda
+{
+#if defined(__linux__)
+    /**
+     * The rings shared with the kernel, set up with the raw system calls so
+     * there is no dependency on liburing. Only this thread writes the
+     * submission tail and the completion head, the kernel writes the others.
+     */
+    struct BatchFileReader::IoRing
+    {
+        int Fd = -1;
+        void* pSqMemory = MAP_FAILED;
+        size_t SqMemorySize = 0;
+        void* pCqMemory = MAP_FAILED;
+        size_t CqMemorySize = 0;
+        io_uring_sqe* pSqes = reinterpret_cast<io_uring_sqe*>(MAP_FAILED);
+        size_t SqesSize = 0;
+
+        unsigned* pSqHead;
+        unsigned* pSqTail;
+        unsigned SqMask;
+        unsigned SqEntries;
+        unsigned* pSqArray;
+
+        unsigned* pCqHead;
+        unsigned* pCqTail;
+        unsigned CqMask;
+        io_uring_cqe* pCqes;
+
+        ~IoRing()
+        {
+            if (pSqes != MAP_FAILED)
+                munmap(pSqes, SqesSize);
+            if (pCqMemory != MAP_FAILED && pCqMemory != pSqMemory)
+                munmap(pCqMemory, CqMemorySize);
+            if (pSqMemory != MAP_FAILED)
+                munmap(pSqMemory, SqMemorySize);
+            if (Fd >= 0)
+                close(Fd);
+        }
+    };
+#else
+    struct BatchFileReader::IoRing
+    {
+    };
+#endif
+
+    BatchFileReader::BatchFileReader(Backend preferred, uint32_t queueDepth)
+        : m_Backend(PANDA_BATCH_THREADS)
+    {
+        if (preferred == PANDA_BATCH_IO_URING && SetupRing(std::max<uint32_t>(queueDepth, 1)))
+            m_Backend = PANDA_BATCH_IO_URING;
+    }
+
+    BatchFileReader::~BatchFileReader()
+    {
+    }
+
+    size_t BatchFileReader::ReadAll(std::vector<BatchFileRead>& reads, const ReadCallback& onRead)
+    {
+        for (auto& read : reads)
+        {
+            read.BytesRead = 0;
+            read.Failed = false;
+        }
+
+        return m_Backend == PANDA_BATCH_IO_URING ? ReadWithRing(reads, onRead) : ReadWithThreads(reads, onRead);
+    }
+
+    size_t BatchFileReader::ReadWithThreads(std::vector<BatchFileRead>& reads, const ReadCallback& onRead)
+    {
+        // every read has its own FILE, so the threads never wait on each other
+        std::atomic<size_t> next{0};
+        auto readFiles = [&reads, &next, &onRead]() {
+            for (size_t i = next++; i < reads.size(); i = next++)
+            {
+                BatchFileRead& read = reads[i];
+                if (fseek(read.pFile, 0, SEEK_SET) == 0)
+                {
+                    read.BytesRead = fread(read.pData, 1, read.Size, read.pFile);
+                    read.Failed = ferror(read.pFile) != 0;
+                }
+                else
+                {
+                    read.Failed = true;
+                }
+
+                if (onRead)
+                    onRead(i);
+            }
+        };
+
+        // the calling thread reads too
+        size_t threadCount = std::min<size_t>(k_ThreadCount, reads.size());
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < threadCount; ++i)
+            threads.emplace_back(readFiles);
+        readFiles();
+        for (auto& thread : threads)
+            thread.join();
+
+        return std::count_if(reads.begin(), reads.end(), [](const BatchFileRead& read) {
+            return !read.Failed && read.BytesRead == read.Size;
+        });
+    }
+
+#if defined(__linux__)
+    bool BatchFileReader::SetupRing(uint32_t queueDepth)
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, queueDepth, &params));
+        if (fd < 0)
+            return false;
+
+        std::unique_ptr<IoRing> pRing(new IoRing());
+        pRing->Fd = fd;
+
+        pRing->SqMemorySize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        pRing->CqMemorySize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMapping)
+            pRing->SqMemorySize = pRing->CqMemorySize = std::max(pRing->SqMemorySize, pRing->CqMemorySize);
+
+        pRing->pSqMemory = mmap(nullptr, pRing->SqMemorySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            fd, IORING_OFF_SQ_RING);
+        if (pRing->pSqMemory == MAP_FAILED)
+            return false;
+
+        pRing->pCqMemory = singleMapping ? pRing->pSqMemory
+            : mmap(nullptr, pRing->CqMemorySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (pRing->pCqMemory == MAP_FAILED)
+            return false;
+
+        pRing->SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        pRing->pSqes = reinterpret_cast<io_uring_sqe*>(mmap(nullptr, pRing->SqesSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (pRing->pSqes == MAP_FAILED)
+            return false;
+
+        uint8_t* pSq = reinterpret_cast<uint8_t*>(pRing->pSqMemory);
+        pRing->pSqHead = reinterpret_cast<unsigned*>(pSq + params.sq_off.head);
+        pRing->pSqTail = reinterpret_cast<unsigned*>(pSq + params.sq_off.tail);
+        pRing->SqMask = *reinterpret_cast<unsigned*>(pSq + params.sq_off.ring_mask);
+        pRing->SqEntries = params.sq_entries;
+        pRing->pSqArray = reinterpret_cast<unsigned*>(pSq + params.sq_off.array);
+
+        uint8_t* pCq = reinterpret_cast<uint8_t*>(pRing->pCqMemory);
+        pRing->pCqHead = reinterpret_cast<unsigned*>(pCq + params.cq_off.head);
+        pRing->pCqTail = reinterpret_cast<unsigned*>(pCq + params.cq_off.tail);
+        pRing->CqMask = *reinterpret_cast<unsigned*>(pCq + params.cq_off.ring_mask);
+        pRing->pCqes = reinterpret_cast<io_uring_cqe*>(pCq + params.cq_off.cqes);
+
+        m_pRing = std::move(pRing);
+        return true;
+    }
+
+    /**
+     * Keep the submission queue full and reap completions as they come. A
+     * short read is submitted again for the rest, the ring runs until every
+     * read has finished one way or the other. When io_uring_enter fails, the
+     * reads the kernel has taken still write into their buffers, so their
+     * completions are waited for before the reads return, failed or not.
+     */
+    size_t BatchFileReader::ReadWithRing(std::vector<BatchFileRead>& reads, const ReadCallback& onRead)
+    {
+        IoRing& ring = *m_pRing;
+        std::vector<iovec> iovecs(reads.size());
+        std::vector<size_t> queue;      // reads still to submit, popped from the back
+        size_t finished = 0;
+        unsigned inFlight = 0;
+        bool isBroken = false;      // io_uring_enter failed, nothing is submitted any more
+
+        auto finish = [&](size_t index) {
+            ++finished;
+            if (onRead)
+                onRead(index);
+        };
+
+        for (size_t i = reads.size(); i > 0; --i)
+        {
+            if (reads[i - 1].Size)
+                queue.push_back(i - 1);
+            else
+                finish(i - 1);
+        }
+
+        while (finished < reads.size())
+        {
+            unsigned tail = *ring.pSqTail;
+            while (!isBroken && !queue.empty() && inFlight < ring.SqEntries)
+            {
+                size_t index = queue.back();
+                queue.pop_back();
+                BatchFileRead& read = reads[index];
+
+                iovecs[index].iov_base = read.pData + read.BytesRead;
+                iovecs[index].iov_len = read.Size - read.BytesRead;
+
+                unsigned slot = tail & ring.SqMask;
+                io_uring_sqe& sqe = ring.pSqes[slot];
+                memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode = IORING_OP_READV;
+                sqe.fd = fileno(read.pFile);
+                sqe.off = read.BytesRead;
+                sqe.addr = reinterpret_cast<uint64_t>(&iovecs[index]);
+                sqe.len = 1;
+                sqe.user_data = index;
+                ring.pSqArray[slot] = slot;
+
+                ++tail;
+                ++inFlight;
+            }
+            __atomic_store_n(ring.pSqTail, tail, __ATOMIC_RELEASE);
+
+            // submit everything the kernel has not taken yet and wait for at least one completion
+            unsigned toSubmit = isBroken ? 0 : tail - __atomic_load_n(ring.pSqHead, __ATOMIC_ACQUIRE);
+            int ret = static_cast<int>(syscall(__NR_io_uring_enter, ring.Fd, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+            if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {
+                if (!isBroken)
+                {
+                    // what the kernel has not taken is withdrawn, it fails with the reads still queued
+                    isBroken = true;
+                    unsigned sqHead = __atomic_load_n(ring.pSqHead, __ATOMIC_ACQUIRE);
+                    for (unsigned i = sqHead; i != tail; ++i, --inFlight)
+                        queue.push_back(static_cast<size_t>(ring.pSqes[ring.pSqArray[i & ring.SqMask]].user_data));
+                    __atomic_store_n(ring.pSqTail, sqHead, __ATOMIC_RELEASE);
+
+                    for (size_t index : queue)
+                    {
+                        reads[index].Failed = true;
+                        finish(index);
+                    }
+                    queue.clear();
+                }
+                else
+                {
+                    // not even waiting works, the completions show up in the queue all the same
+                    std::this_thread::yield();
+                }
+            }
+
+            unsigned head = *ring.pCqHead;
+            unsigned cqTail = __atomic_load_n(ring.pCqTail, __ATOMIC_ACQUIRE);
+            for (; head != cqTail; ++head)
+            {
+                const io_uring_cqe& cqe = ring.pCqes[head & ring.CqMask];
+                size_t index = static_cast<size_t>(cqe.user_data);
+                BatchFileRead& read = reads[index];
+                --inFlight;
+
+                if (cqe.res > 0)
+                    read.BytesRead += cqe.res;
+
+                bool isPartial = (cqe.res > 0 && read.BytesRead < read.Size) || cqe.res == -EAGAIN || cqe.res == -EINTR;
+                if (isPartial && !isBroken)
+                {
+                    // submitted again for the rest
+                    queue.push_back(index);
+                    continue;
+                }
+
+                // 0 is the end of the file, it got shorter after it was opened
+                read.Failed = cqe.res < 0 || isPartial;
+                finish(index);
+            }
+            __atomic_store_n(ring.pCqHead, head, __ATOMIC_RELEASE);
+        }
+
+        return std::count_if(reads.begin(), reads.end(), [](const BatchFileRead& read) {
+            return !read.Failed && read.BytesRead == read.Size;
+        });
+    }
+#else
+    bool BatchFileReader::SetupRing(uint32_t)
+    {
+        return false;
+    }
+
+    size_t BatchFileReader::ReadWithRing(std::vector<BatchFileRead>& reads, const ReadCallback& onRead)
+    {
+        return ReadWithThreads(reads, onRead);
+    }
+#endif
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Panda
+{
+    // one file of a batch, read from its start into memory allocated before the batch is submitted
+    struct BatchFileRead
+    {
+        FILE* pFile;
+        uint8_t* pData;
+        size_t Size;
+        size_t BytesRead;   // less than Size when the file got shorter since it was opened
+        bool Failed;        // the device reported an error
+    };
+
+    /**
+     * Reads many files at once. On Linux the whole batch goes to io_uring, so
+     * the device sees one deep queue and completes the reads in whatever order
+     * suits it. Where io_uring is missing, an old kernel, a sandbox that
+     * forbids it or another OS, a few threads read the files side by side.
+     */
+    class BatchFileReader
+    {
+        public:
+            enum Backend
+            {
+                PANDA_BATCH_IO_URING    = 0,
+                PANDA_BATCH_THREADS     = 1
+            };
+
+            static const uint32_t k_DefaultQueueDepth = 64;
+            static const uint32_t k_ThreadCount = 8;
+
+            explicit BatchFileReader(Backend preferred = PANDA_BATCH_IO_URING, uint32_t queueDepth = k_DefaultQueueDepth);
+            ~BatchFileReader();
+
+            BatchFileReader(const BatchFileReader&) = delete;
+            BatchFileReader& operator=(const BatchFileReader&) = delete;
+
+            // runs as soon as the read with that index is done, on the thread that finished it
+            typedef std::function<void(size_t index)> ReadCallback;
+
+            Backend GetBackend() const {return m_Backend;}
+
+            // blocks until every read is done, returns how many were read whole
+            size_t ReadAll(std::vector<BatchFileRead>& reads, const ReadCallback& onRead = nullptr);
+
+        private:
+            struct IoRing;
+
+            bool SetupRing(uint32_t queueDepth);
+            size_t ReadWithRing(std::vector<BatchFileRead>& reads, const ReadCallback& onRead);
+            size_t ReadWithThreads(std::vector<BatchFileRead>& reads, const ReadCallback& onRead);
+
+        private:
+            Backend m_Backend;
+            std::unique_ptr<IoRing> m_pRing;
+    };
+}
@@ -11,6 +11,7 @@ namespace Panda
     {
         public:
             Buffer() : m_pData(nullptr), m_Size(0), m_Alignment(alignof(uint32_t)) {}   // alignof:Queries alignment requirements of a type since C++11
+            // m_pData is guaranteed to be aligned to alignment, which must be a power of 2
             Buffer(size_t size, size_t alignment = 4) : m_Size(size), m_Alignment(alignment) 
             {
                 m_pData = reinterpret_cast<uint8_t*> (g_pMemoryManager->Allocate(size, alignment));
@@ -42,8 +43,8 @@ namespace Panda
                 }
                 else
                 {
-                    if (m_pData) g_pMemoryManager->Free(m_pData, m_Size);
-                    m_pData = reinterpret_cast<uint8_t*> (g_pMemoryManager->Allocate(rhs.m_Size, m_Alignment));
+                    if (m_pData) g_pMemoryManager->Free(m_pData, m_Size, m_Alignment);
+                    m_pData = reinterpret_cast<uint8_t*> (g_pMemoryManager->Allocate(rhs.m_Size, rhs.m_Alignment));
                     memcpy(m_pData, rhs.m_pData, rhs.m_Size);
                     m_Size = rhs.m_Size;
                     m_Alignment = rhs.m_Alignment;
@@ -54,7 +55,7 @@ namespace Panda
 
             Buffer& operator=(Buffer&& rhs) noexcept
             {
-                if (m_pData) g_pMemoryManager->Free(m_pData, m_Size);
+                if (m_pData) g_pMemoryManager->Free(m_pData, m_Size, m_Alignment);
                 m_pData = rhs.m_pData;
                 m_Size = rhs.m_Size;
                 m_Alignment = rhs.m_Alignment;
@@ -68,7 +69,7 @@ namespace Panda
             {
                 if (m_pData)
                 {
-                    g_pMemoryManager->Free(m_pData, m_Size);
+                    g_pMemoryManager->Free(m_pData, m_Size, m_Alignment);
                     m_pData = nullptr;
                 }
             }
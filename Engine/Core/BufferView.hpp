@@ -0,0 +1,66 @@
+#pragma once
+#include <memory>
+#include <cstddef>
+#include "Buffer.hpp"
+#include "PandaAllocator.hpp"
+
+namespace Panda
+{
+    /**
+     * Read-only window (offset, length) into a Buffer.
+     * Views share the Buffer by reference count, so slicing and copying a view
+     * never copies the payload. A view made from an rvalue Buffer takes it over;
+     * a view made from an lvalue Buffer only borrows it, like std::string_view,
+     * and must not outlive it.
+     */
+    class BufferView
+    {
+        public:
+            BufferView() : m_pData(nullptr), m_Size(0) {}
+
+            // takes over the payload of buf, no copy
+            BufferView(Buffer&& buf)
+            {
+                std::shared_ptr<Buffer> pBuffer = MakeShared<Buffer>(std::move(buf));
+                m_pData = pBuffer->GetData();
+                m_Size = pBuffer->GetDataSize();
+                m_pBuffer = std::move(pBuffer);
+            }
+
+            // borrows buf, which has to outlive the view and all slices of it
+            BufferView(const Buffer& buf) : m_pData(buf.GetData()), m_Size(buf.GetDataSize()) {}
+
+            BufferView(const std::shared_ptr<const Buffer>& pBuffer)
+                : m_pBuffer(pBuffer), m_pData(pBuffer->GetData()), m_Size(pBuffer->GetDataSize()) {}
+
+            // memory kept alive by pOwner that is not a Buffer, e.g. a MappedFile
+            BufferView(std::shared_ptr<const void> pOwner, const uint8_t* pData, size_t size)
+                : m_pBuffer(std::move(pOwner)), m_pData(pData), m_Size(size) {}
+
+            // sub-range sharing the same Buffer, clamped to this view
+            BufferView Slice(size_t offset, size_t length) const
+            {
+                BufferView view;
+                if (offset > m_Size) offset = m_Size;
+                if (length > m_Size - offset) length = m_Size - offset;
+                view.m_pBuffer = m_pBuffer;
+                view.m_pData = m_pData + offset;
+                view.m_Size = length;
+                return view;
+            }
+
+            BufferView Slice(size_t offset) const {return Slice(offset, m_Size);}
+
+            const uint8_t* GetData() const {return m_pData;}
+            size_t GetDataSize() const {return m_Size;}
+            bool IsEmpty() const {return m_Size == 0;}
+
+            // false when the view only borrows the Buffer
+            bool IsShared() const {return m_pBuffer != nullptr;}
+
+        private:
+            std::shared_ptr<const void> m_pBuffer;  // the Buffer, or whatever else owns the bytes
+            const uint8_t* m_pData;
+            size_t m_Size;
+    };
+}
@@ -0,0 +1,217 @@
+#include <vector>
+#include "ColorSpaceConversion.hpp"
+
+// part of every x86-64 target, so there is nothing to check at run time
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define PANDA_COLOR_SSE2 1
+#   include <emmintrin.h>
+#endif
+
+namespace Panda
+{
+    // YCbCr2RGB with 14 fractional bits, so the factors fit the 16 bit multipliers of SSE2
+    static const int32_t k_CrToR = 22970;   //  1.402
+    static const int32_t k_CbToG = -5638;   // -0.344136
+    static const int32_t k_CrToG = -11700;  // -0.714136
+    static const int32_t k_CbToB = 29032;   //  1.772
+    static const int32_t k_Half = 1 << 13;
+
+    static inline uint8_t ClampComponent(int32_t value)
+    {
+        return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+    }
+
+    // cb and cr centered on 0
+    static inline void ConvertPixel(int32_t y, int32_t cb, int32_t cr, uint8_t* pOut)
+    {
+        int32_t luma = (y << 14) + k_Half;
+        pOut[0] = ClampComponent((luma + k_CrToR * cr) >> 14);
+        pOut[1] = ClampComponent((luma + k_CbToG * cb + k_CrToG * cr) >> 14);
+        pOut[2] = ClampComponent((luma + k_CbToB * cb) >> 14);
+        pOut[3] = 255;
+    }
+
+    // the chroma of the 2 output samples around each input sample, inputs with 4 times the weight
+    static inline int32_t UpsampleEven(const int16_t* pSum, int32_t x)
+    {
+        return ((3 * pSum[x >> 1] + pSum[(x >> 1) - 1] + 8) >> 4) - 128;
+    }
+
+    static inline int32_t UpsampleOdd(const int16_t* pSum, int32_t x)
+    {
+        return ((3 * pSum[x >> 1] + pSum[(x >> 1) + 1] + 7) >> 4) - 128;
+    }
+
+#if defined(PANDA_COLOR_SSE2)
+    static inline __m128i ConvertChannelSse2(__m128i lumaLo, __m128i lumaHi, __m128i cbcrLo, __m128i cbcrHi,
+        int32_t cbFactor, int32_t crFactor)
+    {
+        // cb in the low half of each 32 bit lane, cr in the high one, one madd weights and adds both
+        const __m128i factors = _mm_set1_epi32(static_cast<int32_t>((static_cast<uint32_t>(crFactor) << 16)
+            | (static_cast<uint32_t>(cbFactor) & 0xFFFF)));
+        __m128i lo = _mm_srai_epi32(_mm_add_epi32(lumaLo, _mm_madd_epi16(cbcrLo, factors)), 14);
+        __m128i hi = _mm_srai_epi32(_mm_add_epi32(lumaHi, _mm_madd_epi16(cbcrHi, factors)), 14);
+        __m128i channel = _mm_packs_epi32(lo, hi);
+        return _mm_packus_epi16(channel, channel);
+    }
+
+    // 8 pixels, y as 16 bit samples and cb, cr as 16 bit values centered on 0
+    static inline void ConvertPixelsSse2(__m128i y, __m128i cb, __m128i cr, uint8_t* pOut)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i half = _mm_set1_epi32(k_Half);
+        __m128i lumaLo = _mm_add_epi32(_mm_slli_epi32(_mm_unpacklo_epi16(y, zero), 14), half);
+        __m128i lumaHi = _mm_add_epi32(_mm_slli_epi32(_mm_unpackhi_epi16(y, zero), 14), half);
+        __m128i cbcrLo = _mm_unpacklo_epi16(cb, cr);
+        __m128i cbcrHi = _mm_unpackhi_epi16(cb, cr);
+
+        __m128i r = ConvertChannelSse2(lumaLo, lumaHi, cbcrLo, cbcrHi, 0, k_CrToR);
+        __m128i g = ConvertChannelSse2(lumaLo, lumaHi, cbcrLo, cbcrHi, k_CbToG, k_CrToG);
+        __m128i b = ConvertChannelSse2(lumaLo, lumaHi, cbcrLo, cbcrHi, k_CbToB, 0);
+
+        __m128i rg = _mm_unpacklo_epi8(r, g);
+        __m128i ba = _mm_unpacklo_epi8(b, _mm_set1_epi8(-1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pOut), _mm_unpacklo_epi16(rg, ba));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pOut + 16), _mm_unpackhi_epi16(rg, ba));
+    }
+
+    static inline __m128i LoadSamplesSse2(const uint8_t* pSamples)
+    {
+        return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSamples)), _mm_setzero_si128());
+    }
+#endif
+
+    // chroma at full resolution, or none at all
+    static void ConvertRow(const uint8_t* pY, const uint8_t* pCb, const uint8_t* pCr, uint32_t width, uint8_t* pOut)
+    {
+        uint32_t x = 0;
+#if defined(PANDA_COLOR_SSE2)
+        const __m128i center = _mm_set1_epi16(128);
+        for (; x + 8 <= width; x += 8)
+        {
+            __m128i cb = _mm_setzero_si128();
+            __m128i cr = _mm_setzero_si128();
+            if (pCb)
+            {
+                cb = _mm_sub_epi16(LoadSamplesSse2(pCb + x), center);
+                cr = _mm_sub_epi16(LoadSamplesSse2(pCr + x), center);
+            }
+            ConvertPixelsSse2(LoadSamplesSse2(pY + x), cb, cr, pOut + x * 4);
+        }
+#endif
+        for (; x < width; ++x)
+        {
+            if (pCb)
+                ConvertPixel(pY[x], pCb[x] - 128, pCr[x] - 128, pOut + x * 4);
+            else
+                ConvertPixel(pY[x], 0, 0, pOut + x * 4);
+        }
+    }
+
+    /**
+     * 3 times the nearest chroma row plus the other one around the output
+     * row, a sample copied to either end for the horizontal filter.
+     */
+    static void BlendChromaRows(const uint8_t* pNear, const uint8_t* pFar, uint32_t width, int16_t* pSum)
+    {
+        uint32_t x = 0;
+#if defined(PANDA_COLOR_SSE2)
+        for (; x + 8 <= width; x += 8)
+        {
+            __m128i nearest = LoadSamplesSse2(pNear + x);
+            __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(nearest, 1), nearest), LoadSamplesSse2(pFar + x));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pSum + x), sum);
+        }
+#endif
+        for (; x < width; ++x)
+            pSum[x] = static_cast<int16_t>(3 * pNear[x] + pFar[x]);
+
+        pSum[-1] = pSum[0];
+        pSum[width] = pSum[width - 1];
+    }
+
+    // chroma from BlendChromaRows, half the columns of luma when shiftX is 1
+    static void ConvertRowUpsampled(const uint8_t* pY, const int16_t* pCbSum, const int16_t* pCrSum,
+        uint32_t width, uint32_t shiftX, uint8_t* pOut)
+    {
+        uint32_t x = 0;
+#if defined(PANDA_COLOR_SSE2)
+        const __m128i center = _mm_set1_epi16(128);
+        if (shiftX)
+        {
+            const __m128i roundEven = _mm_set1_epi16(8);
+            const __m128i roundOdd = _mm_set1_epi16(7);
+            auto upsample = [&](const int16_t* pSum) {
+                __m128i previous = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSum - 1));
+                __m128i current = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSum));
+                __m128i next = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSum + 1));
+                __m128i current3 = _mm_add_epi16(_mm_slli_epi16(current, 1), current);
+                __m128i even = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(current3, previous), roundEven), 4);
+                __m128i odd = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(current3, next), roundOdd), 4);
+                return _mm_sub_epi16(_mm_unpacklo_epi16(even, odd), center);
+            };
+            for (; x + 8 <= width; x += 8)
+                ConvertPixelsSse2(LoadSamplesSse2(pY + x), upsample(pCbSum + (x >> 1)), upsample(pCrSum + (x >> 1)), pOut + x * 4);
+        }
+        else
+        {
+            const __m128i round = _mm_set1_epi16(2);
+            auto scale = [&](const int16_t* pSum) {
+                __m128i sum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSum));
+                return _mm_sub_epi16(_mm_srli_epi16(_mm_add_epi16(sum, round), 2), center);
+            };
+            for (; x + 8 <= width; x += 8)
+                ConvertPixelsSse2(LoadSamplesSse2(pY + x), scale(pCbSum + x), scale(pCrSum + x), pOut + x * 4);
+        }
+#endif
+        for (; x < width; ++x)
+        {
+            if (!shiftX)
+                ConvertPixel(pY[x], ((pCbSum[x] + 2) >> 2) - 128, ((pCrSum[x] + 2) >> 2) - 128, pOut + x * 4);
+            else if (x & 1)
+                ConvertPixel(pY[x], UpsampleOdd(pCbSum, x), UpsampleOdd(pCrSum, x), pOut + x * 4);
+            else
+                ConvertPixel(pY[x], UpsampleEven(pCbSum, x), UpsampleEven(pCrSum, x), pOut + x * 4);
+        }
+    }
+
+    void ConvertYCbCr2RGBA(const YCbCrPlanes& planes, uint32_t firstRow, uint32_t endRow, Image& img)
+    {
+        endRow = std::min(endRow, planes.Height);
+        if (firstRow >= endRow || planes.Width == 0)
+            return;
+
+        bool isSubsampled = planes.Cb && (planes.ChromaShiftX || planes.ChromaShiftY);
+        uint32_t chromaWidth = (planes.Width + planes.ChromaShiftX) >> planes.ChromaShiftX;
+        uint32_t chromaHeight = (planes.Height + planes.ChromaShiftY) >> planes.ChromaShiftY;
+
+        // a blended row of each chroma plane, with room for the sample copied to either end
+        std::vector<int16_t> sums(isSubsampled ? 2 * (chromaWidth + 2) : 0);
+        int16_t* pCbSum = sums.data() + 1;
+        int16_t* pCrSum = sums.data() + chromaWidth + 3;
+
+        for (uint32_t row = firstRow; row < endRow; ++row)
+        {
+            const uint8_t* pY = planes.Y + static_cast<size_t>(planes.LumaPitch) * row;
+            uint8_t* pOut = reinterpret_cast<uint8_t*>(img.Data) + static_cast<size_t>(img.Pitch) * row;
+            if (!isSubsampled)
+            {
+                size_t offset = static_cast<size_t>(planes.ChromaPitch) * row;
+                ConvertRow(pY, planes.Cb ? planes.Cb + offset : nullptr, planes.Cr ? planes.Cr + offset : nullptr, planes.Width, pOut);
+                continue;
+            }
+
+            // the row lies a quarter of the way from its nearest chroma row to the one above or below
+            uint32_t nearest = row >> planes.ChromaShiftY;
+            uint32_t other = nearest;
+            if (planes.ChromaShiftY)
+                other = (row & 1) ? std::min(nearest + 1, chromaHeight - 1) : (nearest ? nearest - 1 : 0);
+
+            size_t nearOffset = static_cast<size_t>(planes.ChromaPitch) * nearest;
+            size_t otherOffset = static_cast<size_t>(planes.ChromaPitch) * other;
+            BlendChromaRows(planes.Cb + nearOffset, planes.Cb + otherOffset, chromaWidth, pCbSum);
+            BlendChromaRows(planes.Cr + nearOffset, planes.Cr + otherOffset, chromaWidth, pCrSum);
+            ConvertRowUpsampled(pY, pCbSum, pCrSum, planes.Width, planes.ChromaShiftX, pOut);
+        }
+    }
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <algorithm>
 #include "Math/PandaMath.hpp"
+#include "Image.hpp"
 #include "portable.hpp"
 
 namespace Panda
@@ -39,4 +40,33 @@ namespace Panda
 					std::clamp<float>(result[1] + 0.5f, 0.0f, 255.0f),
 					std::clamp<float>(result[2] + 0.5f, 0.0f, 255.0f) });
     }
-}
\ No newline at end of file
+
+    /**
+     * 8 bit YCbCr component planes, the chroma ones at full resolution or
+     * with half the columns and/or half the rows of luma, centered between
+     * the luma samples as JFIF sites them.
+     */
+    struct YCbCrPlanes
+    {
+        const uint8_t* Y;
+        const uint8_t* Cb;      // nullptr with Cr for grayscale
+        const uint8_t* Cr;
+        uint32_t LumaPitch;     // bytes from one row to the next
+        uint32_t ChromaPitch;
+        uint32_t Width;         // in luma samples
+        uint32_t Height;
+        uint32_t ChromaShiftX;  // 1 when chroma has half the columns, 4:2:2 and 4:2:0
+        uint32_t ChromaShiftY;  // 1 when chroma has half the rows, 4:2:0
+    };
+
+    /**
+     * Convert rows firstRow to endRow - 1 of planes into the R8G8B8A8 pixels
+     * of img, which has to be at least planes.Width by planes.Height. The
+     * conversion is in 14 bit fixed point and runs 8 pixels at a time with
+     * SSE2. Subsampled chroma is interpolated as it is converted, each sample
+     * weighted 3/4 against 1/4 of its neighbour in either direction (the
+     * "fancy" upsampling of libjpeg), rather than repeated.
+     * Disjoint ranges of rows can be converted on different threads.
+     */
+    void ConvertYCbCr2RGBA(const YCbCrPlanes& planes, uint32_t firstRow, uint32_t endRow, Image& img);
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <memory>
+#include <new>
+#include <vector>
+#include "MemoryManager.hpp"
+
+namespace Panda
+{
+    /**
+     * STL allocator over MemoryManager::AllocateFrame.
+     * Allocation is a pointer bump and deallocation does nothing, the memory goes
+     * away when the frame arena is reset, two ticks later. Only use it for data
+     * that is rebuilt every frame on the main thread.
+     * Outside Initialize()/Finalize() there is no arena and allocate() throws
+     * std::bad_alloc like any other STL allocator that is out of memory.
+     */
+    template <typename T>
+    class FrameAllocator
+    {
+        public:
+            typedef T value_type;
+
+            FrameAllocator() noexcept {}
+            template <typename U>
+            FrameAllocator(const FrameAllocator<U>&) noexcept {}
+
+            T* allocate(size_t n)
+            {
+                if (n > static_cast<size_t>(-1) / sizeof(T))
+                    throw std::bad_alloc();
+
+                void* p = g_pMemoryManager ? g_pMemoryManager->AllocateFrame(n * sizeof(T), alignof(T)) : nullptr;
+                if (p == nullptr)
+                    throw std::bad_alloc();
+
+                return reinterpret_cast<T*>(p);
+            }
+
+            void deallocate(T*, size_t) noexcept {}
+    };
+
+    template <typename T, typename U>
+    inline bool operator==(const FrameAllocator<T>&, const FrameAllocator<U>&) noexcept {return true;}
+
+    template <typename T, typename U>
+    inline bool operator!=(const FrameAllocator<T>&, const FrameAllocator<U>&) noexcept {return false;}
+
+    template <typename T>
+    using FrameVector = std::vector<T, FrameAllocator<T>>;
+}
@@ -0,0 +1,135 @@
+// 打开PANDA_OVERRIDE_GLOBAL_NEW后，全局operator new/delete都经过MemoryManager。
+// MemoryManager初始化之前和Finalize()之后的分配直接来自系统，
+// 随时都会还给系统；Finalize()时还没有释放的池中的块随页一起释放了，之后的delete会被忽略。
+// 带尺寸的operator delete也使用Free(void*)：初始化之前分配的小块不在池中，
+// 不能按尺寸归还给分配器。
+#if defined(PANDA_OVERRIDE_GLOBAL_NEW)
+#include <cstddef>
+#include <new>
+#include "MemoryManager.hpp"
+
+using namespace Panda;
+
+// operator new的结果要满足__STDCPP_DEFAULT_NEW_ALIGNMENT__（x64上是16），
+// 池中较小的尺寸只按k_Alignment对齐，所以按对齐的版本分配
+#if defined(__STDCPP_DEFAULT_NEW_ALIGNMENT__)
+static const size_t k_NewAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+#else
+static const size_t k_NewAlignment = alignof(std::max_align_t);
+#endif
+
+void* operator new(size_t size)
+{
+	void* p = MemoryManager::Allocate(size, k_NewAlignment);
+	if (p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	void* p = MemoryManager::Allocate(size, k_NewAlignment);
+	if (p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return MemoryManager::Allocate(size, k_NewAlignment);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return MemoryManager::Allocate(size, k_NewAlignment);
+}
+
+void operator delete(void* p) noexcept
+{
+	MemoryManager::Free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	MemoryManager::Free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+	MemoryManager::Free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+	MemoryManager::Free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	MemoryManager::Free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	MemoryManager::Free(p);
+}
+
+#if defined(__cpp_aligned_new)
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	void* p = MemoryManager::Allocate(size, static_cast<size_t>(alignment));
+	if (p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	void* p = MemoryManager::Allocate(size, static_cast<size_t>(alignment));
+	if (p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return MemoryManager::Allocate(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return MemoryManager::Allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+	MemoryManager::Free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+	MemoryManager::Free(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	MemoryManager::Free(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	MemoryManager::Free(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept
+{
+	MemoryManager::Free(p);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t) noexcept
+{
+	MemoryManager::Free(p);
+}
+#endif
+
+#endif
@@ -1,8 +1,13 @@
+#if defined(_WIN32)
 #include <windows.h>
+#else
+#include <chrono>
+#endif
 #include "HighPrecisionTimer.hpp"
 
 namespace Panda
 {
+#if defined(_WIN32)
     HighPrecisionTimer::HighPrecisionTimer()
         :m_MillisecondsPerCount(0.0), m_StartTime(0), m_StopTime(0)
         {
@@ -10,6 +15,14 @@ namespace Panda
             QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
             m_MillisecondsPerCount = 1000.0 / (double)countsPerSec;
         }
+#else
+    typedef std::chrono::steady_clock Clock;
+
+    HighPrecisionTimer::HighPrecisionTimer()
+        :m_MillisecondsPerCount(1000.0 * Clock::period::num / Clock::period::den), m_StartTime(0), m_StopTime(0)
+        {
+        }
+#endif
 
 	int64_t HighPrecisionTimer::TotalClockCount() const
 	{
@@ -21,6 +34,7 @@ namespace Panda
         return (float)((m_StopTime - m_StartTime) * m_MillisecondsPerCount);
     }
 
+#if defined(_WIN32)
     void HighPrecisionTimer::Start()
     {
         QueryPerformanceCounter((LARGE_INTEGER*)&m_StartTime);
@@ -30,4 +44,15 @@ namespace Panda
     {
         QueryPerformanceCounter((LARGE_INTEGER*)&m_StopTime);
     }
+#else
+    void HighPrecisionTimer::Start()
+    {
+        m_StartTime = Clock::now().time_since_epoch().count();
+    }
+
+    void HighPrecisionTimer::Stop()
+    {
+        m_StopTime = Clock::now().time_since_epoch().count();
+    }
+#endif
 }
\ No newline at end of file
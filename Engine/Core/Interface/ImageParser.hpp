@@ -2,12 +2,23 @@
 #include "Interface.hpp"
 #include "Image.hpp"
 #include "Buffer.hpp"
+#include "BufferView.hpp"
+#include "AssetStream.hpp"
 
 namespace Panda
 {
     Interface ImageParser
     {
     public:
-        virtual Image Parse(Buffer& buf) = 0;
+        // a Buffer converts to a view implicitly, without copying
+        virtual Image Parse(const BufferView& buf) = 0;
+
+        // parsers that can not decode a chunk at a time read the rest of the stream first
+        virtual Image Parse(AssetStream& stream)
+        {
+            Buffer buf(stream.GetSize() - stream.GetPosition());
+            size_t size = stream.Read(buf.GetData(), buf.GetDataSize());
+            return Parse(BufferView(std::move(buf)).Slice(0, size));
+        }
     };
 }
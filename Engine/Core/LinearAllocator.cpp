@@ -0,0 +1,105 @@
+#include <assert.h>
+#include "LinearAllocator.hpp"
+
+#ifndef ALIGN
+#define ALIGN(n, a) (((n) + (a - 1)) & ~((a) - 1))		// 获取对齐的最小值
+#endif
+
+Panda::LinearAllocator::LinearAllocator()
+	:m_ChunkSize(0), m_pChunkList(nullptr), m_pCurrent(nullptr), m_pEnd(nullptr),
+	m_UsedSize(0), m_PeakSize(0)
+{
+}
+
+Panda::LinearAllocator::LinearAllocator(size_t inChunkSize)
+	:m_pChunkList(nullptr), m_pCurrent(nullptr), m_pEnd(nullptr),
+	m_UsedSize(0), m_PeakSize(0)
+{
+	Reset(inChunkSize);
+}
+
+Panda::LinearAllocator::~LinearAllocator()
+{
+	FreeAll();
+}
+
+void Panda::LinearAllocator::Reset(size_t inChunkSize)
+{
+	FreeAll();
+
+	m_ChunkSize = inChunkSize;
+	m_PeakSize = 0;
+}
+
+void* Panda::LinearAllocator::Allocate(size_t inSize, size_t alignment)
+{
+	// alignment必须是2的幂
+	assert((alignment & (alignment - 1)) == 0);
+
+	uint8_t* p = reinterpret_cast<uint8_t*>(ALIGN(reinterpret_cast<uintptr_t>(m_pCurrent), alignment));
+	if (m_pCurrent == nullptr || p + inSize > m_pEnd)
+		return AllocateFromNewChunk(inSize, alignment);
+
+	m_UsedSize += (p + inSize) - m_pCurrent;
+	m_pCurrent = p + inSize;
+	return p;
+}
+
+void* Panda::LinearAllocator::AllocateFromNewChunk(size_t inSize, size_t alignment)
+{
+	size_t chunkSize = sizeof(ChunkHeader) + inSize + alignment;
+	if (chunkSize < m_ChunkSize)
+		chunkSize = m_ChunkSize;
+
+	ChunkHeader* pChunk = reinterpret_cast<ChunkHeader*>(new uint8_t[chunkSize]);
+	pChunk->Size = chunkSize;
+	pChunk->pNext = m_pChunkList;
+	m_pChunkList = pChunk;
+
+	m_pCurrent = pChunk->Start();
+	m_pEnd = reinterpret_cast<uint8_t*>(pChunk) + chunkSize;
+
+	uint8_t* p = reinterpret_cast<uint8_t*>(ALIGN(reinterpret_cast<uintptr_t>(m_pCurrent), alignment));
+	m_UsedSize += (p + inSize) - m_pCurrent;
+	m_pCurrent = p + inSize;
+	return p;
+}
+
+void Panda::LinearAllocator::Clear()
+{
+	if (m_UsedSize > m_PeakSize)
+		m_PeakSize = m_UsedSize;
+	m_UsedSize = 0;
+
+	if (m_pChunkList == nullptr)
+		return;
+
+	if (m_pChunkList->pNext)
+	{
+		// 这个周期用了不止一块，合并成一块足够大的，下个周期就只需要移动指针了
+		FreeAll();
+		size_t chunkSize = sizeof(ChunkHeader) + m_PeakSize;
+		if (chunkSize > m_ChunkSize)
+			m_ChunkSize = chunkSize;
+		return;
+	}
+
+	m_pCurrent = m_pChunkList->Start();
+	m_pEnd = reinterpret_cast<uint8_t*>(m_pChunkList) + m_pChunkList->Size;
+}
+
+void Panda::LinearAllocator::FreeAll()
+{
+	ChunkHeader* pFree = m_pChunkList;
+	while (pFree) {
+		ChunkHeader* pTemp = pFree;
+		pFree = pFree->pNext;
+
+		delete[] reinterpret_cast<uint8_t*>(pTemp);
+	}
+
+	m_pChunkList = nullptr;
+	m_pCurrent = nullptr;
+	m_pEnd = nullptr;
+	m_UsedSize = 0;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Panda {
+	// 线性（指针递增）分配器。
+	// 分配只是移动指针，不支持单独释放，只能通过Clear()整体回收。
+	// 不是线程安全的。
+	class LinearAllocator {
+	public:
+		LinearAllocator();
+		LinearAllocator(size_t inChunkSize);
+		~LinearAllocator();
+
+		void Reset(size_t inChunkSize);
+		void* Allocate(size_t inSize, size_t alignment);
+
+		// 回收所有分配，保留内存供下次使用
+		void Clear();
+		void FreeAll();
+
+		size_t GetUsedSize() const { return m_UsedSize; }
+
+	private:
+		struct ChunkHeader {
+			ChunkHeader*	pNext;
+			size_t			Size;		// 包括块头
+			uint8_t* Start() {
+				return reinterpret_cast<uint8_t*>(this + 1);
+			}
+		};
+
+		void* AllocateFromNewChunk(size_t inSize, size_t alignment);
+
+		// 禁用拷贝构造函数和赋值操作符
+		LinearAllocator(const LinearAllocator& clone);
+		LinearAllocator& operator=(const LinearAllocator& rhs);
+
+	private:
+		size_t			m_ChunkSize;		// 默认的块尺寸
+		ChunkHeader*	m_pChunkList;		// 块列表，表头是当前使用的块
+		uint8_t*		m_pCurrent;			// 当前块中下一次分配的位置
+		uint8_t*		m_pEnd;				// 当前块的结尾
+		size_t			m_UsedSize;			// 自上次Clear()以来分配的字节数
+		size_t			m_PeakSize;			// 一次Clear()周期内分配的最大字节数
+	};
+}
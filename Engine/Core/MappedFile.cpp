@@ -0,0 +1,104 @@
+#include "MappedFile.hpp"
+#if defined(_WIN32)
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace Panda
+{
+    bool MappedFile::Map(FILE* fp, AccessPattern pattern)
+    {
+        Unmap();
+        if (!fp)
+            return false;
+
+#if defined(_WIN32)
+        HANDLE file = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(fp)));
+        LARGE_INTEGER size;
+        if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size))
+            return false;
+
+        // an empty file can not be mapped, but it is still a valid, empty result
+        if (size.QuadPart == 0)
+            return true;
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping)
+            return false;
+
+        void* p = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!p)
+        {
+            CloseHandle(mapping);
+            return false;
+        }
+
+        m_pMapping = mapping;
+        m_pData = reinterpret_cast<const uint8_t*>(p);
+        m_Size = static_cast<size_t>(size.QuadPart);
+#else
+        int fd = fileno(fp);
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+            return false;
+
+        if (st.st_size == 0)
+            return true;
+
+        void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+            return false;
+
+        m_pData = reinterpret_cast<const uint8_t*>(p);
+        m_Size = static_cast<size_t>(st.st_size);
+#endif
+
+        Advise(pattern);
+        return true;
+    }
+
+    void MappedFile::Unmap()
+    {
+        if (m_pData)
+        {
+#if defined(_WIN32)
+            UnmapViewOfFile(m_pData);
+            CloseHandle(static_cast<HANDLE>(m_pMapping));
+#else
+            munmap(const_cast<uint8_t*>(m_pData), m_Size);
+#endif
+        }
+
+        m_pData = nullptr;
+        m_Size = 0;
+        m_pMapping = nullptr;
+    }
+
+    /**
+     * Only a hint, a parser reading front to back gets the pages read ahead
+     * and dropped behind it. Windows reads ahead on its own.
+     */
+    void MappedFile::Advise(AccessPattern pattern)
+    {
+        if (!m_pData)
+            return;
+
+#if !defined(_WIN32)
+        void* p = const_cast<uint8_t*>(m_pData);
+        if (pattern == PANDA_ACCESS_SEQUENTIAL)
+        {
+            madvise(p, m_Size, MADV_SEQUENTIAL);
+            madvise(p, m_Size, MADV_WILLNEED);
+        }
+        else
+        {
+            madvise(p, m_Size, MADV_RANDOM);
+        }
+#else
+        (void)pattern;
+#endif
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+
+namespace Panda
+{
+    /**
+     * Read-only memory mapping of a whole file.
+     * The pages are read from the file system cache on first touch, so the
+     * content never goes through a heap buffer. The mapping stays valid after
+     * the FILE it was made from is closed.
+     */
+    class MappedFile
+    {
+        public:
+            enum AccessPattern
+            {
+                PANDA_ACCESS_SEQUENTIAL = 0,    // parsed front to back, read ahead aggressively
+                PANDA_ACCESS_RANDOM     = 1     // jumped around in, e.g. an archive
+            };
+
+            MappedFile() : m_pData(nullptr), m_Size(0), m_pMapping(nullptr) {}
+            ~MappedFile() {Unmap();}
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            // false when the file can not be mapped, e.g. it is a pipe
+            bool Map(FILE* fp, AccessPattern pattern = PANDA_ACCESS_SEQUENTIAL);
+            void Unmap();
+
+            void Advise(AccessPattern pattern);
+
+            const uint8_t* GetData() const {return m_pData;}
+            size_t GetDataSize() const {return m_Size;}
+
+        private:
+            const uint8_t* m_pData;
+            size_t m_Size;
+            void* m_pMapping;   // the file mapping object on Windows
+    };
+}
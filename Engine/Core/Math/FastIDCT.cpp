@@ -0,0 +1,487 @@
+#include <atomic>
+#include <cmath>
+#include "FastIDCT.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#   define PANDA_IDCT_X86 1
+#   include <immintrin.h>
+#   if defined(_MSC_VER)
+#       include <intrin.h>
+        // MSVC compiles any intrinsic without a switch
+#       define PANDA_TARGET_SSE2
+#       define PANDA_TARGET_AVX2
+#   else
+        // only these functions get the instructions, the CPU is checked before they are called
+#       define PANDA_TARGET_SSE2 __attribute__((target("sse2")))
+#       define PANDA_TARGET_AVX2 __attribute__((target("avx2")))
+#   endif
+#endif
+
+namespace Panda
+{
+    // cos(k * PI / 16) * sqrt(2), 1 for k = 0, the scale of each output of the AAN transform
+    static const float k_AanScale[8] = {
+        1.0f, 1.387039845f, 1.306562965f, 1.175875602f,
+        1.0f, 0.785694958f, 0.541196100f, 0.275899379f
+    };
+
+    void PrepareIdctQuantization(const float quantization[64], IdctQuantization& out)
+    {
+        for (int32_t row = 0; row < 8; ++row)
+        {
+            for (int32_t col = 0; col < 8; ++col)
+            {
+                int32_t i = row * 8 + col;
+                // the 1/8 of the two dimensional transform goes in here too
+                out.Scaled[i] = quantization[i] * k_AanScale[row] * k_AanScale[col] * 0.125f;
+                out.Integer[i] = static_cast<int32_t>(quantization[i]);
+            }
+        }
+    }
+
+    /**
+     * One dimensional AAN inverse transform of 8 values in place (Arai, Agui
+     * and Nakajima, as in libjpeg's jidctflt.c), the inputs already multiplied
+     * by their scale factor. A macro so that every kernel runs it on its own
+     * type and with its own instructions.
+     */
+#define PANDA_AAN_IDCT_1D(T, ADD, SUB, MUL, K, v0, v1, v2, v3, v4, v5, v6, v7) \
+    { \
+        /* even part */ \
+        T tmp10 = ADD(v0, v4); \
+        T tmp11 = SUB(v0, v4); \
+        T tmp13 = ADD(v2, v6); \
+        T tmp12 = SUB(MUL(SUB(v2, v6), K(1.414213562f)), tmp13); \
+        T even0 = ADD(tmp10, tmp13); \
+        T even3 = SUB(tmp10, tmp13); \
+        T even1 = ADD(tmp11, tmp12); \
+        T even2 = SUB(tmp11, tmp12); \
+        /* odd part */ \
+        T z13 = ADD(v5, v3); \
+        T z10 = SUB(v5, v3); \
+        T z11 = ADD(v1, v7); \
+        T z12 = SUB(v1, v7); \
+        T odd7 = ADD(z11, z13); \
+        T odd11 = MUL(SUB(z11, z13), K(1.414213562f)); \
+        T z5 = MUL(ADD(z10, z12), K(1.847759065f)); \
+        T odd10 = SUB(MUL(z12, K(1.082392200f)), z5); \
+        T odd12 = ADD(MUL(z10, K(-2.613125930f)), z5); \
+        T odd6 = SUB(odd12, odd7); \
+        T odd5 = SUB(odd11, odd6); \
+        T odd4 = ADD(odd10, odd5); \
+        v0 = ADD(even0, odd7); \
+        v7 = SUB(even0, odd7); \
+        v1 = ADD(even1, odd6); \
+        v6 = SUB(even1, odd6); \
+        v2 = ADD(even2, odd5); \
+        v5 = SUB(even2, odd5); \
+        v4 = ADD(even3, odd4); \
+        v3 = SUB(even3, odd4); \
+    }
+
+#define PANDA_SCALAR_ADD(a, b) ((a) + (b))
+#define PANDA_SCALAR_SUB(a, b) ((a) - (b))
+#define PANDA_SCALAR_MUL(a, b) ((a) * (b))
+#define PANDA_SCALAR_K(k) (k)
+
+    static uint8_t ClampSample(int32_t value)
+    {
+        return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+    }
+
+    static void DequantizeIDCT8x8Scalar(const int16_t coefficients[64], const IdctQuantization& quantization, uint8_t out[64])
+    {
+        float block[64];
+
+        // columns
+        for (int32_t col = 0; col < 8; ++col)
+        {
+            const int16_t* in = coefficients + col;
+            const float* q = quantization.Scaled + col;
+            float* p = block + col;
+
+            if ((in[8] | in[16] | in[24] | in[32] | in[40] | in[48] | in[56]) == 0)
+            {
+                // most columns are their DC alone, which is the whole column
+                float dc = in[0] * q[0];
+                for (int32_t row = 0; row < 8; ++row)
+                    p[row * 8] = dc;
+                continue;
+            }
+
+            float v0 = in[0] * q[0], v1 = in[8] * q[8], v2 = in[16] * q[16], v3 = in[24] * q[24];
+            float v4 = in[32] * q[32], v5 = in[40] * q[40], v6 = in[48] * q[48], v7 = in[56] * q[56];
+            PANDA_AAN_IDCT_1D(float, PANDA_SCALAR_ADD, PANDA_SCALAR_SUB, PANDA_SCALAR_MUL, PANDA_SCALAR_K,
+                v0, v1, v2, v3, v4, v5, v6, v7);
+            p[0] = v0; p[8] = v1; p[16] = v2; p[24] = v3;
+            p[32] = v4; p[40] = v5; p[48] = v6; p[56] = v7;
+        }
+
+        // rows, then the level shift
+        for (int32_t row = 0; row < 8; ++row)
+        {
+            float* p = block + row * 8;
+            float v0 = p[0], v1 = p[1], v2 = p[2], v3 = p[3], v4 = p[4], v5 = p[5], v6 = p[6], v7 = p[7];
+            PANDA_AAN_IDCT_1D(float, PANDA_SCALAR_ADD, PANDA_SCALAR_SUB, PANDA_SCALAR_MUL, PANDA_SCALAR_K,
+                v0, v1, v2, v3, v4, v5, v6, v7);
+            uint8_t* o = out + row * 8;
+            o[0] = ClampSample(static_cast<int32_t>(lrintf(v0 + 128.0f)));
+            o[1] = ClampSample(static_cast<int32_t>(lrintf(v1 + 128.0f)));
+            o[2] = ClampSample(static_cast<int32_t>(lrintf(v2 + 128.0f)));
+            o[3] = ClampSample(static_cast<int32_t>(lrintf(v3 + 128.0f)));
+            o[4] = ClampSample(static_cast<int32_t>(lrintf(v4 + 128.0f)));
+            o[5] = ClampSample(static_cast<int32_t>(lrintf(v5 + 128.0f)));
+            o[6] = ClampSample(static_cast<int32_t>(lrintf(v6 + 128.0f)));
+            o[7] = ClampSample(static_cast<int32_t>(lrintf(v7 + 128.0f)));
+        }
+    }
+
+    /**
+     * Loeffler, Ligtenberg and Moschytz in fixed point, as libjpeg's
+     * jidctint.c: constants with 13 fractional bits, 2 more bits kept
+     * between the passes.
+     */
+    static const int32_t k_ConstBits = 13;
+    static const int32_t k_Pass1Bits = 2;
+
+    static const int32_t k_Fix_0_298631336 = 2446;
+    static const int32_t k_Fix_0_390180644 = 3196;
+    static const int32_t k_Fix_0_541196100 = 4433;
+    static const int32_t k_Fix_0_765366865 = 6270;
+    static const int32_t k_Fix_0_899976223 = 7373;
+    static const int32_t k_Fix_1_175875602 = 9633;
+    static const int32_t k_Fix_1_501321110 = 12299;
+    static const int32_t k_Fix_1_847759065 = 15137;
+    static const int32_t k_Fix_1_961570560 = 16069;
+    static const int32_t k_Fix_2_053119869 = 16819;
+    static const int32_t k_Fix_2_562915447 = 20995;
+    static const int32_t k_Fix_3_072711026 = 25172;
+
+    static int32_t Descale(int32_t value, int32_t bits)
+    {
+        return (value + (1 << (bits - 1))) >> bits;
+    }
+
+    // the even and odd halves of the LLM transform, shared by both passes
+    static void LoefflerIDCT1D(int32_t v0, int32_t v1, int32_t v2, int32_t v3, int32_t v4, int32_t v5, int32_t v6, int32_t v7,
+        int32_t result[8])
+    {
+        // even part
+        int32_t z1 = (v2 + v6) * k_Fix_0_541196100;
+        int32_t tmp2 = z1 - v6 * k_Fix_1_847759065;
+        int32_t tmp3 = z1 + v2 * k_Fix_0_765366865;
+        int32_t tmp0 = (v0 + v4) * (1 << k_ConstBits);
+        int32_t tmp1 = (v0 - v4) * (1 << k_ConstBits);
+
+        int32_t tmp10 = tmp0 + tmp3;
+        int32_t tmp13 = tmp0 - tmp3;
+        int32_t tmp11 = tmp1 + tmp2;
+        int32_t tmp12 = tmp1 - tmp2;
+
+        // odd part
+        tmp0 = v7;
+        tmp1 = v5;
+        tmp2 = v3;
+        tmp3 = v1;
+        z1 = tmp0 + tmp3;
+        int32_t z2 = tmp1 + tmp2;
+        int32_t z3 = tmp0 + tmp2;
+        int32_t z4 = tmp1 + tmp3;
+        int32_t z5 = (z3 + z4) * k_Fix_1_175875602;
+
+        tmp0 *= k_Fix_0_298631336;
+        tmp1 *= k_Fix_2_053119869;
+        tmp2 *= k_Fix_3_072711026;
+        tmp3 *= k_Fix_1_501321110;
+        z1 *= -k_Fix_0_899976223;
+        z2 *= -k_Fix_2_562915447;
+        z3 = z3 * -k_Fix_1_961570560 + z5;
+        z4 = z4 * -k_Fix_0_390180644 + z5;
+
+        tmp0 += z1 + z3;
+        tmp1 += z2 + z4;
+        tmp2 += z2 + z3;
+        tmp3 += z1 + z4;
+
+        result[0] = tmp10 + tmp3;
+        result[7] = tmp10 - tmp3;
+        result[1] = tmp11 + tmp2;
+        result[6] = tmp11 - tmp2;
+        result[2] = tmp12 + tmp1;
+        result[5] = tmp12 - tmp1;
+        result[3] = tmp13 + tmp0;
+        result[4] = tmp13 - tmp0;
+    }
+
+    static void DequantizeIDCT8x8FixedPoint(const int16_t coefficients[64], const IdctQuantization& quantization, uint8_t out[64])
+    {
+        int32_t block[64];
+        int32_t result[8];
+
+        // columns, scaled up by k_Pass1Bits
+        for (int32_t col = 0; col < 8; ++col)
+        {
+            const int16_t* in = coefficients + col;
+            const int32_t* q = quantization.Integer + col;
+            int32_t* p = block + col;
+
+            if ((in[8] | in[16] | in[24] | in[32] | in[40] | in[48] | in[56]) == 0)
+            {
+                int32_t dc = in[0] * q[0] * (1 << k_Pass1Bits);
+                for (int32_t row = 0; row < 8; ++row)
+                    p[row * 8] = dc;
+                continue;
+            }
+
+            LoefflerIDCT1D(in[0] * q[0], in[8] * q[8], in[16] * q[16], in[24] * q[24],
+                in[32] * q[32], in[40] * q[40], in[48] * q[48], in[56] * q[56], result);
+            for (int32_t row = 0; row < 8; ++row)
+                p[row * 8] = Descale(result[row], k_ConstBits - k_Pass1Bits);
+        }
+
+        // rows, taking out the scale of both passes and the 1/8 of the transform
+        for (int32_t row = 0; row < 8; ++row)
+        {
+            const int32_t* p = block + row * 8;
+            uint8_t* o = out + row * 8;
+            LoefflerIDCT1D(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], result);
+            for (int32_t col = 0; col < 8; ++col)
+                o[col] = ClampSample(Descale(result[col], k_ConstBits + k_Pass1Bits + 3) + 128);
+        }
+    }
+
+#if defined(PANDA_IDCT_X86)
+#define PANDA_SSE_ADD(a, b) _mm_add_ps(a, b)
+#define PANDA_SSE_SUB(a, b) _mm_sub_ps(a, b)
+#define PANDA_SSE_MUL(a, b) _mm_mul_ps(a, b)
+#define PANDA_SSE_K(k) _mm_set1_ps(k)
+
+    // the rows of a block are the left and right halves, 4 columns each
+    PANDA_TARGET_SSE2 static void TransposeSse2(__m128 left[8], __m128 right[8])
+    {
+        _MM_TRANSPOSE4_PS(left[0], left[1], left[2], left[3]);
+        _MM_TRANSPOSE4_PS(left[4], left[5], left[6], left[7]);
+        _MM_TRANSPOSE4_PS(right[0], right[1], right[2], right[3]);
+        _MM_TRANSPOSE4_PS(right[4], right[5], right[6], right[7]);
+
+        // the top right and bottom left quarters trade places
+        for (int32_t i = 0; i < 4; ++i)
+        {
+            __m128 tmp = left[4 + i];
+            left[4 + i] = right[i];
+            right[i] = tmp;
+        }
+    }
+
+    PANDA_TARGET_SSE2 static void DequantizeIDCT8x8Sse2(const int16_t coefficients[64], const IdctQuantization& quantization, uint8_t out[64])
+    {
+        __m128 left[8], right[8];
+        for (int32_t row = 0; row < 8; ++row)
+        {
+            __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefficients + row * 8));
+            __m128i sign = _mm_srai_epi16(in, 15);
+            left[row] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(in, sign)), _mm_loadu_ps(quantization.Scaled + row * 8));
+            right[row] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(in, sign)), _mm_loadu_ps(quantization.Scaled + row * 8 + 4));
+        }
+
+        // columns, then rows through the transposed block
+        for (int32_t pass = 0; pass < 2; ++pass)
+        {
+            PANDA_AAN_IDCT_1D(__m128, PANDA_SSE_ADD, PANDA_SSE_SUB, PANDA_SSE_MUL, PANDA_SSE_K,
+                left[0], left[1], left[2], left[3], left[4], left[5], left[6], left[7]);
+            PANDA_AAN_IDCT_1D(__m128, PANDA_SSE_ADD, PANDA_SSE_SUB, PANDA_SSE_MUL, PANDA_SSE_K,
+                right[0], right[1], right[2], right[3], right[4], right[5], right[6], right[7]);
+            TransposeSse2(left, right);
+        }
+
+        // round, saturate to 16 bits and then to 0 - 255
+        __m128 levelShift = _mm_set1_ps(128.0f);
+        for (int32_t row = 0; row < 8; ++row)
+        {
+            __m128i l = _mm_cvtps_epi32(_mm_add_ps(left[row], levelShift));
+            __m128i r = _mm_cvtps_epi32(_mm_add_ps(right[row], levelShift));
+            __m128i samples = _mm_packs_epi32(l, r);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + row * 8), _mm_packus_epi16(samples, samples));
+        }
+    }
+
+#define PANDA_AVX_ADD(a, b) _mm256_add_ps(a, b)
+#define PANDA_AVX_SUB(a, b) _mm256_sub_ps(a, b)
+#define PANDA_AVX_MUL(a, b) _mm256_mul_ps(a, b)
+#define PANDA_AVX_K(k) _mm256_set1_ps(k)
+
+    PANDA_TARGET_AVX2 static void TransposeAvx2(__m256 rows[8])
+    {
+        __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+        __m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+        __m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+        __m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+        __m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+        __m256 t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+        __m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+        __m256 t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+
+        __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+        rows[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+        rows[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+        rows[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+        rows[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+        rows[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+        rows[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+        rows[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+        rows[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+    }
+
+    PANDA_TARGET_AVX2 static void DequantizeIDCT8x8Avx2(const int16_t coefficients[64], const IdctQuantization& quantization, uint8_t out[64])
+    {
+        __m256 rows[8];
+        for (int32_t row = 0; row < 8; ++row)
+        {
+            __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefficients + row * 8));
+            rows[row] = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(in)), _mm256_loadu_ps(quantization.Scaled + row * 8));
+        }
+
+        for (int32_t pass = 0; pass < 2; ++pass)
+        {
+            PANDA_AAN_IDCT_1D(__m256, PANDA_AVX_ADD, PANDA_AVX_SUB, PANDA_AVX_MUL, PANDA_AVX_K,
+                rows[0], rows[1], rows[2], rows[3], rows[4], rows[5], rows[6], rows[7]);
+            TransposeAvx2(rows);
+        }
+
+        __m256 levelShift = _mm256_set1_ps(128.0f);
+        for (int32_t row = 0; row < 8; ++row)
+        {
+            __m256i samples = _mm256_cvtps_epi32(_mm256_add_ps(rows[row], levelShift));
+            __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(samples), _mm256_extracti128_si256(samples, 1));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + row * 8), _mm_packus_epi16(packed, packed));
+        }
+    }
+
+    static bool CpuHasSse2()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        return (info[3] & (1 << 26)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+#endif
+    }
+
+    static bool CpuHasAvx2()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+
+        // the OS has to save the ymm registers too
+        __cpuid(info, 1);
+        const int osxsaveAndAvx = (1 << 27) | (1 << 28);
+        if ((info[2] & osxsaveAndAvx) != osxsaveAndAvx || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    typedef void (*IdctFunction)(const int16_t coefficients[64], const IdctQuantization& quantization, uint8_t out[64]);
+
+    static const IdctFunction k_IdctFunctions[PANDA_IDCT_KERNEL_COUNT] = {
+        DequantizeIDCT8x8Scalar,
+        DequantizeIDCT8x8FixedPoint,
+#if defined(PANDA_IDCT_X86)
+        DequantizeIDCT8x8Sse2,
+        DequantizeIDCT8x8Avx2
+#else
+        nullptr,
+        nullptr
+#endif
+    };
+
+    static std::atomic<int32_t> s_IdctKernel{-1};   // -1 until chosen
+
+    bool IsIdctKernelSupported(IdctKernel kernel)
+    {
+        switch (kernel)
+        {
+            case PANDA_IDCT_SCALAR:
+            case PANDA_IDCT_FIXED_POINT:
+                return true;
+#if defined(PANDA_IDCT_X86)
+            case PANDA_IDCT_SSE2:
+            {
+                static const bool hasSse2 = CpuHasSse2();
+                return hasSse2;
+            }
+            case PANDA_IDCT_AVX2:
+            {
+                static const bool hasAvx2 = CpuHasAvx2();
+                return hasAvx2;
+            }
+#endif
+            default:
+                return false;
+        }
+    }
+
+    IdctKernel GetIdctKernel()
+    {
+        int32_t kernel = s_IdctKernel.load(std::memory_order_relaxed);
+        if (kernel < 0)
+        {
+            // without SIMD the integer kernel is the cheaper one
+            kernel = PANDA_IDCT_FIXED_POINT;
+            if (IsIdctKernelSupported(PANDA_IDCT_AVX2))
+                kernel = PANDA_IDCT_AVX2;
+            else if (IsIdctKernelSupported(PANDA_IDCT_SSE2))
+                kernel = PANDA_IDCT_SSE2;
+
+            // whichever thread gets here first, they all choose the same
+            s_IdctKernel.store(kernel, std::memory_order_relaxed);
+        }
+
+        return static_cast<IdctKernel>(kernel);
+    }
+
+    bool SetIdctKernel(IdctKernel kernel)
+    {
+        if (kernel < 0 || kernel >= PANDA_IDCT_KERNEL_COUNT || !IsIdctKernelSupported(kernel))
+            return false;
+
+        s_IdctKernel.store(kernel, std::memory_order_relaxed);
+        return true;
+    }
+
+    const char* GetIdctKernelName(IdctKernel kernel)
+    {
+        switch (kernel)
+        {
+            case PANDA_IDCT_SCALAR:         return "scalar";
+            case PANDA_IDCT_FIXED_POINT:    return "fixed point";
+            case PANDA_IDCT_SSE2:           return "SSE2";
+            case PANDA_IDCT_AVX2:           return "AVX2";
+            default:                        return "unknown";
+        }
+    }
+
+    void DequantizeIDCT8x8(const int16_t coefficients[64], const IdctQuantization& quantization, uint8_t out[64])
+    {
+        k_IdctFunctions[GetIdctKernel()](coefficients, quantization, out);
+    }
+}
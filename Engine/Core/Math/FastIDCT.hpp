@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+namespace Panda
+{
+    enum IdctKernel
+    {
+        PANDA_IDCT_SCALAR       = 0,    // AAN in floats, one value at a time
+        PANDA_IDCT_FIXED_POINT  = 1,    // Loeffler in 32 bit integers, 13 fractional bits
+        PANDA_IDCT_SSE2         = 2,    // AAN in floats, 4 columns at a time
+        PANDA_IDCT_AVX2         = 3,    // AAN in floats, a whole row at a time
+        PANDA_IDCT_KERNEL_COUNT = 4
+    };
+
+    /**
+     * A quantization table scaled for the kernels, so dequantizing is one
+     * multiply in the first pass of the transform rather than a pass of its
+     * own: the float kernels fold the AAN scale factors of each row and column
+     * in, the fixed point kernel takes the table as it is.
+     */
+    struct IdctQuantization
+    {
+        alignas(32) float Scaled[64];
+        alignas(32) int32_t Integer[64];
+    };
+
+    // quantization in natural (not zigzag) order
+    void PrepareIdctQuantization(const float quantization[64], IdctQuantization& out);
+
+    /**
+     * Dequantize the coefficients of an 8x8 block, in natural order, inverse
+     * transform them and level shift the result to samples of 0 to 255.
+     * Runs on the kernel chosen for the CPU, the first call chooses it.
+     */
+    void DequantizeIDCT8x8(const int16_t coefficients[64], const IdctQuantization& quantization, uint8_t out[64]);
+
+    bool IsIdctKernelSupported(IdctKernel kernel);
+    // the fastest kernel the CPU supports unless another one has been set
+    IdctKernel GetIdctKernel();
+    // for comparing the kernels, returns false and keeps the current one when the CPU lacks it
+    bool SetIdctKernel(IdctKernel kernel);
+    const char* GetIdctKernelName(IdctKernel kernel);
+}
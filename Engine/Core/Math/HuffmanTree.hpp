@@ -1,6 +1,12 @@
 #pragma once
 
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
 #include <memory>
+#include <queue>
+#include <string>
 #include <vector>
 #include "portable.hpp"
 
@@ -221,4 +227,191 @@ namespace Panda
                 std::cout << std::endl;
             }
     };
-}
\ No newline at end of file
+
+    /**
+     * The canonical codes of a JPEG DHT table, decoded by lookup rather than
+     * by walking a tree. The first k_LookupBits of the stream index a table
+     * that gives the symbol and the length of every code that short, the
+     * longer codes are found by comparing against the largest code of each
+     * length (ITU-T81 F.2.2.3). Takes the same arguments as HuffmanTree.
+     */
+    template<typename T>
+    class HuffmanTable
+    {
+        public:
+            static const uint32_t k_LookupBits = 9;
+
+        protected:
+            struct LookupEntry
+            {
+                T Value;
+                uint8_t Length;     // 0 when the code is longer than k_LookupBits
+            };
+
+            LookupEntry m_Lookup[1 << k_LookupBits];
+            int32_t m_MaxCode[17];      // largest code of each length, -1 when there is none
+            int32_t m_ValueOffset[17];  // code of each length to its index in m_Values
+            std::vector<T> m_Values;
+            std::vector<std::pair<uint16_t, uint8_t>> m_Codes; // code and length of each value
+
+        public:
+            HuffmanTable() { Clear(); }
+
+            void Clear()
+            {
+                memset(m_Lookup, 0x00, sizeof(m_Lookup));
+                for (size_t i = 0; i < 17; ++i)
+                {
+                    m_MaxCode[i] = -1;
+                    m_ValueOffset[i] = 0;
+                }
+                m_Values.clear();
+                m_Codes.clear();
+            }
+
+            // returns the number of symbols, 0 for a table whose codes do not fit their lengths
+            size_t PopulateWithHuffmanTable(const uint8_t numOfCodes[16], const T* codeValues)
+            {
+                Clear();
+
+                // a DHT table has 256 symbols at most, and no length can have more codes than it has bits for
+                uint32_t total = 0;
+                uint32_t code = 0;
+                for (uint32_t length = 1; length <= 16; ++length)
+                {
+                    total += numOfCodes[length - 1];
+                    code += numOfCodes[length - 1];
+                    if (code > (1u << length))
+                        return 0;
+                    code <<= 1;
+                }
+                if (total > 256)
+                    return 0;
+
+                // codes of one length count up, the next length starts at the following code shifted left
+                code = 0;
+                for (uint32_t length = 1; length <= 16; ++length)
+                {
+                    uint8_t count = numOfCodes[length - 1];
+                    if (count)
+                    {
+                        m_ValueOffset[length] = static_cast<int32_t>(m_Values.size()) - static_cast<int32_t>(code);
+                        for (uint8_t i = 0; i < count; ++i)
+                        {
+                            T value = codeValues[m_Values.size()];
+                            if (length <= k_LookupBits)
+                            {
+                                // every index that starts with the code
+                                uint32_t first = code << (k_LookupBits - length);
+                                uint32_t last = (code + 1) << (k_LookupBits - length);
+                                for (uint32_t index = first; index < last; ++index)
+                                {
+                                    m_Lookup[index].Value = value;
+                                    m_Lookup[index].Length = static_cast<uint8_t>(length);
+                                }
+                            }
+                            m_Values.push_back(value);
+                            m_Codes.emplace_back(static_cast<uint16_t>(code), static_cast<uint8_t>(length));
+                            code++;
+                        }
+                        m_MaxCode[length] = static_cast<int32_t>(code) - 1;
+                    }
+                    code <<= 1;
+                }
+
+                return m_Values.size();
+            }
+
+            T DecodeSingleValue(const uint8_t* encodedStream, const size_t encodeStreamLength,
+                size_t* byteOffset, uint8_t* bitOffset)
+            {
+                size_t i = *byteOffset;
+                if (i < encodeStreamLength)
+                {
+                    // the next 24 bits at the top, at least 17 of them ahead of bitOffset, zeros past the end
+                    uint32_t bits = static_cast<uint32_t>(encodedStream[i]) << 16;
+                    if (i + 2 < encodeStreamLength)
+                    {
+                        bits |= (static_cast<uint32_t>(encodedStream[i + 1]) << 8) | encodedStream[i + 2];
+                    }
+                    else if (i + 1 < encodeStreamLength)
+                    {
+                        bits |= static_cast<uint32_t>(encodedStream[i + 1]) << 8;
+                    }
+                    bits = (bits << *bitOffset) & 0xFFFFFF;
+
+                    uint32_t length;
+                    T value;
+                    const LookupEntry& entry = m_Lookup[bits >> (24 - k_LookupBits)];
+                    if (entry.Length)
+                    {
+                        length = entry.Length;
+                        value = entry.Value;
+                    }
+                    else
+                    {
+                        // the code is longer than the lookup
+                        length = k_LookupBits + 1;
+                        while (length <= 16 && static_cast<int32_t>(bits >> (24 - length)) > m_MaxCode[length])
+                        {
+                            length++;
+                        }
+                        value = (length <= 16) ? m_Values[m_ValueOffset[length] + (bits >> (24 - length))] : 0;
+                    }
+
+                    size_t bitsLeft = (encodeStreamLength - i) * 8 - *bitOffset;
+                    if (length <= 16 && length <= bitsLeft)
+                    {
+                        size_t bitPosition = *bitOffset + length;
+                        *byteOffset = i + (bitPosition >> 3);
+                        *bitOffset = static_cast<uint8_t>(bitPosition & 0x07);
+                        return value;
+                    }
+                }
+
+                // decode failed, either the stream ended or the code is not in the table
+                *byteOffset = -1;
+                *bitOffset = -1;
+
+                return 0;
+            }
+
+            // the next code of a bit reader with PeekBits() and SkipBits(), 0 when it is not in the table
+            template<typename BitReader>
+            T DecodeSingleValue(BitReader& reader) const
+            {
+                uint32_t bits = reader.PeekBits(16);
+                const LookupEntry& entry = m_Lookup[bits >> (16 - k_LookupBits)];
+                if (entry.Length)
+                {
+                    reader.SkipBits(entry.Length);
+                    return entry.Value;
+                }
+
+                uint32_t length = k_LookupBits + 1;
+                while (length <= 16 && static_cast<int32_t>(bits >> (16 - length)) > m_MaxCode[length])
+                {
+                    length++;
+                }
+                if (length > 16)
+                    return 0;
+
+                reader.SkipBits(length);
+                return m_Values[m_ValueOffset[length] + (bits >> (16 - length))];
+            }
+
+            void Dump()
+            {
+                for (size_t i = 0; i < m_Values.size(); ++i)
+                {
+                    std::string bitStream;
+                    for (int32_t bit = m_Codes[i].second - 1; bit >= 0; --bit)
+                    {
+                        bitStream += ((m_Codes[i].first >> bit) & 0x01) ? "1" : "0";
+                    }
+                    printf("%20s | %x\n", bitStream.c_str(), m_Values[i]);
+                }
+                std::cout << std::endl;
+            }
+    };
+}
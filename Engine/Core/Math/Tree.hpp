@@ -1,6 +1,8 @@
 #pragma once
 #include <iostream>
 #include <list>
+#include <memory>
+#include "PandaAllocator.hpp"
 
 namespace Panda
 {
@@ -8,7 +10,7 @@ namespace Panda
     {
         protected:
             TreeNode* m_Parent;
-            std::list<std::shared_ptr<TreeNode>> m_Children;
+            PandaList<std::shared_ptr<TreeNode>> m_Children;
 
         protected:
             virtual void Dump(std::ostream& out) const {}
@@ -1,28 +1,84 @@
 #include "MemoryManager.hpp"
+#include "ThreadCache.hpp"
+#include "PageAllocator.hpp"
+#include "PageMap.hpp"
+#include "MemoryTrace.hpp"
 #include <cstdlib>
+#include <fstream>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
 
 #ifndef ALIGN
 #define ALIGN(x,a)	(((x) + ((a) - 1)) & ~((a) - 1))
 #endif
 
+// 打开PANDA_MEMORY_TRACE后记录每一次分配和释放，给MemoryBench回放
+#if defined(PANDA_MEMORY_TRACE)
+#define TRACE_ALLOC(p, size, alignment)	MemoryTrace::RecordAlloc(p, size, alignment)
+#define TRACE_FREE(p)					MemoryTrace::RecordFree(p)
+#else
+#define TRACE_ALLOC(p, size, alignment)
+#define TRACE_FREE(p)
+#endif
+
 using namespace Panda;
 
 namespace Panda
 {
 	Allocator* MemoryManager::m_pAllocators = nullptr;
+	std::mutex* MemoryManager::m_pAllocatorLocks = nullptr;
 	uint32_t* MemoryManager::m_pLookUpTable = nullptr;
-	bool MemoryManager::m_IsInitialized = false;
+	LinearAllocator* MemoryManager::m_pFrameAllocators = nullptr;
+	RelocatableHeap* MemoryManager::m_pRelocatableHeap = nullptr;
+	uint32_t MemoryManager::m_FrameIndex = 0;
+	std::atomic<bool> MemoryManager::m_IsInitialized(false);
+	std::atomic<uint32_t> MemoryManager::m_Epoch(0);
+	uint32_t MemoryManager::m_TickCount = 0;
+
+	AllocationCounters* MemoryManager::m_pCounters = nullptr;
+	uint64_t* MemoryManager::m_pPeakLiveBlocks = nullptr;
+	uint64_t* MemoryManager::m_pLastAllocCounts = nullptr;
+	uint64_t MemoryManager::m_LastLargeAllocCount = 0;
+	double MemoryManager::m_LastStatsTime = 0.0;
+	std::atomic<uint64_t> MemoryManager::m_LargeAllocCount(0);
+	std::atomic<uint64_t> MemoryManager::m_LargeFreeCount(0);
+	std::atomic<uint64_t> MemoryManager::m_LargeTotalBytes(0);
+	std::atomic<uint64_t> MemoryManager::m_LargeLiveBytes(0);
+	std::atomic<uint64_t> MemoryManager::m_LargePeakLiveBytes(0);
+	std::chrono::steady_clock::time_point MemoryManager::m_StartTime;
+	std::string MemoryManager::m_StatsDumpPath;
+	MemoryStatsFormat MemoryManager::m_StatsDumpFormat = MemoryStatsFormat::kMemoryStatsCsv;
+	uint32_t MemoryManager::m_StatsDumpInterval = 0;
+}
+
+// 分配器的tag是尺寸类别加1
+static_assert(k_BlockSizeCount < PageMap::k_RetiredTag, "page tags collide with PageMap::k_RetiredTag");
+
+namespace
+{
+	// AlignedMalloc分配的内存前面的块头
+	struct LargeBlockHeader {
+		void*		pBase;		// 系统分配的地址
+		size_t		Size;
+		uint32_t	Epoch;		// 分配时的m_Epoch，没有计入统计时为0
+	};
 }
 
 int Panda::MemoryManager::Initialize() {
-	if (!m_IsInitialized) 
+	if (!m_IsInitialized.load(std::memory_order_acquire)) 
 	{
+		// 上一次Finalize()退役的页已经还给系统，这些地址现在可能是系统分配的大块内存
+		PageMap::EraseRetired();
+
 		// 初始化分配器
 		m_pAllocators = new Allocator[k_BlockSizeCount];
 		for (size_t i = 0; i < k_BlockSizeCount; ++i) 
 		{
 			m_pAllocators[i].Reset(k_PageSize, k_BlockSizes[i], k_Alignment);
+			m_pAllocators[i].SetPageTag(static_cast<uint8_t>(i + 1));
 		}
+		m_pAllocatorLocks = new std::mutex[k_BlockSizeCount];
 
 		// 初始化查询表
 		m_pLookUpTable = new uint32_t[k_MaxBlockSize + 1];
@@ -36,8 +92,34 @@ int Panda::MemoryManager::Initialize() {
 			
 			m_pLookUpTable[i] = j;
 		}
+
+		// 初始化帧分配器
+		m_pFrameAllocators = new LinearAllocator[k_FrameArenaCount];
+		for (size_t i = 0; i < k_FrameArenaCount; ++i)
+		{
+			m_pFrameAllocators[i].Reset(k_FrameArenaSize);
+		}
+		m_FrameIndex = 0;
+		m_TickCount = 0;
+
+		// 初始化可移动堆，第一次分配时才向系统申请内存
+		m_pRelocatableHeap = new RelocatableHeap(k_RelocatableChunkSize);
+
+		// 初始化统计
+		m_pCounters = new AllocationCounters[k_BlockSizeCount];
+		m_pPeakLiveBlocks = new uint64_t[k_BlockSizeCount]();
+		m_pLastAllocCounts = new uint64_t[k_BlockSizeCount]();
+		m_LastLargeAllocCount = 0;
+		m_LastStatsTime = 0.0;
+		m_LargeAllocCount = 0;
+		m_LargeFreeCount = 0;
+		m_LargeTotalBytes = 0;
+		m_LargeLiveBytes = 0;
+		m_LargePeakLiveBytes = 0;
+		m_StartTime = std::chrono::steady_clock::now();
 	
-		m_IsInitialized = true;
+		m_IsInitialized.store(true, std::memory_order_release);
+		m_Epoch.fetch_add(1, std::memory_order_release);
 	}
 
 	return 0;
@@ -45,65 +127,375 @@ int Panda::MemoryManager::Initialize() {
 
 void Panda::MemoryManager::Finalize()
 {
+	// 可移动堆的内存块来自AlignedMalloc，要在统计失效之前还回去
+	delete m_pRelocatableHeap;
+	m_pRelocatableHeap = nullptr;
+
+	// 先让所有线程缓存失效，它们缓存的块属于即将释放的页
+	m_Epoch.fetch_add(1, std::memory_order_release);
+	m_IsInitialized.store(false, std::memory_order_release);
+
 	delete[] m_pAllocators;
+	delete[] m_pAllocatorLocks;
 	delete[] m_pLookUpTable;
-	m_IsInitialized = false;
+	delete[] m_pFrameAllocators;
+	delete[] m_pCounters;
+	delete[] m_pPeakLiveBlocks;
+	delete[] m_pLastAllocCounts;
+	m_pAllocators = nullptr;
+	m_pAllocatorLocks = nullptr;
+	m_pLookUpTable = nullptr;
+	m_pFrameAllocators = nullptr;
+	m_pCounters = nullptr;
+	m_pPeakLiveBlocks = nullptr;
+	m_pLastAllocCounts = nullptr;
+
+	PageAllocator::ReleaseAll();
 }
 
 void Panda::MemoryManager::Tick()
 {
+	// 切换到另一个帧分配器，它上面是两帧之前分配的内存，可以整体回收了
+	m_FrameIndex = (m_FrameIndex + 1) % k_FrameArenaCount;
+	m_pFrameAllocators[m_FrameIndex].Clear();
+
+	m_pRelocatableHeap->Compact(k_CompactBytesPerTick);
+
+	if (++m_TickCount % k_TrimInterval == 0)
+		TrimPages();
+
+	if (m_StatsDumpInterval && m_TickCount % m_StatsDumpInterval == 0)
+		DumpStats(m_StatsDumpPath.c_str(), m_StatsDumpFormat);
 }
 
 void* Panda::MemoryManager::Allocate(size_t inSize)
 {
-	Allocator* pAlloc = LookUpAllocator(inSize);
-	
-	if (pAlloc)
-		return pAlloc->Allocate();
+	void* p;
+	if (m_IsInitialized.load(std::memory_order_acquire) && inSize <= k_MaxBlockSize)
+		p = AllocateBlock(m_pLookUpTable[inSize], inSize);
 	else
-		return malloc(inSize);
+		p = AlignedMalloc(inSize, Allocator::MAX_BLOCK_ALIGNMENT);
+
+	TRACE_ALLOC(p, inSize, 0);		// 0表示默认对齐
+	return p;
 }
 
 void* Panda::MemoryManager::Allocate(size_t inSize, size_t alignment)
 {
-	/* Here are "From 0 Series" codes */
-	// uint8_t* p;
-	// inSize += alignment;
-	// Allocator* pAlloc = LookUpAllocator(inSize);
-	// if (pAlloc)
-	// 	p = reinterpret_cast<uint8_t*> (pAlloc->Allocate());
-	// else
-	// {
-	// 	p = reinterpret_cast<uint8_t*> (malloc(inSize));
-	// }
+	void* p;
+	uint32_t index;
+	if (m_IsInitialized.load(std::memory_order_acquire) && LookUpAlignedIndex(inSize, alignment, index))
+		p = AllocateBlock(index, inSize);
+	else
+		p = AlignedMalloc(inSize, alignment);
 
-	// p = reinterpret_cast<uint8_t*>(ALIGN(reinterpret_cast<size_t>(p), alignment));
+	TRACE_ALLOC(p, inSize, alignment);
+	return p;
+}
 
-	// return static_cast<void*>(p);
-	
-	/* Here are my codes */
-	uint8_t* p;
-	size_t size = ALIGN(inSize, alignment);
-	return Allocate(size);
+void* Panda::MemoryManager::AllocateFrame(size_t inSize, size_t alignment)
+{
+	// 帧分配器只在Initialize()和Finalize()之间存在
+	if (m_pFrameAllocators == nullptr)
+		return nullptr;
+
+	return m_pFrameAllocators[m_FrameIndex].Allocate(inSize, alignment);
+}
+
+RelocatableHandle Panda::MemoryManager::AllocateRelocatable(size_t inSize, size_t alignment)
+{
+	return m_pRelocatableHeap ? m_pRelocatableHeap->Allocate(inSize, alignment) : RelocatableHandle();
+}
+
+void Panda::MemoryManager::FreeRelocatable(RelocatableHandle handle)
+{
+	// 资源的析构可能发生在Finalize()之后
+	if (m_pRelocatableHeap)
+		m_pRelocatableHeap->Free(handle);
+}
+
+void* Panda::MemoryManager::Resolve(RelocatableHandle handle)
+{
+	return m_pRelocatableHeap ? m_pRelocatableHeap->Resolve(handle) : nullptr;
+}
+
+void* Panda::MemoryManager::PinRelocatable(RelocatableHandle handle)
+{
+	return m_pRelocatableHeap ? m_pRelocatableHeap->Pin(handle) : nullptr;
+}
+
+void Panda::MemoryManager::UnpinRelocatable(RelocatableHandle handle)
+{
+	if (m_pRelocatableHeap)
+		m_pRelocatableHeap->Unpin(handle);
 }
 
 void Panda::MemoryManager::Free(void* p, size_t inSize) 
 {
-	if (m_IsInitialized)
+	// 没有查询表，按地址判断
+	if (!m_IsInitialized.load(std::memory_order_acquire))
+		return Free(p);
+
+	TRACE_FREE(p);
+	if (inSize <= k_MaxBlockSize)
+		FreeBlock(p, m_pLookUpTable[inSize]);
+	else
+		AlignedFree(p);		
+}
+
+void Panda::MemoryManager::Free(void* p, size_t inSize, size_t alignment)
+{
+	if (!m_IsInitialized.load(std::memory_order_acquire))
+		return Free(p);
+
+	TRACE_FREE(p);
+	uint32_t index;
+	if (LookUpAlignedIndex(inSize, alignment, index))
+		FreeBlock(p, index);
+	else
+		AlignedFree(p);
+}
+
+void Panda::MemoryManager::Free(void* p)
+{
+	if (p == nullptr)
+		return;
+
+	TRACE_FREE(p);
+	uint8_t tag = PageMap::Find(p);
+	if (tag == 0)
+	{
+		// 不在池中的页里，是AlignedMalloc分配的，块头记录了系统分配的地址，与是否初始化无关
+		AlignedFree(p);
+	}
+	else if (tag != PageMap::k_RetiredTag)
 	{
-		Allocator* pAlloc = LookUpAllocator(inSize);
-		
-		if (pAlloc)
-			pAlloc->Free(p);
-		else
-			free(p);		
+		FreeBlock(p, tag - 1);
 	}
+	// k_RetiredTag：Finalize()时随页一起释放的池中的块，只能忽略。
+	// 系统之后可能把这些地址分配给新的大块内存，它们的释放也会被忽略，直到下一次Initialize()
 }
 
-Panda::Allocator* Panda::MemoryManager::LookUpAllocator(size_t inSize)
+void* Panda::MemoryManager::AllocateBlock(uint32_t index, size_t inSize)
 {
-	if (inSize <= k_MaxBlockSize)
-		return m_pAllocators + m_pLookUpTable[inSize];
-	else
+	ThreadCache* pCache = ThreadCache::Get();
+	if (pCache)
+		return pCache->Allocate(index, inSize);
+
+	AllocationCounters pending;
+	pending.AllocCount = 1;
+	pending.RequestedBytes = inSize;
+	void* p;
+	RefillCache(index, &p, 1, pending);
+	return p;
+}
+
+void Panda::MemoryManager::FreeBlock(void* p, uint32_t index)
+{
+	ThreadCache* pCache = ThreadCache::Get();
+	if (pCache)
+	{
+		pCache->Free(p, index);
+		return;
+	}
+
+	AllocationCounters pending;
+	pending.FreeCount = 1;
+	FlushCache(index, &p, 1, pending);
+}
+
+bool Panda::MemoryManager::LookUpAlignedIndex(size_t inSize, size_t alignment, uint32_t& index)
+{
+	if (alignment < k_Alignment)
+		alignment = k_Alignment;
+	if (alignment > Allocator::MAX_BLOCK_ALIGNMENT)
+		return false;
+
+	size_t size = ALIGN(inSize, alignment);
+	if (size > k_MaxBlockSize)
+		return false;
+
+	// 找到尺寸足够并且块的对齐值满足要求的最小的分配器
+	index = m_pLookUpTable[size];
+	while (index < k_BlockSizeCount && m_pAllocators[index].GetBlockAlignment() < alignment)
+		++index;
+
+	return index < k_BlockSizeCount;
+}
+
+void* Panda::MemoryManager::AlignedMalloc(size_t inSize, size_t alignment)
+{
+	if (alignment < Allocator::MAX_BLOCK_ALIGNMENT)
+		alignment = Allocator::MAX_BLOCK_ALIGNMENT;
+
+	// 块头放在返回地址之前，占用一个对齐值的空间
+	size_t offset = ALIGN(sizeof(LargeBlockHeader), alignment);
+
+#if defined(_WIN32)
+	void* pBase = _aligned_malloc(offset + inSize, alignment);
+	if (pBase == nullptr)
 		return nullptr;
+#else
+	void* pBase = nullptr;
+	if (posix_memalign(&pBase, alignment, offset + inSize) != 0)
+		return nullptr;
+#endif
+
+	uint8_t* p = reinterpret_cast<uint8_t*>(pBase) + offset;
+	LargeBlockHeader* pHeader = reinterpret_cast<LargeBlockHeader*>(p) - 1;
+	pHeader->pBase = pBase;
+	pHeader->Size = inSize;
+	pHeader->Epoch = 0;
+
+	// Initialize()之前的分配不计入统计
+	if (m_IsInitialized.load(std::memory_order_acquire))
+	{
+		pHeader->Epoch = m_Epoch.load(std::memory_order_relaxed);
+		CountLargeAlloc(inSize);
+	}
+
+	return p;
+}
+
+void Panda::MemoryManager::AlignedFree(void* p)
+{
+	LargeBlockHeader* pHeader = reinterpret_cast<LargeBlockHeader*>(p) - 1;
+	if (m_IsInitialized.load(std::memory_order_acquire) && pHeader->Epoch == m_Epoch.load(std::memory_order_relaxed))
+		CountLargeFree(pHeader->Size);
+
+#if defined(_WIN32)
+	_aligned_free(pHeader->pBase);
+#else
+	free(pHeader->pBase);
+#endif
+}
+
+uint32_t Panda::MemoryManager::RefillCache(uint32_t index, void** ppBlocks, uint32_t count, AllocationCounters& pending)
+{
+	std::lock_guard<std::mutex> lock(m_pAllocatorLocks[index]);
+	MergeCounters(index, pending);
+	Allocator& alloc = m_pAllocators[index];
+	for (uint32_t i = 0; i < count; ++i)
+		ppBlocks[i] = alloc.Allocate();
+
+	return count;
+}
+
+void Panda::MemoryManager::FlushCache(uint32_t index, void** ppBlocks, uint32_t count, AllocationCounters& pending)
+{
+	std::lock_guard<std::mutex> lock(m_pAllocatorLocks[index]);
+	MergeCounters(index, pending);
+	Allocator& alloc = m_pAllocators[index];
+	for (uint32_t i = 0; i < count; ++i)
+		alloc.Free(ppBlocks[i]);
+}
+
+void Panda::MemoryManager::MergeCounters(uint32_t index, AllocationCounters& pending)
+{
+	AllocationCounters& counters = m_pCounters[index];
+	counters.AllocCount += pending.AllocCount;
+	counters.FreeCount += pending.FreeCount;
+	counters.RequestedBytes += pending.RequestedBytes;
+	pending = AllocationCounters();
+
+	// 线程缓存成批地合并计数，峰值只在合并时采样，两次合并之间更高的峰值会漏掉。
+	// 每次分配都更新峰值需要共享的原子计数，线程缓存就失去意义了
+	if (counters.AllocCount > counters.FreeCount && counters.AllocCount - counters.FreeCount > m_pPeakLiveBlocks[index])
+		m_pPeakLiveBlocks[index] = counters.AllocCount - counters.FreeCount;
+}
+
+size_t Panda::MemoryManager::TrimPages()
+{
+	size_t releaseCount = 0;
+	for (uint32_t i = 0; i < k_BlockSizeCount; ++i)
+	{
+		// 其他线程正在使用的分配器下次再整理，不在主循环里等锁
+		std::unique_lock<std::mutex> lock(m_pAllocatorLocks[i], std::try_to_lock);
+		if (lock.owns_lock())
+			releaseCount += m_pAllocators[i].Trim(k_KeepEmptyPageCount);
+	}
+
+	if (releaseCount)
+		PageAllocator::Purge();
+
+	return releaseCount;
+}
+
+void Panda::MemoryManager::CountLargeAlloc(size_t inSize)
+{
+	m_LargeAllocCount.fetch_add(1, std::memory_order_relaxed);
+	m_LargeTotalBytes.fetch_add(inSize, std::memory_order_relaxed);
+	uint64_t live = m_LargeLiveBytes.fetch_add(inSize, std::memory_order_relaxed) + inSize;
+	uint64_t peak = m_LargePeakLiveBytes.load(std::memory_order_relaxed);
+	while (live > peak && !m_LargePeakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+		;
+}
+
+void Panda::MemoryManager::CountLargeFree(size_t inSize)
+{
+	m_LargeFreeCount.fetch_add(1, std::memory_order_relaxed);
+	m_LargeLiveBytes.fetch_sub(inSize, std::memory_order_relaxed);
+}
+
+void Panda::MemoryManager::GetStats(MemoryStats& stats)
+{
+	ThreadCache* pCache = ThreadCache::Get();
+	if (pCache)
+		pCache->PublishCounters();
+
+	double now = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_StartTime).count();
+	double elapsed = now - m_LastStatsTime;
+	m_LastStatsTime = now;
+
+	stats.ElapsedSeconds = now;
+	stats.SizeClasses.resize(k_BlockSizeCount);
+	for (uint32_t i = 0; i < k_BlockSizeCount; ++i)
+	{
+		std::lock_guard<std::mutex> lock(m_pAllocatorLocks[i]);
+		const Allocator& alloc = m_pAllocators[i];
+		const AllocationCounters& counters = m_pCounters[i];
+		SizeClassStats& sc = stats.SizeClasses[i];
+
+		sc.BlockSize = k_BlockSizes[i];
+		sc.AllocCount = counters.AllocCount;
+		sc.FreeCount = counters.FreeCount;
+		sc.AllocsPerSecond = elapsed > 0.0 ? (counters.AllocCount - m_pLastAllocCounts[i]) / elapsed : 0.0;
+		sc.LiveBlocks = counters.AllocCount > counters.FreeCount ? counters.AllocCount - counters.FreeCount : 0;
+		sc.PeakLiveBlocks = m_pPeakLiveBlocks[i];
+		sc.PageCount = alloc.GetPageCount();
+		sc.BlockCount = alloc.GetBlockCount();
+		sc.PageUtilization = sc.BlockCount ? static_cast<double>(sc.LiveBlocks) / sc.BlockCount : 0.0;
+		sc.RequestedBytes = counters.RequestedBytes;
+		sc.RoundingWasteBytes = counters.AllocCount * alloc.GetBlockSize() - counters.RequestedBytes;
+
+		m_pLastAllocCounts[i] = counters.AllocCount;
+	}
+
+	LargeAllocStats& large = stats.Large;
+	large.AllocCount = m_LargeAllocCount.load(std::memory_order_relaxed);
+	large.FreeCount = m_LargeFreeCount.load(std::memory_order_relaxed);
+	large.AllocsPerSecond = elapsed > 0.0 ? (large.AllocCount - m_LastLargeAllocCount) / elapsed : 0.0;
+	large.TotalBytes = m_LargeTotalBytes.load(std::memory_order_relaxed);
+	large.LiveBytes = m_LargeLiveBytes.load(std::memory_order_relaxed);
+	large.PeakLiveBytes = m_LargePeakLiveBytes.load(std::memory_order_relaxed);
+	m_LastLargeAllocCount = large.AllocCount;
+}
+
+bool Panda::MemoryManager::DumpStats(const char* path, MemoryStatsFormat format)
+{
+	std::ofstream out(path);
+	if (!out)
+		return false;
+
+	MemoryStats stats;
+	GetStats(stats);
+	WriteMemoryStats(out, stats, format);
+	return true;
+}
+
+void Panda::MemoryManager::SetStatsDump(const char* path, MemoryStatsFormat format, uint32_t intervalTicks)
+{
+	m_StatsDumpPath = path ? path : "";
+	m_StatsDumpFormat = format;
+	m_StatsDumpInterval = intervalTicks;
 }
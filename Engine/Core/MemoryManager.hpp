@@ -1,7 +1,14 @@
 #pragma once
 #include "Interface/IRuntimeModule.hpp"
 #include "Allocator.hpp"
+#include "LinearAllocator.hpp"
+#include "RelocatableHeap.hpp"
+#include "MemoryStats.hpp"
 #include <new>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
 
 namespace Panda {
 	static const uint32_t k_BlockSizes[] = {
@@ -18,6 +25,12 @@ namespace Panda {
 	};
 	static const uint32_t k_PageSize = 8192;	// 页尺寸
 	static const uint32_t k_Alignment = 4;		// 对齐值
+	static const uint32_t k_FrameArenaSize = 1024 * 1024;	// 每帧线性分配器的初始尺寸
+	static const uint32_t k_FrameArenaCount = 2;			// 双缓冲，上一帧分配的内存在本帧仍然有效
+	static const uint32_t k_TrimInterval = 60;			// 每隔多少帧把空页还给操作系统
+	static const uint32_t k_KeepEmptyPageCount = 1;		// 每个分配器保留的空页数，避免反复申请和释放
+	static const uint32_t k_RelocatableChunkSize = 16 * 1024 * 1024;	// 可移动堆每次向系统申请的尺寸
+	static const uint32_t k_CompactBytesPerTick = 1024 * 1024;		// 每帧整理可移动堆时最多移动的字节数
 	
 	static const uint32_t k_BlockSizeCount = sizeof (k_BlockSizes) / sizeof (k_BlockSizes[0]);	// 预配置的分配器数量
 	
@@ -37,7 +50,8 @@ namespace Panda {
 		{
 			p->~T();
 			
-			Free(reinterpret_cast<void*>(p), sizeof(T));
+			// 不使用sizeof(T)，通过基类指针删除时尺寸可能不对
+			Free(reinterpret_cast<void*>(p));
 		}
 	public:
 		~MemoryManager() {}
@@ -47,17 +61,95 @@ namespace Panda {
 		virtual void Finalize();
 		virtual void Tick();
 		
-		void* Allocate(size_t inSize);
-		void* Allocate(size_t inSize, size_t alignment);
-		void Free(void* p, size_t inSize);
+		// 在Initialize()之前也可以调用，此时直接从系统分配，只能用Free(void*)释放
+		static void* Allocate(size_t inSize);
+		// 返回的地址保证按alignment对齐，alignment必须是2的幂
+		static void* Allocate(size_t inSize, size_t alignment);
+		static void Free(void* p, size_t inSize);
+		// 释放Allocate(inSize, alignment)分配的内存，参数必须与分配时一致
+		static void Free(void* p, size_t inSize, size_t alignment);
+		// 不需要尺寸：池中的块通过PageMap找到所属的分配器，大块内存的尺寸记录在块头中。
+		// 比传入尺寸的版本多一次查表。
+		// 大块内存和Initialize()之前的分配任何时候都会还给系统；
+		// Finalize()时还没有归还的池中的块随页一起释放了，之后再释放它们会被忽略。
+		static void Free(void* p);
+
+		// 每帧的临时内存，只是移动指针，不需要释放。
+		// 分配的内存在本帧和下一帧有效，之后在Tick()中整体回收。
+		// 只能在主线程中使用。Initialize()之前和Finalize()之后返回nullptr。
+		void* AllocateFrame(size_t inSize, size_t alignment = k_Alignment);
+
+		// 大块、长生命周期的资源（纹理、顶点数据）放在可移动堆中，通过句柄访问。
+		// Tick()会逐步整理可移动堆，Resolve()返回的地址只在下一次Tick()之前有效，
+		// 需要更久时用PinRelocatable()固定
+		static RelocatableHandle AllocateRelocatable(size_t inSize, size_t alignment = 16);
+		static void FreeRelocatable(RelocatableHandle handle);
+		static void* Resolve(RelocatableHandle handle);
+		static void* PinRelocatable(RelocatableHandle handle);
+		static void UnpinRelocatable(RelocatableHandle handle);
+		static RelocatableHeap* GetRelocatableHeap() { return m_pRelocatableHeap; }
+
+		// 统计数据。其他线程的计数在它们的缓存取块或还块时才会合并，
+		// 因此每个线程每个尺寸类别最多有一个弹匣的误差。
+		// AllocsPerSecond是相对上一次调用GetStats()计算的。
+		void GetStats(MemoryStats& stats);
+		bool DumpStats(const char* path, MemoryStatsFormat format);
+
+		// 每隔intervalTicks帧在Tick()中把统计数据写到path，intervalTicks为0时关闭
+		void SetStatsDump(const char* path, MemoryStatsFormat format, uint32_t intervalTicks);
 		
 	private:
-		static Allocator* LookUpAllocator(size_t inSize);
+		friend class ThreadCache;
+
+		// 线程缓存从中心分配器批量取块和归还块，每个尺寸类别一把锁
+		// 同时把线程缓存累计的统计计数合并进来
+		static uint32_t RefillCache(uint32_t index, void** ppBlocks, uint32_t count, AllocationCounters& pending);
+		static void FlushCache(uint32_t index, void** ppBlocks, uint32_t count, AllocationCounters& pending);
+		static void MergeCounters(uint32_t index, AllocationCounters& pending);
+
+		// 释放所有分配器中的空页
+		static size_t TrimPages();
+
+		// 查找满足尺寸和对齐要求的分配器，找不到时直接从系统分配
+		static bool LookUpAlignedIndex(size_t inSize, size_t alignment, uint32_t& index);
+
+		// 经过当前线程的缓存分配和释放，线程退出缓存已经销毁时直接访问中心分配器
+		static void* AllocateBlock(uint32_t index, size_t inSize);
+		static void FreeBlock(void* p, uint32_t index);
+
+		// 超过k_MaxBlockSize的内存直接从系统分配，至少按缓存行对齐。
+		// 块前面有一个块头，记录系统分配的地址和尺寸
+		static void* AlignedMalloc(size_t inSize, size_t alignment);
+		static void AlignedFree(void* p);
+		static void CountLargeAlloc(size_t inSize);
+		static void CountLargeFree(size_t inSize);
 		
 	private:
 		static Allocator* m_pAllocators;
+		static std::mutex* m_pAllocatorLocks;
 		static uint32_t* m_pLookUpTable;
-		static bool		m_IsInitialized;
+		static LinearAllocator* m_pFrameAllocators;
+		static RelocatableHeap* m_pRelocatableHeap;
+		static uint32_t m_FrameIndex;
+		static std::atomic<bool> m_IsInitialized;	// 工作线程的Allocate()/Free()也会读取
+		static std::atomic<uint32_t> m_Epoch;	// 每次初始化和销毁都会改变，用来让线程缓存失效
+		static uint32_t m_TickCount;
+
+		// 统计
+		static AllocationCounters* m_pCounters;
+		static uint64_t* m_pPeakLiveBlocks;
+		static uint64_t* m_pLastAllocCounts;	// 上一次GetStats()时的分配数，用来计算每秒分配数
+		static uint64_t m_LastLargeAllocCount;
+		static double m_LastStatsTime;
+		static std::atomic<uint64_t> m_LargeAllocCount;
+		static std::atomic<uint64_t> m_LargeFreeCount;
+		static std::atomic<uint64_t> m_LargeTotalBytes;
+		static std::atomic<uint64_t> m_LargeLiveBytes;
+		static std::atomic<uint64_t> m_LargePeakLiveBytes;
+		static std::chrono::steady_clock::time_point m_StartTime;
+		static std::string m_StatsDumpPath;
+		static MemoryStatsFormat m_StatsDumpFormat;
+		static uint32_t m_StatsDumpInterval;
 	};
 
 	extern MemoryManager* g_pMemoryManager;
@@ -0,0 +1,86 @@
+#include "MemoryStats.hpp"
+
+namespace Panda
+{
+    static void WriteCsv(std::ostream& out, const MemoryStats& stats)
+    {
+        out << "BlockSize,AllocCount,FreeCount,AllocsPerSecond,LiveBlocks,PeakLiveBlocks,"
+            << "PageCount,BlockCount,PageUtilization,RequestedBytes,RoundingWasteBytes,"
+            << "LiveBytes,PeakLiveBytes" << std::endl;
+
+        for (const SizeClassStats& sc : stats.SizeClasses)
+        {
+            out << sc.BlockSize << ','
+                << sc.AllocCount << ','
+                << sc.FreeCount << ','
+                << sc.AllocsPerSecond << ','
+                << sc.LiveBlocks << ','
+                << sc.PeakLiveBlocks << ','
+                << sc.PageCount << ','
+                << sc.BlockCount << ','
+                << sc.PageUtilization << ','
+                << sc.RequestedBytes << ','
+                << sc.RoundingWasteBytes << ",," << std::endl;
+        }
+
+        // the large allocations go into the same table as a "large" row, only the byte columns apply
+        const LargeAllocStats& large = stats.Large;
+        out << "large,"
+            << large.AllocCount << ','
+            << large.FreeCount << ','
+            << large.AllocsPerSecond << ','
+            << large.AllocCount - large.FreeCount << ",,,,,"
+            << large.TotalBytes << ",,"
+            << large.LiveBytes << ','
+            << large.PeakLiveBytes << std::endl;
+    }
+
+    static void WriteJson(std::ostream& out, const MemoryStats& stats)
+    {
+        out << "{" << std::endl;
+        out << "  \"ElapsedSeconds\": " << stats.ElapsedSeconds << "," << std::endl;
+        out << "  \"SizeClasses\": [" << std::endl;
+        for (size_t i = 0; i < stats.SizeClasses.size(); ++i)
+        {
+            const SizeClassStats& sc = stats.SizeClasses[i];
+            out << "    {"
+                << "\"BlockSize\": " << sc.BlockSize
+                << ", \"AllocCount\": " << sc.AllocCount
+                << ", \"FreeCount\": " << sc.FreeCount
+                << ", \"AllocsPerSecond\": " << sc.AllocsPerSecond
+                << ", \"LiveBlocks\": " << sc.LiveBlocks
+                << ", \"PeakLiveBlocks\": " << sc.PeakLiveBlocks
+                << ", \"PageCount\": " << sc.PageCount
+                << ", \"BlockCount\": " << sc.BlockCount
+                << ", \"PageUtilization\": " << sc.PageUtilization
+                << ", \"RequestedBytes\": " << sc.RequestedBytes
+                << ", \"RoundingWasteBytes\": " << sc.RoundingWasteBytes
+                << "}" << (i + 1 < stats.SizeClasses.size() ? "," : "") << std::endl;
+        }
+        out << "  ]," << std::endl;
+
+        const LargeAllocStats& large = stats.Large;
+        out << "  \"Large\": {"
+            << "\"AllocCount\": " << large.AllocCount
+            << ", \"FreeCount\": " << large.FreeCount
+            << ", \"AllocsPerSecond\": " << large.AllocsPerSecond
+            << ", \"TotalBytes\": " << large.TotalBytes
+            << ", \"LiveBytes\": " << large.LiveBytes
+            << ", \"PeakLiveBytes\": " << large.PeakLiveBytes
+            << "}" << std::endl;
+        out << "}" << std::endl;
+    }
+
+    void WriteMemoryStats(std::ostream& out, const MemoryStats& stats, MemoryStatsFormat format)
+    {
+        switch (format)
+        {
+            case MemoryStatsFormat::kMemoryStatsCsv:
+                WriteCsv(out, stats);
+                break;
+            case MemoryStatsFormat::kMemoryStatsJson:
+                WriteJson(out, stats);
+                break;
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+#include "portable.hpp"
+
+namespace Panda
+{
+    // counters of one size class, accumulated by the thread caches
+    struct AllocationCounters
+    {
+        uint64_t AllocCount;
+        uint64_t FreeCount;
+        uint64_t RequestedBytes;    // sum of the sizes asked for, before rounding up to the block size
+
+        AllocationCounters() : AllocCount(0), FreeCount(0), RequestedBytes(0) {}
+    };
+
+    struct SizeClassStats
+    {
+        uint32_t BlockSize;
+        uint64_t AllocCount;
+        uint64_t FreeCount;
+        double   AllocsPerSecond;   // since the previous snapshot
+        uint64_t LiveBlocks;        // handed out and not freed yet
+        // sampled: the thread caches count on their own and publish in batches, only the
+        // LiveBlocks seen at a publication count, a higher peak in between is missed
+        uint64_t PeakLiveBlocks;
+        size_t   PageCount;
+        size_t   BlockCount;        // blocks in all pages
+        double   PageUtilization;   // LiveBlocks / BlockCount
+        uint64_t RequestedBytes;
+        uint64_t RoundingWasteBytes; // AllocCount * BlockSize - RequestedBytes
+    };
+
+    // allocations above k_MaxBlockSize, served by the system allocator
+    struct LargeAllocStats
+    {
+        uint64_t AllocCount;
+        uint64_t FreeCount;
+        double   AllocsPerSecond;
+        uint64_t TotalBytes;
+        uint64_t LiveBytes;
+        uint64_t PeakLiveBytes;
+    };
+
+    struct MemoryStats
+    {
+        double ElapsedSeconds;      // since MemoryManager::Initialize()
+        std::vector<SizeClassStats> SizeClasses;
+        LargeAllocStats Large;
+    };
+
+    ENUM(MemoryStatsFormat)
+    {
+        kMemoryStatsCsv,
+        kMemoryStatsJson,
+    };
+
+    void WriteMemoryStats(std::ostream& out, const MemoryStats& stats, MemoryStatsFormat format);
+}
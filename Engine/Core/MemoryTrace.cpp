@@ -0,0 +1,115 @@
+#include "MemoryTrace.hpp"
+#include <cstdio>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+
+namespace Panda
+{
+#if defined(PANDA_MEMORY_TRACE)
+    static std::mutex s_TraceLock;
+    static std::atomic<FILE*> s_pTraceFile(nullptr);
+
+    bool MemoryTrace::Start(const char* path)
+    {
+        std::lock_guard<std::mutex> lock(s_TraceLock);
+        if (s_pTraceFile.load(std::memory_order_relaxed))
+            return false;
+
+        FILE* fp = fopen(path, "w");
+        if (fp == nullptr)
+            return false;
+
+        s_pTraceFile.store(fp, std::memory_order_release);
+        return true;
+    }
+
+    void MemoryTrace::Stop()
+    {
+        std::lock_guard<std::mutex> lock(s_TraceLock);
+        FILE* fp = s_pTraceFile.exchange(nullptr, std::memory_order_acq_rel);
+        if (fp)
+            fclose(fp);
+    }
+
+    void MemoryTrace::RecordAlloc(const void* p, size_t size, size_t alignment)
+    {
+        if (p == nullptr || s_pTraceFile.load(std::memory_order_relaxed) == nullptr)
+            return;
+
+        std::lock_guard<std::mutex> lock(s_TraceLock);
+        FILE* fp = s_pTraceFile.load(std::memory_order_relaxed);
+        if (fp)
+            fprintf(fp, "a %p %zu %zu\n", p, size, alignment);
+    }
+
+    void MemoryTrace::RecordFree(const void* p)
+    {
+        if (p == nullptr || s_pTraceFile.load(std::memory_order_relaxed) == nullptr)
+            return;
+
+        std::lock_guard<std::mutex> lock(s_TraceLock);
+        FILE* fp = s_pTraceFile.load(std::memory_order_relaxed);
+        if (fp)
+            fprintf(fp, "f %p\n", p);
+    }
+#else
+    bool MemoryTrace::Start(const char*)
+    {
+        return false;
+    }
+
+    void MemoryTrace::Stop()
+    {
+    }
+
+    void MemoryTrace::RecordAlloc(const void*, size_t, size_t)
+    {
+    }
+
+    void MemoryTrace::RecordFree(const void*)
+    {
+    }
+#endif
+
+    bool MemoryTrace::Load(const char* path, std::vector<MemoryTraceEvent>& events)
+    {
+        FILE* fp = fopen(path, "r");
+        if (fp == nullptr)
+            return false;
+
+        // addresses are reused once freed, so each one maps to the id of its current block
+        std::unordered_map<void*, MemoryTraceEvent> live;
+        uint32_t nextId = 0;
+        char op;
+        void* p;
+
+        events.clear();
+        while (fscanf(fp, " %c %p", &op, &p) == 2)
+        {
+            if (op == 'a')
+            {
+                MemoryTraceEvent event;
+                if (fscanf(fp, "%zu %zu", &event.Size, &event.Alignment) != 2)
+                    break;
+                event.IsAlloc = true;
+                event.Id = nextId++;
+                live[p] = event;
+                events.push_back(event);
+            }
+            else if (op == 'f')
+            {
+                auto it = live.find(p);
+                if (it == live.end())
+                    continue;
+                MemoryTraceEvent event = it->second;
+                event.IsAlloc = false;
+                live.erase(it);
+                events.push_back(event);
+            }
+        }
+
+        fclose(fp);
+        return true;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace Panda
+{
+    // one MemoryManager call, addresses are already mapped to dense block ids
+    struct MemoryTraceEvent
+    {
+        bool     IsAlloc;
+        uint32_t Id;
+        size_t   Size;          // of the allocation, repeated on the free
+        size_t   Alignment;
+    };
+
+    /**
+     * Records every MemoryManager::Allocate/Free to a text file so that a real
+     * workload (e.g. loading a scene) can be replayed by the allocator benchmark.
+     * Recording is only compiled in with PANDA_MEMORY_TRACE, otherwise Start()
+     * returns false and the Record functions are never called.
+     */
+    class MemoryTrace
+    {
+        public:
+            static bool Start(const char* path);
+            static void Stop();
+
+            static void RecordAlloc(const void* p, size_t size, size_t alignment);
+            static void RecordFree(const void* p);
+
+            // frees of blocks allocated before the recording started are dropped
+            static bool Load(const char* path, std::vector<MemoryTraceEvent>& events);
+    };
+}
@@ -0,0 +1,186 @@
+#include <assert.h>
+#include <stdlib.h>
+#include "PageAllocator.hpp"
+
+#ifndef ALIGN
+#define ALIGN(n, a) (((n) + (a - 1)) & ~((a) - 1))		// 获取对齐的最小值
+#endif
+
+#if defined(PANDA_USE_MMAP_PAGES) && defined(__linux__)
+#include <sys/mman.h>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+
+namespace
+{
+	// 区域表直接从系统分配。全局operator new经过MemoryManager时，
+	// 这里的分配发生在分配器的锁内，不能再回到MemoryManager
+	template <typename T>
+	struct SystemAllocator {
+		typedef T value_type;
+
+		SystemAllocator() {}
+		template <typename U>
+		SystemAllocator(const SystemAllocator<U>&) {}
+
+		T* allocate(size_t n) { return reinterpret_cast<T*>(malloc(n * sizeof(T))); }
+		void deallocate(T* p, size_t) { free(p); }
+
+		template <typename U>
+		bool operator==(const SystemAllocator<U>&) const { return true; }
+		template <typename U>
+		bool operator!=(const SystemAllocator<U>&) const { return false; }
+	};
+
+	template <typename T>
+	using SystemVector = std::vector<T, SystemAllocator<T>>;
+
+	struct Region {
+		uint8_t*	pBase;
+		size_t		Size;
+	};
+
+	struct RegionState {
+		std::mutex		Lock;
+		SystemVector<Region>	Regions;
+		uint8_t*		pCursor = nullptr;		// 当前区域中下一页的位置
+		uint8_t*		pRegionEnd = nullptr;
+		std::unordered_map<size_t, SystemVector<void*>, std::hash<size_t>, std::equal_to<size_t>,
+			SystemAllocator<std::pair<const size_t, SystemVector<void*>>>> FreePages;	// 按页尺寸分类的空闲页
+	};
+
+	RegionState& State()
+	{
+		static RegionState s_State;
+		return s_State;
+	}
+
+	// 映射一个按alignment对齐的区域：多映射alignment字节，再把头尾多余的部分还回去
+	uint8_t* MapRegion(RegionState& state, size_t inSize, size_t alignment)
+	{
+		size_t mapSize = inSize + alignment;
+		void* p = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (p == MAP_FAILED)
+			return nullptr;
+
+		uintptr_t base = reinterpret_cast<uintptr_t>(p);
+		uintptr_t aligned = ALIGN(base, alignment);
+		if (aligned > base)
+			munmap(p, aligned - base);
+		size_t tail = base + mapSize - (aligned + inSize);
+		if (tail)
+			munmap(reinterpret_cast<void*>(aligned + inSize), tail);
+
+		madvise(reinterpret_cast<void*>(aligned), inSize, MADV_HUGEPAGE);
+
+		state.Regions.push_back({reinterpret_cast<uint8_t*>(aligned), inSize});
+		return reinterpret_cast<uint8_t*>(aligned);
+	}
+}
+
+void* Panda::PageAllocator::Allocate(size_t inSize)
+{
+	assert((inSize & (inSize - 1)) == 0);
+
+	RegionState& state = State();
+	std::lock_guard<std::mutex> lock(state.Lock);
+
+	SystemVector<void*>& freePages = state.FreePages[inSize];
+	if (!freePages.empty())
+	{
+		void* p = freePages.back();
+		freePages.pop_back();
+		return p;
+	}
+
+	if (inSize > k_RegionSize)
+	{
+		// 超过区域尺寸的页单独映射
+		return MapRegion(state, inSize, inSize > k_HugePageSize ? inSize : k_HugePageSize);
+	}
+
+	uint8_t* p = reinterpret_cast<uint8_t*>(ALIGN(reinterpret_cast<uintptr_t>(state.pCursor), inSize));
+	if (state.pCursor == nullptr || p + inSize > state.pRegionEnd)
+	{
+		p = MapRegion(state, k_RegionSize, k_HugePageSize);
+		if (p == nullptr)
+			return nullptr;
+		state.pRegionEnd = p + k_RegionSize;
+	}
+
+	state.pCursor = p + inSize;
+	return p;
+}
+
+void Panda::PageAllocator::Free(void* p, size_t inSize)
+{
+	RegionState& state = State();
+	std::lock_guard<std::mutex> lock(state.Lock);
+
+	// 地址空间留着复用，物理内存还给操作系统
+	madvise(p, inSize, MADV_DONTNEED);
+	state.FreePages[inSize].push_back(p);
+}
+
+void Panda::PageAllocator::Purge()
+{
+	// Free()已经把物理内存还回去了
+}
+
+void Panda::PageAllocator::ReleaseAll()
+{
+	RegionState& state = State();
+	std::lock_guard<std::mutex> lock(state.Lock);
+
+	for (auto& region : state.Regions)
+		munmap(region.pBase, region.Size);
+
+	state.Regions.clear();
+	state.FreePages.clear();
+	state.pCursor = nullptr;
+	state.pRegionEnd = nullptr;
+}
+
+#else
+
+#if defined(_WIN32) || defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+void* Panda::PageAllocator::Allocate(size_t inSize)
+{
+	assert((inSize & (inSize - 1)) == 0);
+
+#if defined(_WIN32)
+	return _aligned_malloc(inSize, inSize);
+#else
+	void* p = nullptr;
+	if (posix_memalign(&p, inSize, inSize) != 0)
+		return nullptr;
+	return p;
+#endif
+}
+
+void Panda::PageAllocator::Free(void* p, size_t)
+{
+#if defined(_WIN32)
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+void Panda::PageAllocator::Purge()
+{
+#if defined(__GLIBC__)
+	// glibc只在堆顶空闲时才会收缩，页在堆中间释放时需要主动整理
+	malloc_trim(0);
+#endif
+}
+
+void Panda::PageAllocator::ReleaseAll()
+{
+}
+
+#endif
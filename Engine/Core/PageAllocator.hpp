@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Panda {
+	// 分配器的页来源。
+	// 每一页都按页尺寸对齐，这样从块的地址就能直接算出所在页的地址。
+	// 默认从堆上分配；定义PANDA_USE_MMAP_PAGES后，改为从大块mmap区域中切分，
+	// 区域使用透明大页(transparent huge pages)以减少TLB缺失。
+	class PageAllocator {
+	public:
+		static const size_t k_RegionSize = 32 * 1024 * 1024;	// mmap区域尺寸
+		static const size_t k_HugePageSize = 2 * 1024 * 1024;	// 大页尺寸，区域按此对齐
+
+		// inSize必须是2的幂
+		static void* Allocate(size_t inSize);
+
+		// 释放一页，堆后端需要Purge()之后物理内存才会还给操作系统
+		static void Free(void* p, size_t inSize);
+
+		// 让底层的堆把已释放的页还给操作系统
+		static void Purge();
+
+		// 释放所有区域，只能在所有页都不再使用之后调用
+		static void ReleaseAll();
+	};
+}
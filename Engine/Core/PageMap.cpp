@@ -0,0 +1,102 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <atomic>
+#include "PageMap.hpp"
+
+using namespace Panda;
+
+namespace
+{
+	const size_t k_RootSize = size_t(1) << PageMap::k_RootBits;
+	const size_t k_LeafSize = size_t(1) << PageMap::k_LeafBits;
+
+	struct Leaf {
+		std::atomic<uint8_t> Tags[k_LeafSize];
+	};
+
+	// 静态存储区里的指针数组，只有用到的部分才会占用物理内存
+	std::atomic<Leaf*> s_Root[k_RootSize];
+
+	inline uintptr_t GranuleOf(const void* p)
+	{
+		return reinterpret_cast<uintptr_t>(p) >> PageMap::k_GranuleShift;
+	}
+
+	Leaf* GetOrCreateLeaf(size_t rootIndex)
+	{
+		Leaf* pLeaf = s_Root[rootIndex].load(std::memory_order_acquire);
+		if (pLeaf)
+			return pLeaf;
+
+		// 叶子直接从系统分配，不能经过MemoryManager，否则会在持有分配器锁时重入
+		Leaf* pNewLeaf = reinterpret_cast<Leaf*>(calloc(1, sizeof(Leaf)));
+		if (s_Root[rootIndex].compare_exchange_strong(pLeaf, pNewLeaf, std::memory_order_acq_rel))
+			return pNewLeaf;
+
+		// 其他线程先创建了
+		free(pNewLeaf);
+		return pLeaf;
+	}
+
+	void SetRange(void* pPage, size_t inSize, uint8_t tag)
+	{
+		assert((reinterpret_cast<uintptr_t>(pPage) & (PageMap::k_GranuleSize - 1)) == 0);
+		assert((inSize & (PageMap::k_GranuleSize - 1)) == 0);
+
+		uintptr_t first = GranuleOf(pPage);
+		uintptr_t last = first + inSize / PageMap::k_GranuleSize;
+		assert((last - 1) >> PageMap::k_LeafBits < k_RootSize);
+
+		for (uintptr_t granule = first; granule < last; ++granule)
+		{
+			Leaf* pLeaf = GetOrCreateLeaf(granule >> PageMap::k_LeafBits);
+			pLeaf->Tags[granule & (k_LeafSize - 1)].store(tag, std::memory_order_release);
+		}
+	}
+}
+
+void Panda::PageMap::Insert(void* pPage, size_t inSize, uint8_t tag)
+{
+	assert(tag != 0 && tag != k_RetiredTag);
+	SetRange(pPage, inSize, tag);
+}
+
+void Panda::PageMap::Erase(void* pPage, size_t inSize)
+{
+	SetRange(pPage, inSize, 0);
+}
+
+void Panda::PageMap::Retire(void* pPage, size_t inSize)
+{
+	SetRange(pPage, inSize, k_RetiredTag);
+}
+
+void Panda::PageMap::EraseRetired()
+{
+	for (size_t rootIndex = 0; rootIndex < k_RootSize; ++rootIndex)
+	{
+		Leaf* pLeaf = s_Root[rootIndex].load(std::memory_order_acquire);
+		if (pLeaf == nullptr)
+			continue;
+
+		for (size_t i = 0; i < k_LeafSize; ++i)
+		{
+			if (pLeaf->Tags[i].load(std::memory_order_relaxed) == k_RetiredTag)
+				pLeaf->Tags[i].store(0, std::memory_order_release);
+		}
+	}
+}
+
+uint8_t Panda::PageMap::Find(const void* p)
+{
+	uintptr_t granule = GranuleOf(p);
+	size_t rootIndex = granule >> k_LeafBits;
+	if (rootIndex >= k_RootSize)
+		return 0;
+
+	Leaf* pLeaf = s_Root[rootIndex].load(std::memory_order_acquire);
+	if (pLeaf == nullptr)
+		return 0;
+
+	return pLeaf->Tags[granule & (k_LeafSize - 1)].load(std::memory_order_acquire);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Panda {
+	// 从地址查找所属的分配器页。
+	// 两级基数树，以k_GranuleSize为粒度记录每一段地址属于哪个尺寸类别，
+	// 释放时不需要调用者提供尺寸，也不需要读取地址前面的内存。
+	// 叶子节点按需分配，进程退出前不会释放；查找不加锁。
+	class PageMap {
+	public:
+		static const uint32_t k_GranuleShift = 13;		// 粒度，不能大于最小的页尺寸
+		static const size_t k_GranuleSize = size_t(1) << k_GranuleShift;
+		static const uint32_t k_AddressBits = 48;		// 用户态地址的有效位数
+		static const uint32_t k_LeafBits = 18;			// 每个叶子覆盖2GB地址空间
+		static const uint32_t k_RootBits = k_AddressBits - k_GranuleShift - k_LeafBits;
+		static const uint8_t k_RetiredTag = 0xFF;		// 见Retire()，不能用作分配器的tag
+
+		// 登记一页，pPage和inSize必须按粒度对齐，tag不能为0
+		static void Insert(void* pPage, size_t inSize, uint8_t tag);
+
+		// 取消登记，必须在页还给系统之前调用
+		static void Erase(void* pPage, size_t inSize);
+
+		// 页还给系统时里面可能还有块没有释放（Finalize()时），登记为k_RetiredTag，
+		// 之后释放这些块时才能认出来。必须在页还给系统之前调用
+		static void Retire(void* pPage, size_t inSize);
+
+		// 清除所有k_RetiredTag，只能在没有其他线程访问PageMap时调用
+		static void EraseRetired();
+
+		// 返回p所在页登记的tag，不属于任何已登记的页时返回0
+		static uint8_t Find(const void* p);
+	};
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "MemoryManager.hpp"
+
+namespace Panda
+{
+    /**
+     * STL allocator over MemoryManager::Allocate/Free.
+     * Node based containers get their nodes from the fixed-size pools (and the
+     * per-thread caches) instead of the global heap.
+     * Blocks are returned with the size-free MemoryManager::Free(void*), which
+     * looks the owner up in the PageMap. A container built before Initialize()
+     * (whose blocks come from the system) can therefore be freed after it.
+     * Blocks freed after Finalize() do not touch the released pools, but node
+     * based containers must still go first: their destructors walk the nodes.
+     */
+    template <typename T>
+    class PandaAllocator
+    {
+        public:
+            typedef T value_type;
+
+            PandaAllocator() noexcept {}
+            template <typename U>
+            PandaAllocator(const PandaAllocator<U>&) noexcept {}
+
+            T* allocate(size_t n)
+            {
+                if (n > static_cast<size_t>(-1) / sizeof(T))
+                    throw std::bad_alloc();
+
+                void* p = MemoryManager::Allocate(n * sizeof(T), alignof(T));
+                if (p == nullptr)
+                    throw std::bad_alloc();
+
+                return reinterpret_cast<T*>(p);
+            }
+
+            // the sized Free() would hand a block that came from the system
+            // before Initialize() to a pool, so only the size-free one is safe here
+            void deallocate(T* p, size_t) noexcept
+            {
+                MemoryManager::Free(p);
+            }
+    };
+
+    template <typename T, typename U>
+    inline bool operator==(const PandaAllocator<T>&, const PandaAllocator<U>&) noexcept {return true;}
+
+    template <typename T, typename U>
+    inline bool operator!=(const PandaAllocator<T>&, const PandaAllocator<U>&) noexcept {return false;}
+
+    template <typename T>
+    using PandaVector = std::vector<T, PandaAllocator<T>>;
+
+    template <typename T>
+    using PandaList = std::list<T, PandaAllocator<T>>;
+
+    template <typename Key, typename T, typename Compare = std::less<Key>>
+    using PandaMap = std::map<Key, T, Compare, PandaAllocator<std::pair<const Key, T>>>;
+
+    template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    using PandaUnorderedMap = std::unordered_map<Key, T, Hash, KeyEqual, PandaAllocator<std::pair<const Key, T>>>;
+
+    // std::make_shared with the object and its control block in one pooled block
+    template <typename T, typename... Arguments>
+    inline std::shared_ptr<T> MakeShared(Arguments&&... parameters)
+    {
+        return std::allocate_shared<T>(PandaAllocator<T>(), std::forward<Arguments>(parameters)...);
+    }
+}
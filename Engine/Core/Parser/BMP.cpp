@@ -2,7 +2,7 @@
 
 namespace Panda
 {
-        Image BmpParser::Parse(Buffer& buf)
+        Image BmpParser::Parse(const BufferView& buf)
         {
             Image img;
             const BITMAP_FILEHEADER* pFileHeader = reinterpret_cast<const BITMAP_FILEHEADER*>(buf.GetData());
@@ -34,6 +34,6 @@ namespace Panda
     class BmpParser : implements ImageParser
     {
     public:
-        virtual Image Parse(Buffer& buf);
+        virtual Image Parse(const BufferView& buf);
     };
 }
@@ -14,7 +14,7 @@ namespace Panda
 		{
 			std::string nodeId = inNode.mID;
 			std::string nodeName = inNode.mName;
-			auto _node = std::make_shared<SceneGeometryNode>(nodeName, nodeId);
+			auto _node = MakeShared<SceneGeometryNode>(nodeName, nodeId);
 			_node->SetVisibility(true);
 			_node->SetIfCastShadow(true);
 			_node->SetIfMotionBlur(false);
@@ -22,11 +22,14 @@ namespace Panda
 			// ref scene objects
 			std::string meshId = inNode.mMeshes[0].mMeshOrController;
 			_node->AddSceneObjectRef(meshId);
+			scene.Dependencies.AddDependency(PANDA_ASSET_NODE_SCENE, scene.SceneGraph->GetName(),
+				PANDA_ASSET_NODE_GEOMETRY, meshId);
 
 			// ref materials 
 			for (auto mat : inNode.mMeshes[0].mMaterials)
 			{
 				_node->AddMaterialRef(mat.first);
+				scene.Dependencies.AddDependency(PANDA_ASSET_NODE_GEOMETRY, meshId, PANDA_ASSET_NODE_MATERIAL, mat.first);
 			}
 
 			scene.GeometryNodes.emplace(nodeId, _node);
@@ -44,7 +47,7 @@ namespace Panda
 		{
 			std::string nodeName = inNode.mName;
 
-			auto _node = std::make_shared<SceneCameraNode>(nodeName);
+			auto _node = MakeShared<SceneCameraNode>(nodeName);
 			std::string id = inNode.mCameras[0].mCamera;
 			auto iter = parser.mCameraLibrary.find(id);
 			_node->AddSceneObjectRef(iter->first);
@@ -61,7 +64,7 @@ namespace Panda
 		{
 			std::string nodeName = inNode.mName;
 
-			auto _node = std::make_shared<SceneLightNode>(nodeName);
+			auto _node = MakeShared<SceneLightNode>(nodeName);
 			std::string id = inNode.mLights[0].mLight;
 			auto iter = parser.mLightLibrary.find(id);
 
@@ -90,7 +93,7 @@ namespace Panda
 	void DaeParser::AddGeometryObject(Scene& scene, const std::string& inGeometryName, const Assimp::Collada::Mesh& inMesh)
 	{
 		std::string objectName = inGeometryName;
-		std::shared_ptr<SceneObjectGeometry> _object = std::make_shared<SceneObjectGeometry>();
+		std::shared_ptr<SceneObjectGeometry> _object = MakeShared<SceneObjectGeometry>();
 		_object->SetVisibility(true);
 		_object->SetIfCastShadow(true);
 		_object->SetIfMotionBlur(false);
@@ -115,17 +118,15 @@ namespace Panda
 		// vertex data
 		VertexDataType vertexDataType = VertexDataType::kVertexDataTypeFloat3;
 		uint32_t elementCount = inMesh.mPositions.size();
-		void* data = new float[elementCount * 3];
 		size_t buffSize = sizeof(float) * elementCount * 3;
 		const void* _data = &inMesh.mPositions[0];
-		memcpy(data, _data, buffSize);
-		SceneObjectVertexArray& _v_array = *new SceneObjectVertexArray("position", 0, vertexDataType, data, elementCount * 3);
+		auto data = MakeShared<RelocatableBuffer>(_data, buffSize);
+		SceneObjectVertexArray _v_array("position", 0, vertexDataType, std::move(data), elementCount * 3);
 		mesh->AddVertexArray(std::move(_v_array));
 
 		// normal data
-		void* pNormData = new float[elementCount * 3];
-		memcpy(pNormData, (void*)(&inMesh.mNormals[0]), buffSize);
-		SceneObjectVertexArray& _n_array = *new SceneObjectVertexArray("normal", 0, vertexDataType, pNormData, elementCount * 3);
+		auto pNormData = MakeShared<RelocatableBuffer>((void*)(&inMesh.mNormals[0]), buffSize);
+		SceneObjectVertexArray _n_array("normal", 0, vertexDataType, std::move(pNormData), elementCount * 3);
 		mesh->AddVertexArray(std::move(_n_array));
 
 		// index data
@@ -133,15 +134,14 @@ namespace Panda
 		_data = &inMesh.mFacePosIndices[0];
 		int32_t data_size = 4;
 		buffSize = data_size * elementCount;
-		void* pIndexData = new uint8_t[buffSize];
-		memcpy(pIndexData, _data, buffSize);
+		auto pIndexData = MakeShared<RelocatableBuffer>(_data, buffSize);
 		// fix index bug. I can't do it in assimp because the indices relates to animation.
-		uint32_t* viewData = (uint32_t*)pIndexData;
+		uint32_t* viewData = (uint32_t*)pIndexData->GetData();
 		for (int32_t i = 0; i < elementCount; ++i)
 		{
 			viewData[i] = i;
 		}
-		SceneObjectIndexArray& _i_array = *new SceneObjectIndexArray(0, 0, IndexDataType::kIndexDataTypeInt32, pIndexData, elementCount);
+		SceneObjectIndexArray _i_array(0, 0, IndexDataType::kIndexDataTypeInt32, std::move(pIndexData), elementCount);
 		mesh->AddIndexArray(std::move(_i_array));
 
 		_object->AddMesh(mesh);
@@ -154,7 +154,7 @@ namespace Panda
 		const Assimp::ColladaParser::MaterialLibrary& inMaterialLib, const Assimp::ColladaParser::EffectLibrary& inEffectLib)
 	{
 		std::string objectName = inGeometryName;
-		std::shared_ptr<SceneObjectGeometry> _object = std::make_shared<SceneObjectGeometry>();
+		std::shared_ptr<SceneObjectGeometry> _object = MakeShared<SceneObjectGeometry>();
 		_object->SetVisibility(true);
 		_object->SetIfCastShadow(true);
 		_object->SetIfMotionBlur(false);
@@ -179,17 +179,15 @@ namespace Panda
 		// vertex data
 		VertexDataType vertexDataType = VertexDataType::kVertexDataTypeFloat3;
 		uint32_t elementCount = inMesh.mPositions.size();
-		void* data = new float[elementCount * 3];
 		size_t buffSize = sizeof(float) * elementCount * 3;
 		const void* _data = &inMesh.mPositions[0];
-		memcpy(data, _data, buffSize);
-		SceneObjectVertexArray& _v_array = *new SceneObjectVertexArray("position", 0, vertexDataType, data, elementCount * 3);
+		auto data = MakeShared<RelocatableBuffer>(_data, buffSize);
+		SceneObjectVertexArray _v_array("position", 0, vertexDataType, std::move(data), elementCount * 3);
 		mesh->AddVertexArray(std::move(_v_array));
 
 		// normal data
-		void* pNormData = new float[elementCount * 3];
-		memcpy(pNormData, (void*)(&inMesh.mNormals[0]), buffSize);
-		SceneObjectVertexArray& _n_array = *new SceneObjectVertexArray("normal", 0, vertexDataType, pNormData, elementCount * 3);
+		auto pNormData = MakeShared<RelocatableBuffer>((void*)(&inMesh.mNormals[0]), buffSize);
+		SceneObjectVertexArray _n_array("normal", 0, vertexDataType, std::move(pNormData), elementCount * 3);
 		mesh->AddVertexArray(std::move(_n_array));
 
 
@@ -201,15 +199,14 @@ namespace Panda
 			_data = &inMesh.mFacePosIndices[0];
 			int32_t data_size = 4;
 			buffSize = data_size * elementCount;
-			void* pIndexData = new uint8_t[buffSize];
-			memcpy(pIndexData, _data, buffSize);
+			auto pIndexData = MakeShared<RelocatableBuffer>(_data, buffSize);
 			// fix index bug. I can't do it in assimp because the indices relates to animation.
-			uint32_t* viewData = (uint32_t*)pIndexData;
+			uint32_t* viewData = (uint32_t*)pIndexData->GetData();
 			for (int32_t i = 0; i < elementCount; ++i)
 			{
 				viewData[i] = i;
 			}
-			SceneObjectIndexArray& _i_array = *new SceneObjectIndexArray(matIndex, 0, IndexDataType::kIndexDataTypeInt32, pIndexData, elementCount);
+			SceneObjectIndexArray _i_array(matIndex, 0, IndexDataType::kIndexDataTypeInt32, std::move(pIndexData), elementCount);
 			mesh->AddIndexArray(std::move(_i_array));
 
 			auto matIter = inMaterialLib.find(mat.first);
@@ -232,7 +229,7 @@ namespace Panda
 		auto iter = inMeshLib.find(meshId);
 		const Assimp::Collada::Mesh& mesh = *iter->second;
 
-		std::shared_ptr<SceneObjectGeometry> _object = std::make_shared<SceneObjectGeometry>();
+		std::shared_ptr<SceneObjectGeometry> _object = MakeShared<SceneObjectGeometry>();
 		_object->SetVisibility(true);
 		_object->SetIfCastShadow(true);
 		_object->SetIfMotionBlur(false);
@@ -273,30 +270,28 @@ namespace Panda
 				// vertex data
 				VertexDataType vertexDataType = VertexDataType::kVertexDataTypeFloat3;
 				uint32_t elementCount = mesh.mFaceSize[startFaceIndex] * faceCount;
-				void* data = new float[elementCount * 3];
 				size_t buffSize = sizeof(float) * elementCount * 3;
 				const void* _data = &mesh.mPositions[startVertexAndNormalIndex];
-				memcpy(data, _data, buffSize);
-				SceneObjectVertexArray& _v_array = *new SceneObjectVertexArray("position", 0, vertexDataType, data, elementCount * 3);
+				auto data = MakeShared<RelocatableBuffer>(_data, buffSize);
+				SceneObjectVertexArray _v_array("position", 0, vertexDataType, std::move(data), elementCount * 3);
 				ourMesh->AddVertexArray(std::move(_v_array));
 
 				// normal data
-				void* pNormData = new float[elementCount * 3];
-				memcpy(pNormData, (void*)(&mesh.mNormals[startVertexAndNormalIndex]), buffSize);
-				SceneObjectVertexArray& _n_array = *new SceneObjectVertexArray("normal", 0, vertexDataType, pNormData, elementCount * 3);
+				auto pNormData = MakeShared<RelocatableBuffer>((void*)(&mesh.mNormals[startVertexAndNormalIndex]), buffSize);
+				SceneObjectVertexArray _n_array("normal", 0, vertexDataType, std::move(pNormData), elementCount * 3);
 				ourMesh->AddVertexArray(std::move(_n_array));
 
 				// index data
 				elementCount = mesh.mFaceSize[startFaceIndex] * faceCount;
 				int32_t dataSize = 4;
 				buffSize = elementCount * dataSize;
-				void* pIndexData = new uint8_t[buffSize];
-				uint32_t* viewData = (uint32_t*)pIndexData;
+				auto pIndexData = MakeShared<RelocatableBuffer>(buffSize);
+				uint32_t* viewData = (uint32_t*)pIndexData->GetData();
 				for (int32_t j = 0; j < elementCount; ++j)
 				{
 					viewData[j] = j;
 				}
-				SceneObjectIndexArray& _i_array = *new SceneObjectIndexArray(i, 0, IndexDataType::kIndexDataTypeInt32, pIndexData, elementCount);
+				SceneObjectIndexArray _i_array(i, 0, IndexDataType::kIndexDataTypeInt32, std::move(pIndexData), elementCount);
 				ourMesh->AddIndexArray(std::move(_i_array));
 
 				
@@ -337,32 +332,29 @@ namespace Panda
 			// vertex data
 			VertexDataType vertexDataType = VertexDataType::kVertexDataTypeFloat3;
 			uint32_t elementCount = mesh.mPositions.size();
-			void* data = new float[elementCount * 3];
 			size_t buffSize = sizeof(float) * elementCount * 3;
 			const void* _data = &mesh.mPositions[0];
-			memcpy(data, _data, buffSize);
-			SceneObjectVertexArray& _v_array = *new SceneObjectVertexArray("position", 0, vertexDataType, data, elementCount * 3);
+			auto data = MakeShared<RelocatableBuffer>(_data, buffSize);
+			SceneObjectVertexArray _v_array("position", 0, vertexDataType, std::move(data), elementCount * 3);
 			ourMesh->AddVertexArray(std::move(_v_array));
 
 			// normal data
-			void* pNormData = new float[elementCount * 3];
-			memcpy(pNormData, (void*)(&mesh.mNormals[0]), buffSize);
-			SceneObjectVertexArray& _n_array = *new SceneObjectVertexArray("normal", 0, vertexDataType, pNormData, elementCount * 3);
+			auto pNormData = MakeShared<RelocatableBuffer>((void*)(&mesh.mNormals[0]), buffSize);
+			SceneObjectVertexArray _n_array("normal", 0, vertexDataType, std::move(pNormData), elementCount * 3);
 			ourMesh->AddVertexArray(std::move(_n_array));
 
 			elementCount = mesh.mFacePosIndices.size();
 			_data = &mesh.mFacePosIndices[0];
 			int32_t data_size = 4;
 			buffSize = data_size * elementCount;
-			void* pIndexData = new uint8_t[buffSize];
-			memcpy(pIndexData, _data, buffSize);
+			auto pIndexData = MakeShared<RelocatableBuffer>(_data, buffSize);
 			// fix index bug. I can't do it in assimp because the indices relates to animation.
-			uint32_t* viewData = (uint32_t*)pIndexData;
+			uint32_t* viewData = (uint32_t*)pIndexData->GetData();
 			for (int32_t i = 0; i < elementCount; ++i)
 			{
 				viewData[i] = i;
 			}
-			SceneObjectIndexArray& _i_array = *new SceneObjectIndexArray(0, 0, IndexDataType::kIndexDataTypeInt32, pIndexData, elementCount);
+			SceneObjectIndexArray _i_array(0, 0, IndexDataType::kIndexDataTypeInt32, std::move(pIndexData), elementCount);
 			ourMesh->AddIndexArray(std::move(_i_array));
 
 			auto matIter = inMaterialLib.find(meshInstance.mMaterials.begin()->first);
@@ -382,7 +374,7 @@ namespace Panda
 
 		matrix = transform.f;
 		TransposeMatrix(matrix, matrix);
-		_transform = std::make_shared<SceneObjectTransform>(matrix, false);
+		_transform = MakeShared<SceneObjectTransform>(matrix, false);
 		baseNode->AppendTransform("", std::move(_transform));
 	}
 
@@ -394,22 +386,22 @@ namespace Panda
 		{
 		case aiLightSourceType::aiLightSource_POINT:
 		{
-			light = std::make_shared<SceneObjectPointLight>();
+			light = MakeShared<SceneObjectPointLight>();
 			break;
 		}
 		case aiLightSourceType::aiLightSource_DIRECTIONAL:
 		{
-			light = std::make_shared<SceneObjectInfiniteLight>();
+			light = MakeShared<SceneObjectInfiniteLight>();
 			break;
 		}
 		case aiLightSourceType::aiLightSource_SPOT:
 		{
-			light = std::make_shared<SceneObjectSpotLight>();
+			light = MakeShared<SceneObjectSpotLight>();
 			break;
 		}
 		case aiLightSourceType::aiLightSource_AREA:
 		{
-			light = std::make_shared<SceneObjectAreaLight>();
+			light = MakeShared<SceneObjectAreaLight>();
 			break;
 		}
 		default:
@@ -444,7 +436,7 @@ namespace Panda
 	void DaeParser::AddCameraObject(Scene& scene, const std::string& inCameraName, const Assimp::Collada::Camera& inCamera)
 	{
 		std::string cameraName = inCameraName;
-		auto camera = std::make_shared<SceneObjectPerspectiveCamera>();
+		auto camera = MakeShared<SceneObjectPerspectiveCamera>();
 
 		// Set fov
 		std::string param = "fov";
@@ -468,7 +460,7 @@ namespace Panda
 
 	void DaeParser::AddMaterial(Scene& scene, const std::string& keyName, const std::string& matName, const Assimp::Collada::Effect& effect)
 	{
-		auto material = std::make_shared<SceneObjectMaterial>();
+		auto material = MakeShared<SceneObjectMaterial>();
 		material->SetName(matName);
 
 		std::string attrib;
@@ -497,7 +489,7 @@ namespace Panda
 
 	void DaeParser::AddDefaultMaterial(Scene& scene)
 	{
-		auto material = std::make_shared<SceneObjectMaterial>();
+		auto material = MakeShared<SceneObjectMaterial>();
 		material->SetName("default");
 
 		scene.Materials["default"] = material;
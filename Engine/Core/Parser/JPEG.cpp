@@ -2,64 +2,130 @@
 
 namespace Panda
 {
-    size_t JfifParser::ParseScanData(const uint8_t* pScanData, const uint8_t* pDataEnd, Image& img)
+    JpegBitReader::JpegBitReader(AssetStream& stream) :
+        m_pStream(&stream),
+        m_Bits(0),
+        m_BitCount(0),
+        m_PaddingBits(0),
+        m_pNext(nullptr),
+        m_pEnd(nullptr),
+        m_Marker(0),
+        m_IsEnded(false)
     {
-        std::vector<uint8_t> scanData;
-        size_t scanLength = 0;
+    }
 
+    bool JpegBitReader::NextByte(uint8_t& byte)
+    {
+        if (m_pNext == m_pEnd)
         {
-            const uint8_t* p = pScanData;
+            size_t size = m_pStream->ReadChunk(m_pNext);
+            m_pEnd = m_pNext + size;
+            if (size == 0)
+                return false;
+        }
 
-            // scan for scan data buffer size and remove bitstuff
-            bool bitstuff = false;
-            while (p < pDataEnd && (*p != 0xFF || *(p + 1) == 0x00))
+        byte = *m_pNext++;
+        return true;
+    }
+
+    void JpegBitReader::Refill()
+    {
+        while (m_BitCount <= 56)
+        {
+            uint8_t byte;
+            if (m_Marker || m_IsEnded || !NextByte(byte))
             {
-                if (!bitstuff)
+                // past the end of the segment the decoder reads zeros
+                m_IsEnded = true;
+                m_PaddingBits += 64 - m_BitCount;
+                m_BitCount = 64;
+                return;
+            }
+
+            if (byte == 0xFF)
+            {
+                // more 0xFF are fill bytes in front of a marker
+                uint8_t next;
+                bool hasNext;
+                while ((hasNext = NextByte(next)) && next == 0xFF) {}
+                if (!hasNext)
                 {
-                    scanData.push_back(*p);
+                    m_IsEnded = true;
+                    continue;
                 }
-                else 
+
+                if (next != 0x00)
                 {
-                    // ignore it and reset the flag
-                    assert(*p == 0x00);
-                    bitstuff = false;
+                    m_Marker = 0xFF00 | next;
+                    continue;
                 }
-
-                if (*(uint16_t*)p == to_endian_net((uint16_t)0xFF00))
-                    bitstuff = true;
-
-                p++;
-                scanLength++;
+                // bitstuff, the 0x00 is dropped
             }
 
-            if (*p == 0xFF && *(p + 1) >= 0xD0 && *(p + 1) <= 0xD7)
+            m_Bits |= static_cast<uint64_t>(byte) << (56 - m_BitCount);
+            m_BitCount += 8;
+        }
+    }
+
+    uint16_t JpegBitReader::Finish()
+    {
+        // skip what is left of the segment, the bits still buffered included
+        m_Bits = 0;
+        m_BitCount = 0;
+        while (!m_Marker && !m_IsEnded)
+        {
+            if (m_pNext == m_pEnd)
             {
-                // found restart mark
-#if DUMP_DETAILS
-                std::cout << "Found RST while scan the ECS." << std::endl;
-#endif
+                size_t size = m_pStream->ReadChunk(m_pNext);
+                m_pEnd = m_pNext + size;
+                if (size == 0)
+                {
+                    m_IsEnded = true;
+                    break;
+                }
             }
 
-#if DUMP_DETAILS
-            std::cout << "Size of Scan: " << scanLength << " bytes" << std::endl;
-            std::cout << "Size of Scan (after remove bitstuff):" << scanData.size() << " bytes" << std::endl;
-            std::cout << "Total MCU count: " << McuCount << std::endl;
-#endif
+            const uint8_t* pMarker = static_cast<const uint8_t*>(memchr(m_pNext, 0xFF, m_pEnd - m_pNext));
+            m_pNext = pMarker ? pMarker : m_pEnd;
+            if (!pMarker)
+                continue;
+
+            uint8_t byte;
+            NextByte(byte);
+            uint8_t next;
+            bool hasNext;
+            while ((hasNext = NextByte(next)) && next == 0xFF) {}
+            if (!hasNext)
+                m_IsEnded = true;
+            else if (next != 0x00)
+                m_Marker = 0xFF00 | next;
         }
 
+        // what follows the marker is read again by Parse()
+        if (m_pNext != m_pEnd)
+            m_pStream->Unread(m_pEnd - m_pNext);
+        m_pNext = m_pEnd = nullptr;
+        m_IsEnded = true;
+
+        return m_Marker;
+    }
+
+    int JfifParser::DecodeMcus(JpegBitReader& reader, int firstMcu, int endMcu)
+    {
         int16_t previousDC[4]; // 4 is max num of components defined by ITU-T81
         memset(previousDC, 0x00, sizeof(previousDC));
 
-        size_t byteOffset = 0;
-        uint8_t bitOffset = 0;
-
-        while(byteOffset < scanData.size() && McuIndex < McuCount)
+        int mcuIndex = firstMcu;
+        while(mcuIndex < endMcu)
         {
+            if (reader.IsPastEnd())
+                break;
+
             #if DUMP_DETAILS
-            std::cout << "MCU: " << McuIndex << std::endl;
+            std::cout << "MCU: " << mcuIndex << std::endl;
             #endif
-            float block[4][64]; // 4 is max num of components defined by ITU-T81
-            memset(&block, 0x00, sizeof(block));
+            int mcuIndexX = mcuIndex % McuCountX;
+            int mcuIndexY = mcuIndex / McuCountX;
 
             for (uint8_t i = 0; i < m_ComponentsInFrame; ++i)
             {
@@ -71,254 +137,358 @@ namespace Panda
                 std::cout << "\tAC Entropy Coding table Destination Selector: " << (uint16_t)pScsp[i].AcEntropyCodingTableDestSelector() << std::endl;
                 #endif 
 
-                // Decode DC
-                uint8_t dcCode = m_TreeHuffman[pScsp[i].DcEntropyCodingTableDestSelector()].DecodeSingleValue(scanData.data(), scanData.size(), &byteOffset, &bitOffset);
-                uint8_t dcBitLength = dcCode & 0x0F;
-                int16_t dcValue;
-                uint32_t tmpValue;
-
-                if (!dcCode)
+                // the blocks of a component in an MCU are in rows, left to right
+                for (int32_t blockY = 0; blockY < m_BlocksY[i]; ++blockY)
+                for (int32_t blockX = 0; blockX < m_BlocksX[i]; ++blockX)
                 {
+                    int16_t block[64];
+                    memset(block, 0x00, sizeof(block));
+                    uint8_t samples[64];
+
+                    // Decode DC
+                    uint8_t dcCode = m_TableHuffman[pScsp[i].DcEntropyCodingTableDestSelector()].DecodeSingleValue(reader);
+                    uint8_t dcBitLength = dcCode & 0x0F;
+
                     #if DUMP_DETAILS
-                    std::cout << "Found EOB when decode DC!" << std::endl;
+                    if (!dcCode)
+                        std::cout << "Found EOB when decode DC!" << std::endl;
                     #endif
 
-                    dcValue = 0;
-                }
-                else
-                {
-                    if (dcBitLength + bitOffset <= 8)
-                    {
-                        tmpValue = ((scanData[byteOffset] & ((0x01u << (8 - bitOffset)) - 1)) >> (8 - dcBitLength - bitOffset));
-                    }
-                    else 
+                    // add with previous DC value
+                    int16_t dcValue = static_cast<int16_t>(reader.ReceiveExtend(dcBitLength) + previousDC[i]);
+                    // save the value for next DC
+                    previousDC[i] = dcValue;
+
+                    #ifdef DUMP_DETAILS
+                    printf("DC Code: %x\n", dcCode);
+                    printf("DC Bit Length:%d\n", dcBitLength);
+                    printf("DC Value: %d\n", dcValue);
+                    #endif
+
+                    block[0] = dcValue;
+
+                    // Decode AC
+                    const HuffmanTable<uint8_t>& acTable = m_TableHuffman[2 + pScsp[i].AcEntropyCodingTableDestSelector()];
+                    int32_t acIndex = 1;
+                    while(acIndex < 64)
                     {
-                        uint8_t bitsInFirstByte = 8 - bitOffset;
-                        uint8_t appendFullBytes = (dcBitLength - bitsInFirstByte) / 8;
-                        uint8_t bitsInLastByte = dcBitLength - bitsInFirstByte - 8 * appendFullBytes;
-                        tmpValue = (scanData[byteOffset] & ((0x01u << (8 - bitOffset)) - 1));
-                        for (size_t m = 1; m <= appendFullBytes; ++m)
+                        uint8_t acCode = acTable.DecodeSingleValue(reader);
+
+                        if (!acCode)
                         {
-                            tmpValue <<= 8;
-                            tmpValue += scanData[byteOffset + m];
+                            #if DUMP_DETAILS
+                            std::cout << "Found EOB when decode AC!" << std::endl;
+                            #endif
+                            break;
+                        }
+                        else if (acCode == 0xF0)
+                        {
+                            #if DUMP_DETAILS
+                            std::cout << "Found ZRL when decode AC!" << std::endl;
+                            #endif
+                            acIndex += 16;
+                            continue;
                         }
-                        tmpValue <<= bitsInLastByte;
-                        tmpValue += (scanData[byteOffset + appendFullBytes + 1] >> (8 - bitsInLastByte));
-                    }
-
-                    // decode dc value;
-                    if ((tmpValue >> (dcBitLength - 1)) == 0)
-                    {
-                        // MSB = 1, turn it to minus value
-                        dcValue = -(int16_t)(~tmpValue & ((0x0001u << dcBitLength) - 1));
-                    }
-                    else 
-                    {
-                        dcValue = tmpValue;
-                    }
-                }
-                
-                // add with previous DC value
-                dcValue += previousDC[i];
-                // save the value for next DC
-                previousDC[i] = dcValue;
-
-                #ifdef DUMP_DETAILS
-                printf("DC Code: %x\n", dcCode);
-                printf("DC Bit Length:%d\n", dcBitLength);
-                printf("DC Value: %d\n", dcValue);
-                #endif
-
-                block[i][0] = dcValue;
-
-                // forward pointers to end of DC
-                bitOffset += dcBitLength;
-                while(bitOffset >= 8)
-                {
-                    bitOffset -= 8;
-                    byteOffset++;
-                }
 
-                // Decode AC
-                int32_t acIndex = 1;
-                while(byteOffset < scanData.size() && acIndex < 64)
-                {
-                    uint8_t acCode = m_TreeHuffman[2 + pScsp[i].AcEntropyCodingTableDestSelector()].DecodeSingleValue(scanData.data(), scanData.size(), &byteOffset, &bitOffset);
+                        uint8_t acZeroLength = acCode >> 4;
+                        acIndex += acZeroLength;
+                        uint8_t acBitLength = acCode & 0x0F;
+                        int16_t acValue = static_cast<int16_t>(reader.ReceiveExtend(acBitLength));
 
-                    if (!acCode)
-                    {
-                        #if DUMP_DETAILS
-                        std::cout << "Found EOB when decode AC!" << std::endl;
-                        #endif
-                        break;
-                    }
-                    else if (acCode == 0xF0)
-                    {
-                        #if DUMP_DETAILS
-                        std::cout << "Found ZRL when decode AC!" << std::endl;
+                        #ifdef DUMP_DETAILS
+                        printf("AC Code: %x\n", acCode);
+                        printf("AC Bit Length: %d\n", acBitLength);
+                        printf("AC Value: %d\n", acValue);
                         #endif
-                        acIndex += 16;
-                        continue;
-                    }
 
-                    uint8_t acZeroLength = acCode >> 4;
-                    acIndex += acZeroLength;
-                    uint8_t acBitLength = acCode & 0x0F;
-                    int16_t acValue;
+                        // a run past the end of the block only comes from a corrupt scan
+                        if (acIndex > 63)
+                            break;
 
-                    if (acBitLength + bitOffset <= 8)
-                    {
-                        tmpValue = ((scanData[byteOffset] & ((0x01u << (8 - bitOffset)) - 1)) >> (8 - acBitLength - bitOffset));
-                    }
-                    else 
-                    {
-                        uint8_t bitsInFirstByte = 8 - bitOffset;
-                        uint8_t appendFullBytes = (acBitLength - bitsInFirstByte) / 8;
-                        uint8_t bitsInLastByte = acBitLength - bitsInFirstByte - 8 * appendFullBytes;
-                        tmpValue = (scanData[byteOffset] & ((0x01u << (8 - bitOffset)) - 1));
-                        for (size_t m = 1; m <= appendFullBytes; ++m)
-                        {
-                            tmpValue <<= 8;
-                            tmpValue += scanData[byteOffset + m];
-                        }
-                        tmpValue <<= bitsInLastByte;
-                        tmpValue += (scanData[byteOffset + appendFullBytes + 1] >> (8 - bitsInLastByte));
-                    }
+                        int32_t index = m_ZigzagIndex[acIndex];
+                        block[(index >> 3) * 8 + (index & 0x07)] = acValue;
 
-                    // decode ac value
-                    if ((tmpValue >> (acBitLength - 1)) == 0)
-                    {
-                        // MSB = 1, turn it to minus value
-                        acValue = -(int16_t)(~tmpValue & ((0x0001u << acBitLength) - 1));
-                    }
-                    else
-                    {
-                        acValue = tmpValue;
+                        acIndex++;
                     }
 
                     #ifdef DUMP_DETAILS
-                    printf("AC Code: %x\n", acCode);
-                    printf("AC Bit Length: %d\n", acBitLength);
-                    printf("AC Value: %d\n", acValue);
-                    #endif
+                    printf("Extracted Component[%d] 8x8 block: \n", i);
+                    for (size_t _i = 0; _i < 64; ++_i)
+                    {
 
-                    int32_t index = m_ZigzagIndex[acIndex];
-                    block[i][(index >> 3) * 8 + (index & 0x07)] = acValue;
+                        if (_i != 0 && (_i % 8 == 0))
+                            std::cout << std::endl;
+                        std::cout << block[_i] << ",";
+                    }
+                    std::cout << std::endl << std::endl;
+                    #endif
 
-                    // forward pointers to end of AC
-                    bitOffset += acBitLength;
-                    while(bitOffset >= 8)
+                    // dequantized, transformed and level shifted in one go
+                    DequantizeIDCT8x8(block, m_IdctQuantization[fcsp.QuantizationTableDestSelector], samples);
+                    #ifdef DUMP_DETAILS
+                    std::cout << "After IDCT: " << std::endl;
+                    for (size_t _i = 0; _i < 64; ++_i)
                     {
-                        bitOffset -= 8;
-                        byteOffset++;
+
+                        if (_i != 0 && (_i % 8 == 0))
+                            std::cout << std::endl;
+                        std::cout << (int32_t)samples[_i] << ",";
                     }
+                    std::cout << std::endl << std::endl;
+                    #endif
 
-                    acIndex++;
+                    // into the plane of the component, the image is converted once all of it is decoded
+                    uint8_t* pPlane = m_Planes[i].data() + static_cast<size_t>(m_PlanePitch[i]) * ((mcuIndexY * m_BlocksY[i] + blockY) * 8)
+                        + (mcuIndexX * m_BlocksX[i] + blockX) * 8;
+                    for (int32_t row = 0; row < 8; ++row)
+                        memcpy(pPlane + static_cast<size_t>(m_PlanePitch[i]) * row, samples + row * 8, 8);
                 }
+            }
 
-                #ifdef DUMP_DETAILS
-                printf("Extracted Component[%d] 8x8 block: \n", i);
-                for (size_t _i = 0; _i < 64; ++_i)
-                {
+            mcuIndex++;
+        }
 
-                    if (_i != 0 && (_i % 8 == 0))
-                        std::cout << std::endl;
-                    std::cout << block[i][_i] << ",";
-                }
-                std::cout << std::endl << std::endl;
-                #endif
+        return mcuIndex;
+    }
 
-                for (size_t _i = 0; _i < 64; ++_i)
-                {
-                    block[i][_i] *= m_TableQuantization[fcsp.QuantizationTableDestSelector][_i];
-                }
-                
-#ifdef DUMP_DETAILS
-                std::cout << "After Quantization: " << std::endl;
-                for (size_t _i = 0; _i < 64; ++_i)
-                {
+    void JfifParser::ParseScanData(AssetStream& stream)
+    {
+        // the bits are taken from the chunks of the stream as they come, the segment is never copied
+        JpegBitReader reader(stream);
 
-                    if (_i != 0 && (_i % 8 == 0))
-                        std::cout << std::endl;
-                    std::cout << block[i][_i] << ",";
-                }
-                std::cout << std::endl << std::endl;
+#if DUMP_DETAILS
+        std::cout << "Total MCU count: " << McuCount << std::endl;
 #endif
 
-                block[i][0] += 1024.0f; // level shift. same as +128 to each element after IDCT
-                IDCT8x8(block[i], block[i]);
-                #ifdef DUMP_DETAILS
-                std::cout << "After IDCT: " << std::endl;
-                for (size_t _i = 0; _i < 64; ++_i)
-                {
+        // the interval ends byte aligned, with the restart marker after it
+        int endMcu = McuCount;
+        if (m_RestartInterval != 0)
+            endMcu = std::min(McuCount, (McuIndex / m_RestartInterval + 1) * m_RestartInterval);
+        McuIndex = DecodeMcus(reader, McuIndex, endMcu);
 
-                    if (_i != 0 && (_i % 8 == 0))
-                        std::cout << std::endl;
-                    std::cout << block[i][_i] << ",";
-                }
-                std::cout << std::endl << std::endl;
-                #endif
+        // skip what is left of the segment, so the marker after it is read next
+        m_PendingMarker = reader.Finish();
+    }
+
+    // where the intervals of an entropy coded segment start and end, as offsets into it
+    struct ScanIndex
+    {
+        std::vector<size_t> IntervalStart;
+        std::vector<size_t> IntervalEnd;
+        size_t Scanned = 0;     // bytes indexed so far, what follows may still be missing
+        size_t End = 0;         // just past the marker that ends the segment
+        uint16_t Marker = 0;    // that marker, 0 while it has not been found
+    };
+
+    // continues indexing data from index.Scanned, true once the marker that ends the segment is found
+    static bool IndexScanData(const uint8_t* pData, size_t size, ScanIndex& index)
+    {
+        if (index.IntervalStart.empty())
+            index.IntervalStart.push_back(0);
+
+        while (index.Scanned < size)
+        {
+            const uint8_t* pMarker = static_cast<const uint8_t*>(memchr(pData + index.Scanned, 0xFF, size - index.Scanned));
+            if (!pMarker)
+            {
+                index.Scanned = size;
+                break;
             }
 
-            assert(m_ComponentsInFrame <= 4);
+            // more 0xFF are fill bytes in front of a marker
+            size_t marker = pMarker - pData;
+            size_t next = marker + 1;
+            while (next < size && pData[next] == 0xFF)
+                ++next;
+            if (next == size)
+            {
+                // the byte after it has not come yet, looked at again with it
+                index.Scanned = marker;
+                break;
+            }
 
-            YCbCrf ycbcr;
-            RGBf rgb;
-            int mcuIndexX = McuIndex % McuCountX;
-            int mcuIndexY = McuIndex / McuCountX;
-            uint8_t* pBuf;
+            index.Scanned = next + 1;
+            if (pData[next] == 0x00)
+                continue;   // bitstuff
 
-            for (size_t i = 0; i < 8; ++i)
-                for (size_t j = 0; j < 8; ++j)
-                {
-                    for (size_t k = 0; k < m_ComponentsInFrame; ++k)
-                    {
-                        ycbcr.data[k] = block[k][i * 8 + j];
-                    }
+            index.IntervalEnd.push_back(marker);
+            if (pData[next] >= 0xD0 && pData[next] <= 0xD7)
+            {
+                index.IntervalStart.push_back(next + 1);
+                continue;
+            }
 
-                    pBuf = reinterpret_cast<uint8_t*>(img.Data) + (img.Pitch * (mcuIndexY * 8 + i) + (mcuIndexX * 8 + j) * (img.BitCount >> 3));
-                    rgb = ConvertYCbCr2RGB(ycbcr);
-                    reinterpret_cast<R8G8B8A8Unorm*>(pBuf)->data[0] = (uint8_t)rgb[0];
-                    reinterpret_cast<R8G8B8A8Unorm*>(pBuf)->data[1] = (uint8_t)rgb[1];
-                    reinterpret_cast<R8G8B8A8Unorm*>(pBuf)->data[2] = (uint8_t)rgb[2];
-                    reinterpret_cast<R8G8B8A8Unorm*>(pBuf)->data[3] = 255;
-                }
+            index.End = next + 1;
+            index.Marker = 0xFF00 | pData[next];
+            return true;
+        }
 
-            McuIndex++;
+        return false;
+    }
 
-            if(m_RestartInterval != 0 && (McuIndex % m_RestartInterval == 0))
+    void JfifParser::ParseScanDataParallel(AssetStream& stream)
+    {
+        // the stream is over memory, its first chunk is all that is left of the asset and the scan
+        // is decoded in place
+        assert(stream.IsInMemory());
+        ScanIndex index;
+        const uint8_t* pData;
+        size_t size = stream.ReadChunk(pData);
+        IndexScanData(pData, size, index);
+
+        if (index.Marker)
+        {
+            // what follows the marker is read again by Parse(), it is all in the last chunk
+            stream.Unread(size - index.End);
+        }
+        else
+        {
+            // a truncated scan, the last interval runs to the end of the asset
+            index.IntervalEnd.resize(index.IntervalStart.size(), size);
+        }
+        m_PendingMarker = index.Marker;
+
+        int firstMcu = McuIndex;
+        int intervalCount = std::min(static_cast<int>(index.IntervalStart.size()),
+            (McuCount - firstMcu + m_RestartInterval - 1) / m_RestartInterval);
+        McuIndex = std::min(McuCount, firstMcu + intervalCount * m_RestartInterval);
+
+#if DUMP_DETAILS
+        std::cout << "Total MCU count: " << McuCount << ", restart intervals: " << intervalCount << std::endl;
+#endif
+
+        // every interval starts its DC prediction over and covers MCUs of its own,
+        // so they decode side by side into disjoint blocks of the planes
+        std::atomic<int> nextInterval{0};
+        auto decodeIntervals = [&]() {
+            int interval;
+            while ((interval = nextInterval++) < intervalCount)
             {
-                if (bitOffset)
-                {
-                    // finish current byte
-                    bitOffset = 0;
-                    byteOffset++;
-                }
-                assert(byteOffset == scanData.size());
-                break;
+                size_t start = index.IntervalStart[interval];
+                AssetStream intervalStream(BufferView(nullptr, pData + start, index.IntervalEnd[interval] - start));
+                JpegBitReader reader(intervalStream);
+                int mcu = firstMcu + interval * m_RestartInterval;
+                DecodeMcus(reader, mcu, std::min(McuCount, mcu + m_RestartInterval));
             }
+        };
+
+        uint32_t threadCount = std::min(GetDecodeConcurrency(), static_cast<uint32_t>(std::max(intervalCount, 1)));
+
+        // the calling thread decodes as one of them
+        std::vector<std::thread> workers;
+        for (uint32_t i = 1; i < threadCount; ++i)
+            workers.emplace_back(decodeIntervals);
+        decodeIntervals();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    uint32_t JfifParser::GetDecodeConcurrency() const
+    {
+        if (m_MaxConcurrency)
+            return m_MaxConcurrency;
+
+        // the threads of a Resolve() loading this image decode other assets on the rest of the cores
+        uint32_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+        uint32_t resolving = std::max(AssetDependencyGraph::GetResolveConcurrency(), 1u);
+        return std::max(cores / resolving, 1u);
+    }
+
+    void JfifParser::ConvertPlanes(Image& img) const
+    {
+        // the padding of the last MCUs is converted too, as the pitch covers it anyway
+        YCbCrPlanes planes;
+        planes.Y = m_Planes[0].data();
+        planes.Cb = m_ComponentsInFrame == 3 ? m_Planes[1].data() : nullptr;
+        planes.Cr = m_ComponentsInFrame == 3 ? m_Planes[2].data() : nullptr;
+        planes.LumaPitch = m_PlanePitch[0];
+        planes.ChromaPitch = m_ComponentsInFrame == 3 ? m_PlanePitch[1] : 0;
+        planes.Width = m_PlanePitch[0];
+        planes.Height = static_cast<uint32_t>(m_Planes[0].size() / m_PlanePitch[0]);
+        planes.ChromaShiftX = m_ComponentsInFrame == 3 && m_BlocksX[0] > m_BlocksX[1] ? 1 : 0;
+        planes.ChromaShiftY = m_ComponentsInFrame == 3 && m_BlocksY[0] > m_BlocksY[1] ? 1 : 0;
+
+        ConvertYCbCr2RGBA(planes, 0, planes.Height, img);
+    }
+
+    bool JfifParser::ReadMarker(AssetStream& stream, uint16_t& marker)
+    {
+        if (m_PendingMarker)
+        {
+            marker = m_PendingMarker;
+            m_PendingMarker = 0;
+            return true;
+        }
+
+        // anything in front of the 0xFF is skipped, more 0xFF are fill bytes,
+        // and 0xFF00 is stuffed scan data rather than a marker
+        uint8_t byte = 0;
+        while (byte == 0)
+        {
+            do
+            {
+                if (stream.Read(&byte, 1) != 1)
+                    return false;
+            } while (byte != 0xFF);
+            do
+            {
+                if (stream.Read(&byte, 1) != 1)
+                    return false;
+            } while (byte == 0xFF);
         }
-        
-        return scanLength;
+
+        marker = 0xFF00 | byte;
+        return true;
+    }
+
+    Image JfifParser::Parse(const BufferView& buf)
+    {
+        // the stream hands out slices of buf, nothing is copied
+        AssetStream stream(buf);
+        return Parse(stream);
     }
 
-    Image JfifParser::Parse(Buffer& buf)
+    Image JfifParser::Parse(AssetStream& stream)
     {
         Image img;
 
-        const uint8_t* pData = buf.GetData();
-        const uint8_t* pDataEnd = buf.GetData() + buf.GetDataSize();
+        m_PendingMarker = 0;
+        m_RestartInterval = 0;
+        pScsp = nullptr;
 
-        const JFIF_FILEHEADER* pFileHeader = reinterpret_cast<const JFIF_FILEHEADER*>(pData);
-        pData += sizeof(JFIF_FILEHEADER);
-        if (pFileHeader->SOI == to_endian_net((uint16_t)0xFFD8))
+        JFIF_FILEHEADER fileHeader;
+        if (stream.Read(&fileHeader, sizeof(JFIF_FILEHEADER)) == sizeof(JFIF_FILEHEADER)
+            && fileHeader.SOI == to_endian_net((uint16_t)0xFFD8))
         {
             std::cout << "Asset if JPEG file" << std::endl;
 
-            while(pData < pDataEnd)
+            // the segment being parsed, marker and length included, so the headers can be cast onto it
+            std::vector<uint8_t> segment;
+            bool imageEnded = false;
+            uint16_t marker;
+
+            while(!imageEnded && ReadMarker(stream, marker))
             {
-                size_t scanLength = 0;
+                // restart markers and the end of image have no length, nor any data
+                bool hasLength = !(marker >= 0xFFD0 && marker <= 0xFFD9) && marker != 0xFF01;
+                segment.assign(sizeof(JPEG_SEGMENT_HEADER), 0);
+                *reinterpret_cast<uint16_t*>(segment.data()) = to_endian_net(marker);
+                if (hasLength)
+                {
+                    if (stream.Read(segment.data() + sizeof(uint16_t), sizeof(uint16_t)) != sizeof(uint16_t))
+                        break;
+                    size_t length = to_endian_native(reinterpret_cast<const JPEG_SEGMENT_HEADER*>(segment.data())->Length);
+                    if (length < sizeof(uint16_t))
+                        break;
+                    segment.resize(sizeof(uint16_t) + length);
+                    if (stream.Read(segment.data() + sizeof(JPEG_SEGMENT_HEADER), length - sizeof(uint16_t)) != length - sizeof(uint16_t))
+                    {
+                        std::cout << "JPEG file looks corrupted. Segment is cut short." << std::endl;
+                        break;
+                    }
+                }
 
+                const uint8_t* pData = segment.data();
                 const JPEG_SEGMENT_HEADER* pSegmentHeader = reinterpret_cast<const JPEG_SEGMENT_HEADER*>(pData);
 
                 switch(to_endian_native(pSegmentHeader->Marker))
@@ -343,18 +513,15 @@ namespace Panda
                         m_SamplesPerLine = to_endian_native(pFrameHeader->NumOfSamplesPerLine);
                         m_ComponentsInFrame = pFrameHeader->NumOfComponentsInFrame;
                         McuIndex = 0;
-                        McuCountX = ((m_SamplesPerLine + 7) >> 3);
-                        McuCountY = ((m_Lines + 7) >> 3);
-                        McuCount = McuCountX * McuCountY;
 
                         std::cout << "Sample Precision: " << m_SamplePrecision << std::endl;
                         std::cout << "Num of Lines: " << m_Lines << std::endl;
                         std::cout << "Num of Samples per line: " << m_SamplesPerLine << std::endl;
                         std::cout << "Num of Components In Frame: " << m_ComponentsInFrame << std::endl;
-                        std::cout << "Totale MCU count: " << McuCount << std::endl;
 
                         const uint8_t* pTmp = pData + sizeof(FRAME_HEADER);
                         const FRAME_COMPONENT_SPEC_PARAMS* pFcsp = reinterpret_cast<const FRAME_COMPONENT_SPEC_PARAMS*>(pTmp);
+                        m_TableFrameComponentSpec.clear();
                         for (uint8_t i = 0; i < pFrameHeader->NumOfComponentsInFrame; ++i)
                         {
                             std::cout << "\tComponent Identifier: " << (uint16_t)pFcsp->ComponentIdentifier << std::endl;
@@ -366,15 +533,51 @@ namespace Panda
                             pFcsp++;
                         }
 
+                        // an MCU is as many blocks of a component as its sampling factors say, a single
+                        // component scan is not interleaved and goes one block at a time
+                        int32_t maxBlocksX = 1;
+                        int32_t maxBlocksY = 1;
+                        bool isSupported = m_ComponentsInFrame == 1 || m_ComponentsInFrame == 3;
+                        for (uint8_t i = 0; i < m_ComponentsInFrame && isSupported; ++i)
+                        {
+                            m_BlocksX[i] = m_ComponentsInFrame == 1 ? 1 : m_TableFrameComponentSpec[i].HorizontalSamplingFactor();
+                            m_BlocksY[i] = m_ComponentsInFrame == 1 ? 1 : m_TableFrameComponentSpec[i].VerticalSamplingFactor();
+                            maxBlocksX = std::max(maxBlocksX, m_BlocksX[i]);
+                            maxBlocksY = std::max(maxBlocksY, m_BlocksY[i]);
+                        }
+                        // luma at full resolution, chroma at full or half of it, 4:4:4, 4:2:2, 4:4:0 or 4:2:0
+                        for (uint8_t i = 0; i < m_ComponentsInFrame && isSupported; ++i)
+                        {
+                            bool isLuma = i == 0;
+                            isSupported = (isLuma ? m_BlocksX[i] == maxBlocksX && m_BlocksY[i] == maxBlocksY
+                                : m_BlocksX[i] == 1 && m_BlocksY[i] == 1) && maxBlocksX <= 2 && maxBlocksY <= 2;
+                        }
+
+                        if (!isSupported)
+                        {
+                            std::cout << "Unsupported components or sampling factors!" << std::endl;
+                            break;
+                        }
+
+                        McuCountX = (m_SamplesPerLine + maxBlocksX * 8 - 1) / (maxBlocksX * 8);
+                        McuCountY = (m_Lines + maxBlocksY * 8 - 1) / (maxBlocksY * 8);
+                        McuCount = McuCountX * McuCountY;
+                        std::cout << "Totale MCU count: " << McuCount << std::endl;
+
+                        for (uint8_t i = 0; i < m_ComponentsInFrame; ++i)
+                        {
+                            m_PlanePitch[i] = McuCountX * m_BlocksX[i] * 8;
+                            m_Planes[i].assign(static_cast<size_t>(m_PlanePitch[i]) * McuCountY * m_BlocksY[i] * 8, 0);
+                        }
+
                         img.Width = m_SamplesPerLine;
                         img.Height = m_Lines;
                         img.BitCount = 32;
-                        img.Pitch = McuCountX * 8 * (img.BitCount >> 3);
-                        img.DataSize = img.Pitch * McuCountY * 8; //* (img.BitCount >> 3);
+                        img.Pitch = McuCountX * maxBlocksX * 8 * (img.BitCount >> 3);
+                        img.DataSize = img.Pitch * McuCountY * maxBlocksY * 8; //* (img.BitCount >> 3);
                         img.Data = g_pMemoryManager->Allocate(img.DataSize);
 
                         std::cout << std::endl;
-                        pData += to_endian_native(pSegmentHeader->Length) + 2; // length of marker
                     }
                     break;
                     case 0xFFC4: // Define Huffman Table(s)
@@ -392,15 +595,37 @@ namespace Panda
 
                         while (segmentLength > 0)
                         {
+                            if (segmentLength < sizeof(HUFFMAN_TABLE_SPEC))
+                            {
+                                std::cout << "JPEG file looks corrupted. Huffman table is cut short." << std::endl;
+                                break;
+                            }
+
                             const HUFFMAN_TABLE_SPEC* pHtable = reinterpret_cast<const HUFFMAN_TABLE_SPEC*>(pTmp);
                             std::cout << "Table Class: " << pHtable->TableClass() << std::endl;
                             std::cout << "Destination Identifier: " << pHtable->DestinationIdentifier() << std::endl;
 
+                            // the symbols follow the counts, all of them have to be inside the segment
+                            size_t symbolCount = 0;
+                            for (size_t i = 0; i < 16; ++i)
+                                symbolCount += pHtable->NumOfHuffmanCodes[i];
+                            if (pHtable->TableClass() > 1 || pHtable->DestinationIdentifier() > 1
+                                || symbolCount > segmentLength - sizeof(HUFFMAN_TABLE_SPEC))
+                            {
+                                std::cout << "JPEG file looks corrupted. Invalid Huffman table." << std::endl;
+                                break;
+                            }
+
                             const uint8_t* pCodeValueStart = reinterpret_cast<const uint8_t*>(pHtable) + sizeof(HUFFMAN_TABLE_SPEC);
-                            auto numSymbo = m_TreeHuffman[(pHtable->TableClass() << 1) | pHtable->DestinationIdentifier()].PopulateWithHuffmanTable(pHtable->NumOfHuffmanCodes, pCodeValueStart);
+                            auto numSymbo = m_TableHuffman[(pHtable->TableClass() << 1) | pHtable->DestinationIdentifier()].PopulateWithHuffmanTable(pHtable->NumOfHuffmanCodes, pCodeValueStart);
+                            if (numSymbo != symbolCount)
+                            {
+                                std::cout << "JPEG file looks corrupted. Huffman codes do not fit their lengths." << std::endl;
+                                break;
+                            }
 
                             #ifdef DUMP_DETAILS
-                            m_TreeHuffman[(pHtable->TableClass() << 1) | pHtable->DestinationIdentifier()].Dump();
+                            m_TableHuffman[(pHtable->TableClass() << 1) | pHtable->DestinationIdentifier()].Dump();
                             #endif
 
                             size_t processedLength = sizeof(HUFFMAN_TABLE_SPEC) + numSymbo;
@@ -408,7 +633,6 @@ namespace Panda
                             segmentLength -= processedLength;
                         }
                         std::cout << std::endl;
-                        pData += to_endian_native(pSegmentHeader->Length) + 2; // length of the marker
                     }
                     break;
                     case 0xFFDB: // Define Quantization Table(s)
@@ -439,6 +663,7 @@ namespace Panda
                                 else 
                                     m_TableQuantization[pQtable->DestinationIdentifier()][(index >> 3) * 8 + (index & 0x7)] = to_endian_native(*((uint16_t*)pElementDataStart + i));
                             }
+                            PrepareIdctQuantization(m_TableQuantization[pQtable->DestinationIdentifier()], m_IdctQuantization[pQtable->DestinationIdentifier()]);
                             #ifdef DUMP_DETAILS
                             std::cout << std::endl;
                             for (size_t i = 0; i < 64; ++i)
@@ -454,7 +679,6 @@ namespace Panda
                             segmentLength -= processedLength;
                         }
                         std::cout << std::endl;
-                        pData += to_endian_native(pSegmentHeader->Length) + 2; // lengh of the marker
                     }
                     break;
                     case 0xFFDD:
@@ -470,7 +694,6 @@ namespace Panda
                         m_RestartInterval = to_endian_native((uint16_t)pRestartHeader->RestertInterval);
                         std::cout << "Restart interval: " << m_RestartInterval << std::endl;
                         std::cout << std::endl;
-                        pData += to_endian_native(pSegmentHeader->Length) + 2; // length of the marker
                     }
                     break;
                     case 0xFFDA:
@@ -487,13 +710,19 @@ namespace Panda
                         assert(pScanHeader->NumOfComponents == m_ComponentsInFrame);
 
                         const uint8_t* pTmp = pData + sizeof(SCAN_HEADER);
-                        pScsp = reinterpret_cast<const SCAN_COMPONENT_SPEC_PARAMS*>(pTmp);
-
-                        const uint8_t* pScanData = pData + to_endian_native((uint16_t)pScanHeader->Length) + 2;
-
-                        scanLength = ParseScanData(pScanData, pDataEnd, img);
+                        // kept for the restart intervals that follow, the segment buffer is reused
+                        m_ScanComponentSpec.assign(reinterpret_cast<const SCAN_COMPONENT_SPEC_PARAMS*>(pTmp),
+                            reinterpret_cast<const SCAN_COMPONENT_SPEC_PARAMS*>(pTmp) + pScanHeader->NumOfComponents);
+                        pScsp = m_ScanComponentSpec.data();
+
+                        // the entropy coded segment follows the header directly, a file is decoded as it
+                        // comes through the ring so no more than the ring is held
+                        if (img.Data && stream.IsInMemory() && m_RestartInterval != 0 && GetDecodeConcurrency() > 1
+                            && McuCount > m_RestartInterval)
+                            ParseScanDataParallel(stream);
+                        else if (img.Data)
+                            ParseScanData(stream);
                         std::cout << std::endl;
-                        pData += to_endian_native(pSegmentHeader->Length) + 2 + scanLength; // length of the marker
                     }
                     break;
                     case 0xFFD0:
@@ -508,16 +737,14 @@ namespace Panda
 #if DUMP_DETAILS
                         std::cout << "======================" << std::endl;
 #endif
-                        std::cout << "Segment Length: " << to_endian_native(pSegmentHeader->Length) << " bytes" << std::endl;
                         #if DUMP_DETAILS
                         std::cout << "Restart of Scan" << std::endl;
                         std::cout << "----------------------" << std::endl;
                         #endif
 
-                        const uint8_t* pScanData = pData + 2;
-                        scanLength = ParseScanData(pScanData, pDataEnd, img);
+                        if (img.Data && pScsp)
+                            ParseScanData(stream);
                         std::cout << std::endl;
-                        pData += 2 + scanLength; // length of the marker
                     }
                     break;
                     case 0xFFD9:
@@ -528,7 +755,7 @@ namespace Panda
                         std::cout << "End of Scan" << std::endl;
                         std::cout << "------------------------" << std::endl;
                         std::cout << std::endl;
-                        pData += 2; // length of marker
+                        imageEnded = true;
                     }
                     break;
                     case 0xFFE0: // Application specific
@@ -590,7 +817,6 @@ namespace Panda
                                 std::cout << "Ignore Unrecognized APP0 segment" << std::endl;
                         }
                         std::cout << std::endl;
-                        pData += to_endian_native(pSegmentHeader->Length) + 2;
                     }
                     break;
                     case 0xFFFE:
@@ -602,7 +828,6 @@ namespace Panda
                         std::cout << "Text Comment" << std::endl;
                         std::cout << "---------------------" << std::endl;
                         std::cout << std::endl;
-                        pData += to_endian_native(pSegmentHeader->Length) + 2;
                     }
                     break;
                     default:
@@ -613,7 +838,6 @@ namespace Panda
                         std::cout << "Segment Length: " << to_endian_native(pSegmentHeader->Length) << " bytes" << std::endl;
                             std::printf("Ignore unrecognized Segment. Marker = %0x\n\n", to_endian_native(pSegmentHeader->Marker));
                             std::cout << std::endl;
-                            pData += to_endian_native(pSegmentHeader->Length) + 2; // length of the marker
                         }
                         break;
                 }
@@ -622,6 +846,10 @@ namespace Panda
         else 
             std::cout << "File is not a JPEG file!" << std::endl;
 
+        // what is left of a truncated image stays at the samples the planes were cleared to
+        if (img.Data)
+            ConvertPlanes(img);
+
         return img;
     }   
 }
\ No newline at end of file
@@ -6,10 +6,15 @@
 #include <cassert>
 #include <queue>
 #include <algorithm>
+#include <vector>
+#include <atomic>
+#include <thread>
 #include "Interface/ImageParser.hpp"
 #include "portable.hpp"
 #include "Math/HuffmanTree.hpp"
+#include "Math/FastIDCT.hpp"
 #include "ColorSpaceConversion.hpp"
+#include "AssetDependencyGraph.hpp"
 
 namespace Panda
 {
@@ -115,6 +120,73 @@ namespace Panda
     };
 #pragma pack(pop)
 
+    /**
+     * Reads the bits of an entropy coded segment straight out of the chunks
+     * of an AssetStream, 64 of them buffered at a time. The stuffed 0x00 after
+     * each 0xFF is dropped as the buffer is refilled, the marker that ends the
+     * segment stops it, and after that the decoder reads zeros.
+     */
+    class JpegBitReader
+    {
+        public:
+            explicit JpegBitReader(AssetStream& stream);
+
+            // the next count bits, 1 to 32, without consuming them
+            FORCEINLINE uint32_t PeekBits(uint32_t count)
+            {
+                if (m_BitCount < count)
+                    Refill();
+                return static_cast<uint32_t>(m_Bits >> (64 - count));
+            }
+
+            // count may not be more than the last PeekBits() asked for
+            FORCEINLINE void SkipBits(uint32_t count)
+            {
+                m_Bits <<= count;
+                m_BitCount -= count;
+            }
+
+            FORCEINLINE uint32_t GetBits(uint32_t count)
+            {
+                if (count == 0)
+                    return 0;
+                uint32_t bits = PeekBits(count);
+                SkipBits(count);
+                return bits;
+            }
+
+            // the next size bits as a coefficient, the values with the top bit clear are the negative ones (ITU-T81 F.2.2.1)
+            FORCEINLINE int32_t ReceiveExtend(uint32_t size)
+            {
+                int32_t value = static_cast<int32_t>(GetBits(size));
+                return (size && value < (1 << (size - 1))) ? value - (1 << size) + 1 : value;
+            }
+
+            // every bit of the segment has been consumed
+            bool IsPastEnd() const {return m_IsEnded && m_BitCount <= m_PaddingBits;}
+
+            /**
+             * Skip the rest of the segment and return the marker after it, 0 when
+             * the stream ends first. The stream is left right after the marker.
+             */
+            uint16_t Finish();
+
+        private:
+            // buffer at least 57 bits
+            void Refill();
+            bool NextByte(uint8_t& byte);
+
+        private:
+            AssetStream* m_pStream;
+            uint64_t m_Bits;            // the next bit is the top one
+            uint32_t m_BitCount;
+            size_t m_PaddingBits;       // zeros buffered after the end of the segment
+            const uint8_t* m_pNext;     // in the chunk the stream handed out last
+            const uint8_t* m_pEnd;
+            uint16_t m_Marker;          // the marker that ended the segment
+            bool m_IsEnded;
+    };
+
     class JfifParser : implements ImageParser 
     {
         private:
@@ -130,8 +202,9 @@ namespace Panda
             };
 
         protected:
-            HuffmanTree<uint8_t> m_TreeHuffman[4];
+            HuffmanTable<uint8_t> m_TableHuffman[4];
             float m_TableQuantization[4][64];
+            IdctQuantization m_IdctQuantization[4];    // m_TableQuantization scaled for DequantizeIDCT8x8
             std::vector<FRAME_COMPONENT_SPEC_PARAMS>    m_TableFrameComponentSpec;
             uint16_t m_SamplePrecision;
             uint16_t m_Lines;
@@ -142,12 +215,36 @@ namespace Panda
             int McuCountX;
             int McuCountY;
             int McuCount;
+            int32_t m_BlocksX[4];   // 8x8 blocks of each component across an MCU
+            int32_t m_BlocksY[4];   // and down it
+            std::vector<uint8_t> m_Planes[4];   // the decoded samples of each component, MCUs padding included
+            uint32_t m_PlanePitch[4];
             const SCAN_COMPONENT_SPEC_PARAMS* pScsp;
+            std::vector<SCAN_COMPONENT_SPEC_PARAMS> m_ScanComponentSpec;    // pScsp points in here
+
+            uint16_t m_PendingMarker;   // the marker that ended the last scan, 0 when the next one still has to be read
+            uint32_t m_MaxConcurrency = 0;  // threads decoding restart intervals, 0 for the cores left to the caller
 
         protected:
-            size_t ParseScanData(const uint8_t* pScanData, const uint8_t* pDataEnd, Image& img);
+            // decode MCUs firstMcu to endMcu - 1 with the DC prediction starting over, returns where it
+            // stopped, writes nothing but the samples of those MCUs
+            int DecodeMcus(JpegBitReader& reader, int firstMcu, int endMcu);
+            // decode MCUs until the segment ends or a restart interval is complete
+            void ParseScanData(AssetStream& stream);
+            // index the restart intervals of the whole segment, then decode them on a number of threads,
+            // for streams over memory only
+            void ParseScanDataParallel(AssetStream& stream);
+            uint32_t GetDecodeConcurrency() const;
+            // the planes into the pixels of img, chroma upsampled on the way
+            void ConvertPlanes(Image& img) const;
+            bool ReadMarker(AssetStream& stream, uint16_t& marker);
 
         public:
-            virtual Image Parse(Buffer& buf);
+            // for scans with restart intervals, 1 decodes them one after another as they are read
+            void SetMaxConcurrency(uint32_t maxConcurrency) { m_MaxConcurrency = maxConcurrency; }
+
+            virtual Image Parse(const BufferView& buf);
+            // the scan data is decoded as it is read, through a window of a fixed size
+            virtual Image Parse(AssetStream& stream);
     };
 }
\ No newline at end of file
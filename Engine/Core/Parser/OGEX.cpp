@@ -27,12 +27,12 @@ namespace Panda
             }
             case OGEX::kStructureNode:
             {
-                node = std::make_shared<SceneEmptyNode>(structure.GetStructureName());
+                node = MakeShared<SceneEmptyNode>(structure.GetStructureName());
                 break;
             }
             case OGEX::kStructureBoneNode:
             {
-                auto _node = std::make_shared<SceneBoneNode>(structure.GetStructureName());
+                auto _node = MakeShared<SceneBoneNode>(structure.GetStructureName());
                 std::string _key = structure.GetStructureName();
                 scene.BoneNodes.emplace(_key, _node);
                 node = _node;
@@ -41,7 +41,7 @@ namespace Panda
             case OGEX::kStructureGeometryNode:
             {
                 std::string _key = structure.GetStructureName();
-                auto _node = std::make_shared<SceneGeometryNode>(_key);
+                auto _node = MakeShared<SceneGeometryNode>(_key);
                 const OGEX::GeometryNodeStructure& _structure = dynamic_cast<const OGEX::GeometryNodeStructure&>(structure);
 
                 _node->SetVisibility(_structure.GetVisibleFlag());
@@ -51,6 +51,8 @@ namespace Panda
                 // ref scene objects
                 _key = _structure.GetObjectStructure()->GetStructureName();
                 _node->AddSceneObjectRef(_key);
+                scene.Dependencies.AddDependency(PANDA_ASSET_NODE_SCENE, scene.SceneGraph->GetName(),
+                    PANDA_ASSET_NODE_GEOMETRY, _key);
 
                 // ref materials
                 auto materials = _structure.GetMaterialStructureArray();
@@ -60,6 +62,7 @@ namespace Panda
                     auto material = materials[i];
                     std::string name = material->GetStructureName();
                     _node->AddMaterialRef(name);
+                    scene.Dependencies.AddDependency(PANDA_ASSET_NODE_GEOMETRY, _key, PANDA_ASSET_NODE_MATERIAL, name);
                 }
 
                 std::string name = _structure.GetNodeName();
@@ -71,7 +74,7 @@ namespace Panda
             }
             case OGEX::kStructureLightNode:
             {
-                auto _node = std::make_shared<SceneLightNode>(structure.GetStructureName());
+                auto _node = MakeShared<SceneLightNode>(structure.GetStructureName());
                 const OGEX::LightNodeStructure& _structure = dynamic_cast<const OGEX::LightNodeStructure&>(structure);
 
                 _node->SetIfCastShadow(_structure.GetShadowFlag());
@@ -87,7 +90,7 @@ namespace Panda
             }
             case OGEX::kStructureCameraNode:
             {
-                auto _node = std::make_shared<SceneCameraNode>(structure.GetStructureName());
+                auto _node = MakeShared<SceneCameraNode>(structure.GetStructureName());
                 const OGEX::CameraNodeStructure& _structure = dynamic_cast<const OGEX::CameraNodeStructure&>(structure);
 
                 // ref scene objects
@@ -103,7 +106,7 @@ namespace Panda
             {
                 const OGEX::GeometryObjectStructure& _structure = dynamic_cast<const OGEX::GeometryObjectStructure&>(structure);
                 std::string _key = _structure.GetStructureName();
-                auto _object = std::make_shared<SceneObjectGeometry>();
+                auto _object = MakeShared<SceneObjectGeometry>();
 
                 // properties
                 _object->SetVisibility(_structure.GetVisibleFlag());
@@ -196,9 +199,7 @@ namespace Panda
                                     auto arraySize = dataStructure->GetArraySize();
                                     auto elementCount = dataStructure->GetDataElementCount();
                                     const void*_data = &dataStructure->GetDataElement(0);
-                                    void* data = new float[elementCount];
                                     size_t buf_size = sizeof(float) * elementCount;
-                                    memcpy(data, _data, buf_size);
                                     VertexDataType vertexDataType;
                                     switch(arraySize)
                                     {
@@ -217,7 +218,9 @@ namespace Panda
                                         default:
                                             continue;
                                     }
-                                    SceneObjectVertexArray& _v_array = *new SceneObjectVertexArray(attr, morph_index, vertexDataType, data, elementCount);
+                                    // long-lived vertex data goes to the relocatable heap
+                                    auto data = MakeShared<RelocatableBuffer>(_data, buf_size);
+                                    SceneObjectVertexArray _v_array(attr, morph_index, vertexDataType, std::move(data), elementCount);
                                     mesh->AddVertexArray(std::move(_v_array));
 
                                     break;
@@ -291,9 +294,8 @@ namespace Panda
                                     }
 
                                     size_t buf_size = elementCount * data_size;
-                                    void* data = new uint8_t[buf_size];
-                                    memcpy(data, _data, buf_size);
-                                    SceneObjectIndexArray& _i_array = *new SceneObjectIndexArray(material_index, restart_index, index_type, data, elementCount);
+                                    auto data = MakeShared<RelocatableBuffer>(_data, buf_size);
+                                    SceneObjectIndexArray _i_array(material_index, restart_index, index_type, std::move(data), elementCount);
                                     mesh->AddIndexArray(std::move(_i_array));
 
                                     break;
@@ -335,7 +337,7 @@ namespace Panda
                         // TODO: EXCHANGE y and z
                         // ExchangeYandZ(matrix)
                     }
-                    transform = std::make_shared<SceneObjectTransform>(matrix, object_flag);
+                    transform = MakeShared<SceneObjectTransform>(matrix, object_flag);
                     baseNode->AppendTransform(_key, std::move(transform));
                     //baseNode->AppendTransform(transform);
                 }
@@ -351,11 +353,11 @@ namespace Panda
                 auto data = _structure.GetTranslation();
                 if (kind == "xyz")
                 {
-                    translation = std::make_shared<SceneObjectTranslation>(data[0], data[1], data[2]);
+                    translation = MakeShared<SceneObjectTranslation>(data[0], data[1], data[2]);
                 }
                 else 
                 {
-                    translation = std::make_shared<SceneObjectTranslation>(kind[0], data[0]);
+                    translation = MakeShared<SceneObjectTranslation>(kind[0], data[0]);
                 }
                 auto _key = _structure.GetStructureName();
                 baseNode->AppendTransform(_key, std::move(translation));
@@ -371,23 +373,23 @@ namespace Panda
                 auto data = _structure.GetRotation();
                 if (kind == "x")
                 {
-                    rotation = std::make_shared<SceneObjectRotation>('x', data[0], object_flag);
+                    rotation = MakeShared<SceneObjectRotation>('x', data[0], object_flag);
                 }
                 else if (kind == "y")
                 {
-                    rotation = std::make_shared<SceneObjectRotation>('y', data[0], object_flag);
+                    rotation = MakeShared<SceneObjectRotation>('y', data[0], object_flag);
                 }
                 else if (kind == "z")
                 {
-                    rotation = std::make_shared<SceneObjectRotation>('z', data[0], object_flag);
+                    rotation = MakeShared<SceneObjectRotation>('z', data[0], object_flag);
                 }
                 else if (kind == "axis")
                 {
-                    rotation = std::make_shared<SceneObjectRotation>(Vector3Df({ data[0], data[1], data[2] }), data[3], object_flag);
+                    rotation = MakeShared<SceneObjectRotation>(Vector3Df({ data[0], data[1], data[2] }), data[3], object_flag);
                 }
                 else if (kind == "quaternion")
                 {
-                    rotation = std::make_shared<SceneObjectRotation>(Quaternion({ data[0], data[1], data[2], data[3] }), object_flag);
+                    rotation = MakeShared<SceneObjectRotation>(Quaternion({ data[0], data[1], data[2], data[3] }), object_flag);
                 }
 
                 auto _key = _structure.GetStructureName();
@@ -404,19 +406,19 @@ namespace Panda
                 auto data = _structure.GetScale();
                 if (kind == "x")
                 {
-                    scale = std::make_shared<SceneObjectScale>('x', data[0], object_flag);
+                    scale = MakeShared<SceneObjectScale>('x', data[0], object_flag);
                 }
                 else if (kind == "y")
                 {
-                    scale = std::make_shared<SceneObjectScale>('y', data[0], object_flag);
+                    scale = MakeShared<SceneObjectScale>('y', data[0], object_flag);
                 }
                 else if (kind == "z")
                 {
-                    scale = std::make_shared<SceneObjectScale>('z', data[0], object_flag);
+                    scale = MakeShared<SceneObjectScale>('z', data[0], object_flag);
                 }
                 else if (kind == "xyz")
                 {
-                    scale = std::make_shared<SceneObjectScale>(data[0], data[1], data[2], object_flag);
+                    scale = MakeShared<SceneObjectScale>(data[0], data[1], data[2], object_flag);
                 }
                 auto _key = _structure.GetStructureName();
                 baseNode->AppendTransform(_key, std::move(scale));
@@ -432,7 +434,7 @@ namespace Panda
                     material_name = _name;
                 }
                 std::string _key = _structure.GetStructureName();
-                auto material = std::make_shared<SceneObjectMaterial>();
+                auto material = MakeShared<SceneObjectMaterial>();
                 material->SetName(material_name);
                 
                 const ODDL::Structure* _sub_structure = _structure.GetFirstCoreSubnode();
@@ -462,6 +464,7 @@ namespace Panda
                             attrib = dynamic_cast<const OGEX::TextureStructure*>(_sub_structure)->GetAttribString();
                             textureName = dynamic_cast<const OGEX::TextureStructure*>(_sub_structure)->GetTextureName();
                             material->SetTexture(attrib, textureName);
+                            scene.Dependencies.AddDependency(PANDA_ASSET_NODE_MATERIAL, _key, PANDA_ASSET_NODE_TEXTURE, textureName);
                             break;
                         }
                         default:
@@ -485,19 +488,19 @@ namespace Panda
 
 				if (!strncmp(typeStr, "infinite", 8))
 				{
-					light = std::make_shared<SceneObjectInfiniteLight>();
+					light = MakeShared<SceneObjectInfiniteLight>();
 				}
 				else if (!strncmp(typeStr, "point", 5))
 				{
-					light = std::make_shared<SceneObjectPointLight>();
+					light = MakeShared<SceneObjectPointLight>();
 				}
 				else if (!strncmp(typeStr, "spot", 4))
 				{
-					light = std::make_shared<SceneObjectSpotLight>();
+					light = MakeShared<SceneObjectSpotLight>();
 				}
 				else if (!strncmp(typeStr, "area", 4))
 				{
-					light = std::make_shared<SceneObjectAreaLight>();
+					light = MakeShared<SceneObjectAreaLight>();
 				}
 				else
 					assert(0);
@@ -623,7 +626,7 @@ namespace Panda
             {
                 const OGEX::CameraObjectStructure& _structure = dynamic_cast<const OGEX::CameraObjectStructure&>(structure);
                 std::string _key = _structure.GetStructureName();
-                auto camera = std::make_shared<SceneObjectPerspectiveCamera>();
+                auto camera = MakeShared<SceneObjectPerspectiveCamera>();
 
                 const ODDL::Structure* subStructure = _structure.GetFirstCoreSubnode();
                 while(subStructure)
@@ -667,7 +670,7 @@ namespace Panda
             {
                 //const OGEX::AnimationStructure& _structure = dynamic_cast<const OGEX::AnimationStructure&>(structure);
                 //auto clipIndex = _structure.GetClipIndex();
-                //std::shared_ptr<SceneObjectAnimationClip> clip = std::make_shared<SceneObjectAnimationClip>(clipIndex);
+                //std::shared_ptr<SceneObjectAnimationClip> clip = MakeShared<SceneObjectAnimationClip>(clipIndex);
 
                 //const ODDL::Structure* _sub_structure = _structure.GetFirstCoreSubnode();
                 //while(_sub_structure)
@@ -710,10 +713,10 @@ namespace Panda
                 //                dataStructure =
                 //                    static_cast<const ODDL::DataStructure<ODDL::FloatDataType>*>(keyOutgoingControl->GetFirstCoreSubnode());
                 //                const float* outCp = &dataStructure->GetDataElement(0);
-                //                timeCurve = std::make_shared<Bezier<float, float>>(timeKnots, inCp, outCp, timeKeyDataCount);
+                //                timeCurve = MakeShared<Bezier<float, float>>(timeKnots, inCp, outCp, timeKeyDataCount);
                 //            }
                 //            else {
-                //                timeCurve = std::make_shared<Linear<float, float>>(timeKnots, timeKeyDataCount);
+                //                timeCurve = MakeShared<Linear<float, float>>(timeKnots, timeKeyDataCount);
                 //            }
                 //            if (valueStructure.GetCurveType() == "bezier")
                 //            {
@@ -732,7 +735,7 @@ namespace Panda
                 //                    case 0:
                 //                    case 1:
                 //                    {
-                //                        valueCurve = std::make_shared<Bezier<float, float>>(
+                //                        valueCurve = MakeShared<Bezier<float, float>>(
                 //                            valueKnots,
                 //                            inCp,
                 //                            outCp,
@@ -743,7 +746,7 @@ namespace Panda
                 //                    }
                 //                    case 3:
                 //                    {
-                //                        valueCurve = std::make_shared<Bezier<Vector3Df, Vector3Df>>(
+                //                        valueCurve = MakeShared<Bezier<Vector3Df, Vector3Df>>(
                 //                            reinterpret_cast<const Vector3Df*>(valueKnots),
                 //                            reinterpret_cast<const Vector3Df*>(inCp),
                 //                            reinterpret_cast<const Vector3Df*>(outCp),
@@ -754,7 +757,7 @@ namespace Panda
                 //                    }
                 //                    case 4:
                 //                    {
-                //                        valueCurve = std::make_shared<Bezier<Vector4Df, float>>(
+                //                        valueCurve = MakeShared<Bezier<Vector4Df, float>>(
                 //                            reinterpret_cast<const Vector4Df*>(valueKnots),
                 //                            reinterpret_cast<const Vector4Df*>(inCp),
                 //                            reinterpret_cast<const Vector4Df*>(outCp),
@@ -765,7 +768,7 @@ namespace Panda
                 //                    }
                 //                    case 16:
                 //                    {
-                //                        valueCurve = std::make_shared<Bezier<Matrix4f, float>>(
+                //                        valueCurve = MakeShared<Bezier<Matrix4f, float>>(
                 //                            reinterpret_cast<const Matrix4f*>(valueKnots),
                 //                            reinterpret_cast<const Matrix4f*>(inCp),
                 //                            reinterpret_cast<const Matrix4f*>(outCp),
@@ -784,7 +787,7 @@ namespace Panda
                 //                    case 0:
                 //                    case 1:
                 //                        {
-                //                            valueCurve = std::make_shared<Linear<float, float>>(
+                //                            valueCurve = MakeShared<Linear<float, float>>(
                 //                                valueKnots,
                 //                                valueKeyDataCount
                 //                            );
@@ -793,7 +796,7 @@ namespace Panda
                 //                        }
                 //                    case 3:
                 //                    {
-                //                        valueCurve = std::make_shared<Linear<Vector3Df, Vector3Df>>(
+                //                        valueCurve = MakeShared<Linear<Vector3Df, Vector3Df>>(
                 //                            reinterpret_cast<const Vector3Df*>(valueKnots),
                 //                            valueKeyDataCount);
                 //                        type = SceneObjectTrackType::kVector3;
@@ -801,7 +804,7 @@ namespace Panda
                 //                    }
                 //                    case 4:
                 //                    {
-                //                        valueCurve = std::make_shared<Linear<Vector4Df, float>>(
+                //                        valueCurve = MakeShared<Linear<Vector4Df, float>>(
                 //                            reinterpret_cast<const Vector4Df*>(valueKnots),
                 //                            valueKeyDataCount);
                 //                        type = SceneObjectTrackType::kQuaternion;
@@ -809,7 +812,7 @@ namespace Panda
                 //                    }
                 //                    case 16:
                 //                    {
-                //                        valueCurve = std::make_shared<Linear<Matrix4f, float>>(
+                //                        valueCurve = MakeShared<Linear<Matrix4f, float>>(
                 //                            reinterpret_cast<const Matrix4f*>(valueKnots),
                 //                            valueKeyDataCount
                 //                        );
@@ -821,7 +824,7 @@ namespace Panda
                 //                }
                 //            }
                 //            
-                //            track = std::make_shared<SceneObjectTrack>(trans, timeCurve, valueCurve, type);
+                //            track = MakeShared<SceneObjectTrack>(trans, timeCurve, valueCurve, type);
                 //            clip->AddTrack(track);
                 //        }
                 //        default:
@@ -854,11 +857,24 @@ namespace Panda
     }
 
     std::unique_ptr<Scene> OgexParser::Parse(const std::string& buf)
+    {
+        return ParseText(buf.c_str());
+    }
+
+    std::unique_ptr<Scene> OgexParser::Parse(const BufferView& buf)
+    {
+        if (buf.IsEmpty() || buf.GetData()[buf.GetDataSize() - 1] != '\0')
+            return Parse(std::string(reinterpret_cast<const char*>(buf.GetData()), buf.GetDataSize()));
+
+        return ParseText(reinterpret_cast<const char*>(buf.GetData()));
+    }
+
+    std::unique_ptr<Scene> OgexParser::ParseText(const char* text)
     {
         std::unique_ptr<Scene> pScene(new Scene("Root"));
         OGEX::OpenGexDataDescription openGexDataDescription;
 
-        ODDL::DataResult result = openGexDataDescription.ProcessText(buf.c_str());
+        ODDL::DataResult result = openGexDataDescription.ProcessText(text);
         if (result == ODDL::kDataOkay)
         {
             const ODDL::Structure* structure = openGexDataDescription.GetRootStructure()->GetFirstSubnode();
@@ -8,6 +8,7 @@
 #include "Math/Curve.hpp"
 #include "Scene.hpp"
 #include "Interface/SceneParser.hpp"
+#include "BufferView.hpp"
 #include "Math/Linear.hpp"
 
 namespace Panda
@@ -16,12 +17,16 @@ namespace Panda
     {
         private:
             void ConvertOddlStructureToSceneNode(const ODDL::Structure& structure, std::shared_ptr<BaseSceneNode>& baseNode, Scene& scene);
+            std::unique_ptr<Scene> ParseText(const char* text);
 
         public:
             OgexParser() = default;
             virtual ~OgexParser() = default;
 
             virtual std::unique_ptr<Scene> Parse(const std::string& buf);
+            // parses the text in place when buf ends with '\0', as SyncOpenAndReadText() leaves it,
+            // otherwise parses a copy
+            std::unique_ptr<Scene> Parse(const BufferView& buf);
 
         private:
             bool m_UpIsYAxis;
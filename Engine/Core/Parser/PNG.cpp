@@ -28,29 +28,44 @@ namespace Panda
         }
     }
 
-    Image PngParser::Parse(Buffer& buf)
+    Image PngParser::Parse(const BufferView& buf)
     {
-        Image img;
+        // the stream hands out slices of buf, nothing is copied
+        AssetStream stream(buf);
+        return Parse(stream);
+    }
 
-        uint8_t* pData = buf.GetData();
-        uint8_t* pDataEnd = buf.GetData() + buf.GetDataSize();
+    Image PngParser::Parse(AssetStream& stream)
+    {
+        Image img;
 
         bool imageDataStarted = false;
-        bool imageDataEnded =false;
-        uint8_t* imageDataStartPos = nullptr;
-        uint8_t* imageDataEndPos = nullptr;
+        bool imageDataEnded = false;
 
-        const PNG_FILEHEADER* pFileHeader = reinterpret_cast<const PNG_FILEHEADER*>(pData);
-        pData += sizeof(PNG_FILEHEADER);
-        if (pFileHeader->Signature == to_endian_net((uint64_t)0x89504E470D0A1A0A))
+        PNG_FILEHEADER fileHeader;
+        if (stream.Read(&fileHeader, sizeof(PNG_FILEHEADER)) == sizeof(PNG_FILEHEADER)
+            && fileHeader.Signature == to_endian_net((uint64_t)0x89504E470D0A1A0A))
         {
             std::cout << "Asset is PNG file" << std::endl;
 
-            while(pData < pDataEnd)
+            // the IDAT blocks form one zlib stream, inflated a block at a time as they come in
+            const size_t kChunkSize = 256 * 1024;
+            std::vector<uint8_t> decompressed;
+            z_stream strm;
+            strm.zalloc = Z_NULL;
+            strm.zfree = Z_NULL;
+            strm.opaque = Z_NULL;
+            strm.avail_in = 0;
+            strm.next_in = Z_NULL;
+            bool inflating = false;
+            bool inflateDone = false;
+
+            PNG_CHUNK_HEADER chunkHeader;
+            while(!imageDataEnded && stream.Read(&chunkHeader, sizeof(PNG_CHUNK_HEADER)) == sizeof(PNG_CHUNK_HEADER))
             {
-                const PNG_CHUNK_HEADER* pChunkHeader = reinterpret_cast<const PNG_CHUNK_HEADER*>(pData);
-                PNG_CHUNK_TYPE type = static_cast<PNG_CHUNK_TYPE>(to_endian_native(static_cast<uint32_t>(pChunkHeader->Type)));
-                uint32_t chunkDataSize = to_endian_native(pChunkHeader->Length);
+                PNG_CHUNK_TYPE type = static_cast<PNG_CHUNK_TYPE>(to_endian_native(static_cast<uint32_t>(chunkHeader.Type)));
+                uint32_t chunkDataSize = to_endian_native(chunkHeader.Length);
+                size_t unreadSize = chunkDataSize;    // what is left of the chunk data
 
                 std::cout << "======================" << std::endl;
 
@@ -60,7 +75,18 @@ namespace Panda
                     {
                         std::cout << "IHDR (Image Header)" << std::endl;
                         std::cout << "------------------------------" << std::endl;
-                        const PNG_IHDR_HEADER* pIHDRHeader = reinterpret_cast<const PNG_IHDR_HEADER*>(pData);
+                        PNG_IHDR_HEADER ihdrHeader;
+                        const size_t ihdrSize = sizeof(PNG_IHDR_HEADER) - sizeof(PNG_CHUNK_HEADER);
+                        if (chunkDataSize < ihdrSize || img.Data
+                            || stream.Read(reinterpret_cast<uint8_t*>(&ihdrHeader) + sizeof(PNG_CHUNK_HEADER), ihdrSize) != ihdrSize)
+                        {
+                            std::cout << "PNG file looks corrupted. Bad IHDR." << std::endl;
+                            imageDataEnded = true;
+                            break;
+                        }
+                        unreadSize -= ihdrSize;
+
+                        const PNG_IHDR_HEADER* pIHDRHeader = &ihdrHeader;
                         m_Width = to_endian_native(pIHDRHeader->Width);
                         m_Height = to_endian_native(pIHDRHeader->Height);
                         m_BitDepth = pIHDRHeader->BitDepth;
@@ -122,14 +148,9 @@ namespace Panda
                     {
                         std::cout << "PLTE (Palette)" << std::endl;
                         std::cout << "-------------------------" << std::endl;
-                        const PNG_PLTE_HEADER* pPLTEHeader = reinterpret_cast<const PNG_PLTE_HEADER*>(pData);
-                        size_t maxCount = chunkDataSize / sizeof(*pPLTEHeader->pEntries);
-                        for (size_t i = 0; i < maxCount; ++i)
-                        {
 #if DUMP_DETAILS
-                            std::cout << "Entry " << i << ": " << pPLTEHeader->pEntries[i] << std::endl;
+                        std::cout << "Entries: " << chunkDataSize / sizeof(Vector<uint8_t, 3>) << std::endl;
 #endif
-                        }
                     }
                     break;
                     case PNG_CHUNK_TYPE::IDAT:
@@ -139,23 +160,45 @@ namespace Panda
 
                         std::cout << "Compressed Data Length: " << chunkDataSize << std::endl;
 
-                        if (imageDataEnded)
+                        if (!img.Data)
                         {
-                            std::cout << "PNG file looks corrupted. Found IDAT after IEND." << std::endl;
+                            std::cout << "PNG file looks corrupted. Found IDAT before IHDR." << std::endl;
                             break;
                         }
 
-                        if (!imageDataStarted)
+                        imageDataStarted = true;
+
+                        if (!inflating && !inflateDone)
                         {
-                            imageDataStarted = true;
-                            imageDataStartPos = pData + sizeof(PNG_CHUNK_HEADER);
-                            imageDataEndPos = imageDataStartPos + chunkDataSize;
+                            int ret = inflateInit(&strm);
+                            if (ret != Z_OK)
+                            {
+                                zerr(ret);
+                                inflateDone = true;
+                                break;
+                            }
+                            inflating = true;
+                            decompressed.resize(kChunkSize);
+                            m_FilterType = 0;
+                            m_CurrentRow = 0;
+                            m_CurrentCol = -1;
                         }
-                        else 
+
+                        // inflate straight out of the stream, a chunk of it at a time
+                        while (inflating && unreadSize > 0)
                         {
-                            // concat the IDAT blocks
-                            memcpy(imageDataEndPos, pData + sizeof(PNG_CHUNK_HEADER), chunkDataSize);
-                            imageDataEndPos += chunkDataSize;
+                            const uint8_t* pData;
+                            size_t size = stream.ReadChunk(pData, unreadSize);
+                            if (size == 0)
+                                break;
+                            unreadSize -= size;
+
+                            if (!InflateImageData(strm, pData, size, decompressed.data(), kChunkSize, img))
+                            {
+                                (void)inflateEnd(&strm);
+                                inflating = false;
+                                inflateDone = true;
+                            }
                         }
                     }
                     break;
@@ -164,141 +207,14 @@ namespace Panda
                         std::cout << "IEND (Image Data End) " << std::endl;
                         std::cout << "---------------------------" << std::endl;
 
-                        size_t compressedDataSize = imageDataEndPos - imageDataStartPos;
-
                         if (!imageDataStarted)
                         {
                             std::cout << "PNG file looks corrupted. Found IEND before IDAT." << std::endl;
                             break;
                         }
-                        else
-                        {
-                            imageDataEnded = true;
-                        }
 
-                        const size_t kChunkSize = 256 * 1024;
-                        z_stream strm;
-                        strm.zalloc = Z_NULL;
-                        strm.zfree = Z_NULL;
-                        strm.opaque = Z_NULL;
-                        strm.avail_in = 0;
-                        strm.next_in = Z_NULL;
-                        int ret = inflateInit(&strm);
-                        if (ret != Z_OK)
-                        {
-                            zerr(ret);
-                            //std::cout << "[Error] Failed to init zlib" << std::endl;
-                            break;
-                        }
-
-                        const uint8_t* pIn = imageDataStartPos; // point to the start of the input data buffer
-                        uint8_t* pOut = reinterpret_cast<uint8_t*>(img.Data); // point to the start of the input data buffer
-                        uint8_t* pDecompressedBuffer = new uint8_t[kChunkSize];
-                        uint8_t filterType = 0;
-                        int currentRow = 0;
-                        int currentCol = -1; // -1 means we need to read filter type
-
-                        do 
-                        {
-                            size_t nextInSize = (compressedDataSize > kChunkSize)? kChunkSize : (size_t)compressedDataSize;
-                            if (nextInSize == 0) break;
-                            compressedDataSize -= nextInSize;
-                            strm.next_in = const_cast<Bytef*>(pIn);
-                            strm.avail_in = nextInSize;
-                            do
-                            {
-                                strm.avail_out = kChunkSize; // 256K
-                                strm.next_out = static_cast<Bytef*>(pDecompressedBuffer);
-                                ret = inflate(&strm, Z_NO_FLUSH);
-                                assert(ret != Z_STREAM_ERROR);
-                                switch(ret)
-                                {
-                                    case Z_NEED_DICT:
-                                    case Z_DATA_ERROR:
-                                    case Z_MEM_ERROR:
-                                        zerr(ret);
-                                        ret = Z_STREAM_END;
-                                    default:
-                                        // now we de-filter the data into image
-                                        uint8_t* p = pDecompressedBuffer;
-                                        while(p - pDecompressedBuffer < (kChunkSize - strm.avail_out))
-                                        {
-                                            if (currentCol == -1)
-                                            {
-                                                // we are at start of scan line, get the filter type and advance the pointer
-                                                filterType = *p;
-                                            }
-                                            else 
-                                            {
-                                                // prediction filter
-                                                // X is current value
-                                                //
-                                                // C B D
-                                                // A X
-                                                uint8_t A, B, C;
-                                                if (currentRow == 0)
-                                                {
-                                                    B = C = 0;
-                                                }
-                                                else 
-                                                {
-                                                    B = *(pOut + img.Pitch * (currentRow - 1) + currentCol);
-                                                    C = (currentCol < m_BytesPerPixel)? 0 : *(pOut + img.Pitch * (currentRow - 1) + currentCol - m_BytesPerPixel);
-                                                }
-
-                                                A = (currentCol < m_BytesPerPixel)? 0 : *(pOut + img.Pitch * currentRow + currentCol - m_BytesPerPixel);
-
-                                                switch(filterType)
-                                                {
-                                                    case 0:
-                                                        *(pOut + img.Pitch * currentRow + currentCol) = *p;
-                                                        break;
-                                                    case 1:
-                                                        *(pOut + img.Pitch * currentRow + currentCol) = *p + A;
-                                                        break;
-                                                    case 2:
-                                                        *(pOut + img.Pitch * currentRow + currentCol) = *p + B;
-                                                        break;
-                                                    case 3:
-                                                        *(pOut + img.Pitch * currentRow + currentCol) = *p + (A + B) / 2;
-                                                        break;
-                                                    case 4:
-                                                        {
-                                                            int _p = A + B - C;
-                                                            int pa = abs(_p - A);
-                                                            int pb = abs(_p - B);
-                                                            int pc = abs(_p - C);
-                                                            if (pa <= pb && pa <= pc)
-                                                                *(pOut + img.Pitch * currentRow + currentCol) = *p + A;
-                                                            else if (pb <= pc)
-                                                                *(pOut + img.Pitch * currentRow + currentCol) = *p + B;
-                                                            else 
-                                                                *(pOut + img.Pitch * currentRow + currentCol) = *p + C;
-                                                        }
-                                                        break;
-                                                    default:
-                                                        std::cout << "[Error] Unknown Filter type!" << std::endl;
-                                                        assert(0);
-                                                }
-                                            }
-
-                                            ++currentCol;
-                                            if (currentCol == m_ScanLineSize)
-                                            {
-                                                currentCol = -1;
-                                                ++currentRow;
-                                            }
-
-                                            p++;
-                                        }
-                                }
-                            } while (strm.avail_out == 0);
-                            
-                            pIn += nextInSize; // move pIn to next chunk
-                        }while (ret != Z_STREAM_END);
-
-                        (void)inflateEnd(&strm);
-                        delete[] pDecompressedBuffer;
+                        // nothing after IEND belongs to the image, so the rest of the stream is left alone
+                        imageDataEnded = true;
                     }
                     break;
                     default:
@@ -307,8 +223,13 @@ namespace Panda
                     }
                     break;
                 }
-                pData += chunkDataSize + sizeof(PNG_CHUNK_HEADER) + 4 /* length of CRC */;
+
+                if (!imageDataEnded)
+                    stream.Skip(unreadSize + 4 /* length of CRC */);
             }
+
+            if (inflating)
+                (void)inflateEnd(&strm);
         }
         else 
         {
@@ -317,4 +238,111 @@ namespace Panda
 
         return img;
     }
-}
\ No newline at end of file
+
+    bool PngParser::InflateImageData(z_stream& strm, const uint8_t* pData, size_t size, uint8_t* pScratch, size_t scratchSize, Image& img)
+    {
+        strm.next_in = const_cast<Bytef*>(pData);
+        strm.avail_in = static_cast<uInt>(size);
+
+        int ret;
+        do
+        {
+            strm.avail_out = static_cast<uInt>(scratchSize);
+            strm.next_out = static_cast<Bytef*>(pScratch);
+            ret = inflate(&strm, Z_NO_FLUSH);
+            assert(ret != Z_STREAM_ERROR);
+            switch(ret)
+            {
+                case Z_NEED_DICT:
+                case Z_DATA_ERROR:
+                case Z_MEM_ERROR:
+                    zerr(ret);
+                    ret = Z_STREAM_END;
+                default:
+                    // now we de-filter the data into image
+                    Unfilter(pScratch, scratchSize - strm.avail_out, img);
+            }
+        } while (strm.avail_out == 0 && ret != Z_STREAM_END);
+
+        return ret != Z_STREAM_END;
+    }
+
+    void PngParser::Unfilter(const uint8_t* pData, size_t size, Image& img)
+    {
+        uint8_t* pOut = reinterpret_cast<uint8_t*>(img.Data); // point to the start of the output image
+        const uint8_t* p = pData;
+        const uint8_t* pEnd = pData + size;
+
+        // anything past the last scan line is ignored rather than written out of bounds
+        while(p < pEnd && m_CurrentRow < m_Height)
+        {
+            if (m_CurrentCol == -1)
+            {
+                // we are at start of scan line, get the filter type and advance the pointer
+                m_FilterType = *p;
+            }
+            else 
+            {
+                // prediction filter
+                // X is current value
+                //
+                // C B D
+                // A X
+                uint8_t A, B, C;
+                if (m_CurrentRow == 0)
+                {
+                    B = C = 0;
+                }
+                else 
+                {
+                    B = *(pOut + img.Pitch * (m_CurrentRow - 1) + m_CurrentCol);
+                    C = (m_CurrentCol < m_BytesPerPixel)? 0 : *(pOut + img.Pitch * (m_CurrentRow - 1) + m_CurrentCol - m_BytesPerPixel);
+                }
+
+                A = (m_CurrentCol < m_BytesPerPixel)? 0 : *(pOut + img.Pitch * m_CurrentRow + m_CurrentCol - m_BytesPerPixel);
+
+                switch(m_FilterType)
+                {
+                    case 0:
+                        *(pOut + img.Pitch * m_CurrentRow + m_CurrentCol) = *p;
+                        break;
+                    case 1:
+                        *(pOut + img.Pitch * m_CurrentRow + m_CurrentCol) = *p + A;
+                        break;
+                    case 2:
+                        *(pOut + img.Pitch * m_CurrentRow + m_CurrentCol) = *p + B;
+                        break;
+                    case 3:
+                        *(pOut + img.Pitch * m_CurrentRow + m_CurrentCol) = *p + (A + B) / 2;
+                        break;
+                    case 4:
+                        {
+                            int _p = A + B - C;
+                            int pa = abs(_p - A);
+                            int pb = abs(_p - B);
+                            int pc = abs(_p - C);
+                            if (pa <= pb && pa <= pc)
+                                *(pOut + img.Pitch * m_CurrentRow + m_CurrentCol) = *p + A;
+                            else if (pb <= pc)
+                                *(pOut + img.Pitch * m_CurrentRow + m_CurrentCol) = *p + B;
+                            else 
+                                *(pOut + img.Pitch * m_CurrentRow + m_CurrentCol) = *p + C;
+                        }
+                        break;
+                    default:
+                        std::cout << "[Error] Unknown Filter type!" << std::endl;
+                        assert(0);
+                }
+            }
+
+            ++m_CurrentCol;
+            if (m_CurrentCol == static_cast<int64_t>(m_ScanLineSize))
+            {
+                m_CurrentCol = -1;
+                ++m_CurrentRow;
+            }
+
+            p++;
+        }
+    }
+}
@@ -5,6 +5,7 @@
 #include <string>
 #include <cassert>
 #include <queue>
+#include <vector>
 #include <algorithm>
 #include "Utility.hpp"
 #include "Interface/ImageParser.hpp"
@@ -80,7 +81,20 @@ namespace Panda
             size_t   m_ScanLineSize;
             uint8_t  m_BytesPerPixel;
 
+            // where de-filtering stopped, inflate output does not end on scan line boundaries
+            uint8_t  m_FilterType;
+            uint32_t m_CurrentRow;
+            int64_t  m_CurrentCol;     // -1 means the filter type byte comes next
+
+        protected:
+            // feed one IDAT payload to inflate, returns false once the zlib stream ended or broke
+            bool InflateImageData(z_stream& strm, const uint8_t* pData, size_t size, uint8_t* pScratch, size_t scratchSize, Image& img);
+            // undo the scan line filters of freshly inflated bytes into img
+            void Unfilter(const uint8_t* pData, size_t size, Image& img);
+
         public:
-            virtual Image Parse(Buffer& buf);
+            virtual Image Parse(const BufferView& buf);
+            // IDAT payloads are inflated as they are read, the compressed image is never held whole
+            virtual Image Parse(AssetStream& stream);
     };
 }
@@ -2,7 +2,7 @@
 
 namespace Panda
 {
-    Image TgaParser::Parse(Buffer& buf)
+    Image TgaParser::Parse(const BufferView& buf)
     {
         Image img;
         const uint8_t* pData = buf.GetData();
@@ -23,6 +23,6 @@ namespace Panda
     class TgaParser : implements ImageParser
     {
         public:
-            virtual Image Parse(Buffer& buf);
+            virtual Image Parse(const BufferView& buf);
     };
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include "MemoryManager.hpp"
+
+namespace Panda
+{
+    /**
+     * Owns a block of the MemoryManager's relocatable heap.
+     * MemoryManager::Tick() may move the block while compacting, so GetData()
+     * resolves the handle on every call and the returned pointer must not be
+     * kept across a Tick(). Use Pin()/Unpin() around longer uses.
+     */
+    class RelocatableBuffer
+    {
+        public:
+            RelocatableBuffer() : m_Size(0) {}
+
+            RelocatableBuffer(size_t size, size_t alignment = 16)
+                : m_Handle(MemoryManager::AllocateRelocatable(size, alignment)), m_Size(size) {}
+
+            RelocatableBuffer(const void* pData, size_t size, size_t alignment = 16)
+                : RelocatableBuffer(size, alignment)
+            {
+                void* p = MemoryManager::Resolve(m_Handle);
+                if (p && pData)
+                    memcpy(p, pData, size);
+            }
+
+            RelocatableBuffer(const RelocatableBuffer&) = delete;
+            RelocatableBuffer& operator=(const RelocatableBuffer&) = delete;
+
+            RelocatableBuffer(RelocatableBuffer&& rhs) noexcept : m_Handle(rhs.m_Handle), m_Size(rhs.m_Size)
+            {
+                rhs.m_Handle = RelocatableHandle();
+                rhs.m_Size = 0;
+            }
+
+            RelocatableBuffer& operator=(RelocatableBuffer&& rhs) noexcept
+            {
+                if (this != &rhs)
+                {
+                    MemoryManager::FreeRelocatable(m_Handle);
+                    m_Handle = rhs.m_Handle;
+                    m_Size = rhs.m_Size;
+                    rhs.m_Handle = RelocatableHandle();
+                    rhs.m_Size = 0;
+                }
+                return *this;
+            }
+
+            ~RelocatableBuffer()
+            {
+                MemoryManager::FreeRelocatable(m_Handle);
+            }
+
+            // valid until the next MemoryManager::Tick()
+            uint8_t* GetData() const {return reinterpret_cast<uint8_t*>(MemoryManager::Resolve(m_Handle));}
+            size_t GetDataSize() const {return m_Size;}
+            RelocatableHandle GetHandle() const {return m_Handle;}
+
+            // the block stays in place until the matching Unpin()
+            uint8_t* Pin() const {return reinterpret_cast<uint8_t*>(MemoryManager::PinRelocatable(m_Handle));}
+            void Unpin() const {MemoryManager::UnpinRelocatable(m_Handle);}
+
+        private:
+            RelocatableHandle m_Handle;
+            size_t m_Size;
+    };
+}
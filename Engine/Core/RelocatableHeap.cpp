@@ -0,0 +1,388 @@
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include "RelocatableHeap.hpp"
+#include "MemoryManager.hpp"
+
+#ifndef ALIGN
+#define ALIGN(n, a) (((n) + (a - 1)) & ~((a) - 1))		// 获取对齐的最小值
+#endif
+
+using namespace Panda;
+
+Panda::RelocatableHeap::RelocatableHeap()
+	: m_ChunkSize(0), m_LiveBytes(0), m_ReservedBytes(0), m_IsFragmented(false),
+	m_CompactChunk(0), m_CompactBlock(0), m_CompactTop(0)
+{
+}
+
+Panda::RelocatableHeap::RelocatableHeap(size_t inChunkSize)
+	: RelocatableHeap()
+{
+	Reset(inChunkSize);
+}
+
+Panda::RelocatableHeap::~RelocatableHeap()
+{
+	FreeAll();
+}
+
+void Panda::RelocatableHeap::Reset(size_t inChunkSize)
+{
+	FreeAll();
+	m_ChunkSize = inChunkSize;
+}
+
+RelocatableHandle Panda::RelocatableHeap::Allocate(size_t inSize, size_t alignment)
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+
+	// 空块也占一个字节，保证Blocks中的地址互不相同
+	if (inSize == 0)
+		inSize = 1;
+	if (alignment == 0)
+		alignment = 1;
+	if (alignment > MAX_ALIGNMENT)
+		alignment = MAX_ALIGNMENT;
+	assert((alignment & (alignment - 1)) == 0);
+
+	// 在内存块尾部的空闲空间中分配，块内的空洞留给Compact()回收
+	Chunk* pChunk = nullptr;
+	size_t offset = 0;
+	for (Chunk* pCandidate : m_Chunks)
+	{
+		offset = ALIGN(pCandidate->Top, alignment);
+		if (offset + inSize <= pCandidate->Size)
+		{
+			pChunk = pCandidate;
+			break;
+		}
+	}
+
+	if (pChunk == nullptr)
+	{
+		// 超过内存块尺寸的资源单独占一个内存块
+		pChunk = NewChunk(inSize > m_ChunkSize ? inSize : m_ChunkSize);
+		if (pChunk == nullptr)
+			return RelocatableHandle();
+		offset = 0;
+	}
+
+	uint32_t index;
+	if (!m_FreeEntries.empty())
+	{
+		index = m_FreeEntries.back();
+		m_FreeEntries.pop_back();
+	}
+	else
+	{
+		index = static_cast<uint32_t>(m_Entries.size());
+		m_Entries.push_back(Entry());
+		m_Entries[index].Generation = 1;
+	}
+
+	Entry& entry = m_Entries[index];
+	entry.pChunk = pChunk;
+	entry.Offset = offset;
+	entry.Size = inSize;
+	entry.Alignment = alignment;
+	entry.PinCount = 0;
+
+	pChunk->Top = offset + inSize;
+	pChunk->Blocks.push_back(index);
+	m_LiveBytes += inSize;
+
+	RelocatableHandle handle;
+	handle.Index = index;
+	handle.Generation = entry.Generation;
+	return handle;
+}
+
+void Panda::RelocatableHeap::Free(RelocatableHandle handle)
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+
+	Entry* pEntry = Lookup(handle);
+	if (pEntry == nullptr)
+		return;
+	assert(pEntry->PinCount == 0);
+
+	// Blocks按地址排列，二分查找条目的位置
+	Chunk* pChunk = pEntry->pChunk;
+	size_t offset = pEntry->Offset;
+	auto it = std::lower_bound(pChunk->Blocks.begin(), pChunk->Blocks.end(), offset,
+		[this](uint32_t index, size_t inOffset) { return m_Entries[index].Offset < inOffset; });
+	assert(it != pChunk->Blocks.end() && *it == handle.Index);
+	size_t position = it - pChunk->Blocks.begin();
+	pChunk->Blocks.erase(it);
+
+	if (m_CompactChunk < m_Chunks.size() && m_Chunks[m_CompactChunk] == pChunk && position < m_CompactBlock)
+		--m_CompactBlock;
+
+	// 释放的是最后一块时，块尾的空间可以直接再分配，否则留下空洞。
+	// 空的内存块也要等Compact()来释放
+	if (position == pChunk->Blocks.size())
+	{
+		if (pChunk->Blocks.empty())
+			pChunk->Top = 0;
+		else
+		{
+			const Entry& last = m_Entries[pChunk->Blocks.back()];
+			pChunk->Top = last.Offset + last.Size;
+		}
+	}
+	if (position != pChunk->Blocks.size() || pChunk->Blocks.empty())
+		m_IsFragmented = true;
+
+	m_LiveBytes -= pEntry->Size;
+	pEntry->pChunk = nullptr;
+	if (++pEntry->Generation == 0)
+		pEntry->Generation = 1;
+	m_FreeEntries.push_back(handle.Index);
+}
+
+void Panda::RelocatableHeap::FreeAll()
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+
+	for (Chunk* pChunk : m_Chunks)
+	{
+		MemoryManager::Free(pChunk->pBase, pChunk->Size, MAX_ALIGNMENT);
+		delete pChunk;
+	}
+	m_Chunks.clear();
+
+	// 保留代数，之前发出的句柄继续无效
+	m_FreeEntries.clear();
+	for (uint32_t i = 0; i < m_Entries.size(); ++i)
+	{
+		Entry& entry = m_Entries[i];
+		if (entry.pChunk)
+		{
+			entry.pChunk = nullptr;
+			if (++entry.Generation == 0)
+				entry.Generation = 1;
+		}
+		m_FreeEntries.push_back(i);
+	}
+
+	m_LiveBytes = 0;
+	m_ReservedBytes = 0;
+	m_IsFragmented = false;
+	m_CompactChunk = 0;
+	m_CompactBlock = 0;
+	m_CompactTop = 0;
+}
+
+void* Panda::RelocatableHeap::Resolve(RelocatableHandle handle)
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+
+	Entry* pEntry = Lookup(handle);
+	return pEntry ? pEntry->pChunk->pBase + pEntry->Offset : nullptr;
+}
+
+bool Panda::RelocatableHeap::IsValid(RelocatableHandle handle)
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+
+	return Lookup(handle) != nullptr;
+}
+
+size_t Panda::RelocatableHeap::GetSize(RelocatableHandle handle)
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+
+	Entry* pEntry = Lookup(handle);
+	return pEntry ? pEntry->Size : 0;
+}
+
+void* Panda::RelocatableHeap::Pin(RelocatableHandle handle)
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+
+	Entry* pEntry = Lookup(handle);
+	if (pEntry == nullptr)
+		return nullptr;
+
+	++pEntry->PinCount;
+	return pEntry->pChunk->pBase + pEntry->Offset;
+}
+
+void Panda::RelocatableHeap::Unpin(RelocatableHandle handle)
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+
+	Entry* pEntry = Lookup(handle);
+	if (pEntry == nullptr)
+		return;
+
+	assert(pEntry->PinCount > 0);
+	if (--pEntry->PinCount == 0)
+		m_IsFragmented = true;		// 固定期间跳过的空洞现在可以整理了
+}
+
+size_t Panda::RelocatableHeap::Compact(size_t inMaxMoveBytes)
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+
+	// 新一轮开始时，上一轮之后没有产生过空洞就不用整理
+	if (m_CompactChunk == 0 && m_CompactBlock == 0)
+	{
+		if (!m_IsFragmented)
+			return 0;
+		m_IsFragmented = false;
+	}
+
+	// 按顺序处理每个内存块中的块，每次调用最多走到这一轮的结尾
+	size_t moved = 0;
+	while (m_CompactChunk < m_Chunks.size())
+	{
+		Chunk* pChunk = m_Chunks[m_CompactChunk];
+		if (m_CompactBlock >= pChunk->Blocks.size())
+		{
+			FinishCompactChunk();
+			continue;
+		}
+
+		uint32_t index = pChunk->Blocks[m_CompactBlock];
+		Entry& entry = m_Entries[index];
+		if (entry.PinCount == 0)
+		{
+			// 前面的内存块在这一轮已经整理过，尾部有空间时把块搬过去，后面的内存块才能腾空释放
+			Chunk* pTarget = nullptr;
+			size_t offset = 0;
+			for (size_t i = 0; i < m_CompactChunk; ++i)
+			{
+				offset = ALIGN(m_Chunks[i]->Top, entry.Alignment);
+				if (offset + entry.Size <= m_Chunks[i]->Size)
+				{
+					pTarget = m_Chunks[i];
+					break;
+				}
+			}
+
+			// 搬不走时在本内存块中向低地址滑动
+			if (pTarget == nullptr)
+			{
+				offset = ALIGN(m_CompactTop, entry.Alignment);
+				if (offset < entry.Offset)
+					pTarget = pChunk;
+			}
+
+			if (pTarget)
+			{
+				// 至少移动一块，否则比预算大的块永远不会移动
+				if (moved && moved + entry.Size > inMaxMoveBytes)
+					return moved;
+
+				memmove(pTarget->pBase + offset, pChunk->pBase + entry.Offset, entry.Size);
+				entry.Offset = offset;
+				moved += entry.Size;
+
+				if (pTarget != pChunk)
+				{
+					entry.pChunk = pTarget;
+					pTarget->Top = offset + entry.Size;
+					pTarget->Blocks.push_back(index);
+					pChunk->Blocks.erase(pChunk->Blocks.begin() + m_CompactBlock);
+					continue;
+				}
+			}
+		}
+
+		m_CompactTop = entry.Offset + entry.Size;
+		++m_CompactBlock;
+	}
+
+	m_CompactChunk = 0;
+	m_CompactBlock = 0;
+	m_CompactTop = 0;
+	return moved;
+}
+
+size_t Panda::RelocatableHeap::GetChunkCount()
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+	return m_Chunks.size();
+}
+
+size_t Panda::RelocatableHeap::GetLiveBytes()
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+	return m_LiveBytes;
+}
+
+size_t Panda::RelocatableHeap::GetReservedBytes()
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+	return m_ReservedBytes;
+}
+
+RelocatableHeap::Entry* Panda::RelocatableHeap::Lookup(RelocatableHandle handle)
+{
+	if (handle.IsNull() || handle.Index >= m_Entries.size())
+		return nullptr;
+
+	Entry& entry = m_Entries[handle.Index];
+	if (entry.Generation != handle.Generation || entry.pChunk == nullptr)
+		return nullptr;
+
+	return &entry;
+}
+
+RelocatableHeap::Chunk* Panda::RelocatableHeap::NewChunk(size_t inSize)
+{
+	inSize = ALIGN(inSize, MAX_ALIGNMENT);
+	uint8_t* pBase = reinterpret_cast<uint8_t*>(MemoryManager::Allocate(inSize, MAX_ALIGNMENT));
+	if (pBase == nullptr)
+		return nullptr;
+
+	Chunk* pChunk = new Chunk;
+	pChunk->pBase = pBase;
+	pChunk->Size = inSize;
+	pChunk->Top = 0;
+	m_Chunks.push_back(pChunk);
+	m_ReservedBytes += inSize;
+
+	return pChunk;
+}
+
+void Panda::RelocatableHeap::ReleaseChunk(size_t inChunkIndex)
+{
+	Chunk* pChunk = m_Chunks[inChunkIndex];
+	assert(pChunk->Blocks.empty());
+
+	m_ReservedBytes -= pChunk->Size;
+	MemoryManager::Free(pChunk->pBase, pChunk->Size, MAX_ALIGNMENT);
+	delete pChunk;
+	m_Chunks.erase(m_Chunks.begin() + inChunkIndex);
+}
+
+void Panda::RelocatableHeap::FinishCompactChunk()
+{
+	Chunk* pChunk = m_Chunks[m_CompactChunk];
+	pChunk->Top = m_CompactTop;
+
+	// 空的内存块还给系统，只保留一个标准尺寸的内存块，避免加载下一个场景时马上又申请
+	bool keep = pChunk->Size == ALIGN(m_ChunkSize, MAX_ALIGNMENT);
+	if (pChunk->Blocks.empty())
+	{
+		for (size_t i = 0; keep && i < m_Chunks.size(); ++i)
+		{
+			if (i != m_CompactChunk && m_Chunks[i]->Blocks.empty() && m_Chunks[i]->Size == pChunk->Size)
+				keep = false;
+		}
+		if (!keep)
+		{
+			ReleaseChunk(m_CompactChunk);
+			m_CompactBlock = 0;
+			m_CompactTop = 0;
+			return;
+		}
+	}
+
+	++m_CompactChunk;
+	m_CompactBlock = 0;
+	m_CompactTop = 0;
+}
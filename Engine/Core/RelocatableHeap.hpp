@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+
+namespace Panda{
+	// 句柄：条目下标和代数。条目释放后代数加一，旧句柄随之失效
+	struct RelocatableHandle {
+		uint32_t	Index;
+		uint32_t	Generation;		// 0表示空句柄
+
+		RelocatableHandle() : Index(0), Generation(0) {}
+		bool IsNull() const { return Generation == 0; }
+	};
+
+	// 存放大块、长生命周期的资源（纹理、顶点数据）。
+	// 资源只通过句柄访问，Compact()可以在块之间挪动数据，把空洞挤到块尾并释放空块，
+	// 场景反复加载和卸载时不会留下碎片。
+	// Resolve()返回的地址在下一次Compact()之前有效，需要跨过Compact()使用时先Pin()。
+	class RelocatableHeap{
+	public:
+		// 块起始地址的对齐值，更大的对齐需求会被降到这个值
+		static const size_t MAX_ALIGNMENT = 64;
+
+		RelocatableHeap();
+		explicit RelocatableHeap(size_t inChunkSize);
+		~RelocatableHeap();
+
+		void Reset(size_t inChunkSize);
+
+		RelocatableHandle Allocate(size_t inSize, size_t alignment = 16);
+		void Free(RelocatableHandle handle);
+		void FreeAll();
+
+		// 句柄失效时返回nullptr
+		void* Resolve(RelocatableHandle handle);
+		bool IsValid(RelocatableHandle handle);
+		size_t GetSize(RelocatableHandle handle);
+
+		// 固定的块在Compact()中不会移动，Pin()和Unpin()必须成对调用
+		void* Pin(RelocatableHandle handle);
+		void Unpin(RelocatableHandle handle);
+
+		// 增量整理，最多移动inMaxMoveBytes字节，返回实际移动的字节数
+		size_t Compact(size_t inMaxMoveBytes);
+
+		size_t GetChunkCount();
+		size_t GetLiveBytes();
+		size_t GetReservedBytes();		// 所有内存块的尺寸之和
+
+	private:
+		struct Chunk {
+			uint8_t*	pBase;
+			size_t		Size;
+			size_t		Top;				// 之后的空间还没有分配过
+			std::vector<uint32_t> Blocks;	// 按地址排列的条目下标
+		};
+
+		struct Entry {
+			Chunk*		pChunk;				// 空闲条目为nullptr
+			size_t		Offset;
+			size_t		Size;
+			size_t		Alignment;
+			uint32_t	Generation;
+			uint32_t	PinCount;
+		};
+
+		Entry* Lookup(RelocatableHandle handle);
+		Chunk* NewChunk(size_t inSize);
+		void ReleaseChunk(size_t inChunkIndex);
+		// 整理游标移到下一个内存块，空块在这里释放
+		void FinishCompactChunk();
+
+		// 禁用拷贝构造函数和赋值操作符
+		RelocatableHeap(const RelocatableHeap& clone);
+		RelocatableHeap& operator=(const RelocatableHeap& rhs);
+
+	private:
+		std::mutex				m_Lock;
+		size_t					m_ChunkSize;
+		std::vector<Chunk*>		m_Chunks;
+		std::vector<Entry>		m_Entries;
+		std::vector<uint32_t>	m_FreeEntries;
+		size_t					m_LiveBytes;
+		size_t					m_ReservedBytes;
+		bool					m_IsFragmented;		// 上一轮整理开始之后是否产生过空洞
+
+		// 增量整理的位置：正在整理的内存块、其中下一个要处理的块，以及下一个块可以移到的位置
+		size_t					m_CompactChunk;
+		size_t					m_CompactBlock;
+		size_t					m_CompactTop;
+	};
+}
@@ -0,0 +1,119 @@
+#include <string.h>
+#include "ThreadCache.hpp"
+
+namespace
+{
+	// 没有析构函数，在线程的整个生命周期内都可以访问
+	thread_local bool t_IsCacheDestroyed = false;
+}
+
+Panda::ThreadCache::ThreadCache()
+	:m_Epoch(0)
+{
+	for (uint32_t i = 0; i < k_BlockSizeCount; ++i)
+	{
+		// 小块缓存得多一些，大块缓存得少一些，每个弹匣大约覆盖两页内存
+		uint32_t capacity = 2 * k_PageSize / k_BlockSizes[i];
+		if (capacity > k_MaxMagazineSize) capacity = k_MaxMagazineSize;
+		if (capacity < k_MinMagazineSize) capacity = k_MinMagazineSize;
+
+		m_Magazines[i].Count = 0;
+		m_Magazines[i].Capacity = capacity;
+	}
+}
+
+Panda::ThreadCache::~ThreadCache()
+{
+	// 线程退出时把缓存的块还回去，否则这些块就泄漏了
+	if (!IsStale())
+		FlushAll();
+
+	t_IsCacheDestroyed = true;
+}
+
+Panda::ThreadCache* Panda::ThreadCache::Get()
+{
+	if (t_IsCacheDestroyed)
+		return nullptr;
+
+	static thread_local ThreadCache s_Cache;
+	return &s_Cache;
+}
+
+void* Panda::ThreadCache::Allocate(uint32_t index, size_t inSize)
+{
+	if (IsStale())
+		Invalidate();
+
+	Magazine& mag = m_Magazines[index];
+	if (mag.Count == 0)
+	{
+		// 弹匣空了，一次取半个弹匣
+		mag.Count = MemoryManager::RefillCache(index, mag.pBlocks, mag.Capacity / 2, mag.Pending);
+	}
+
+	mag.Pending.AllocCount++;
+	mag.Pending.RequestedBytes += inSize;
+	return mag.pBlocks[--mag.Count];
+}
+
+void Panda::ThreadCache::Free(void* p, uint32_t index)
+{
+	if (IsStale())
+		Invalidate();
+
+	Magazine& mag = m_Magazines[index];
+	if (mag.Count == mag.Capacity)
+	{
+		// 弹匣满了，归还最早放进来的一半，保留最近释放的块（它们更可能还在缓存里）
+		uint32_t half = mag.Capacity / 2;
+		MemoryManager::FlushCache(index, mag.pBlocks, half, mag.Pending);
+		memmove(mag.pBlocks, mag.pBlocks + half, (mag.Count - half) * sizeof(void*));
+		mag.Count -= half;
+	}
+
+	mag.Pending.FreeCount++;
+	mag.pBlocks[mag.Count++] = p;
+}
+
+void Panda::ThreadCache::FlushAll()
+{
+	for (uint32_t i = 0; i < k_BlockSizeCount; ++i)
+	{
+		Magazine& mag = m_Magazines[i];
+		if (mag.Count || mag.Pending.AllocCount || mag.Pending.FreeCount)
+		{
+			MemoryManager::FlushCache(i, mag.pBlocks, mag.Count, mag.Pending);
+			mag.Count = 0;
+		}
+	}
+}
+
+void Panda::ThreadCache::PublishCounters()
+{
+	if (IsStale())
+		return;
+
+	for (uint32_t i = 0; i < k_BlockSizeCount; ++i)
+	{
+		Magazine& mag = m_Magazines[i];
+		if (mag.Pending.AllocCount || mag.Pending.FreeCount)
+			MemoryManager::FlushCache(i, mag.pBlocks, 0, mag.Pending);
+	}
+}
+
+void Panda::ThreadCache::Invalidate()
+{
+	for (uint32_t i = 0; i < k_BlockSizeCount; ++i)
+	{
+		m_Magazines[i].Count = 0;
+		m_Magazines[i].Pending = AllocationCounters();
+	}
+
+	m_Epoch = MemoryManager::m_Epoch.load(std::memory_order_acquire);
+}
+
+bool Panda::ThreadCache::IsStale() const
+{
+	return m_Epoch != MemoryManager::m_Epoch.load(std::memory_order_relaxed);
+}
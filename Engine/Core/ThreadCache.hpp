@@ -0,0 +1,48 @@
+#pragma once
+#include "MemoryManager.hpp"
+
+namespace Panda {
+	// 线程私有的分配缓存。
+	// 每个尺寸类别对应一个"弹匣"(magazine)，分配和释放只操作本线程的弹匣，
+	// 弹匣空了或满了才加锁，批量地从中心分配器取块或归还块。
+	class ThreadCache {
+	public:
+		static const uint32_t k_MaxMagazineSize = 64;	// 弹匣的最大容量
+		static const uint32_t k_MinMagazineSize = 8;	// 弹匣的最小容量
+
+		ThreadCache();
+		~ThreadCache();
+
+		void* Allocate(uint32_t index, size_t inSize);
+		void Free(void* p, uint32_t index);
+
+		// 把所有缓存的块归还给中心分配器
+		void FlushAll();
+
+		// 把本线程累计的统计计数合并到中心分配器
+		void PublishCounters();
+
+		// 当前线程的缓存。线程退出时缓存析构之后，
+		// 其他线程局部对象的析构函数仍然可能释放内存，此时返回nullptr
+		static ThreadCache* Get();
+
+	private:
+		struct Magazine {
+			void*		pBlocks[k_MaxMagazineSize];
+			uint32_t	Count;		// 当前缓存的块数
+			uint32_t	Capacity;	// 此尺寸类别的容量
+			AllocationCounters	Pending;	// 还没有合并到中心分配器的统计计数
+		};
+
+		// MemoryManager重新初始化后，缓存的块已经失效，直接丢弃
+		void Invalidate();
+		bool IsStale() const;
+
+		ThreadCache(const ThreadCache& clone);
+		ThreadCache& operator=(const ThreadCache& rhs);
+
+	private:
+		Magazine	m_Magazines[k_BlockSizeCount];
+		uint32_t	m_Epoch;
+	};
+}
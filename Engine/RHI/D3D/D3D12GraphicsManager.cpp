@@ -1837,7 +1837,7 @@ namespace Panda {
         memset(&pbc, 0x00, sizeof(pbc));
 
         Matrix4f trans;
-        trans = *m_DrawBatchContext[index].node->GetCalculatedTransform();
+        trans = m_DrawBatchContext[index].node->GetCalculatedTransform();
 
         pbc.objectMatrix = trans;
 
@@ -85,7 +85,7 @@ namespace Panda
 		auto pCameraNode = scene.GetFirstCameraNode();
 		if (pCameraNode)
 		{
-			m_DrawFrameContext.ViewMatrix = *pCameraNode->GetCalculatedTransform();
+			m_DrawFrameContext.ViewMatrix = pCameraNode->GetCalculatedTransform();
 			InverseMatrix(m_DrawFrameContext.ViewMatrix, m_DrawFrameContext.ViewMatrix);
 		}
 		else 
@@ -129,7 +129,8 @@ namespace Panda
 	void GraphicsManager::CalculateLights()
 	{
 		m_DrawFrameContext.AmbientColor = {0.2f, 0.2f, 0.2f};
-		m_DrawFrameContext.Lights.clear();
+		// don't clear(), the old storage belongs to a frame arena that is about to be reset
+		m_DrawFrameContext.Lights = FrameVector<LightContext>();
 		
 		auto& scene = g_pSceneManager->GetScene();
 		auto _pLightNode = scene.GetFirstLightNode();
@@ -154,14 +155,15 @@ namespace Panda
 			return;
 		}
 
+		m_DrawFrameContext.Lights.reserve(scene.LightNodes.size());
 		for (auto pLightNode : scene.LightNodes)
 		{
 			LightContext light;
-			const std::shared_ptr<Matrix4f> transPtr = pLightNode.second->GetCalculatedTransform();
+			const Matrix4f trans = pLightNode.second->GetCalculatedTransform();
 			light.LightPosition = {0.0f, 0.0f, 0.0f, 1.0f};
-			TransformCoord(light.LightPosition, *transPtr);
+			TransformCoord(light.LightPosition, trans);
 			light.LightDirection = {0.0f, 0.0f, -1.0f, 0.0f};
-			TransformCoord(light.LightDirection, *transPtr);
+			TransformCoord(light.LightDirection, trans);
 
 			const std::shared_ptr<SceneObjectLight> pLight = scene.GetLight(pLightNode.second->GetSceneObjectRef());
 			if (pLight)
@@ -3,6 +3,7 @@
 #include "Interface/IRuntimeModule.hpp"
 #include "Math/PandaMath.hpp"
 #include "Image.hpp"
+#include "FrameAllocator.hpp"
 #include "Scene.hpp"
 
 namespace Panda {
@@ -68,7 +69,7 @@ namespace Panda {
 				Matrix4f ViewMatrix;
 				Matrix4f ProjectionMatrix;
 				Vector3Df AmbientColor;
-				std::vector<LightContext> Lights;
+				FrameVector<LightContext> Lights;	// rebuilt every frame in CalculateLights()
 
 				//friend std::ostream& operator<<(std::ostream& out, DrawFrameContext context)
 				//{
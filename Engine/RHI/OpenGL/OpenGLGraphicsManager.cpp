@@ -377,7 +377,7 @@ namespace Panda
 					auto parentNode = iter->second;
 
 					std::shared_ptr<SceneObjectTransform> _transform;
-					_transform = std::make_shared<SceneObjectTransform>(*parentNode->GetCalculatedTransform(), false);
+					_transform = std::make_shared<SceneObjectTransform>(parentNode->GetCalculatedTransform(), false);
 					pGeometryNode->AppendTransform("", std::move(_transform));
 
 					pParent = pParent->GetParent();
@@ -608,7 +608,7 @@ namespace Panda
         {
             Matrix4f trans;// = *dbc.node ->GetCalculatedTransform();
 
-            trans = *dbc.node ->GetCalculatedTransform();
+            trans = dbc.node ->GetCalculatedTransform();
             SetPerBatchShaderParameters(m_ShaderProgram, "modelMatrix", trans);
             glBindVertexArray(dbc.vao);
 
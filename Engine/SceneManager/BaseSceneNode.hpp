@@ -7,6 +7,7 @@
 #include <string>
 #include "Math/Tree.hpp"
 #include "SceneObject.hpp"
+#include "PandaAllocator.hpp"
 
 namespace Panda
 {
@@ -15,8 +16,8 @@ namespace Panda
         protected:
 			std::string m_Sid;
             std::string m_Name;
-            std::vector<std::shared_ptr<SceneObjectTransform>> m_Transforms;
-            std::map<std::string, std::shared_ptr<SceneObjectTransform>> m_LUTransform;
+            PandaVector<std::shared_ptr<SceneObjectTransform>> m_Transforms;
+            PandaMap<std::string, std::shared_ptr<SceneObjectTransform>> m_LUTransform;
             
 			Matrix4f m_RuntimeTransform;
 
@@ -70,19 +71,20 @@ namespace Panda
                 }
             }
 
-            const std::shared_ptr<Matrix4f> GetCalculatedTransform() const
+            // by value, the callers only read it and 64 bytes need no allocation at all
+            Matrix4f GetCalculatedTransform() const
             {
-                std::shared_ptr<Matrix4f> result (new Matrix4f);
-                result->SetIdentity();
+                Matrix4f result;
+                result.SetIdentity();
 
                 // TODO: cascading calcuation
                 for (auto it = m_Transforms.rbegin(); it != m_Transforms.rend(); ++it)
                 {
-                    *result = *result * static_cast<Matrix4f>(**it);
+                    result = result * static_cast<Matrix4f>(**it);
                 }
 
                 // apply runtime transforms
-                *result = *result * m_RuntimeTransform;
+                result = result * m_RuntimeTransform;
 
                 return result;
             }
@@ -1,3 +1,4 @@
+#include <iostream>
 #include "Scene.hpp"
 
 namespace Panda
@@ -87,13 +88,63 @@ namespace Panda
     //     return (++_it == CameraNodes.cend())? nullptr : _it->second;
     // }
 
-    void Scene::LoadResource()
+    /**
+     * The textures are the leaves of the dependency graph, they are decoded in
+     * parallel and a material is done once its textures are. The texture
+     * objects of one file are all loaded by its node, so none of them is
+     * touched by two threads, and the file is decoded once through the cache.
+     */
+    void Scene::LoadResource(uint32_t maxConcurrency)
     {
+        // queue all the reads as one batch first, then each texture is decoded while the others are still being read
+        std::vector<std::string> batch;
         for (auto material : Materials)
         {
             if (auto ptr = material.second)
-                ptr->LoadTexture();
+                ptr->PrefetchTexture(batch);
         }
+        g_pAssetLoader->GetCache().Prefetch(batch);
+
+        std::string sceneName = SceneGraph ? SceneGraph->GetName() : std::string();
+        std::unordered_map<uint32_t, std::vector<std::shared_ptr<SceneObjectTexture>>> textures;
+        for (auto material : Materials)
+        {
+            auto ptr = material.second;
+            if (!ptr)
+                continue;
+
+            // materials no geometry refers to, or scenes built by hand, are not in the graph yet
+            uint32_t node = Dependencies.FindNode(PANDA_ASSET_NODE_MATERIAL, material.first);
+            if (node == AssetDependencyGraph::k_InvalidNode)
+            {
+                node = Dependencies.AddNode(PANDA_ASSET_NODE_MATERIAL, material.first);
+                Dependencies.AddDependency(Dependencies.AddNode(PANDA_ASSET_NODE_SCENE, sceneName), node);
+            }
+            Dependencies.SetResolveFunction(node, [ptr]() { ptr->LoadTexture(); });
+
+            if (auto pTexture = ptr->GetBaseColor().ValueMap)
+            {
+                uint32_t texture = Dependencies.AddNode(PANDA_ASSET_NODE_TEXTURE, pTexture->GetName());
+                Dependencies.AddDependency(node, texture);
+                textures[texture].push_back(pTexture);
+            }
+        }
+
+        for (auto& texture : textures)
+        {
+            auto& objects = texture.second;
+            Dependencies.SetResolveFunction(texture.first, [&objects]() {
+                for (auto& pTexture : objects)
+                    pTexture->LoadTexture();
+            });
+        }
+
+        if (!Dependencies.Resolve(maxConcurrency))
+            std::cerr << "[Scene] The asset dependencies form a cycle, some materials are not loaded" << std::endl;
+
+        // the functions hold on to the materials, the graph itself stays for reloading
+        for (uint32_t i = 0; i < Dependencies.GetNodeCount(); ++i)
+            Dependencies.SetResolveFunction(i, nullptr);
     }
 }
 
@@ -5,6 +5,8 @@
 #include <unordered_map>
 #include "SceneNode.hpp"
 #include "SceneObject.hpp"
+#include "PandaAllocator.hpp"
+#include "AssetDependencyGraph.hpp"
 
 namespace Panda
 {
@@ -17,7 +19,7 @@ namespace Panda
     {
         public:
             Scene() {
-                m_pDefaultMaterial = std::make_shared<SceneObjectMaterial>("default");
+                m_pDefaultMaterial = MakeShared<SceneObjectMaterial>("default");
             }
 
             Scene(const char* sceneName) :
@@ -43,22 +45,27 @@ namespace Panda
             const std::shared_ptr<SceneGeometryNode> GetFirstGeometryNode() const;
             //const std::shared_ptr<SceneGeometryNode> GetNextGeometryNode() const;
 
-            void LoadResource();
+            // loads the textures of independent materials on up to maxConcurrency threads at once
+            void LoadResource(uint32_t maxConcurrency = AssetDependencyGraph::k_DefaultConcurrency);
         public:
+            // the containers and the objects they hold are allocated from the MemoryManager pools
             std::shared_ptr<BaseSceneNode> SceneGraph;
 
-            std::unordered_map<std::string, std::shared_ptr<SceneCameraNode>>       CameraNodes;
-            std::unordered_map<std::string, std::shared_ptr<SceneLightNode>>        LightNodes;
-            std::unordered_map<std::string, std::shared_ptr<SceneGeometryNode>>     GeometryNodes;
-            std::unordered_map<std::string, std::weak_ptr<SceneBoneNode>>           BoneNodes;
+            PandaUnorderedMap<std::string, std::shared_ptr<SceneCameraNode>>     CameraNodes;
+            PandaUnorderedMap<std::string, std::shared_ptr<SceneLightNode>>      LightNodes;
+            PandaUnorderedMap<std::string, std::shared_ptr<SceneGeometryNode>>   GeometryNodes;
+            PandaUnorderedMap<std::string, std::weak_ptr<SceneBoneNode>>         BoneNodes;
             
-            std::unordered_map<std::string, std::shared_ptr<SceneObjectCamera>>     Cameras;
-            std::unordered_map<std::string, std::shared_ptr<SceneObjectLight>>      Lights;
-            std::unordered_map<std::string, std::shared_ptr<SceneObjectMaterial>>   Materials;
-            std::unordered_map<std::string, std::shared_ptr<SceneObjectGeometry>>   Geometries;
+            PandaUnorderedMap<std::string, std::shared_ptr<SceneObjectCamera>>   Cameras;
+            PandaUnorderedMap<std::string, std::shared_ptr<SceneObjectLight>>    Lights;
+            PandaUnorderedMap<std::string, std::shared_ptr<SceneObjectMaterial>> Materials;
+            PandaUnorderedMap<std::string, std::shared_ptr<SceneObjectGeometry>> Geometries;
 
-            std::vector<std::weak_ptr<BaseSceneNode>>                           AnimatableNodes;
-            std::unordered_map<std::string, std::weak_ptr<SceneGeometryNode>>   LUTNameGeometryNode;
+            PandaVector<std::weak_ptr<BaseSceneNode>>                            AnimatableNodes;
+            PandaUnorderedMap<std::string, std::weak_ptr<SceneGeometryNode>>     LUTNameGeometryNode;
+
+            // scene, geometries, materials and textures, filled in by the scene parsers
+            AssetDependencyGraph Dependencies;
 
         private:
            std::shared_ptr<SceneObjectMaterial> m_pDefaultMaterial;
@@ -15,18 +15,18 @@ namespace Panda
             const Vector3Df& GetTarget() {return m_Target;}
 			Vector3Df GetForwardDirection()
 			{
-				auto pTransform = GetCalculatedTransform();
+				Matrix4f transform = GetCalculatedTransform();
 				Vector4Df forward = Vector4Df({ 0.0f, 0.0f, -1.0f, 0.0f });
-				TransformCoord(forward, *pTransform);
+				TransformCoord(forward, transform);
 				return Normalize(Vector3Df({ forward.data[0], forward.data[1], forward.data[2] }));
 			}
 
 			Vector3Df GetRightDirection()
 			{
 				Vector3Df forward = GetForwardDirection();
-				auto pTransform = GetCalculatedTransform();
+				Matrix4f transform = GetCalculatedTransform();
 				Vector4Df up4 = Vector4Df({ 0.0f, 1.0f, 0.0f, 0.0f });
-				TransformCoord(up4, *pTransform);
+				TransformCoord(up4, transform);
 				Vector3Df up3 = Normalize(Vector3Df({ up4.data[0], up4.data[1], up4.data[2] }));
 
 				Vector3Df right = CrossProduct(up3, -forward);
@@ -44,10 +44,10 @@ namespace Panda
             Matrix3f GetLocalAxis()
             {
                 Matrix3f result;
-                auto pTransform = GetCalculatedTransform();
+                Matrix4f transform = GetCalculatedTransform();
                 Vector3Df target = GetTarget();
                 Vector3Df cameraPosition = Vector3Df(0.0f);
-                TransformCoord(cameraPosition, *pTransform);
+                TransformCoord(cameraPosition, transform);
 				Vector3Df up({ 0.0f, 0.0f, 1.0f });
                 Vector3Df cameraZAxis = cameraPosition - target;
 				cameraZAxis = Normalize(cameraZAxis);
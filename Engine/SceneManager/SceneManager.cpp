@@ -14,13 +14,14 @@ namespace Panda
 	{
 		int result = 0;
 
-		m_pScene = std::make_shared<Scene>();
+		m_pScene = MakeShared<Scene>();
 		return result;
 	}
 
 	void SceneManager::Finalize()
 	{
-
+		// 场景对象来自MemoryManager的池，要在MemoryManager::Finalize()释放页之前析构
+		m_pScene.reset();
 	}
 
 	void SceneManager::Tick()
@@ -39,7 +40,7 @@ namespace Panda
 		{
 			if (LoadOgexScene(sceneFileName))
 			{
-				m_pScene->LoadResource();
+				m_pScene->LoadResource(m_LoadConcurrency);
 				m_DirtyFlag = true;
 				m_IsRenderingQueued = false;
 				return 0;
@@ -51,7 +52,7 @@ namespace Panda
 		{
 			if (LoadDaeScene(sceneFileName))
 			{
-				m_pScene->LoadResource();
+				m_pScene->LoadResource(m_LoadConcurrency);
 				m_DirtyFlag = true;
 				m_IsRenderingQueued = false;
 				return 0;
@@ -70,14 +71,18 @@ namespace Panda
 
 	bool SceneManager::LoadOgexScene(const char* ogexSceneFileName)
 	{
-		std::string ogexText = g_pAssetLoader->SyncOpenAndReadFileToString(ogexSceneFileName);
+		// parse the loaded text in place instead of copying it into a std::string
+		Buffer ogexText = g_pAssetLoader->SyncOpenAndReadText(ogexSceneFileName);
 
-		if (ogexText.empty())
+		if (ogexText.GetDataSize() <= 1)
 		{
 			return false;
 		}
+		AssetLoadProfiler& profiler = g_pAssetLoader->GetProfiler();
+		int64_t parseStart = profiler.Now();
 		OgexParser ogexParser;
 		m_pScene = ogexParser.Parse(ogexText);
+		profiler.RecordParse(ogexSceneFileName, parseStart, profiler.Now());
 
 		if (!m_pScene)
 		{
@@ -16,6 +16,8 @@ namespace Panda
             virtual void Tick();
 
             int LoadScene(const char* sceneFileName);
+            // how many textures are decoded at once while loading a scene, 0 for one per core
+            void SetLoadConcurrency(uint32_t maxConcurrency) {m_LoadConcurrency = maxConcurrency;}
 
             bool IsSceneChanged();
             void NotifySceneIsRenderingQueued();
@@ -36,6 +38,7 @@ namespace Panda
             std::shared_ptr<Scene> m_pScene;
             bool m_IsRenderingQueued = false;
             bool m_DirtyFlag = false;
+            uint32_t m_LoadConcurrency = AssetDependencyGraph::k_DefaultConcurrency;
     };
 
     extern SceneManager* g_pSceneManager;
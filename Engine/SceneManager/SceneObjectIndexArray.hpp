@@ -1,5 +1,7 @@
 #pragma once
+#include <memory>
 #include "SceneObjectTypeDef.hpp"
+#include "RelocatableBuffer.hpp"
 
 namespace Panda
 {
@@ -11,6 +13,8 @@ namespace Panda
             const IndexDataType   m_DataType;
 
             const void*           m_pData;
+            // when set the data lives in the relocatable heap and m_pData is unused
+            std::shared_ptr<RelocatableBuffer> m_pBuffer;
             const size_t          m_DataSize;
 
             public:
@@ -19,12 +23,18 @@ namespace Panda
                     m_MaterialIndex(material_index), m_RestartIndex(restart_index), m_DataType(data_type),
                     m_pData(data), m_DataSize(dataSize)
                     {}
+                SceneObjectIndexArray(const uint32_t material_index, const uint32_t restart_index, const IndexDataType data_type,
+                    std::shared_ptr<RelocatableBuffer> pBuffer, const size_t dataSize) :
+                    m_MaterialIndex(material_index), m_RestartIndex(restart_index), m_DataType(data_type),
+                    m_pData(nullptr), m_pBuffer(std::move(pBuffer)), m_DataSize(dataSize)
+                    {}
                 SceneObjectIndexArray(SceneObjectIndexArray& arr) = default;
                 SceneObjectIndexArray(SceneObjectIndexArray&& arr) = default;
 
                 const uint32_t GetMaterialIndex() const {return m_MaterialIndex;}
                 const IndexDataType GetIndexType() const {return m_DataType;}
-                const void* GetData() const {return m_pData;}
+                // the relocatable heap is compacted in MemoryManager::Tick(), do not keep the pointer across frames
+                const void* GetData() const {return m_pBuffer ? m_pBuffer->GetData() : m_pData;}
                 size_t GetDataSize() const
                 {
                     size_t size = m_DataSize;
@@ -129,6 +129,14 @@ namespace Panda
                 }
             }
 
+            void PrefetchTexture(std::vector<std::string>& batch)
+            {
+                if (m_BaseColor.ValueMap)
+                {
+                    m_BaseColor.ValueMap->PrefetchTexture(batch);
+                }
+            }
+
             void LoadTexture()
             {
                 if (m_BaseColor.ValueMap)
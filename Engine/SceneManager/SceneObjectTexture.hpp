@@ -7,6 +7,7 @@
 #include "Parser/TGA.hpp"
 #include "Image.hpp"
 #include "AssetLoader.hpp"
+#include "RelocatableBuffer.hpp"
 
 namespace Panda
 {
@@ -16,6 +17,8 @@ namespace Panda
             std::string m_Name;
             uint32_t m_TexCoordIndex;
             std::shared_ptr<Image> m_pImage;
+            // pixels of a texture loaded from file, shared through the asset cache
+            std::shared_ptr<const CachedImage> m_pCachedImage;
 
             std::vector<Matrix4f> m_Transforms;
 
@@ -31,34 +34,20 @@ namespace Panda
             void SetName(const std::string& name) {m_Name = name;}
             void SetName(std::string&& name) {m_Name = std::move(name);}
             const std::string& GetName() const {return m_Name;}
+            // add the file to a batch read on the I/O workers, so it can overlap with decoding other textures
+            void PrefetchTexture(std::vector<std::string>& batch)
+            {
+                if (!m_pImage && !m_Name.empty())
+                    batch.push_back(m_Name);
+            }
+
             void LoadTexture()
             {
                 if (!m_pImage)
                 {
-                    // we should lookup if the texture has been loaded already to prevent
-                    // duplicate load. This could be done in Asset Loader Manager.
-                    Buffer buf = g_pAssetLoader->SyncOpenAndReadBinary(m_Name.c_str());
-                    std::string ext = m_Name.substr(m_Name.find_last_of("."));
-                    if (ext == ".jpg" || ext == "jpeg")
-                    {
-                        JfifParser jfifParser;
-                        m_pImage = std::make_shared<Image>(jfifParser.Parse(buf));                        
-                    }
-                    else if (ext == ".png")
-                    {
-                        PngParser pngParser;
-                        m_pImage = std::make_shared<Image>(pngParser.Parse(buf));
-                    }
-                    else if (ext == ".bmp")
-                    {
-                        BmpParser bmpParser;
-                        m_pImage = std::make_shared<Image>(bmpParser.Parse(buf));
-                    }
-                    else if (ext == ".tga")
-                    {
-                        TgaParser tgaParser;
-                        m_pImage = std::make_shared<Image>(tgaParser.Parse(buf));
-                    }
+                    // a texture used by many materials is read and decoded only once
+                    m_pCachedImage = g_pAssetLoader->GetCache().LoadImage(m_Name.c_str(), DecodeImage);
+                    m_pImage = m_pCachedImage ? std::make_shared<Image>(m_pCachedImage->Header) : std::make_shared<Image>();
                 }
             }
 
@@ -69,9 +58,43 @@ namespace Panda
                     LoadTexture();
                 }
 
+                // the pixels may have moved since the last call, Data is valid until the next MemoryManager::Tick()
+                if (m_pCachedImage)
+                    m_pImage->Data = m_pCachedImage->Pixels.GetData();
+
                 return *m_pImage;
             }
 
             friend std::ostream& operator<<(std::ostream& out, const SceneObjectTexture& obj);
+
+        private:
+            static Image DecodeImage(const std::string& name, const BufferView& data)
+            {
+                Image image;
+                size_t dot = name.find_last_of(".");
+                std::string ext = (dot == std::string::npos) ? std::string() : name.substr(dot);
+                if (ext == ".jpg" || ext == ".jpeg")
+                {
+                    JfifParser jfifParser;
+                    image = jfifParser.Parse(data);
+                }
+                else if (ext == ".png")
+                {
+                    PngParser pngParser;
+                    image = pngParser.Parse(data);
+                }
+                else if (ext == ".bmp")
+                {
+                    BmpParser bmpParser;
+                    image = bmpParser.Parse(data);
+                }
+                else if (ext == ".tga")
+                {
+                    TgaParser tgaParser;
+                    image = tgaParser.Parse(data);
+                }
+
+                return image;
+            }
     };
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include <string>
+#include <memory>
 #include "SceneObjectTypeDef.hpp"
+#include "RelocatableBuffer.hpp"
 
 namespace Panda
 {
@@ -12,6 +14,8 @@ namespace Panda
         const VertexDataType    m_DataType;
 
         const void*             m_pData;
+        // when set the data lives in the relocatable heap and m_pData is unused
+        std::shared_ptr<RelocatableBuffer> m_pBuffer;
 
         const size_t            m_DataSize;
         
@@ -20,6 +24,10 @@ namespace Panda
                 const void* data = nullptr, const size_t dataSize = 0)
                 : m_Attribute(attr), m_MorphTargetIndex(morphIndex), m_DataType(dataType), m_pData(data), m_DataSize(dataSize)
                 {}
+            SceneObjectVertexArray(const char* attr, const uint32_t morphIndex, const VertexDataType dataType,
+                std::shared_ptr<RelocatableBuffer> pBuffer, const size_t dataSize)
+                : m_Attribute(attr), m_MorphTargetIndex(morphIndex), m_DataType(dataType), m_pData(nullptr), m_pBuffer(std::move(pBuffer)), m_DataSize(dataSize)
+                {}
             SceneObjectVertexArray(SceneObjectVertexArray& arr) = default; // this two might be modified
             SceneObjectVertexArray(SceneObjectVertexArray&& arr) = default;
 
@@ -53,7 +61,8 @@ namespace Panda
                 return size;
             }
 
-            const void* GetData() const {return m_pData;}
+            // the relocatable heap is compacted in MemoryManager::Tick(), do not keep the pointer across frames
+            const void* GetData() const {return m_pBuffer ? m_pBuffer->GetData() : m_pData;}
 
             size_t GetVertexCount() const
             {
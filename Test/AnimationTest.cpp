@@ -18,8 +18,8 @@ namespace Panda
     AnimationManager* g_pAnimationManager = new AnimationManager();
 }
 
-template<typename T>
-static ostream& operator<<(ostream& out, unordered_map<string, shared_ptr<T>> map)
+template<typename T, typename... Rest>
+static ostream& operator<<(ostream& out, const unordered_map<string, shared_ptr<T>, Rest...>& map)
 {
     for (auto p : map)
     {
@@ -57,20 +57,21 @@ int main(int argc, char** argv)
         {
             auto pNode = node.lock();
             if (pNode)
-                cout << *pNode->GetCalculatedTransform() << endl;
+                cout << pNode->GetCalculatedTransform() << endl;
         }
         const chrono::milliseconds oneFrameTime(33);
         this_thread::sleep_for(oneFrameTime);
     }
 
+    // everything holding blocks of the memory manager goes before its pages are released
     g_pAnimationManager->Finalize();
     g_pSceneManager->Finalize();
     g_pAssetLoader->Finalize();
-    g_pMemoryManager->Finalize();
-
     delete g_pAnimationManager;
     delete g_pSceneManager;
     delete g_pAssetLoader;
+
+    g_pMemoryManager->Finalize();
     delete g_pMemoryManager;
 
     return 0;
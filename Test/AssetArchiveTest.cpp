@@ -0,0 +1,159 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include "MemoryManager.hpp"
+#include "AssetLoader.hpp"
+#include "AssetArchive.hpp"
+#include "AssetArchiveWriter.hpp"
+
+using namespace std;
+using namespace Panda;
+
+namespace Panda
+{
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+}
+
+static int g_Failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        cerr << "FAILED: " << what << endl;
+        ++g_Failures;
+    }
+}
+
+static string AsString(const BufferView& view)
+{
+    return string(reinterpret_cast<const char*>(view.GetData()), view.GetDataSize());
+}
+
+// borrows the string, it outlives the writer
+static BufferView View(const string& data)
+{
+    return BufferView(nullptr, reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+static void TestArchive(const string& path, const string& text, const string& noise)
+{
+    {
+        AssetArchiveWriter writer;
+        // added out of order, the writer sorts them
+        writer.AddFile("Scenes/scene.ogex", Buffer(), false);
+        writer.AddFile("text.txt", View(text), true);
+        writer.AddFile("noise.bin", View(noise), true);
+        writer.AddFile("empty.bin", BufferView(), true);
+        Expect(writer.Write(path.c_str()), "archive is written");
+
+        writer.AddFile("text.txt", BufferView(), false);
+        Expect(!writer.Write((path + ".dup").c_str()), "duplicate names are rejected");
+    }
+
+    AssetArchive archive;
+    Expect(archive.Open(path.c_str()), "archive opens");
+    Expect(archive.GetEntryCount() == 4, "entry count");
+    Expect(archive.Find("missing") == nullptr && archive.Find("text") == nullptr, "missing names");
+
+    const AssetArchiveEntry* pText = archive.Find("text.txt");
+    Expect(pText && (pText->Flags & PANDA_ARCHIVE_ENTRY_COMPRESSED), "repetitive text is compressed");
+    Expect(pText && pText->StoredSize < text.size(), "compressed entry is smaller");
+    Expect(pText && AsString(archive.Read(*pText)) == text, "compressed entry round trips");
+
+    const AssetArchiveEntry* pNoise = archive.Find("noise.bin");
+    Expect(pNoise && !(pNoise->Flags & PANDA_ARCHIVE_ENTRY_COMPRESSED), "incompressible data is stored");
+    Expect(pNoise && pNoise->Offset % k_AssetArchiveAlignment == 0, "entries are aligned");
+
+    BufferView slice;
+    if (pNoise)
+        slice = archive.Read(*pNoise);
+    archive.Close();
+    Expect(AsString(slice) == noise, "stored entry outlives the archive");
+
+    const AssetArchiveEntry* pEmpty = nullptr;
+    if (archive.Open(path.c_str()))
+        pEmpty = archive.Find("empty.bin");
+    Expect(pEmpty && pEmpty->Size == 0 && archive.Read(*pEmpty).IsEmpty(), "empty entry");
+    Expect(archive.Find("Scenes/scene.ogex") != nullptr, "nested name");
+
+    // a truncated archive is refused instead of read out of bounds
+    string truncated = path + ".truncated";
+    filesystem::copy_file(path, truncated, filesystem::copy_options::overwrite_existing);
+    filesystem::resize_file(truncated, 40);
+    AssetArchive broken;
+    Expect(!broken.Open(truncated.c_str()), "truncated archive is refused");
+}
+
+static void TestMount(const string& path, const filesystem::path& root, const string& text, const string& noise)
+{
+    ofstream(root / "Asset" / "text.txt", ios::binary) << "loose";
+    g_pAssetLoader->AddSearchPath(root.string().c_str());
+    Expect(g_pAssetLoader->SyncOpenAndReadFileToString("text.txt") == "loose", "loose file before mounting");
+
+    Expect(g_pAssetLoader->AddSearchPath(path.c_str()), "archive mounts");
+    Expect(!g_pAssetLoader->AddSearchPath((root / "missing.pak").string().c_str()), "missing archive");
+
+    Buffer textBuffer = g_pAssetLoader->SyncOpenAndReadText("text.txt");
+    Expect(textBuffer.GetDataSize() == text.size() + 1 && textBuffer.GetData()[text.size()] == '\0'
+        && string(reinterpret_cast<const char*>(textBuffer.GetData())) == text, "archive wins over loose files");
+
+    Buffer noiseBuffer = g_pAssetLoader->SyncOpenAndReadBinary("noise.bin");
+    Expect(noiseBuffer.GetDataSize() == noise.size()
+        && memcmp(noiseBuffer.GetData(), noise.data(), noise.size()) == 0, "binary read from the archive");
+
+    BufferView mapped = g_pAssetLoader->SyncOpenAndMapBinary("noise.bin");
+    Expect(AsString(mapped) == noise, "mapped read from the archive");
+    Expect(reinterpret_cast<uintptr_t>(mapped.GetData()) % k_AssetArchiveAlignment == 0, "stored entry is not copied");
+
+    Expect(g_pAssetLoader->FileExists("Scenes/scene.ogex"), "archive entry exists");
+    Expect(g_pAssetLoader->AsyncOpenAndRead("text.txt", AssetLoader::PANDA_LOAD_PRIORITY_NORMAL,
+        AssetLoader::PANDA_OPEN_BINARY).get().GetDataSize() == text.size(), "async read from the archive");
+
+    g_pAssetLoader->RemoveSearchPath(path.c_str());
+    Expect(!g_pAssetLoader->FileExists("noise.bin"), "archive unmounts");
+    Expect(AsString(mapped) == noise, "view outlives the unmount");
+    Expect(g_pAssetLoader->SyncOpenAndReadFileToString("text.txt") == "loose", "loose file after unmounting");
+}
+
+int main(int argc, char** argv)
+{
+    filesystem::path root = filesystem::temp_directory_path() / "PandaAssetArchiveTest";
+    filesystem::create_directories(root / "Asset");
+    string path = (root / "test.pak").string();
+
+    string text;
+    for (uint32_t i = 0; i < 1000; ++i)
+        text += "line " + to_string(i % 10) + "\n";
+    string noise;
+    uint32_t seed = 12345;
+    for (uint32_t i = 0; i < 10000; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        noise += static_cast<char>(seed >> 24);
+    }
+
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->Initialize();
+
+    TestArchive(path, text, noise);
+    TestMount(path, root, text, noise);
+
+    g_pAssetLoader->Finalize();
+    delete g_pAssetLoader;
+    g_pMemoryManager->Finalize();
+    delete g_pMemoryManager;
+
+    filesystem::remove_all(root);
+
+    if (g_Failures)
+    {
+        cerr << g_Failures << " check(s) failed" << endl;
+        return 1;
+    }
+
+    cout << "All asset archive checks passed" << endl;
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "MemoryManager.hpp"
+#include "AssetLoader.hpp"
+#include "Parser/BMP.hpp"
+
+using namespace std;
+using namespace Panda;
+
+namespace Panda
+{
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+}
+
+static int g_Failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        cerr << "FAILED: " << what << endl;
+        ++g_Failures;
+    }
+}
+
+// a 32 bit BMP filled with one color
+static void WriteBmp(const filesystem::path& path, int32_t width, int32_t height, uint8_t color)
+{
+    BITMAP_FILEHEADER fileHeader = {};
+    BITMAP_HEADER header = {};
+    uint32_t dataSize = width * height * 4;
+    fileHeader.signature = 0x4D42;
+    fileHeader.bitsOffset = BITMAP_FILEHEADER_SIZE + sizeof(BITMAP_HEADER);
+    fileHeader.size = fileHeader.bitsOffset + dataSize;
+    header.headerSize = sizeof(BITMAP_HEADER);
+    header.width = width;
+    header.height = height;
+    header.planes = 1;
+    header.bitCount = 32;
+    header.sizeImage = dataSize;
+
+    ofstream file(path, ios::binary);
+    file.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file << string(dataSize, static_cast<char>(color));
+}
+
+static Image DecodeBmp(const string&, const BufferView& data)
+{
+    BmpParser parser;
+    return parser.Parse(data);
+}
+
+static void TestImages()
+{
+    AssetCache& cache = g_pAssetLoader->GetCache();
+    cache.SetContentKeying(true);
+
+    auto pFirst = cache.LoadImage("red.bmp", DecodeBmp);
+    Expect(pFirst && pFirst->Header.Width == 16 && pFirst->Header.Height == 16, "image is decoded");
+    Expect(pFirst && pFirst->Header.Data == nullptr && pFirst->Pixels.GetData()[0] == 0x40, "pixels are in the cache");
+
+    auto pSecond = cache.LoadImage("red.bmp", DecodeBmp);
+    Expect(pFirst == pSecond, "the same name is decoded once");
+    Expect(cache.GetHitCount() == 1 && cache.GetMissCount() == 1, "hit and miss counts");
+
+    // same content under another name
+    auto pCopy = cache.LoadImage("Textures/red_copy.bmp", DecodeBmp);
+    Expect(pCopy == pFirst, "identical files are decoded once");
+    Expect(cache.GetEntryCount() == 1, "one entry for both names");
+
+    auto pBlue = cache.LoadImage("blue.bmp", DecodeBmp);
+    Expect(pBlue && pBlue != pFirst && pBlue->Pixels.GetData()[0] == 0x80, "different content is its own entry");
+    Expect(cache.LoadImage("missing.bmp", DecodeBmp) == nullptr, "missing image");
+
+    // the prefetched read is picked up by the next load
+    cache.Prefetch("green.bmp");
+    auto pGreen = cache.LoadImage("green.bmp", DecodeBmp);
+    Expect(pGreen && pGreen->Pixels.GetData()[0] == 0xC0, "prefetched image");
+    cache.Prefetch("green.bmp");
+    Expect(cache.IsCached("green.bmp"), "cached image is not prefetched again");
+
+    // budget smaller than one image: only the unused ones go
+    size_t entries = cache.GetEntryCount();
+    pSecond.reset();
+    pCopy.reset();
+    pGreen.reset();
+    cache.SetBudget(1);
+    Expect(cache.GetEntryCount() == 2, "unused images are evicted");
+    Expect(cache.IsCached("red.bmp") && cache.IsCached("blue.bmp"), "images in use stay");
+    Expect(!cache.IsCached("green.bmp"), "least recently used image is gone");
+
+    pFirst.reset();
+    cache.Trim();
+    Expect(!cache.IsCached("red.bmp") && !cache.IsCached("Textures/red_copy.bmp"), "released image goes with all its names");
+    Expect(cache.GetCachedBytes() == pBlue->Pixels.GetDataSize(), "cached bytes");
+    Expect(entries == 3, "entry count before eviction");
+
+    cache.SetBudget(AssetCache::k_DefaultBudget);
+    cache.Clear();
+    Expect(cache.GetEntryCount() == 0 && cache.GetCachedBytes() == 0, "cache is cleared");
+    Expect(pBlue->Pixels.GetData()[0] == 0x80, "images in use outlive Clear");
+    cache.SetContentKeying(false);
+}
+
+static void TestPathKeys()
+{
+    AssetCache& cache = g_pAssetLoader->GetCache();
+    Expect(!cache.IsContentKeying(), "content keying is off by default");
+
+    // without content keys a copy is only found by its own path
+    auto pFirst = cache.LoadImage("red.bmp", DecodeBmp);
+    auto pCopy = cache.LoadImage("Textures/red_copy.bmp", DecodeBmp);
+    Expect(pFirst && pCopy && pFirst != pCopy, "copies are separate entries by default");
+    Expect(cache.GetEntryCount() == 2, "one entry for each path");
+    Expect(cache.LoadImage("Textures/red_copy.bmp", DecodeBmp) == pCopy, "the copy is found by its path");
+
+    pFirst.reset();
+    pCopy.reset();
+    cache.Clear();
+}
+
+static void TestBuffers()
+{
+    AssetCache& cache = g_pAssetLoader->GetCache();
+
+    auto pText = cache.LoadBuffer("shader.txt");
+    Expect(pText && string(reinterpret_cast<const char*>(pText->GetData()), pText->GetDataSize()) == "void main() {}",
+        "buffer content");
+    Expect(cache.LoadBuffer("shader.txt") == pText, "the same buffer is shared");
+
+    // buffers and images are separate even for one file
+    auto pImage = cache.LoadImage("red.bmp", DecodeBmp);
+    auto pRaw = cache.LoadBuffer("red.bmp");
+    Expect(pImage && pRaw && pRaw->GetDataSize() == BITMAP_FILEHEADER_SIZE + sizeof(BITMAP_HEADER) + 16 * 16 * 4,
+        "raw file and image side by side");
+
+    cache.Clear();
+}
+
+int main(int argc, char** argv)
+{
+    filesystem::path root = filesystem::temp_directory_path() / "PandaAssetCacheTest";
+    filesystem::create_directories(root / "Asset" / "Textures");
+    WriteBmp(root / "Asset" / "red.bmp", 16, 16, 0x40);
+    WriteBmp(root / "Asset" / "Textures" / "red_copy.bmp", 16, 16, 0x40);
+    WriteBmp(root / "Asset" / "blue.bmp", 16, 16, 0x80);
+    WriteBmp(root / "Asset" / "green.bmp", 16, 16, 0xC0);
+    ofstream(root / "Asset" / "shader.txt", ios::binary) << "void main() {}";
+
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->Initialize();
+    g_pAssetLoader->AddSearchPath(root.string().c_str());
+
+    TestImages();
+    TestBuffers();
+    TestPathKeys();
+
+    g_pAssetLoader->Finalize();
+    delete g_pAssetLoader;
+    g_pMemoryManager->Finalize();
+    delete g_pMemoryManager;
+
+    filesystem::remove_all(root);
+
+    if (g_Failures)
+    {
+        cerr << g_Failures << " check(s) failed" << endl;
+        return 1;
+    }
+
+    cout << "All asset cache checks passed" << endl;
+    return 0;
+}
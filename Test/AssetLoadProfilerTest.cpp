@@ -0,0 +1,181 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include "MemoryManager.hpp"
+#include "AssetLoader.hpp"
+#include "AssetArchiveWriter.hpp"
+#include "Parser/BMP.hpp"
+
+using namespace std;
+using namespace Panda;
+
+namespace Panda
+{
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+}
+
+static int g_Failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        cerr << "FAILED: " << what << endl;
+        ++g_Failures;
+    }
+}
+
+static void WriteBmp(const filesystem::path& path, int32_t width, int32_t height)
+{
+    BITMAP_FILEHEADER fileHeader = {};
+    BITMAP_HEADER header = {};
+    uint32_t dataSize = width * height * 4;
+    fileHeader.signature = 0x4D42;
+    fileHeader.bitsOffset = BITMAP_FILEHEADER_SIZE + sizeof(BITMAP_HEADER);
+    fileHeader.size = fileHeader.bitsOffset + dataSize;
+    header.headerSize = sizeof(BITMAP_HEADER);
+    header.width = width;
+    header.height = height;
+    header.planes = 1;
+    header.bitCount = 32;
+    header.sizeImage = dataSize;
+
+    ofstream file(path, ios::binary);
+    file.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file << string(dataSize, '\x40');
+}
+
+// slow enough that the parse is measurable
+static Image DecodeBmp(const string&, const BufferView& data)
+{
+    this_thread::sleep_for(chrono::milliseconds(5));
+    BmpParser parser;
+    return parser.Parse(data);
+}
+
+static const AssetLoadRecord* FindRecord(const vector<AssetLoadRecord>& records, const string& name)
+{
+    for (const auto& record : records)
+    {
+        if (record.Name == name)
+            return &record;
+    }
+    return nullptr;
+}
+
+static size_t CountOf(const string& text, const string& pattern)
+{
+    size_t count = 0;
+    for (size_t pos = text.find(pattern); pos != string::npos; pos = text.find(pattern, pos + 1))
+        ++count;
+    return count;
+}
+
+static void TestDisabled()
+{
+    AssetLoadProfiler& profiler = g_pAssetLoader->GetProfiler();
+    Expect(!profiler.IsEnabled(), "profiler starts disabled");
+    g_pAssetLoader->SyncOpenAndReadBinary("data.bin");
+    Expect(profiler.GetRecords().empty(), "nothing is recorded while disabled");
+}
+
+static void TestRecords()
+{
+    AssetLoadProfiler& profiler = g_pAssetLoader->GetProfiler();
+    profiler.Start();
+
+    g_pAssetLoader->SyncOpenAndReadBinary("data.bin");
+    g_pAssetLoader->SyncOpenAndReadText("archived.txt");
+    g_pAssetLoader->SyncOpenAndReadBatch({"batch_a.bin", "batch_b.bin"});
+    auto pImage = g_pAssetLoader->GetCache().LoadImage("image.bmp", DecodeBmp);
+    Expect(pImage != nullptr, "image is loaded");
+    profiler.RecordParse("we\"ird\\name", profiler.Now(), profiler.Now());
+
+    profiler.Stop();
+    g_pAssetLoader->SyncOpenAndReadBinary("data.bin");
+
+    vector<AssetLoadRecord> records = profiler.GetRecords();
+    Expect(records.size() == 6, "one record per asset, none after Stop");
+
+    const AssetLoadRecord* pData = FindRecord(records, "data.bin");
+    Expect(pData && pData->Open.Start >= 0 && pData->Read.Start >= pData->Open.Start + pData->Open.Duration,
+        "the read follows the open");
+    Expect(pData && pData->BytesRead == 100000 && pData->Parse.Start < 0, "bytes of a loose file");
+
+    const AssetLoadRecord* pArchived = FindRecord(records, "archived.txt");
+    Expect(pArchived && pArchived->Open.Start >= 0 && pArchived->BytesRead == 11, "archive entry");
+
+    const AssetLoadRecord* pBatch = FindRecord(records, "batch_b.bin");
+    Expect(pBatch && pBatch->Open.Start >= 0 && pBatch->Read.Start >= 0 && pBatch->BytesRead == 3000, "batch read");
+
+    const AssetLoadRecord* pImageRecord = FindRecord(records, "image.bmp");
+    Expect(pImageRecord && pImageRecord->Read.Start >= 0 && pImageRecord->Parse.Duration >= 5000,
+        "parse time of a decoded image");
+    Expect(pImageRecord && pImageRecord->Parse.Start >= pImageRecord->Read.Start + pImageRecord->Read.Duration,
+        "the parse follows the read");
+
+    ostringstream summary;
+    profiler.WriteSummary(summary);
+    string table = summary.str();
+    Expect(table.find("image.bmp") < table.find("data.bin"), "slowest asset first");
+    Expect(table.find("Total") != string::npos && table.find("6 assets") != string::npos, "totals");
+    Expect(table.find("parse-bound") != string::npos, "the sleeping decoder makes the load parse-bound");
+
+    ostringstream trace;
+    profiler.WriteChromeTrace(trace);
+    string json = trace.str();
+    Expect(json.find("{\"traceEvents\": [") == 0, "trace header");
+    Expect(CountOf(json, "\"ph\": \"X\"") == 12, "an event per step");
+    Expect(CountOf(json, "\"cat\": \"parse\"") == 2, "parse events");
+    Expect(json.find("we\\\"ird\\\\name") != string::npos, "names are escaped");
+    Expect(json.find("\"thread_name\"") != string::npos, "threads are named");
+
+    cout << table;
+    g_pAssetLoader->GetCache().Clear();
+}
+
+int main(int argc, char** argv)
+{
+    filesystem::path root = filesystem::temp_directory_path() / "PandaAssetLoadProfilerTest";
+    filesystem::create_directories(root / "Asset");
+    ofstream(root / "Asset" / "data.bin", ios::binary) << string(100000, 'd');
+    ofstream(root / "Asset" / "batch_a.bin", ios::binary) << string(2000, 'a');
+    ofstream(root / "Asset" / "batch_b.bin", ios::binary) << string(3000, 'b');
+    WriteBmp(root / "Asset" / "image.bmp", 64, 64);
+
+    AssetArchiveWriter writer;
+    string text = "in the pak!";
+    writer.AddFile("archived.txt", BufferView(nullptr, reinterpret_cast<const uint8_t*>(text.data()), text.size()), false);
+    writer.Write((root / "assets.pak").string().c_str());
+
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->Initialize();
+    g_pAssetLoader->AddSearchPath(root.string().c_str());
+    g_pAssetLoader->AddSearchPath((root / "assets.pak").string().c_str());
+
+    TestDisabled();
+    TestRecords();
+
+    g_pAssetLoader->Finalize();
+    delete g_pAssetLoader;
+    g_pMemoryManager->Finalize();
+    delete g_pMemoryManager;
+
+    filesystem::remove_all(root);
+
+    if (g_Failures)
+    {
+        cerr << g_Failures << " check(s) failed" << endl;
+        return 1;
+    }
+
+    cout << "All asset load profiler checks passed" << endl;
+    return 0;
+}
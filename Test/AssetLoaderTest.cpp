@@ -22,9 +22,9 @@ int main (int argc, char** argv)
     cout << shader_pgm;
 
     g_pAssetLoader->Finalize();
-    g_pMemoryManager->Finalize();
-
     delete g_pAssetLoader;
+
+    g_pMemoryManager->Finalize();
     delete g_pMemoryManager;
 
 	getchar();
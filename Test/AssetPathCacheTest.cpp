@@ -0,0 +1,95 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include "MemoryManager.hpp"
+#include "AssetLoader.hpp"
+
+using namespace std;
+using namespace Panda;
+
+namespace Panda
+{
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+}
+
+static int g_Failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        cerr << "FAILED: " << what << endl;
+        ++g_Failures;
+    }
+}
+
+static void WriteFile(const filesystem::path& path, const string& content)
+{
+    filesystem::create_directories(path.parent_path());
+    ofstream(path, ios::binary) << content;
+}
+
+static string ReadAsset(const char* name)
+{
+    return g_pAssetLoader->SyncOpenAndReadFileToString(name);
+}
+
+int main(int argc, char** argv)
+{
+    filesystem::path root = filesystem::temp_directory_path() / "PandaAssetPathCacheTest";
+    filesystem::path first = root / "first";
+    filesystem::path second = root / "second";
+    WriteFile(first / "Asset" / "shared.txt", "first");
+    WriteFile(second / "Asset" / "shared.txt", "second");
+    WriteFile(second / "Asset" / "Textures" / "nested.txt", "nested");
+
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->Initialize();
+    g_pAssetLoader->AddSearchPath(first.string().c_str());
+    g_pAssetLoader->AddSearchPath(second.string().c_str());
+
+    // search paths are probed in the order they were added
+    Expect(ReadAsset("shared.txt") == "first", "first search path wins");
+    Expect(ReadAsset("Textures/nested.txt") == "nested", "nested name");
+
+    // misses are cached until the cache is invalidated
+    Expect(!g_pAssetLoader->FileExists("late.txt"), "missing file");
+    WriteFile(second / "Asset" / "late.txt", "late");
+    Expect(!g_pAssetLoader->FileExists("late.txt"), "miss is cached");
+    g_pAssetLoader->InvalidatePathCache();
+    Expect(g_pAssetLoader->FileExists("late.txt"), "found after invalidation");
+
+    // a cached file that went away is looked up again
+    filesystem::remove(first / "Asset" / "shared.txt");
+    Expect(ReadAsset("shared.txt") == "second", "removed file is probed again");
+    WriteFile(first / "Asset" / "shared.txt", "first");
+
+    // changing the search paths drops the cache
+    g_pAssetLoader->RemoveSearchPath(second.string().c_str());
+    Expect(!g_pAssetLoader->FileExists("Textures/nested.txt"), "cache follows removed search path");
+    g_pAssetLoader->AddSearchPath(second.string().c_str());
+
+    size_t indexed = g_pAssetLoader->BuildDirectoryIndex();
+    Expect(indexed >= 3, "index holds the test files");
+    Expect(ReadAsset("shared.txt") == "first", "index keeps probing order");
+    Expect(ReadAsset("Textures/nested.txt") == "nested", "index holds nested names");
+    Expect(ReadAsset("late.txt") == "late", "index holds later files");
+
+    g_pAssetLoader->Finalize();
+    delete g_pAssetLoader;
+    g_pMemoryManager->Finalize();
+    delete g_pMemoryManager;
+
+    filesystem::remove_all(root);
+
+    if (g_Failures)
+    {
+        cerr << g_Failures << " check(s) failed" << endl;
+        return 1;
+    }
+
+    cout << "All asset path cache checks passed" << endl;
+    return 0;
+}
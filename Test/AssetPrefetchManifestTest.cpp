@@ -0,0 +1,131 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <thread>
+#include "MemoryManager.hpp"
+#include "AssetLoader.hpp"
+#include "AssetArchiveWriter.hpp"
+
+using namespace std;
+using namespace Panda;
+
+namespace Panda
+{
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+}
+
+static int g_Failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        cerr << "FAILED: " << what << endl;
+        ++g_Failures;
+    }
+}
+
+static string Absolute(const filesystem::path& path)
+{
+    return filesystem::absolute(path).lexically_normal().string();
+}
+
+static void TestManifest(const filesystem::path& root)
+{
+    string manifestPath = (root / "test.manifest").string();
+
+    AssetPrefetchManifest manifest;
+    manifest.Record("/a/first.png", 0, 0);
+    manifest.Record("/a/archive.pak", 4096, 1000);
+    manifest.Record("/a/first.png", 0, 0);
+    manifest.Record("/a/with space.png", 0, 0);
+    Expect(manifest.GetRangeCount() == 3, "a range is recorded once");
+    Expect(manifest.Save(manifestPath.c_str()), "manifest is saved");
+
+    // a damaged line is skipped, the rest still loads
+    ofstream(manifestPath, ios::app) << "not a range\n";
+
+    AssetPrefetchManifest loaded;
+    Expect(loaded.Load(manifestPath.c_str()), "manifest is loaded");
+    vector<AssetPrefetchRange> ranges = loaded.GetRanges();
+    Expect(ranges.size() == 3, "range count");
+    Expect(ranges.size() == 3 && ranges[0].Path == "/a/first.png" && ranges[0].Offset == 0 && ranges[0].Size == 0,
+        "whole file range");
+    Expect(ranges.size() == 3 && ranges[1].Path == "/a/archive.pak" && ranges[1].Offset == 4096 && ranges[1].Size == 1000,
+        "archive range");
+    Expect(ranges.size() == 3 && ranges[2].Path == "/a/with space.png", "paths keep their spaces");
+    Expect(!loaded.Load((root / "missing.manifest").string().c_str()), "missing manifest");
+
+    // files that are gone since the manifest was written are skipped
+    Expect(!AssetPrefetchManifest::Readahead(ranges[0]), "readahead of a missing file");
+}
+
+static void TestRecording(const filesystem::path& root)
+{
+    string manifestPath = (root / "startup.manifest").string();
+
+    Expect(!g_pAssetLoader->ReplayManifest(manifestPath.c_str()), "no manifest on the first launch");
+
+    g_pAssetLoader->StartRecording();
+    Buffer texture = g_pAssetLoader->SyncOpenAndReadBinary("texture.bin");
+    Buffer archived = g_pAssetLoader->SyncOpenAndReadBinary("archived.txt");
+    g_pAssetLoader->SyncOpenAndReadBinary("texture.bin");
+    g_pAssetLoader->SyncOpenAndReadBinary("missing.bin");
+    Expect(texture.GetDataSize() == 8192 && archived.GetDataSize() == 5, "assets are read while recording");
+    Expect(g_pAssetLoader->StopRecording(manifestPath.c_str()), "recording is saved");
+    g_pAssetLoader->SyncOpenAndReadBinary("shader.txt");
+
+    AssetPrefetchManifest manifest;
+    manifest.Load(manifestPath.c_str());
+    vector<AssetPrefetchRange> ranges = manifest.GetRanges();
+    Expect(ranges.size() == 2, "each asset read is recorded once");
+    Expect(ranges.size() == 2 && ranges[0].Path == Absolute(root / "Asset" / "texture.bin") && ranges[0].Size == 0,
+        "loose file in read order");
+    Expect(ranges.size() == 2 && ranges[1].Path == Absolute(root / "assets.pak") && ranges[1].Offset > 0
+        && ranges[1].Size == 5, "archive entry range");
+
+    // the next launch
+    Expect(g_pAssetLoader->ReplayManifest(manifestPath.c_str()), "manifest is replayed");
+    Expect(AssetPrefetchManifest::Readahead(ranges[0]) && AssetPrefetchManifest::Readahead(ranges[1]),
+        "readahead of recorded ranges");
+}
+
+int main(int argc, char** argv)
+{
+    filesystem::path root = filesystem::temp_directory_path() / "PandaAssetPrefetchManifestTest";
+    filesystem::create_directories(root / "Asset");
+    ofstream(root / "Asset" / "texture.bin", ios::binary) << string(8192, 'x');
+    ofstream(root / "Asset" / "shader.txt", ios::binary) << "void main() {}";
+
+    AssetArchiveWriter writer;
+    string text = "hello";
+    writer.AddFile("archived.txt", BufferView(nullptr, reinterpret_cast<const uint8_t*>(text.data()), text.size()), false);
+    writer.Write((root / "assets.pak").string().c_str());
+
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->Initialize();
+    g_pAssetLoader->AddSearchPath(root.string().c_str());
+    g_pAssetLoader->AddSearchPath((root / "assets.pak").string().c_str());
+
+    TestManifest(root);
+    TestRecording(root);
+
+    g_pAssetLoader->Finalize();
+    delete g_pAssetLoader;
+    g_pMemoryManager->Finalize();
+    delete g_pMemoryManager;
+
+    filesystem::remove_all(root);
+
+    if (g_Failures)
+    {
+        cerr << g_Failures << " check(s) failed" << endl;
+        return 1;
+    }
+
+    cout << "All prefetch manifest checks passed" << endl;
+    return 0;
+}
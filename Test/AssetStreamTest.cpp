@@ -0,0 +1,438 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <cstring>
+#include "MemoryManager.hpp"
+#include "AssetLoader.hpp"
+#include "AssetArchiveWriter.hpp"
+#include "Parser/PNG.hpp"
+#include "Parser/JPEG.hpp"
+
+using namespace std;
+using namespace Panda;
+
+namespace Panda
+{
+    Handness g_ViewHandness = Handness::kHandnessRight;
+    DepthClipSpace g_DepthClipSpace = DepthClipSpace::kDepthClipNegativeOneToOne;
+
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+}
+
+static int g_Failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        cerr << "FAILED: " << what << endl;
+        ++g_Failures;
+    }
+}
+
+static uint32_t g_Seed = 12345;
+
+static uint32_t Random()
+{
+    g_Seed = g_Seed * 1664525u + 1013904223u;
+    return g_Seed >> 8;
+}
+
+static void PutBigEndian(string& out, uint32_t value, size_t bytes)
+{
+    for (size_t i = bytes; i > 0; --i)
+        out += static_cast<char>((value >> ((i - 1) * 8)) & 0xFF);
+}
+
+static bool SameImage(const Image& a, const Image& b)
+{
+    return a.Data && b.Data && a.Width == b.Width && a.Height == b.Height && a.Pitch == b.Pitch
+        && a.DataSize == b.DataSize && memcmp(a.Data, b.Data, a.DataSize) == 0;
+}
+
+static void FreeImage(Image& image)
+{
+    if (image.Data)
+        g_pMemoryManager->Free(image.Data, image.DataSize);
+    image.Data = nullptr;
+}
+
+static void TestStream(const string& noise)
+{
+    Expect(g_pAssetLoader->OpenStream("missing.bin") == nullptr, "missing asset has no stream");
+
+    auto pStream = g_pAssetLoader->OpenStream("noise.bin", 4096);
+    Expect(pStream && pStream->GetSize() == noise.size(), "stream size");
+    if (!pStream)
+        return;
+
+    // chunks never cross the end of the ring
+    string content;
+    bool chunksFit = true;
+    const uint8_t* pData;
+    while (size_t size = pStream->ReadChunk(pData, 1000))
+    {
+        chunksFit = chunksFit && size <= 1000;
+        content.append(reinterpret_cast<const char*>(pData), size);
+    }
+    Expect(content == noise, "chunks add up to the file");
+    Expect(chunksFit, "chunks are no larger than asked for");
+    Expect(pStream->IsEnd() && !pStream->HasError(), "stream ends cleanly");
+    Expect(pStream->ReadChunk(pData) == 0, "no more chunks at the end");
+
+    pStream = g_pAssetLoader->OpenStream("noise.bin", 64);
+    char head[16];
+    Expect(pStream->Skip(10) == 10 && pStream->Read(head, sizeof(head)) == sizeof(head)
+        && memcmp(head, noise.data() + 10, sizeof(head)) == 0, "skip and read");
+    Expect(pStream->GetPosition() == 26, "position");
+
+    size_t size = pStream->ReadChunk(pData, 8);
+    pStream->Unread(size / 2);
+    const uint8_t* pAgain;
+    Expect(size > 0 && pStream->ReadChunk(pAgain, 1) == 1 && *pAgain == static_cast<uint8_t>(noise[26 + size - size / 2]),
+        "unread bytes are returned again");
+
+    // closing the stream stops the read-ahead with most of the file unread
+    pStream.reset();
+
+    // a stream over memory hands out the memory itself
+    AssetStream memory(BufferView(nullptr, reinterpret_cast<const uint8_t*>(noise.data()), noise.size()));
+    Expect(memory.ReadChunk(pData) == noise.size() && pData == reinterpret_cast<const uint8_t*>(noise.data()),
+        "memory stream does not copy");
+}
+
+static void TestArchiveStream(const filesystem::path& root)
+{
+    string text;
+    for (uint32_t i = 0; i < 1000; ++i)
+        text += "line " + to_string(i % 10) + "\n";
+
+    string path = (root / "stream.pak").string();
+    {
+        AssetArchiveWriter writer;
+        writer.AddFile("archived.txt", BufferView(nullptr, reinterpret_cast<const uint8_t*>(text.data()), text.size()), true);
+        Expect(writer.Write(path.c_str()), "archive is written");
+    }
+    Expect(g_pAssetLoader->AddSearchPath(path.c_str()), "archive mounts");
+
+    auto pStream = g_pAssetLoader->OpenStream("archived.txt");
+    string content(text.size(), '\0');
+    Expect(pStream && pStream->Read(&content[0], content.size()) == text.size() && content == text
+        && pStream->IsEnd(), "archived asset streams");
+
+    g_pAssetLoader->RemoveSearchPath(path.c_str());
+}
+
+// Sub, Up, Average and Paeth filters applied the way an encoder would
+static uint8_t FilterByte(uint8_t type, uint8_t x, uint8_t a, uint8_t b, uint8_t c)
+{
+    switch (type)
+    {
+        case 1: return x - a;
+        case 2: return x - b;
+        case 3: return x - (a + b) / 2;
+        case 4:
+        {
+            int p = a + b - c;
+            int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+            return x - ((pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c);
+        }
+        default: return x;
+    }
+}
+
+static void PutPngChunk(string& out, const char* type, const string& data)
+{
+    PutBigEndian(out, static_cast<uint32_t>(data.size()), 4);
+    string body = string(type, 4) + data;
+    out += body;
+    PutBigEndian(out, static_cast<uint32_t>(crc32(0L, reinterpret_cast<const Bytef*>(body.data()), static_cast<uInt>(body.size()))), 4);
+}
+
+// RGBA image with every filter type in use, the zlib stream split over many IDAT chunks
+static string MakePng(uint32_t width, uint32_t height, vector<uint8_t>& pixels)
+{
+    const uint32_t bpp = 4;
+    pixels.resize(width * height * bpp);
+    for (uint32_t y = 0; y < height; ++y)
+        for (uint32_t x = 0; x < width * bpp; ++x)
+            pixels[y * width * bpp + x] = static_cast<uint8_t>((x * 7 + y * 13) ^ (Random() & 0x0F));
+
+    string raw;
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        uint8_t type = y % 5;
+        raw += static_cast<char>(type);
+        for (uint32_t x = 0; x < width * bpp; ++x)
+        {
+            uint8_t a = x >= bpp ? pixels[y * width * bpp + x - bpp] : 0;
+            uint8_t b = y > 0 ? pixels[(y - 1) * width * bpp + x] : 0;
+            uint8_t c = (x >= bpp && y > 0) ? pixels[(y - 1) * width * bpp + x - bpp] : 0;
+            raw += static_cast<char>(FilterByte(type, pixels[y * width * bpp + x], a, b, c));
+        }
+    }
+
+    uLongf compressedSize = compressBound(static_cast<uLong>(raw.size()));
+    string compressed(compressedSize, '\0');
+    compress(reinterpret_cast<Bytef*>(&compressed[0]), &compressedSize, reinterpret_cast<const Bytef*>(raw.data()),
+        static_cast<uLong>(raw.size()));
+    compressed.resize(compressedSize);
+
+    string png = "\x89PNG\r\n\x1A\n";
+    string ihdr;
+    PutBigEndian(ihdr, width, 4);
+    PutBigEndian(ihdr, height, 4);
+    ihdr += string("\x08\x06\x00\x00\x00", 5);
+    PutPngChunk(png, "IHDR", ihdr);
+    PutPngChunk(png, "tEXt", string("Comment\0streamed", 16));
+    for (size_t offset = 0; offset < compressed.size(); offset += 97)
+        PutPngChunk(png, "IDAT", compressed.substr(offset, 97));
+    PutPngChunk(png, "IEND", string());
+
+    return png;
+}
+
+static void TestPng(const filesystem::path& root)
+{
+    const uint32_t width = 61;
+    const uint32_t height = 37;
+    vector<uint8_t> pixels;
+    ofstream(root / "Asset" / "streamed.png", ios::binary) << MakePng(width, height, pixels);
+
+    PngParser parser;
+    auto pStream = g_pAssetLoader->OpenStream("streamed.png", 64);
+    Image streamed = pStream ? parser.Parse(*pStream) : Image();
+
+    bool same = streamed.Data && streamed.Width == width && streamed.Height == height;
+    for (uint32_t y = 0; same && y < height; ++y)
+        same = memcmp(reinterpret_cast<uint8_t*>(streamed.Data) + y * streamed.Pitch, &pixels[y * width * 4], width * 4) == 0;
+    Expect(same, "png decodes through a small ring");
+
+    Buffer buf = g_pAssetLoader->SyncOpenAndReadBinary("streamed.png");
+    Image whole = parser.Parse(buf);
+    Expect(SameImage(streamed, whole), "png decodes the same from memory");
+
+    FreeImage(streamed);
+    FreeImage(whole);
+}
+
+class BitWriter
+{
+    public:
+        explicit BitWriter(string& out) : m_Out(out) {}
+
+        void Put(uint32_t bits, uint32_t count)
+        {
+            while (count--)
+            {
+                m_Byte = (m_Byte << 1) | ((bits >> count) & 1);
+                if (++m_Count == 8)
+                    Flush();
+            }
+        }
+
+        // pad with ones to the byte boundary
+        void Align()
+        {
+            while (m_Count)
+                Put(1, 1);
+        }
+
+        size_t m_StuffedBytes = 0;
+
+    private:
+        void Flush()
+        {
+            m_Out += static_cast<char>(m_Byte);
+            if (m_Byte == 0xFF)
+            {
+                m_Out += '\0';
+                ++m_StuffedBytes;
+            }
+            m_Byte = 0;
+            m_Count = 0;
+        }
+
+        string& m_Out;
+        uint32_t m_Byte = 0;
+        uint32_t m_Count = 0;
+};
+
+/**
+ * Baseline JPEG with three components and no subsampling. The blocks only
+ * carry DC values, but the AC run lengths vary, so the scan has stuffed bytes
+ * and restart markers in awkward places. Returns the luma DC of the first block.
+ */
+static string MakeJpeg(uint16_t width, uint16_t height, uint16_t restartInterval, size_t& stuffedBytes, int32_t& firstDc)
+{
+    string jpeg = "\xFF\xD8";
+
+    // quantization table of ones
+    jpeg += "\xFF\xDB";
+    PutBigEndian(jpeg, 67, 2);
+    jpeg += '\0';
+    jpeg += string(64, '\x01');
+
+    jpeg += "\xFF\xC0";
+    PutBigEndian(jpeg, 17, 2);
+    jpeg += '\x08';
+    PutBigEndian(jpeg, height, 2);
+    PutBigEndian(jpeg, width, 2);
+    jpeg += '\x03';
+    for (char id = 1; id <= 3; ++id)
+        jpeg += string(1, id) + "\x11" + string(1, '\0');
+
+    // DC: "0" no change, "1" a 4 bit difference; AC: "0" end of block, "1" a run of 16 zeros
+    jpeg += "\xFF\xC4";
+    PutBigEndian(jpeg, 21, 2);
+    jpeg += '\x00';
+    jpeg += '\x02' + string(15, '\0');
+    jpeg += string("\x00\x04", 2);
+    jpeg += "\xFF\xC4";
+    PutBigEndian(jpeg, 21, 2);
+    jpeg += '\x10';
+    jpeg += '\x02' + string(15, '\0');
+    jpeg += string("\x00\xF0", 2);
+
+    jpeg += "\xFF\xDD";
+    PutBigEndian(jpeg, 4, 2);
+    PutBigEndian(jpeg, restartInterval, 2);
+
+    jpeg += "\xFF\xDA";
+    PutBigEndian(jpeg, 12, 2);
+    jpeg += '\x03';
+    for (char id = 1; id <= 3; ++id)
+        jpeg += string(1, id) + string(1, '\0');
+    jpeg += string("\x00\x3F\x00", 3);
+
+    BitWriter writer(jpeg);
+    uint32_t mcuCount = ((width + 7) / 8) * ((height + 7) / 8);
+    int32_t predictor[3] = {0, 0, 0};
+    firstDc = 0;
+    for (uint32_t mcu = 0; mcu < mcuCount; ++mcu)
+    {
+        if (mcu && mcu % restartInterval == 0)
+        {
+            writer.Align();
+            jpeg += '\xFF';
+            jpeg += static_cast<char>(0xD0 + (mcu / restartInterval - 1) % 8);
+            memset(predictor, 0, sizeof(predictor));
+        }
+
+        for (int32_t i = 0; i < 3; ++i)
+        {
+            // luma wanders about, the chroma stays near the middle and is gray in the first block
+            int32_t diff = 0;
+            if (Random() % 4 && (mcu || i == 0))
+            {
+                diff = 8 + Random() % 8;
+                int32_t limit = i == 0 ? 600 : 40;
+                if ((Random() % 2 && predictor[i] - diff >= -limit) || predictor[i] + diff > limit)
+                    diff = -diff;
+            }
+            predictor[i] += diff;
+            if (mcu == 0 && i == 0)
+                firstDc = predictor[i];
+
+            if (diff == 0)
+                writer.Put(0, 1);
+            else
+            {
+                writer.Put(1, 1);
+                writer.Put(diff > 0 ? diff : (diff - 1) & 0x0F, 4);
+            }
+
+            uint32_t runs = Random() % 4;
+            writer.Put((1u << runs) - 1, runs);
+            writer.Put(0, 1);
+        }
+    }
+    writer.Align();
+    jpeg += "\xFF\xD9";
+
+    stuffedBytes = writer.m_StuffedBytes;
+    return jpeg;
+}
+
+static void TestJpeg(const filesystem::path& root)
+{
+    // the scan is larger than the decoder's window
+    const uint16_t width = 2048;
+    const uint16_t height = 1024;
+    size_t stuffedBytes;
+    int32_t firstDc;
+    string jpeg = MakeJpeg(width, height, 100, stuffedBytes, firstDc);
+    ofstream(root / "Asset" / "streamed.jpg", ios::binary) << jpeg;
+    Expect(stuffedBytes > 0, "test scan has stuffed bytes");
+    Expect(jpeg.size() > 64 * 1024, "test scan is larger than the window");
+
+    JfifParser streamParser;
+    auto pStream = g_pAssetLoader->OpenStream("streamed.jpg", 64);
+    Image streamed = pStream ? streamParser.Parse(*pStream) : Image();
+    Expect(streamed.Data && streamed.Width == width && streamed.Height == height, "jpeg decodes through a small ring");
+
+    JfifParser wholeParser;
+    Buffer buf = g_pAssetLoader->SyncOpenAndReadBinary("streamed.jpg");
+    Image whole = wholeParser.Parse(buf);
+    Expect(SameImage(streamed, whole), "jpeg decodes the same from memory");
+
+    if (streamed.Data)
+    {
+        // DC only blocks are flat, luma is 128 + DC / 8 with a table of ones
+        const uint8_t* pFirst = reinterpret_cast<const uint8_t*>(streamed.Data);
+        int32_t expected = 128 + firstDc / 8;
+        Expect(abs(pFirst[0] - expected) <= 1, "first block has the right value");
+
+        bool flat = true;
+        for (uint32_t y = 0; flat && y < height; ++y)
+            for (uint32_t x = 0; flat && x < width; ++x)
+            {
+                const uint8_t* pPixel = pFirst + y * streamed.Pitch + x * 4;
+                const uint8_t* pCorner = pFirst + (y & ~7u) * streamed.Pitch + (x & ~7u) * 4;
+                flat = abs(pPixel[0] - pCorner[0]) <= 1;
+            }
+        Expect(flat, "blocks are flat");
+    }
+
+    FreeImage(streamed);
+    FreeImage(whole);
+}
+
+int main(int argc, char** argv)
+{
+    filesystem::path root = filesystem::temp_directory_path() / "PandaAssetStreamTest";
+    filesystem::create_directories(root / "Asset");
+
+    string noise;
+    for (uint32_t i = 0; i < 100000; ++i)
+        noise += static_cast<char>(Random());
+    ofstream(root / "Asset" / "noise.bin", ios::binary) << noise;
+
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->Initialize();
+    g_pAssetLoader->AddSearchPath(root.string().c_str());
+
+    TestStream(noise);
+    TestArchiveStream(root);
+    TestPng(root);
+    TestJpeg(root);
+
+    g_pAssetLoader->Finalize();
+    delete g_pAssetLoader;
+    g_pMemoryManager->Finalize();
+    delete g_pMemoryManager;
+
+    filesystem::remove_all(root);
+
+    if (g_Failures)
+    {
+        cerr << g_Failures << " check(s) failed" << endl;
+        return 1;
+    }
+
+    cout << "All asset stream checks passed" << endl;
+    return 0;
+}
@@ -0,0 +1,177 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include "MemoryManager.hpp"
+#include "AssetLoader.hpp"
+
+using namespace std;
+using namespace Panda;
+
+namespace Panda
+{
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+}
+
+static int g_Failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        cerr << "FAILED: " << what << endl;
+        ++g_Failures;
+    }
+}
+
+static string FileName(uint32_t i)
+{
+    return "async_" + to_string(i) + ".bin";
+}
+
+// every file holds its own index repeated, so a mixed up buffer is noticed
+static bool CheckContent(uint32_t i, const Buffer& buffer)
+{
+    if (buffer.GetDataSize() != 1000 + i * 10)
+        return false;
+    for (size_t j = 0; j < buffer.GetDataSize(); ++j)
+    {
+        if (buffer.GetData()[j] != static_cast<uint8_t>(i))
+            return false;
+    }
+    return true;
+}
+
+static void WaitForPending()
+{
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(10);
+    while (g_pAssetLoader->GetPendingAsyncCount() && chrono::steady_clock::now() < deadline)
+    {
+        g_pAssetLoader->Tick();
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+}
+
+static void TestCallbacks(uint32_t fileCount)
+{
+    vector<int> delivered(fileCount, 0);
+    uint32_t correct = 0;
+    thread::id mainThread = this_thread::get_id();
+    bool onMainThread = true;
+
+    for (uint32_t i = 0; i < fileCount; ++i)
+    {
+        AssetLoader::AssetLoadPriority priority = (i % 3 == 0) ? AssetLoader::PANDA_LOAD_PRIORITY_HIGH
+                                                                : AssetLoader::PANDA_LOAD_PRIORITY_LOW;
+        g_pAssetLoader->AsyncOpenAndRead(FileName(i).c_str(), priority,
+            [&, i](const string& name, Buffer& buffer) {
+                ++delivered[i];
+                onMainThread = onMainThread && this_thread::get_id() == mainThread;
+                if (name == FileName(i) && CheckContent(i, buffer))
+                    ++correct;
+            });
+    }
+
+    // nothing is delivered before Tick()
+    this_thread::sleep_for(chrono::milliseconds(50));
+    uint32_t early = 0;
+    for (int count : delivered)
+        early += count;
+    Expect(early == 0, "callbacks wait for Tick");
+
+    WaitForPending();
+    Expect(g_pAssetLoader->GetPendingAsyncCount() == 0, "pending count drains");
+    Expect(correct == fileCount, "callbacks get the right content");
+    Expect(onMainThread, "callbacks run on the ticking thread");
+
+    bool once = true;
+    for (int count : delivered)
+        once = once && count == 1;
+    Expect(once, "each callback runs once");
+}
+
+static void TestFutures(uint32_t fileCount)
+{
+    vector<future<Buffer>> futures;
+    for (uint32_t i = 0; i < fileCount; ++i)
+        futures.push_back(g_pAssetLoader->AsyncOpenAndRead(FileName(i).c_str()));
+
+    // futures do not need Tick()
+    bool allCorrect = true;
+    for (uint32_t i = 0; i < fileCount; ++i)
+    {
+        Buffer buffer = futures[i].get();
+        allCorrect = allCorrect && CheckContent(i, buffer);
+    }
+    Expect(allCorrect, "futures get the right content");
+    Expect(g_pAssetLoader->GetPendingAsyncCount() == 0, "no future left pending");
+}
+
+static void TestMissingFile()
+{
+    Buffer missing = g_pAssetLoader->AsyncOpenAndRead("async_missing.bin").get();
+    Expect(missing.GetDataSize() == 0, "missing file gives an empty buffer");
+
+    bool called = false;
+    g_pAssetLoader->AsyncOpenAndRead("async_missing.bin", AssetLoader::PANDA_LOAD_PRIORITY_NORMAL,
+        [&](const string&, Buffer& buffer) {
+            called = true;
+            Expect(buffer.GetDataSize() == 0, "missing file callback gets an empty buffer");
+        });
+    WaitForPending();
+    Expect(called, "missing file callback still runs");
+}
+
+static void TestChainedRead()
+{
+    // a callback may queue the next read, it is delivered on a later Tick()
+    bool second = false;
+    g_pAssetLoader->AsyncOpenAndRead(FileName(0).c_str(), AssetLoader::PANDA_LOAD_PRIORITY_NORMAL,
+        [&](const string&, Buffer&) {
+            g_pAssetLoader->AsyncOpenAndRead(FileName(1).c_str(), AssetLoader::PANDA_LOAD_PRIORITY_NORMAL,
+                [&](const string&, Buffer& buffer) { second = CheckContent(1, buffer); });
+        });
+    WaitForPending();
+    Expect(second, "read queued from a callback");
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t fileCount = 64;
+    filesystem::path root = filesystem::temp_directory_path() / "PandaAsyncAssetLoaderTest";
+    filesystem::create_directories(root / "Asset");
+    for (uint32_t i = 0; i < fileCount; ++i)
+    {
+        ofstream file(root / "Asset" / FileName(i), ios::binary);
+        file << string(1000 + i * 10, static_cast<char>(i));
+    }
+
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->Initialize();
+    g_pAssetLoader->AddSearchPath(root.string().c_str());
+
+    TestCallbacks(fileCount);
+    TestFutures(fileCount);
+    TestMissingFile();
+    TestChainedRead();
+
+    g_pAssetLoader->Finalize();
+    delete g_pAssetLoader;
+    g_pMemoryManager->Finalize();
+    delete g_pMemoryManager;
+
+    filesystem::remove_all(root);
+
+    if (g_Failures)
+    {
+        cerr << g_Failures << " check(s) failed" << endl;
+        return 1;
+    }
+
+    cout << "All async asset loader checks passed" << endl;
+    return 0;
+}
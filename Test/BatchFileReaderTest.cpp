@@ -0,0 +1,175 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <atomic>
+#include "MemoryManager.hpp"
+#include "AssetLoader.hpp"
+#include "BatchFileReader.hpp"
+
+using namespace std;
+using namespace Panda;
+
+namespace Panda
+{
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+}
+
+static int g_Failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        cerr << "FAILED: " << what << endl;
+        ++g_Failures;
+    }
+}
+
+static const size_t k_FileCount = 100;
+
+// file i is i * 997 bytes long, so there are empty, small and multi-page files
+static string FileContent(size_t i)
+{
+    string content(i * 997, '\0');
+    for (size_t j = 0; j < content.size(); ++j)
+        content[j] = static_cast<char>((i * 31 + j * 7) & 0xFF);
+    return content;
+}
+
+static string FileName(size_t i)
+{
+    return "batch_" + to_string(i) + ".bin";
+}
+
+static void TestReader(const filesystem::path& dir, BatchFileReader::Backend backend)
+{
+    // a small queue, so the ring has to be refilled while reads complete
+    BatchFileReader reader(backend, 8);
+    if (backend == BatchFileReader::PANDA_BATCH_THREADS)
+        Expect(reader.GetBackend() == BatchFileReader::PANDA_BATCH_THREADS, "thread backend is used when asked for");
+    cout << "Backend: " << (reader.GetBackend() == BatchFileReader::PANDA_BATCH_IO_URING ? "io_uring" : "threads") << endl;
+
+    vector<string> contents;
+    vector<vector<uint8_t>> buffers(k_FileCount);
+    vector<BatchFileRead> reads;
+    for (size_t i = 0; i < k_FileCount; ++i)
+    {
+        contents.push_back(FileContent(i));
+        FILE* fp = fopen((dir / FileName(i)).string().c_str(), "rb");
+        buffers[i].resize(contents[i].size());
+        reads.push_back({fp, buffers[i].data(), buffers[i].size(), 0, false});
+    }
+
+    // a file that is shorter than the caller expected
+    buffers.emplace_back(2048);
+    reads.push_back({fopen((dir / FileName(1)).string().c_str(), "rb"), buffers.back().data(), 2048, 0, false});
+
+    vector<atomic<int>> callbacks(reads.size());
+    size_t whole = reader.ReadAll(reads, [&callbacks](size_t index) { ++callbacks[index]; });
+    Expect(whole == k_FileCount, "every file is read whole");
+
+    bool allCalled = true;
+    for (auto& count : callbacks)
+        allCalled = allCalled && count == 1;
+    Expect(allCalled, "each read reports completion once");
+
+    bool allMatch = true;
+    for (size_t i = 0; i < k_FileCount; ++i)
+    {
+        allMatch = allMatch && !reads[i].Failed && reads[i].BytesRead == contents[i].size()
+            && equal(contents[i].begin(), contents[i].end(), buffers[i].begin(),
+                [](char a, uint8_t b) { return static_cast<uint8_t>(a) == b; });
+    }
+    Expect(allMatch, "file content");
+    Expect(!reads.back().Failed && reads.back().BytesRead == 997, "short file ends early without failing");
+
+    // the reader can be used for another batch
+    vector<BatchFileRead> again(reads.begin(), reads.begin() + 2);
+    Expect(reader.ReadAll(again) == 2 && again[1].BytesRead == 997, "second batch");
+
+    for (auto& read : reads)
+        fclose(read.pFile);
+}
+
+static void TestLoader()
+{
+    vector<string> names;
+    for (size_t i = 0; i < k_FileCount; ++i)
+        names.push_back(FileName(i));
+    names.push_back("missing.bin");
+
+    vector<Buffer> buffers = g_pAssetLoader->SyncOpenAndReadBatch(names);
+    Expect(buffers.size() == names.size(), "one buffer per name");
+    bool allMatch = true;
+    for (size_t i = 0; i < k_FileCount; ++i)
+    {
+        string content = FileContent(i);
+        allMatch = allMatch && buffers[i].GetDataSize() == content.size()
+            && (content.empty() || memcmp(buffers[i].GetData(), content.data(), content.size()) == 0);
+    }
+    Expect(allMatch, "batch read content");
+    Expect(buffers.back().GetDataSize() == 0, "missing file gives an empty buffer");
+
+    vector<Buffer> texts = g_pAssetLoader->SyncOpenAndReadBatch({"shader.txt", "batch_3.bin"}, AssetLoader::PANDA_OPEN_TEXT);
+    Expect(texts[0].GetDataSize() == 15 && string(reinterpret_cast<const char*>(texts[0].GetData())) == "void main() {}",
+        "text is terminated");
+    Expect(texts[1].GetDataSize() == 3 * 997 + 1, "text buffer has room for the terminator");
+
+    vector<future<Buffer>> futures = g_pAssetLoader->AsyncOpenAndReadBatch(names, AssetLoader::PANDA_LOAD_PRIORITY_HIGH);
+    allMatch = futures.size() == names.size();
+    for (size_t i = 0; i < k_FileCount && allMatch; ++i)
+    {
+        Buffer buffer = futures[i].get();
+        string content = FileContent(i);
+        allMatch = buffer.GetDataSize() == content.size()
+            && (content.empty() || memcmp(buffer.GetData(), content.data(), content.size()) == 0);
+    }
+    Expect(allMatch, "asynchronous batch content");
+    Expect(futures.back().get().GetDataSize() == 0, "missing file in an asynchronous batch");
+
+    // the cache reads the prefetched batch and skips what it has
+    AssetCache& cache = g_pAssetLoader->GetCache();
+    auto pFirst = cache.LoadBuffer("batch_5.bin");
+    cache.Prefetch(vector<string>{"batch_5.bin", "batch_6.bin", "batch_7.bin", "batch_6.bin"});
+    auto pSecond = cache.LoadBuffer("batch_6.bin");
+    auto pThird = cache.LoadBuffer("batch_7.bin");
+    Expect(pFirst && pSecond && pThird && pThird->GetDataSize() == 7 * 997, "prefetched batch is picked up");
+    Expect(cache.GetMissCount() == 3 && cache.GetHitCount() == 0, "each file is read once");
+    cache.Clear();
+}
+
+int main(int argc, char** argv)
+{
+    filesystem::path root = filesystem::temp_directory_path() / "PandaBatchFileReaderTest";
+    filesystem::create_directories(root / "Asset");
+    for (size_t i = 0; i < k_FileCount; ++i)
+        ofstream(root / "Asset" / FileName(i), ios::binary) << FileContent(i);
+    ofstream(root / "Asset" / "shader.txt", ios::binary) << "void main() {}";
+
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->Initialize();
+    g_pAssetLoader->AddSearchPath(root.string().c_str());
+
+    TestReader(root / "Asset", BatchFileReader::PANDA_BATCH_THREADS);
+    TestReader(root / "Asset", BatchFileReader::PANDA_BATCH_IO_URING);
+    TestLoader();
+
+    g_pAssetLoader->Finalize();
+    delete g_pAssetLoader;
+    g_pMemoryManager->Finalize();
+    delete g_pMemoryManager;
+
+    filesystem::remove_all(root);
+
+    if (g_Failures)
+    {
+        cerr << g_Failures << " check(s) failed" << endl;
+        return 1;
+    }
+
+    cout << "All batch read checks passed" << endl;
+    return 0;
+}
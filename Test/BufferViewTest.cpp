@@ -0,0 +1,68 @@
+#include <iostream>
+#include <string>
+#include "AssetLoader.hpp"
+#include "MemoryManager.hpp"
+#include "BufferView.hpp"
+
+using namespace std;
+using namespace Panda;
+
+namespace Panda
+{
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+}
+
+static bool Check(bool condition, const char* what)
+{
+    cout << (condition ? "[ OK ] " : "[FAIL] ") << what << endl;
+    return condition;
+}
+
+int main (int argc, char** argv)
+{
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->Initialize();
+
+    bool passed = true;
+    {
+        Buffer buf(256);
+        for (size_t i = 0; i < buf.GetDataSize(); ++i)
+            buf.GetData()[i] = static_cast<uint8_t>(i);
+        const uint8_t* pPayload = buf.GetData();
+
+        // borrowing view of an lvalue
+        BufferView borrowed(buf);
+        passed &= Check(borrowed.GetData() == pPayload && !borrowed.IsShared(), "borrowed view points at the buffer");
+
+        // owning view of an rvalue, the payload moves without a copy
+        BufferView whole(std::move(buf));
+        passed &= Check(whole.GetData() == pPayload && whole.IsShared(), "owning view takes over the payload");
+
+        BufferView slice = whole.Slice(16, 32);
+        passed &= Check(slice.GetData() == pPayload + 16 && slice.GetDataSize() == 32 && slice.GetData()[0] == 16, "slice shares the payload");
+
+        BufferView nested = slice.Slice(8);
+        passed &= Check(nested.GetData() == pPayload + 24 && nested.GetDataSize() == 24, "slice of a slice");
+
+        BufferView clamped = whole.Slice(250, 100);
+        passed &= Check(clamped.GetDataSize() == 6 && whole.Slice(1000).IsEmpty(), "slices are clamped to the view");
+
+        // the slice keeps the payload alive after the other views are gone
+        whole = BufferView();
+        passed &= Check(nested.GetData()[0] == 24, "slice outlives the original view");
+    }
+
+    {
+        BufferView file = g_pAssetLoader->SyncOpenAndReadBinary("Shaders/copy.vs");
+        passed &= Check(!file.IsEmpty() && file.IsShared(), "loaded file moved into a view");
+    }
+
+    g_pAssetLoader->Finalize();
+    delete g_pAssetLoader;
+
+    g_pMemoryManager->Finalize();
+    delete g_pMemoryManager;
+
+    return passed ? 0 : 1;
+}
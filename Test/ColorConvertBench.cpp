@@ -0,0 +1,210 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "HighPrecisionTimer.hpp"
+#include "ColorSpaceConversion.hpp"
+
+using namespace std;
+using namespace Panda;
+
+/*
+ * YCbCr to RGBA benchmark, the row converter against ConvertYCbCr2RGB one
+ * pixel at a time, for full resolution and subsampled chroma.
+ *
+ *   ColorConvertBench [--size WxH]
+ *
+ * The converter is checked against a float reference first, a failure is
+ * reported with a non zero exit code.
+ */
+
+namespace Panda
+{
+    Handness g_ViewHandness = Handness::kHandnessRight;
+    DepthClipSpace g_DepthClipSpace = DepthClipSpace::kDepthClipNegativeOneToOne;
+}
+
+static int g_Failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        cerr << "FAILED: " << what << endl;
+        ++g_Failures;
+    }
+}
+
+static uint32_t XorShift(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+struct Plane
+{
+    uint32_t Width;
+    uint32_t Height;
+    vector<uint8_t> Samples;
+
+    uint8_t At(int32_t x, int32_t y) const
+    {
+        x = min(max(x, 0), static_cast<int32_t>(Width) - 1);
+        y = min(max(y, 0), static_cast<int32_t>(Height) - 1);
+        return Samples[static_cast<size_t>(y) * Width + x];
+    }
+};
+
+// smooth ramps with noise on top, as a decoded photo has them
+static Plane MakePlane(uint32_t width, uint32_t height, uint32_t seed)
+{
+    Plane plane = {width, height, vector<uint8_t>(static_cast<size_t>(width) * height)};
+    uint32_t state = seed;
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            int32_t value = static_cast<int32_t>((x * 255 / width + y * 255 / height) / 2) + static_cast<int32_t>(XorShift(state) % 33) - 16;
+            plane.Samples[static_cast<size_t>(y) * width + x] = static_cast<uint8_t>(min(max(value, 0), 255));
+        }
+    }
+    return plane;
+}
+
+// the triangle filter written out, 3/4 of the nearest sample and 1/4 of the next one in either direction
+static float UpsampleReference(const Plane& plane, uint32_t x, uint32_t y, uint32_t shiftX, uint32_t shiftY)
+{
+    int32_t nearX = x >> shiftX;
+    int32_t nearY = y >> shiftY;
+    int32_t otherX = shiftX ? nearX + ((x & 1) ? 1 : -1) : nearX;
+    int32_t otherY = shiftY ? nearY + ((y & 1) ? 1 : -1) : nearY;
+
+    int32_t column = 3 * plane.At(nearX, nearY) + plane.At(nearX, otherY);
+    int32_t other = 3 * plane.At(otherX, nearY) + plane.At(otherX, otherY);
+    if (!shiftX)
+        return static_cast<float>((4 * column + 8) >> 4);
+    return static_cast<float>((3 * column + other + ((x & 1) ? 7 : 8)) >> 4);
+}
+
+static void RunCase(const char* name, uint32_t width, uint32_t height, uint32_t shiftX, uint32_t shiftY, bool isGray)
+{
+    Plane y = MakePlane(width, height, 0x9E3779B9);
+    Plane cb = MakePlane((width + shiftX) >> shiftX, (height + shiftY) >> shiftY, 0x2545F491);
+    Plane cr = MakePlane((width + shiftX) >> shiftX, (height + shiftY) >> shiftY, 0x6A09E667);
+
+    YCbCrPlanes planes;
+    planes.Y = y.Samples.data();
+    planes.Cb = isGray ? nullptr : cb.Samples.data();
+    planes.Cr = isGray ? nullptr : cr.Samples.data();
+    planes.LumaPitch = width;
+    planes.ChromaPitch = cb.Width;
+    planes.Width = width;
+    planes.Height = height;
+    planes.ChromaShiftX = shiftX;
+    planes.ChromaShiftY = shiftY;
+
+    vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    Image img;
+    img.Width = width;
+    img.Height = height;
+    img.BitCount = 32;
+    img.Pitch = width * 4;
+    img.DataSize = pixels.size();
+    img.Data = pixels.data();
+
+    // in two ranges of rows, as two threads would convert them
+    ConvertYCbCr2RGBA(planes, 0, height / 3, img);
+    ConvertYCbCr2RGBA(planes, height / 3, height, img);
+
+    int32_t maxError = 0;
+    bool isOpaque = true;
+    for (uint32_t row = 0; row < height; ++row)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            YCbCrf ycbcr({static_cast<float>(y.At(x, row)), 128.0f, 128.0f});
+            if (!isGray)
+            {
+                ycbcr.data[1] = UpsampleReference(cb, x, row, shiftX, shiftY);
+                ycbcr.data[2] = UpsampleReference(cr, x, row, shiftX, shiftY);
+            }
+            RGBf rgb = ConvertYCbCr2RGB(ycbcr);
+
+            const uint8_t* pPixel = &pixels[(static_cast<size_t>(row) * width + x) * 4];
+            for (int32_t c = 0; c < 3; ++c)
+                maxError = max(maxError, abs(static_cast<int32_t>(pPixel[c]) - static_cast<int32_t>(rgb[c])));
+            isOpaque = isOpaque && pPixel[3] == 255;
+        }
+    }
+    Expect(maxError <= 1, "the converter is within 1 of the float reference");
+    Expect(isOpaque, "alpha is 255");
+
+    if (g_Failures)
+        return;
+
+    HighPrecisionTimer timer;
+    timer.Start();
+    ConvertYCbCr2RGBA(planes, 0, height, img);
+    timer.Stop();
+    double convertMs = timer.TotalTime();
+
+    // what JfifParser did for every pixel before, chroma repeated rather than interpolated
+    timer.Start();
+    for (uint32_t row = 0; row < height; ++row)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            YCbCrf ycbcr({static_cast<float>(y.At(x, row)), 128.0f, 128.0f});
+            if (!isGray)
+            {
+                ycbcr.data[1] = cb.At(x >> shiftX, row >> shiftY);
+                ycbcr.data[2] = cr.At(x >> shiftX, row >> shiftY);
+            }
+            RGBf rgb = ConvertYCbCr2RGB(ycbcr);
+            uint8_t* pPixel = &pixels[(static_cast<size_t>(row) * width + x) * 4];
+            pPixel[0] = static_cast<uint8_t>(rgb[0]);
+            pPixel[1] = static_cast<uint8_t>(rgb[1]);
+            pPixel[2] = static_cast<uint8_t>(rgb[2]);
+            pPixel[3] = 255;
+        }
+    }
+    timer.Stop();
+    double perPixelMs = timer.TotalTime();
+
+    printf("%-8s %5ux%-5u %12.2f %12.2f %9.1fx %10d\n", name, width, height, perPixelMs, convertMs, perPixelMs / convertMs, maxError);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t width = 1920;
+    uint32_t height = 1080;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--size") == 0 && i + 1 < argc && sscanf(argv[++i], "%ux%u", &width, &height) == 2 && width && height)
+            continue;
+
+        cerr << "Usage: ColorConvertBench [--size WxH]" << endl;
+        return 1;
+    }
+
+    printf("%-8s %11s %12s %12s %10s %10s\n", "Chroma", "Size", "Pixel ms", "Row ms", "Speedup", "Max error");
+    RunCase("4:4:4", width, height, 0, 0, false);
+    RunCase("4:2:2", width, height, 1, 0, false);
+    RunCase("4:2:0", width, height, 1, 1, false);
+    RunCase("4:4:0", width, height, 0, 1, false);
+    RunCase("gray", width, height, 0, 0, true);
+    // odd sizes end in a partial group of 8 and a chroma sample of its own
+    RunCase("4:2:0", 37, 23, 1, 1, false);
+    RunCase("4:2:2", 1, 3, 1, 0, false);
+
+    if (g_Failures)
+    {
+        cerr << g_Failures << " check(s) failed" << endl;
+        return 1;
+    }
+
+    return 0;
+}
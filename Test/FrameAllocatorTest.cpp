@@ -0,0 +1,94 @@
+#include <iostream>
+#include <cstdint>
+#include <new>
+#include "FrameAllocator.hpp"
+
+using namespace std;
+using namespace Panda;
+
+namespace Panda
+{
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+}
+
+static int g_Failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        cerr << "FAILED: " << what << endl;
+        ++g_Failures;
+    }
+}
+
+// a FrameVector has no arena to grow into, push_back must throw rather than write through nullptr
+static bool PushBackThrows()
+{
+    try
+    {
+        FrameVector<uint32_t> values;
+        values.push_back(1);
+    }
+    catch (const bad_alloc&)
+    {
+        return true;
+    }
+    return false;
+}
+
+int main(int, char**)
+{
+    Expect(PushBackThrows(), "allocating before Initialize() throws bad_alloc");
+
+    g_pMemoryManager->Initialize();
+
+    {
+        FrameVector<uint64_t> values;
+        for (uint64_t i = 0; i < 4096; ++i)
+            values.push_back(i * i);
+
+        bool intact = true;
+        for (uint64_t i = 0; i < values.size(); ++i)
+            intact = intact && values[i] == i * i;
+        Expect(values.size() == 4096 && intact, "a FrameVector keeps its contents while it grows");
+        Expect(reinterpret_cast<uintptr_t>(values.data()) % alignof(uint64_t) == 0, "frame allocations are aligned");
+
+        // the previous frame's data is still valid after one Tick()
+        g_pMemoryManager->Tick();
+        Expect(values[4095] == 4095ull * 4095ull, "frame memory survives the next Tick()");
+
+        values.clear();
+        values.shrink_to_fit();
+    }
+
+    FrameAllocator<uint32_t> allocator;
+    bool tooLargeThrows = false;
+    try
+    {
+        allocator.allocate(static_cast<size_t>(-1) / 2);
+    }
+    catch (const bad_alloc&)
+    {
+        tooLargeThrows = true;
+    }
+    Expect(tooLargeThrows, "a size that overflows throws bad_alloc");
+
+    g_pMemoryManager->Finalize();
+
+    Expect(PushBackThrows(), "allocating after Finalize() throws bad_alloc");
+
+    delete g_pMemoryManager;
+    g_pMemoryManager = nullptr;
+
+    Expect(PushBackThrows(), "allocating without a MemoryManager throws bad_alloc");
+
+    if (g_Failures)
+    {
+        cerr << g_Failures << " check(s) failed" << endl;
+        return 1;
+    }
+
+    cout << "All FrameAllocator checks passed" << endl;
+    return 0;
+}
@@ -0,0 +1,216 @@
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "HighPrecisionTimer.hpp"
+#include "Math/HuffmanTree.hpp"
+
+using namespace std;
+using namespace Panda;
+
+/*
+ * Huffman decoding benchmark, HuffmanTable against the HuffmanTree walk,
+ * on the typical tables of ITU-T81 Annex K.3.
+ *
+ *   HuffmanBench [--symbols N]
+ *
+ * Both decoders are checked to return the same symbols first, so a failure
+ * is reported with a non zero exit code.
+ */
+
+static int g_Failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        cerr << "FAILED: " << what << endl;
+        ++g_Failures;
+    }
+}
+
+static uint32_t XorShift(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+struct DhtTable
+{
+    const char* Name;
+    uint8_t NumOfCodes[16];
+    vector<uint8_t> Values;
+};
+
+static DhtTable LuminanceDcTable()
+{
+    DhtTable table = {"luminance DC", {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0}, {}};
+    for (uint8_t i = 0; i < 12; ++i)
+        table.Values.push_back(i);
+    return table;
+}
+
+static DhtTable LuminanceAcTable()
+{
+    DhtTable table = {"luminance AC", {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d}, {}};
+    table.Values = {
+        0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+        0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+        0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+        0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a
+    };
+    // the rest are runs of 0 to 15 zeros followed by every size the code has not had yet
+    const uint8_t firstSize[] = {0x43, 0x53, 0x63, 0x73, 0x83, 0x92, 0xa2, 0xb2, 0xc2, 0xd2, 0xe1, 0xf1};
+    for (uint8_t first : firstSize)
+    {
+        for (uint8_t value = first; (value & 0x0F) <= 0x0A && (value & 0x0F) != 0; ++value)
+            table.Values.push_back(value);
+    }
+    return table;
+}
+
+struct EncodedStream
+{
+    vector<uint8_t> Data;
+    vector<uint8_t> Symbols;
+};
+
+// symbols drawn as often as random bits would decode them, 2^-length, padded with 1 bits as in a scan
+static EncodedStream Encode(const DhtTable& table, size_t symbolCount)
+{
+    vector<uint32_t> codes, lengths, weights;
+    uint32_t code = 0, total = 0;
+    for (uint32_t length = 1; length <= 16; ++length)
+    {
+        for (uint8_t i = 0; i < table.NumOfCodes[length - 1]; ++i)
+        {
+            codes.push_back(code++);
+            lengths.push_back(length);
+            total += 1u << (16 - length);
+            weights.push_back(total);
+        }
+        code <<= 1;
+    }
+
+    EncodedStream stream;
+    uint32_t state = 0x2545F491;
+    uint64_t bits = 0;
+    uint32_t bitCount = 0;
+    for (size_t n = 0; n < symbolCount; ++n)
+    {
+        size_t index = upper_bound(weights.begin(), weights.end(), XorShift(state) % total) - weights.begin();
+        stream.Symbols.push_back(table.Values[index]);
+        bits = (bits << lengths[index]) | codes[index];
+        bitCount += lengths[index];
+        while (bitCount >= 8)
+        {
+            bitCount -= 8;
+            stream.Data.push_back(static_cast<uint8_t>(bits >> bitCount));
+        }
+    }
+    if (bitCount)
+        stream.Data.push_back(static_cast<uint8_t>((bits << (8 - bitCount)) | ((1u << (8 - bitCount)) - 1)));
+
+    return stream;
+}
+
+template<typename Decoder>
+static vector<uint8_t> DecodeAll(Decoder& decoder, const EncodedStream& stream, size_t symbolCount)
+{
+    vector<uint8_t> symbols;
+    symbols.reserve(symbolCount);
+    size_t byteOffset = 0;
+    uint8_t bitOffset = 0;
+    for (size_t n = 0; n < symbolCount && byteOffset < stream.Data.size(); ++n)
+        symbols.push_back(decoder.DecodeSingleValue(stream.Data.data(), stream.Data.size(), &byteOffset, &bitOffset));
+    return symbols;
+}
+
+template<typename Decoder>
+static double NsPerSymbol(Decoder& decoder, const EncodedStream& stream, int passes)
+{
+    HighPrecisionTimer timer;
+    uint32_t checksum = 0;
+    timer.Start();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        size_t byteOffset = 0;
+        uint8_t bitOffset = 0;
+        for (size_t n = 0; n < stream.Symbols.size(); ++n)
+            checksum += decoder.DecodeSingleValue(stream.Data.data(), stream.Data.size(), &byteOffset, &bitOffset);
+    }
+    timer.Stop();
+
+    // keeps the decode from being optimized away
+    if (checksum == 0xFFFFFFFF)
+        cout << checksum << endl;
+    return timer.TotalTime() * 1e6 / (static_cast<double>(stream.Symbols.size()) * passes);
+}
+
+static void RunTable(const DhtTable& table, size_t symbolCount)
+{
+    HuffmanTree<uint8_t> tree;
+    HuffmanTable<uint8_t> lookup;
+    Expect(tree.PopulateWithHuffmanTable(table.NumOfCodes, table.Values.data()) == table.Values.size(), "tree symbol count");
+    Expect(lookup.PopulateWithHuffmanTable(table.NumOfCodes, table.Values.data()) == table.Values.size(), "table symbol count");
+
+    EncodedStream stream = Encode(table, symbolCount);
+    vector<uint8_t> fromTree = DecodeAll(tree, stream, symbolCount);
+    vector<uint8_t> fromTable = DecodeAll(lookup, stream, symbolCount);
+    Expect(fromTree == stream.Symbols, "the tree decodes what was encoded");
+    Expect(fromTable == stream.Symbols, "the table decodes what was encoded");
+
+    // the padding is no code of its own, both report the stream ended
+    size_t treeByte = stream.Data.size() - 1, tableByte = treeByte;
+    uint8_t treeBit = 7, tableBit = 7;
+    tree.DecodeSingleValue(stream.Data.data(), stream.Data.size(), &treeByte, &treeBit);
+    lookup.DecodeSingleValue(stream.Data.data(), stream.Data.size(), &tableByte, &tableBit);
+    Expect(treeByte == static_cast<size_t>(-1) && tableByte == treeByte, "decoding past the end fails");
+
+    if (g_Failures)
+        return;
+
+    double treeNs = NsPerSymbol(tree, stream, 2);
+    double tableNs = NsPerSymbol(lookup, stream, 2);
+    printf("%-16s %12zu %12.2f %12.2f %9.1fx\n", table.Name, stream.Symbols.size(), treeNs, tableNs, treeNs / tableNs);
+}
+
+int main(int argc, char** argv)
+{
+    size_t symbolCount = 1 << 20;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--symbols") == 0 && i + 1 < argc)
+            symbolCount = strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            cerr << "Usage: HuffmanBench [--symbols N]" << endl;
+            return 1;
+        }
+    }
+
+    printf("%-16s %12s %12s %12s %10s\n", "Table", "Symbols", "Tree ns", "Table ns", "Speedup");
+    RunTable(LuminanceDcTable(), symbolCount);
+    RunTable(LuminanceAcTable(), symbolCount);
+
+    // 3 codes of 1 bit, or 255 codes of 8 bits on top of one of 1 bit, do not fit
+    const uint8_t tooManyShort[16] = {3};
+    const uint8_t tooManyLong[16] = {1, 0, 0, 0, 0, 0, 0, 255};
+    vector<uint8_t> values(256);
+    HuffmanTable<uint8_t> malformed;
+    Expect(malformed.PopulateWithHuffmanTable(tooManyShort, values.data()) == 0, "codes past their length are rejected");
+    Expect(malformed.PopulateWithHuffmanTable(tooManyLong, values.data()) == 0, "codes past the lookup are rejected");
+
+    if (g_Failures)
+    {
+        cerr << g_Failures << " check(s) failed" << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include <iostream>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "HighPrecisionTimer.hpp"
+#include "portable.hpp"
+#include "Math/DCT.hpp"
+#include "Math/FastIDCT.hpp"
+
+using namespace std;
+using namespace Panda;
+
+/*
+ * Inverse DCT benchmark, every kernel of DequantizeIDCT8x8 the CPU supports
+ * against the reference IDCT8x8 that JfifParser used to call.
+ *
+ *   IdctBench [--blocks N]
+ *
+ * The kernels are checked against the reference first, a failure is
+ * reported with a non zero exit code.
+ */
+
+static int g_Failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        cerr << "FAILED: " << what << endl;
+        ++g_Failures;
+    }
+}
+
+static uint32_t XorShift(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// ITU-T81 Annex K.1 luminance table, natural order
+static const float k_Quantization[64] = {
+    16, 11, 10, 16,  24,  40,  51,  61,
+    12, 12, 14, 19,  26,  58,  60,  55,
+    14, 13, 16, 24,  40,  57,  69,  56,
+    14, 17, 22, 29,  51,  87,  80,  62,
+    18, 22, 37, 56,  68, 109, 103,  77,
+    24, 35, 55, 64,  81, 104, 113,  92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103,  99
+};
+
+struct Block
+{
+    int16_t Coefficients[64];
+};
+
+// blocks as an encoder makes them: a gradient with noise, transformed and quantized
+static vector<Block> MakeBlocks(size_t count, const float quantization[64])
+{
+    vector<Block> blocks(count);
+    uint32_t state = 0x9E3779B9;
+    for (Block& block : blocks)
+    {
+        float pixels[64];
+        int32_t base = XorShift(state) % 256;
+        int32_t slopeX = static_cast<int32_t>(XorShift(state) % 17) - 8;
+        int32_t slopeY = static_cast<int32_t>(XorShift(state) % 17) - 8;
+        int32_t noise = 1 + XorShift(state) % 64;
+        for (int32_t i = 0; i < 64; ++i)
+        {
+            int32_t value = base + slopeX * (i & 7) + slopeY * (i >> 3) + static_cast<int32_t>(XorShift(state) % noise) - noise / 2;
+            pixels[i] = static_cast<float>(min(max(value, 0), 255) - 128);
+        }
+
+        float dct[64];
+        DCT8x8(pixels, dct);
+        for (int32_t i = 0; i < 64; ++i)
+            block.Coefficients[i] = static_cast<int16_t>(lrintf(dct[i] / quantization[i]));
+    }
+    return blocks;
+}
+
+static void ReferenceIDCT(const Block& block, const float quantization[64], uint8_t out[64])
+{
+    float values[64];
+    for (int32_t i = 0; i < 64; ++i)
+        values[i] = block.Coefficients[i] * quantization[i];
+    values[0] += 1024.0f;
+    IDCT8x8(values, values);
+    for (int32_t i = 0; i < 64; ++i)
+        out[i] = static_cast<uint8_t>(min(max(static_cast<int32_t>(lrintf(values[i])), 0), 255));
+}
+
+int main(int argc, char** argv)
+{
+    size_t blockCount = 20000;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--blocks") == 0 && i + 1 < argc)
+            blockCount = strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            cerr << "Usage: IdctBench [--blocks N]" << endl;
+            return 1;
+        }
+    }
+
+    // the table at about quality 75, a DQT table holds whole numbers only
+    float quantization[64];
+    for (int32_t i = 0; i < 64; ++i)
+        quantization[i] = max(floorf(k_Quantization[i] * 0.5f + 0.5f), 1.0f);
+    IdctQuantization prepared;
+    PrepareIdctQuantization(quantization, prepared);
+
+    vector<Block> blocks = MakeBlocks(blockCount, quantization);
+    vector<uint8_t> reference(blocks.size() * 64);
+
+    HighPrecisionTimer timer;
+    timer.Start();
+    for (size_t i = 0; i < blocks.size(); ++i)
+        ReferenceIDCT(blocks[i], quantization, &reference[i * 64]);
+    timer.Stop();
+    double referenceNs = timer.TotalTime() * 1e6 / blocks.size();
+
+    printf("Default kernel: %s\n", GetIdctKernelName(GetIdctKernel()));
+    printf("%-12s %12s %12s %10s\n", "Kernel", "ns/block", "Max error", "Speedup");
+    printf("%-12s %12.1f %12d %9.1fx\n", "reference", referenceNs, 0, 1.0);
+
+    vector<uint8_t> samples(blocks.size() * 64);
+    for (int32_t kernel = 0; kernel < PANDA_IDCT_KERNEL_COUNT; ++kernel)
+    {
+        if (!SetIdctKernel(static_cast<IdctKernel>(kernel)))
+            continue;
+
+        // twice, the first pass warms the caches up
+        for (int32_t pass = 0; pass < 2; ++pass)
+        {
+            timer.Start();
+            for (size_t i = 0; i < blocks.size(); ++i)
+                DequantizeIDCT8x8(blocks[i].Coefficients, prepared, &samples[i * 64]);
+            timer.Stop();
+        }
+        double ns = timer.TotalTime() * 1e6 / blocks.size();
+
+        int32_t maxError = 0;
+        for (size_t i = 0; i < samples.size(); ++i)
+            maxError = max(maxError, abs(static_cast<int32_t>(samples[i]) - reference[i]));
+        Expect(maxError <= 1, "a kernel is within 1 of the reference");
+
+        printf("%-12s %12.1f %12d %9.1fx\n", GetIdctKernelName(static_cast<IdctKernel>(kernel)), ns, maxError, referenceNs / ns);
+    }
+
+    Expect(!SetIdctKernel(PANDA_IDCT_KERNEL_COUNT), "an unknown kernel is refused");
+
+    if (g_Failures)
+    {
+        cerr << g_Failures << " check(s) failed" << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include "MemoryManager.hpp"
+#include "AssetLoader.hpp"
+
+using namespace std;
+using namespace Panda;
+
+namespace Panda
+{
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+}
+
+static int g_Failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        cerr << "FAILED: " << what << endl;
+        ++g_Failures;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    filesystem::path root = filesystem::temp_directory_path() / "PandaMappedFileTest";
+    filesystem::create_directories(root / "Asset");
+
+    string content;
+    for (uint32_t i = 0; i < 100000; ++i)
+        content += static_cast<char>('a' + i % 26);
+    ofstream(root / "Asset" / "mapped.txt", ios::binary) << content;
+    ofstream(root / "Asset" / "empty.txt", ios::binary);
+
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->Initialize();
+    g_pAssetLoader->AddSearchPath(root.string().c_str());
+
+    {
+        BufferView slice;
+        {
+            BufferView view = g_pAssetLoader->SyncOpenAndMapBinary("mapped.txt");
+            Expect(view.GetDataSize() == content.size(), "mapped size");
+            Expect(view.IsShared(), "the view owns the mapping");
+            Expect(view.GetDataSize() == content.size()
+                && memcmp(view.GetData(), content.data(), content.size()) == 0, "mapped content");
+            slice = view.Slice(50000, 26);
+        }
+        // the slice keeps the mapping alive after the view is gone
+        Expect(string(reinterpret_cast<const char*>(slice.GetData()), slice.GetDataSize()) == content.substr(50000, 26),
+            "slice outlives the view");
+    }
+
+    Expect(g_pAssetLoader->SyncOpenAndReadFileToString("mapped.txt") == content, "file to string");
+
+    BufferView random = g_pAssetLoader->SyncOpenAndMapBinary("mapped.txt", MappedFile::PANDA_ACCESS_RANDOM);
+    Expect(random.GetDataSize() == content.size() && random.GetData()[12345] == content[12345], "random access mapping");
+    random = BufferView();
+
+    Expect(g_pAssetLoader->SyncOpenAndMapBinary("empty.txt").IsEmpty(), "empty file");
+    Expect(g_pAssetLoader->SyncOpenAndMapBinary("missing.txt").IsEmpty(), "missing file");
+    Expect(g_pAssetLoader->SyncOpenAndReadFileToString("missing.txt").empty(), "missing file to string");
+
+    g_pAssetLoader->Finalize();
+    delete g_pAssetLoader;
+    g_pMemoryManager->Finalize();
+    delete g_pMemoryManager;
+
+    filesystem::remove_all(root);
+
+    if (g_Failures)
+    {
+        cerr << g_Failures << " check(s) failed" << endl;
+        return 1;
+    }
+
+    cout << "All mapped file checks passed" << endl;
+    return 0;
+}
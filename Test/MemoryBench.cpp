@@ -0,0 +1,426 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <unistd.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#endif
+#include "AssetLoader.hpp"
+#include "MemoryManager.hpp"
+#include "MemoryTrace.hpp"
+#include "HighPrecisionTimer.hpp"
+#include "Parser/OGEX.hpp"
+
+using namespace std;
+using namespace Panda;
+
+namespace Panda
+{
+    Handness g_ViewHandness = Handness::kHandnessRight;
+    DepthClipSpace g_DepthClipSpace = DepthClipSpace::kDepthClipZeroToOne;
+
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+}
+
+/*
+ * Allocator benchmark, MemoryManager against the system malloc.
+ *
+ *   MemoryBench [--threads N] [--csv] [--trace file]...
+ *   MemoryBench --record Scene/cube.ogex cube.trace
+ *
+ * --record needs Core built with PANDA_MEMORY_TRACE, it loads the scene with
+ * every MemoryManager call written to the trace file. --trace replays such a
+ * trace single threaded on both allocators.
+ */
+
+static const uint32_t k_SlotCount = 4096;
+static const uint32_t k_ChurnOps = 2000000;
+static const uint32_t k_QueueOps = 2000000;
+static const uint32_t k_QueueSize = 1024;
+
+struct BenchResult
+{
+    double NsPerOp;
+    int64_t RssKB;      // resident set growth at the peak of the workload
+};
+
+struct PoolFuncs
+{
+    static void* Alloc(size_t size) { return MemoryManager::Allocate(size); }
+    static void* AllocAligned(size_t size, size_t alignment) { return MemoryManager::Allocate(size, alignment); }
+    static void Free(void* p, size_t size) { MemoryManager::Free(p, size); }
+    static void FreeAligned(void* p, size_t size, size_t alignment) { MemoryManager::Free(p, size, alignment); }
+
+    // hand the pages of the previous workload back, so that it does not hide the RSS of the next one
+    static void Reset()
+    {
+        for (uint32_t i = 0; i < k_TrimInterval; ++i)
+            g_pMemoryManager->Tick();
+    }
+};
+
+struct MallocFuncs
+{
+    static void* Alloc(size_t size) { return malloc(size); }
+    static void* AllocAligned(size_t size, size_t alignment)
+    {
+#if defined(_WIN32)
+        return _aligned_malloc(size, alignment);
+#else
+        void* p = nullptr;
+        if (posix_memalign(&p, alignment < sizeof(void*) ? sizeof(void*) : alignment, size) != 0)
+            return nullptr;
+        return p;
+#endif
+    }
+    static void Free(void* p, size_t) { free(p); }
+    static void FreeAligned(void* p, size_t, size_t)
+    {
+#if defined(_WIN32)
+        _aligned_free(p);
+#else
+        free(p);
+#endif
+    }
+
+    static void Reset()
+    {
+#if defined(__GLIBC__)
+        malloc_trim(0);
+#endif
+    }
+};
+
+static int64_t ResidentKB()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return static_cast<int64_t>(counters.WorkingSetSize / 1024);
+    return 0;
+#elif defined(__linux__)
+    long pages = 0, resident = 0;
+    FILE* fp = fopen("/proc/self/statm", "r");
+    if (fp)
+    {
+        if (fscanf(fp, "%ld %ld", &pages, &resident) != 2)
+            resident = 0;
+        fclose(fp);
+    }
+    return static_cast<int64_t>(resident) * sysconf(_SC_PAGESIZE) / 1024;
+#else
+    return 0;
+#endif
+}
+
+// the highest resident set seen by any thread of the running workload
+static atomic<int64_t> g_PeakRssKB(0);
+
+static void SampleRss()
+{
+    int64_t rss = ResidentKB();
+    int64_t peak = g_PeakRssKB.load(memory_order_relaxed);
+    while (rss > peak && !g_PeakRssKB.compare_exchange_weak(peak, rss, memory_order_relaxed))
+        ;
+}
+
+static uint32_t XorShift(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+struct Slot
+{
+    void* p;
+    size_t size;
+};
+
+// random slot replacement, sizeFunc picks the size of every new block
+template <typename Funcs, typename SizeFunc>
+static void Churn(uint32_t threadIndex, SizeFunc sizeFunc)
+{
+    vector<Slot> slots(k_SlotCount, Slot{nullptr, 0});
+    uint32_t state = 0x9E3779B9u ^ (threadIndex + 1) * 0x85EBCA6Bu;
+
+    for (uint32_t i = 0; i < k_ChurnOps; ++i)
+    {
+        Slot& slot = slots[XorShift(state) % k_SlotCount];
+        if (slot.p)
+            Funcs::Free(slot.p, slot.size);
+
+        slot.size = sizeFunc(state);
+        slot.p = Funcs::Alloc(slot.size);
+        *reinterpret_cast<uint8_t*>(slot.p) = static_cast<uint8_t>(i);
+    }
+
+    SampleRss();
+
+    for (auto& slot : slots)
+    {
+        if (slot.p)
+            Funcs::Free(slot.p, slot.size);
+    }
+}
+
+template <typename Funcs, typename SizeFunc>
+static BenchResult RunChurn(uint32_t threadCount, SizeFunc sizeFunc)
+{
+    Funcs::Reset();
+    int64_t baseRss = ResidentKB();
+    g_PeakRssKB = baseRss;
+
+    HighPrecisionTimer timer;
+    vector<thread> threads;
+    timer.Start();
+    for (uint32_t i = 0; i < threadCount; ++i)
+        threads.emplace_back(Churn<Funcs, SizeFunc>, i, sizeFunc);
+    for (auto& t : threads)
+        t.join();
+    timer.Stop();
+
+    // every iteration is one free and one allocation
+    double ops = 2.0 * k_ChurnOps * threadCount;
+    return BenchResult{timer.TotalTime() * 1.0e6 / ops, g_PeakRssKB - baseRss};
+}
+
+// the producer allocates, the consumer frees, so every block is freed by a thread that did not allocate it
+template <typename Funcs>
+static BenchResult RunProducerConsumer()
+{
+    Funcs::Reset();
+    int64_t baseRss = ResidentKB();
+    g_PeakRssKB = baseRss;
+
+    vector<Slot> queue(k_QueueSize);
+    atomic<uint32_t> head(0), tail(0);
+
+    HighPrecisionTimer timer;
+    timer.Start();
+
+    thread producer([&]() {
+        uint32_t state = 0x2545F491u;
+        for (uint32_t i = 0; i < k_QueueOps; ++i)
+        {
+            Slot slot;
+            slot.size = 16 + XorShift(state) % 496;
+            slot.p = Funcs::Alloc(slot.size);
+
+            uint32_t t = tail.load(memory_order_relaxed);
+            while (t - head.load(memory_order_acquire) == k_QueueSize)
+                this_thread::yield();
+            queue[t % k_QueueSize] = slot;
+            tail.store(t + 1, memory_order_release);
+        }
+        SampleRss();
+    });
+
+    thread consumer([&]() {
+        for (uint32_t i = 0; i < k_QueueOps; ++i)
+        {
+            uint32_t h = head.load(memory_order_relaxed);
+            while (tail.load(memory_order_acquire) == h)
+                this_thread::yield();
+            Slot slot = queue[h % k_QueueSize];
+            head.store(h + 1, memory_order_release);
+            Funcs::Free(slot.p, slot.size);
+        }
+    });
+
+    producer.join();
+    consumer.join();
+    timer.Stop();
+
+    return BenchResult{timer.TotalTime() * 1.0e6 / (2.0 * k_QueueOps), g_PeakRssKB - baseRss};
+}
+
+template <typename Funcs>
+static BenchResult RunTrace(const vector<MemoryTraceEvent>& events, uint32_t blockCount)
+{
+    Funcs::Reset();
+    int64_t baseRss = ResidentKB();
+    g_PeakRssKB = baseRss;
+
+    vector<void*> blocks(blockCount, nullptr);
+    HighPrecisionTimer timer;
+    timer.Start();
+    for (const MemoryTraceEvent& event : events)
+    {
+        if (event.IsAlloc)
+        {
+            blocks[event.Id] = event.Alignment ? Funcs::AllocAligned(event.Size, event.Alignment)
+                                               : Funcs::Alloc(event.Size);
+        }
+        else
+        {
+            if (event.Alignment)
+                Funcs::FreeAligned(blocks[event.Id], event.Size, event.Alignment);
+            else
+                Funcs::Free(blocks[event.Id], event.Size);
+            blocks[event.Id] = nullptr;
+        }
+    }
+    timer.Stop();
+    SampleRss();
+
+    // blocks still alive at the end of the recording, e.g. the loaded scene
+    for (const MemoryTraceEvent& event : events)
+    {
+        if (event.IsAlloc && blocks[event.Id])
+        {
+            if (event.Alignment)
+                Funcs::FreeAligned(blocks[event.Id], event.Size, event.Alignment);
+            else
+                Funcs::Free(blocks[event.Id], event.Size);
+            blocks[event.Id] = nullptr;
+        }
+    }
+
+    return BenchResult{events.empty() ? 0.0 : timer.TotalTime() * 1.0e6 / events.size(), g_PeakRssKB - baseRss};
+}
+
+static bool g_Csv = false;
+
+static void PrintHeader()
+{
+    if (g_Csv)
+    {
+        cout << "workload,MemoryManagerNsPerOp,mallocNsPerOp,MemoryManagerRssKB,mallocRssKB" << endl;
+        return;
+    }
+
+    cout << left << setw(28) << "workload" << right
+         << setw(16) << "pool(ns/op)" << setw(16) << "malloc(ns/op)"
+         << setw(16) << "pool RSS(KB)" << setw(16) << "malloc RSS(KB)" << endl;
+}
+
+static void PrintRow(const string& name, const BenchResult& pool, const BenchResult& sys)
+{
+    if (g_Csv)
+    {
+        cout << name << ',' << pool.NsPerOp << ',' << sys.NsPerOp << ',' << pool.RssKB << ',' << sys.RssKB << endl;
+        return;
+    }
+
+    cout << left << setw(28) << name << right << fixed << setprecision(2)
+         << setw(16) << pool.NsPerOp << setw(16) << sys.NsPerOp
+         << setw(16) << pool.RssKB << setw(16) << sys.RssKB << endl;
+}
+
+static int RecordScene(const char* sceneFile, const char* tracePath)
+{
+    g_pAssetLoader->Initialize();
+
+    string ogexText = g_pAssetLoader->SyncOpenAndReadFileToString(sceneFile);
+    if (ogexText.empty())
+    {
+        cerr << "Can not read " << sceneFile << endl;
+        return 1;
+    }
+
+    if (!MemoryTrace::Start(tracePath))
+    {
+        cerr << "Can not record to " << tracePath << ", Core has to be built with PANDA_MEMORY_TRACE" << endl;
+        return 1;
+    }
+
+    // the trace ends with the scene loaded, which is where the benchmark samples the RSS
+    OgexParser parser;
+    std::unique_ptr<Scene> pScene = parser.Parse(ogexText);
+    MemoryTrace::Stop();
+    pScene.reset();
+    g_pAssetLoader->Finalize();
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    g_pMemoryManager->Initialize();
+
+    uint32_t threadCount = thread::hardware_concurrency();
+    if (threadCount == 0) threadCount = 4;
+    vector<string> traces;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threadCount = static_cast<uint32_t>(atoi(argv[++i]));
+        else if (strcmp(argv[i], "--csv") == 0)
+            g_Csv = true;
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            traces.push_back(argv[++i]);
+        else if (strcmp(argv[i], "--record") == 0 && i + 2 < argc)
+        {
+            int result = RecordScene(argv[i + 1], argv[i + 2]);
+            g_pMemoryManager->Finalize();
+            delete g_pAssetLoader;
+            delete g_pMemoryManager;
+            return result;
+        }
+        else
+        {
+            cerr << "Usage: MemoryBench [--threads N] [--csv] [--trace file]... | --record scene.ogex file" << endl;
+            return 1;
+        }
+    }
+    if (threadCount == 0) threadCount = 1;
+
+    auto singleSize = [](uint32_t&) -> size_t { return 64; };
+    // mostly small blocks, now and then one above k_MaxBlockSize
+    auto mixedSize = [](uint32_t& state) -> size_t {
+        return (XorShift(state) % 32 == 0) ? 2048 + XorShift(state) % 6144 : 8 + XorShift(state) % 504;
+    };
+
+    PrintHeader();
+
+    PrintRow("single-size 64B x1", RunChurn<PoolFuncs>(1, singleSize), RunChurn<MallocFuncs>(1, singleSize));
+    PrintRow("single-size 64B x" + to_string(threadCount),
+             RunChurn<PoolFuncs>(threadCount, singleSize), RunChurn<MallocFuncs>(threadCount, singleSize));
+    PrintRow("mixed-size x1", RunChurn<PoolFuncs>(1, mixedSize), RunChurn<MallocFuncs>(1, mixedSize));
+    PrintRow("mixed-size x" + to_string(threadCount),
+             RunChurn<PoolFuncs>(threadCount, mixedSize), RunChurn<MallocFuncs>(threadCount, mixedSize));
+    PrintRow("producer/consumer", RunProducerConsumer<PoolFuncs>(), RunProducerConsumer<MallocFuncs>());
+
+    int result = 0;
+    for (const string& path : traces)
+    {
+        vector<MemoryTraceEvent> events;
+        if (!MemoryTrace::Load(path.c_str(), events))
+        {
+            cerr << "Can not read trace " << path << endl;
+            result = 1;
+            continue;
+        }
+
+        uint32_t blockCount = 0;
+        for (const MemoryTraceEvent& event : events)
+        {
+            if (event.IsAlloc)
+                ++blockCount;
+        }
+
+        PrintRow("trace " + path, RunTrace<PoolFuncs>(events, blockCount), RunTrace<MallocFuncs>(events, blockCount));
+    }
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pAssetLoader;
+    delete g_pMemoryManager;
+
+    return result;
+}
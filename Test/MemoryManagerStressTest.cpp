@@ -0,0 +1,143 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include "MemoryManager.hpp"
+
+using namespace std;
+using namespace Panda;
+
+namespace Panda
+{
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+}
+
+static const uint32_t k_SlotCount = 1024;
+static const uint32_t k_Iterations = 1000000;
+
+static atomic<bool> g_Corrupted(false);
+
+struct Slot
+{
+    uint8_t* p;
+    size_t size;
+};
+
+static uint32_t XorShift(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Every block is stamped with its owner's tag, if two threads are ever handed
+// the same block the tag will not survive until the block is freed.
+static void Stamp(const Slot& slot, uint8_t tag)
+{
+    memset(slot.p, tag, slot.size);
+}
+
+static void Check(const Slot& slot, uint8_t tag)
+{
+    for (size_t i = 0; i < slot.size; ++i)
+    {
+        if (slot.p[i] != tag)
+        {
+            g_Corrupted = true;
+            return;
+        }
+    }
+}
+
+template <typename AllocFunc, typename FreeFunc>
+static void Churn(uint32_t threadIndex, AllocFunc alloc, FreeFunc dealloc)
+{
+    vector<Slot> slots(k_SlotCount, Slot{nullptr, 0});
+    uint32_t state = 0x9E3779B9u ^ (threadIndex + 1) * 0x85EBCA6Bu;
+    uint8_t tag = static_cast<uint8_t>(threadIndex + 1);
+
+    for (uint32_t i = 0; i < k_Iterations; ++i)
+    {
+        Slot& slot = slots[XorShift(state) % k_SlotCount];
+        if (slot.p)
+        {
+            Check(slot, tag);
+            dealloc(slot.p, slot.size);
+        }
+
+        // mostly small blocks with an occasional one above k_MaxBlockSize
+        slot.size = (XorShift(state) % 16 == 0) ? 2048 : 8 + XorShift(state) % 504;
+        slot.p = reinterpret_cast<uint8_t*>(alloc(slot.size));
+        Stamp(slot, tag);
+    }
+
+    for (auto& slot : slots)
+    {
+        if (slot.p)
+        {
+            Check(slot, tag);
+            dealloc(slot.p, slot.size);
+        }
+    }
+}
+
+template <typename AllocFunc, typename FreeFunc>
+static double RunThreads(uint32_t threadCount, AllocFunc alloc, FreeFunc dealloc)
+{
+    vector<thread> threads;
+    auto start = chrono::steady_clock::now();
+    for (uint32_t i = 0; i < threadCount; ++i)
+        threads.emplace_back(Churn<AllocFunc, FreeFunc>, i, alloc, dealloc);
+    for (auto& t : threads)
+        t.join();
+    auto stop = chrono::steady_clock::now();
+
+    return chrono::duration<double, milli>(stop - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    g_pMemoryManager->Initialize();
+
+    auto poolAlloc = [](size_t size) { return g_pMemoryManager->Allocate(size); };
+    auto poolFree = [](void* p, size_t size) { g_pMemoryManager->Free(p, size); };
+    auto poolFreeUnsized = [](void* p, size_t) { g_pMemoryManager->Free(p); };
+    auto mallocAlloc = [](size_t size) { return malloc(size); };
+    auto mallocFree = [](void* p, size_t) { free(p); };
+
+    uint32_t maxThreads = thread::hardware_concurrency();
+    if (argc >= 2)
+        maxThreads = static_cast<uint32_t>(atoi(argv[1]));
+    if (maxThreads == 0) maxThreads = 4;
+
+    cout << setw(8) << "threads" << setw(18) << "MemoryManager(ms)" << setw(16) << "size-free(ms)" << setw(14) << "malloc(ms)" << endl;
+    for (uint32_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+    {
+        double poolTime = RunThreads(threadCount, poolAlloc, poolFree);
+        double unsizedTime = RunThreads(threadCount, poolAlloc, poolFreeUnsized);
+        double mallocTime = RunThreads(threadCount, mallocAlloc, mallocFree);
+        cout << setw(8) << threadCount << setw(18) << poolTime << setw(16) << unsizedTime << setw(14) << mallocTime << endl;
+    }
+
+    MemoryStats stats;
+    g_pMemoryManager->GetStats(stats);
+    cout << endl;
+    WriteMemoryStats(cout, stats, MemoryStatsFormat::kMemoryStatsCsv);
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pMemoryManager;
+
+    if (g_Corrupted)
+    {
+        cerr << "Block handed out to more than one owner!" << endl;
+        return 1;
+    }
+
+    return 0;
+}
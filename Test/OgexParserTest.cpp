@@ -16,8 +16,8 @@ namespace Panda
     AssetLoader* g_pAssetLoader = new AssetLoader();
 }
 
-template<typename Key, typename T>
-static std::ostream& operator<<(std::ostream& out, std::unordered_map<Key, T> map)
+template<typename Key, typename T, typename... Rest>
+static std::ostream& operator<<(std::ostream& out, const std::unordered_map<Key, T, Rest...>& map)
 {
     for (auto p : map)
     {
@@ -58,10 +58,13 @@ int main (int , char**)
     std::cout << "------------------------" << std::endl;
     std::cout << pScene->Materials << std::endl;
 
-    g_pAssetLoader->Finalize();
-    g_pMemoryManager->Finalize();
+    // the scene lives in pages of the memory manager, it goes before they are released
+    pScene.reset();
 
+    g_pAssetLoader->Finalize();
     delete g_pAssetLoader;
+
+    g_pMemoryManager->Finalize();
     delete g_pMemoryManager;
 
 	getchar();
@@ -0,0 +1,189 @@
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include "MemoryManager.hpp"
+#include "RelocatableHeap.hpp"
+#include "RelocatableBuffer.hpp"
+
+using namespace std;
+using namespace Panda;
+
+namespace Panda
+{
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+}
+
+static int g_Failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        cerr << "FAILED: " << what << endl;
+        ++g_Failures;
+    }
+}
+
+struct Block
+{
+    RelocatableHandle Handle;
+    size_t Size;
+    uint8_t Tag;
+};
+
+static bool CheckBlock(RelocatableHeap& heap, const Block& block)
+{
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(heap.Resolve(block.Handle));
+    if (p == nullptr)
+        return false;
+    for (size_t i = 0; i < block.Size; ++i)
+    {
+        if (p[i] != block.Tag)
+            return false;
+    }
+    return true;
+}
+
+static void TestHandles()
+{
+    RelocatableHeap heap(64 * 1024);
+
+    RelocatableHandle handle = heap.Allocate(100);
+    Expect(heap.IsValid(handle), "fresh handle is valid");
+    Expect(heap.GetSize(handle) == 100, "size is kept");
+    Expect(reinterpret_cast<uintptr_t>(heap.Resolve(handle)) % 16 == 0, "default alignment");
+
+    heap.Free(handle);
+    Expect(!heap.IsValid(handle), "freed handle is stale");
+    Expect(heap.Resolve(handle) == nullptr, "stale handle resolves to nullptr");
+
+    // the entry is reused, the old handle must not see the new block
+    RelocatableHandle reused = heap.Allocate(100);
+    Expect(reused.Index == handle.Index, "entry is reused");
+    Expect(!heap.IsValid(handle), "old generation stays stale");
+    Expect(heap.IsValid(reused), "new generation is valid");
+
+    Expect(!heap.IsValid(RelocatableHandle()), "null handle is invalid");
+}
+
+static void TestCompaction()
+{
+    const size_t chunkSize = 64 * 1024;
+    RelocatableHeap heap(chunkSize);
+    vector<Block> blocks;
+
+    for (uint32_t i = 0; i < 400; ++i)
+    {
+        Block block;
+        block.Size = 200 + (i * 37) % 1800;
+        block.Tag = static_cast<uint8_t>(i + 1);
+        block.Handle = heap.Allocate(block.Size, (i % 3 == 0) ? 64 : 16);
+        memset(heap.Resolve(block.Handle), block.Tag, block.Size);
+        blocks.push_back(block);
+    }
+    size_t chunksBefore = heap.GetChunkCount();
+
+    // leave holes all over the heap and pin one block behind a hole
+    vector<Block> survivors;
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        if (i % 4 != 0)
+            heap.Free(blocks[i].Handle);
+        else
+            survivors.push_back(blocks[i]);
+    }
+    void* pPinned = heap.Pin(survivors[5].Handle);
+
+    // a small budget forces the work to be spread over many calls
+    size_t moved = 0, step;
+    uint32_t calls = 0;
+    while ((step = heap.Compact(4096)) > 0)
+    {
+        moved += step;
+        ++calls;
+        for (const Block& block : survivors)
+            Expect(CheckBlock(heap, block), "content survives a compaction step");
+    }
+    Expect(moved > 0 && calls > 1, "compaction is incremental");
+    Expect(heap.Resolve(survivors[5].Handle) == pPinned, "pinned block does not move");
+    Expect(heap.GetChunkCount() < chunksBefore, "emptied chunks are released");
+
+    heap.Unpin(survivors[5].Handle);
+    while (heap.Compact(4096) > 0)
+        ;
+    for (const Block& block : survivors)
+        Expect(CheckBlock(heap, block), "content survives after unpin");
+
+    size_t live = 0;
+    for (const Block& block : survivors)
+        live += block.Size;
+    Expect(heap.GetLiveBytes() == live, "live bytes");
+
+    for (const Block& block : survivors)
+        heap.Free(block.Handle);
+    while (heap.Compact(4096) > 0)
+        ;
+    heap.Compact(4096);
+    Expect(heap.GetLiveBytes() == 0, "nothing left alive");
+    Expect(heap.GetReservedBytes() <= chunkSize, "at most one chunk is kept");
+}
+
+static void TestOversized()
+{
+    RelocatableHeap heap(4096);
+
+    RelocatableHandle big = heap.Allocate(100000);
+    memset(heap.Resolve(big), 0x5A, 100000);
+    Expect(heap.GetReservedBytes() >= 100000, "oversized block gets its own chunk");
+
+    heap.Free(big);
+    heap.Compact(4096);
+    Expect(heap.GetReservedBytes() == 0, "oversized chunk is released once empty");
+}
+
+static void TestMemoryManagerTick()
+{
+    // the buffers compact behind the scenes in MemoryManager::Tick()
+    vector<RelocatableBuffer> buffers;
+    for (uint32_t i = 0; i < 64; ++i)
+    {
+        buffers.emplace_back(64 * 1024);
+        memset(buffers.back().GetData(), i, buffers.back().GetDataSize());
+    }
+    for (uint32_t i = 0; i < buffers.size(); i += 2)
+        buffers[i] = RelocatableBuffer();
+
+    for (uint32_t i = 0; i < 16; ++i)
+        g_pMemoryManager->Tick();
+
+    for (uint32_t i = 1; i < buffers.size(); i += 2)
+    {
+        const uint8_t* p = buffers[i].GetData();
+        bool same = true;
+        for (size_t j = 0; j < buffers[i].GetDataSize(); ++j)
+            same = same && p[j] == i;
+        Expect(same, "relocatable buffer content after Tick");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    g_pMemoryManager->Initialize();
+
+    TestHandles();
+    TestCompaction();
+    TestOversized();
+    TestMemoryManagerTick();
+
+    g_pMemoryManager->Finalize();
+    delete g_pMemoryManager;
+
+    if (g_Failures)
+    {
+        cerr << g_Failures << " check(s) failed" << endl;
+        return 1;
+    }
+
+    cout << "All relocatable heap checks passed" << endl;
+    return 0;
+}
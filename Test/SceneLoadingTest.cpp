@@ -17,8 +17,8 @@ namespace Panda
     SceneManager* g_pSceneManager = new SceneManager();
 }
 
-template <typename T>
-static ostream& operator<< (ostream& out, unordered_map<string, shared_ptr<T>> map)
+template <typename T, typename... Rest>
+static ostream& operator<< (ostream& out, const unordered_map<string, shared_ptr<T>, Rest...>& map)
 {
     for (auto p : map)
         out << *p.second << endl;
@@ -97,12 +97,13 @@ int main(int, char**)
             cout << *pBone << endl;
     }
 
+    // everything holding blocks of the memory manager goes before its pages are released
     g_pSceneManager->Finalize();
     g_pAssetLoader->Finalize();
-    g_pMemoryManager->Finalize();
-
     delete g_pSceneManager;
     delete g_pAssetLoader;
+
+    g_pMemoryManager->Finalize();
     delete g_pMemoryManager;
 
     getchar();
@@ -36,9 +36,9 @@ int main(int argc, const char** argv)
     }
 
     g_pAssetLoader->Finalize();
-    g_pMemoryManager->Finalize();
-
     delete g_pAssetLoader;
+
+    g_pMemoryManager->Finalize();
     delete g_pMemoryManager;
 
     return 0;
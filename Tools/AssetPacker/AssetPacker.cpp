@@ -0,0 +1,115 @@
+#include <iostream>
+#include <filesystem>
+#include <memory>
+#include <set>
+#include <string>
+#include <cstring>
+#include "MemoryManager.hpp"
+#include "MappedFile.hpp"
+#include "AssetArchiveWriter.hpp"
+
+using namespace std;
+using namespace Panda;
+
+namespace Panda
+{
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+}
+
+/*
+ * Packs every file under a directory into a .pak archive. The names in the
+ * archive are the paths relative to that directory, so packing Asset/ gives
+ * the names AssetLoader is asked for.
+ *
+ * Files are compressed unless their format is compressed already, or
+ * --store names their extension.
+ */
+
+static void Usage()
+{
+    cerr << "Usage: AssetPacker <directory> <archive.pak> [--store .ext]... [--no-compress]" << endl;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        Usage();
+        return 1;
+    }
+
+    filesystem::path root = argv[1];
+    const char* archivePath = argv[2];
+    set<string> stored = {".png", ".jpg", ".jpeg"};
+    bool compress = true;
+
+    for (int i = 3; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--store") == 0 && i + 1 < argc)
+            stored.insert(argv[++i]);
+        else if (strcmp(argv[i], "--no-compress") == 0)
+            compress = false;
+        else
+        {
+            Usage();
+            return 1;
+        }
+    }
+
+    if (!filesystem::is_directory(root))
+    {
+        cerr << root.string() << " is not a directory" << endl;
+        return 1;
+    }
+
+    g_pMemoryManager->Initialize();
+
+    int result = 0;
+    {
+        AssetArchiveWriter writer;
+        size_t totalSize = 0;
+        for (auto& item : filesystem::recursive_directory_iterator(root))
+        {
+            if (!item.is_regular_file())
+                continue;
+
+            FILE* fp = fopen(item.path().string().c_str(), "rb");
+            shared_ptr<MappedFile> pMapping = make_shared<MappedFile>();
+            bool mapped = fp && pMapping->Map(fp);
+            if (fp)
+                fclose(fp);
+            if (!mapped)
+            {
+                cerr << "Error reading " << item.path().string() << endl;
+                result = 1;
+                break;
+            }
+
+            string name = item.path().lexically_relative(root).generic_string();
+            string ext = item.path().extension().string();
+            const uint8_t* pData = pMapping->GetData();
+            size_t size = pMapping->GetDataSize();
+
+            writer.AddFile(name, BufferView(move(pMapping), pData, size), compress && !stored.count(ext));
+            totalSize += size;
+        }
+
+        if (result == 0)
+        {
+            if (writer.Write(archivePath))
+            {
+                cout << "Packed " << writer.GetFileCount() << " files, " << totalSize << " bytes, into "
+                     << archivePath << " (" << filesystem::file_size(archivePath) << " bytes)" << endl;
+            }
+            else
+            {
+                result = 1;
+            }
+        }
+    }
+
+    g_pMemoryManager->Finalize();
+    delete g_pMemoryManager;
+
+    return result;
+}